@@ -2,9 +2,16 @@
 
 #include "hvn3/objects/IObject.h"
 
+#include "editor/PropertySchema.h"
+#include "editor/detail/ObjectPool.h"
+
+#include <cstdint>
+#include <map>
 #include <memory>
 #include <string>
+#include <type_traits>
 #include <unordered_map>
+#include <vector>
 
 namespace hvn3 {
 	namespace editor {
@@ -17,6 +24,10 @@ namespace hvn3 {
 			public:
 				// Creates a new instance of the object using its default constructor and returns a pointer to it.
 				virtual IObjectPtr New() const = 0;
+				// Creates a copy of the given instance, which must be of this type. Types that can't be copied are created using their default constructor instead.
+				virtual IObjectPtr Clone(const IObject& prototype) const = 0;
+				// Makes sure that the given number of instances can be created without allocating more memory.
+				virtual void Reserve(size_t count) const = 0;
 				// Returns the name of the object.
 				virtual const std::string& Name() const = 0;
 
@@ -30,40 +41,113 @@ namespace hvn3 {
 				ObjectRegistryItem(const std::string& name);
 
 				IObjectPtr New() const override;
+				IObjectPtr Clone(const IObject& prototype) const override;
+				void Reserve(size_t count) const override;
 				const std::string& Name() const override;
 
 			private:
 				std::string _name;
+				// Instances are allocated from a pool shared by all instances of the type, which stays alive as long as any of them do.
+				std::shared_ptr<detail::ObjectPool> _pool;
+
+				IObjectPtr _clone(const IObject& prototype, std::true_type) const;
+				IObjectPtr _clone(const IObject& prototype, std::false_type) const;
 
 			};
 
 		public:
-			typedef std::unordered_map<std::string, std::shared_ptr<IObjectRegistryItem>> registry_type;
+			// Identifies a type in the registry. IDs are assigned in the order types are registered, and don't change afterwards, so they can be resolved once and reused instead of looking up the name each time.
+			typedef uint32_t type_id_type;
+
+			static const type_id_type INVALID_TYPE_ID;
 
 			ObjectRegistry() = default;
 
-			// Adds a new object type to the registry.
+			// Adds a new object type to the registry, under the given category. Registering a name that's already registered replaces it, keeping its ID.
+			// If a schema is given, the properties of instances of the type are checked against it whenever instances are loaded, pasted or placed.
 			template<typename ObjectType>
-			void RegisterObject(const std::string& name);
-
-			// Creates a new instance of the object with the given name using its default constructor and returns a pointer to it.
+			void RegisterObject(const std::string& name, const std::string& category = "", PropertySchema schema = PropertySchema());
+
+			// Returns the ID of the type with the given name, or INVALID_TYPE_ID if there isn't one.
+			type_id_type GetTypeId(const std::string& name) const;
+			const std::string& GetName(type_id_type id) const;
+			const std::string& GetCategory(type_id_type id) const;
+			// Returns the property schema of the type with the given ID, which is empty if the type was registered without one.
+			const PropertySchema& GetSchema(type_id_type id) const;
+			// Returns the property schema of the type with the given ID, or nullptr if it doesn't have one. The schema stays alive even if the type is registered again.
+			std::shared_ptr<const PropertySchema> GetSharedSchema(type_id_type id) const;
+			// Returns the number of registered types.
+			size_t Count() const;
+
+			// Returns the IDs of all types, sorted by name (ignoring case).
+			const std::vector<type_id_type>& Types() const;
+			// Returns the names of all categories, in alphabetical order. Types registered without a category aren't included.
+			std::vector<std::string> Categories() const;
+			// Appends the IDs of all types whose names begin with the given prefix (ignoring case), sorted by name.
+			void FindByPrefix(const std::string& prefix, std::vector<type_id_type>& results) const;
+			// Appends the IDs of all types whose names contain the given string (ignoring case), sorted by name.
+			void FindBySubstring(const std::string& substring, std::vector<type_id_type>& results) const;
+			// Appends the IDs of all types in the given category, sorted by name.
+			void FindByCategory(const std::string& category, std::vector<type_id_type>& results) const;
+
+			// Creates a new instance of the object with the given name using its default constructor and returns a pointer to it. Returns nullptr if there's no such object.
 			IObjectPtr MakeObject(const std::string& key) const;
-
-			registry_type::iterator begin();
-			registry_type::iterator end();
+			// Creates a new instance of the object with the given ID using its default constructor and returns a pointer to it. Returns nullptr if there's no such object.
+			IObjectPtr MakeObject(type_id_type id) const;
+			// Creates the given number of instances of the object with the given ID, appending them to the results. Memory for all of them is reserved up front.
+			void MakeObjects(type_id_type id, size_t count, std::vector<IObjectPtr>& results) const;
+			void MakeObjects(const std::string& key, size_t count, std::vector<IObjectPtr>& results) const;
+			// Creates the given number of copies of the given instance of the object with the given ID, appending them to the results.
+			// This is used to place many objects configured the same way. Types that can't be copied are created using their default constructor instead.
+			void CloneObjects(type_id_type id, const IObject& prototype, size_t count, std::vector<IObjectPtr>& results) const;
 
 		private:
-			registry_type _registry;
+			struct Type {
+				std::string name;
+				// The name converted to lowercase, which the sorted index is ordered by.
+				std::string key;
+				std::string category;
+				std::shared_ptr<const PropertySchema> schema;
+				std::shared_ptr<IObjectRegistryItem> item;
+			};
+
+			std::vector<Type> _types;
+			std::unordered_map<std::string, type_id_type> _ids;
+			// Type IDs, sorted by key.
+			std::vector<type_id_type> _sorted;
+			std::map<std::string, std::vector<type_id_type>> _categories;
+
+			void _register(const std::string& name, const std::string& category, PropertySchema&& schema, std::shared_ptr<IObjectRegistryItem>&& item);
+			// Inserts the given type into the given list of types sorted by key.
+			void _insertSorted(std::vector<type_id_type>& ids, type_id_type id) const;
+
+			static std::string _toLower(const std::string& value);
 
 		};
 
 		template<typename ObjectType>
 		ObjectRegistry::ObjectRegistryItem<ObjectType>::ObjectRegistryItem(const std::string& name) :
-			_name(name) {
+			_name(name),
+			_pool(std::make_shared<detail::ObjectPool>()) {
 		}
 		template<typename ObjectType>
 		IObjectPtr ObjectRegistry::ObjectRegistryItem<ObjectType>::New() const {
-			return hvn3::make_object<ObjectType>();
+			return std::allocate_shared<ObjectType>(detail::PoolAllocator<ObjectType>(_pool));
+		}
+		template<typename ObjectType>
+		IObjectPtr ObjectRegistry::ObjectRegistryItem<ObjectType>::Clone(const IObject& prototype) const {
+			return _clone(prototype, std::is_copy_constructible<ObjectType>());
+		}
+		template<typename ObjectType>
+		void ObjectRegistry::ObjectRegistryItem<ObjectType>::Reserve(size_t count) const {
+
+			// The pool's block size is set by the first allocation, so an instance has to be created before anything can be reserved.
+
+			if (_pool->BlockSize() == 0)
+				New();
+
+			_pool->Reserve(count);
+
 		}
 		template<typename ObjectType>
 		const std::string& ObjectRegistry::ObjectRegistryItem<ObjectType>::Name() const {
@@ -71,11 +155,27 @@ namespace hvn3 {
 		}
 
 		template<typename ObjectType>
-		void ObjectRegistry::RegisterObject(const std::string& name) {
+		IObjectPtr ObjectRegistry::ObjectRegistryItem<ObjectType>::_clone(const IObject& prototype, std::true_type) const {
+
+			const ObjectType* object = dynamic_cast<const ObjectType*>(&prototype);
+
+			if (object == nullptr)
+				return New();
+
+			return std::allocate_shared<ObjectType>(detail::PoolAllocator<ObjectType>(_pool), *object);
+
+		}
+		template<typename ObjectType>
+		IObjectPtr ObjectRegistry::ObjectRegistryItem<ObjectType>::_clone(const IObject& prototype, std::false_type) const {
+			return New();
+		}
+
+		template<typename ObjectType>
+		void ObjectRegistry::RegisterObject(const std::string& name, const std::string& category, PropertySchema schema) {
 
-			std::unique_ptr<IObjectRegistryItem> item(new ObjectRegistryItem<ObjectType>(name));
+			std::shared_ptr<IObjectRegistryItem> item(new ObjectRegistryItem<ObjectType>(name));
 
-			_registry[name] = std::move(item);
+			_register(name, category, std::move(schema), std::move(item));
 
 		}
 
@@ -0,0 +1,197 @@
+#pragma once
+
+#include <limits>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace hvn3 {
+	namespace editor {
+
+		enum class PropertyType {
+			Bool,
+			Int,
+			Float,
+			String
+		};
+
+		// Declares a property of an object type, with its default value and the range of values it can take. Properties can be declared as constexpr, and their type is checked when the schema is built.
+		// Supported types are bool, int, float and const char* (for strings).
+		template <typename T>
+		class Property {
+
+			static_assert(std::is_same<T, bool>::value || std::is_same<T, int>::value || std::is_same<T, float>::value, "Properties must be of type bool, int, float or const char*.");
+
+		public:
+			constexpr Property(const char* name, T default_value) :
+				Property(name, default_value, std::numeric_limits<T>::lowest(), std::numeric_limits<T>::max()) {
+			}
+			constexpr Property(const char* name, T default_value, T min, T max) :
+				_name(name),
+				_default_value(default_value),
+				_min(min),
+				_max(max) {
+			}
+
+			constexpr const char* Name() const {
+				return _name;
+			}
+			constexpr T DefaultValue() const {
+				return _default_value;
+			}
+			constexpr T Min() const {
+				return _min;
+			}
+			constexpr T Max() const {
+				return _max;
+			}
+
+		private:
+			const char* _name;
+			T _default_value;
+			T _min;
+			T _max;
+
+		};
+
+		template <>
+		class Property<const char*> {
+
+		public:
+			constexpr Property(const char* name, const char* default_value) :
+				_name(name),
+				_default_value(default_value) {
+			}
+
+			constexpr const char* Name() const {
+				return _name;
+			}
+			constexpr const char* DefaultValue() const {
+				return _default_value;
+			}
+
+		private:
+			const char* _name;
+			const char* _default_value;
+
+		};
+
+		// The properties of an object type. Values are checked against the schema whenever objects are loaded, pasted or placed, so that typos and out-of-range values are caught, and values equal to the default aren't stored.
+		class PropertySchema {
+
+		public:
+			enum class Result {
+				// The value is valid, and differs from the default.
+				Valid,
+				// The value is equal to the default, and doesn't need to be stored.
+				Default,
+				// The value was outside of the property's range, and was clamped.
+				Clamped,
+				// The value couldn't be parsed, so the default is used instead.
+				Invalid,
+				// The schema doesn't have a property with the given name.
+				Unknown
+			};
+
+			struct Definition {
+				std::string name;
+				PropertyType type;
+				// Numbers (including bools) are stored as doubles, which can hold any int or float exactly.
+				double default_number;
+				double min;
+				double max;
+				std::string default_string;
+			};
+
+			PropertySchema() = default;
+
+			// Builds a schema from the given properties, for example:
+			// PropertySchema::Make(Property<int>("health", 100, 1, 999), Property<bool>("boss", false), Property<const char*>("dialog", ""))
+			template <typename... PropertyTypes>
+			static PropertySchema Make(const Property<PropertyTypes>&... properties);
+
+			bool Empty() const;
+			const std::vector<Definition>& Properties() const;
+			// Returns the property with the given name, or nullptr if there isn't one.
+			const Definition* Find(const std::string& name) const;
+
+			// Returns the index of the property with the given name, or -1 if there isn't one.
+			int IndexOf(const std::string& name) const;
+
+			// Parses the given value of the given property, and formats it in the property's canonical form (or formats the default if it isn't valid).
+			// Values of unknown properties are passed through unchanged.
+			Result Normalize(const std::string& name, const std::string& value, std::string& normalized) const;
+
+		private:
+			friend class PropertyValues;
+
+			std::vector<Definition> _properties;
+
+			void _add(const Property<bool>& property);
+			void _add(const Property<int>& property);
+			void _add(const Property<float>& property);
+			void _add(const Property<const char*>& property);
+			void _addNumber(const char* name, PropertyType type, double default_value, double min, double max);
+
+			static bool _parseNumber(PropertyType type, const std::string& value, double& number);
+			static std::string _formatNumber(PropertyType type, double number);
+
+		};
+
+		// The typed values of an object's properties. Each value is parsed once when it's set, so reading it doesn't parse anything.
+		class PropertyValues {
+
+		public:
+			PropertyValues();
+
+			// Sets the schema the values are parsed with (which can be nullptr), and resets every property to its default value.
+			void Reset(std::shared_ptr<const PropertySchema> schema);
+			// Parses the given value of the given property. Invalid values are replaced with the default, out-of-range values are clamped, and properties that aren't in the schema are ignored.
+			void Set(const std::string& name, const std::string& value);
+
+			// Returns the value of the given property, or the default if it hasn't been set. Properties that aren't in the schema return zero (or an empty string).
+			template <typename T>
+			T Get(const std::string& name) const;
+
+		private:
+			std::shared_ptr<const PropertySchema> _schema;
+			// Values indexed like the schema's properties. Numbers (including bools) are stored as doubles, like the schema's defaults.
+			std::vector<double> _numbers;
+			std::vector<std::string> _strings;
+
+			double _getNumber(const std::string& name) const;
+			std::string _getString(const std::string& name) const;
+
+		};
+
+		template <typename... PropertyTypes>
+		PropertySchema PropertySchema::Make(const Property<PropertyTypes>&... properties) {
+
+			PropertySchema schema;
+
+			int expand[] = { 0, (schema._add(properties), 0)... };
+			(void)expand;
+
+			return schema;
+
+		}
+		template <>
+		inline bool PropertyValues::Get<bool>(const std::string& name) const {
+			return _getNumber(name) != 0.0;
+		}
+		template <>
+		inline int PropertyValues::Get<int>(const std::string& name) const {
+			return static_cast<int>(_getNumber(name));
+		}
+		template <>
+		inline float PropertyValues::Get<float>(const std::string& name) const {
+			return static_cast<float>(_getNumber(name));
+		}
+		template <>
+		inline std::string PropertyValues::Get<std::string>(const std::string& name) const {
+			return _getString(name);
+		}
+
+	}
+}
\ No newline at end of file
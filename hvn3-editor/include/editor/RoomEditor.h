@@ -8,21 +8,44 @@
 #include "hvn3/xml/XmlResourceAdapterBase.h"
 
 #include "editor/ObjectRegistry.h"
+#include "editor/detail/BitmapCache.h"
+#include "editor/detail/Clipboard.h"
+#include "editor/detail/DiskImageCache.h"
+#include "editor/detail/FileWatcher.h"
+#include "editor/detail/IconAtlas.h"
+#include "editor/detail/ImageData.h"
+#include "editor/detail/JobSystem.h"
 #include "editor/detail/ObjectList.h"
+#include "editor/detail/ObjectRenderer.h"
+#include "editor/detail/RoomStreamer.h"
+#include "editor/detail/ScatterBrush.h"
+#include "editor/detail/SnapIndex.h"
+#include "editor/detail/TileLayer.h"
+#include "editor/detail/TileOverview.h"
 
+#include <memory>
 #include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
 
 namespace hvn3 {
 
 	namespace Gui {
-		class ListBox;
 		class RoomView;
 		class Window;
 	}
 
+	namespace Xml {
+		class XmlDocument;
+		class XmlElement;
+	}
+
 	namespace editor {
 
 		class RoomEditorBackgroundsWidget;
+		class RoomEditorListWidget;
+		class RoomEditorMinimapWidget;
 		class RoomEditorStatusStripWidget;
 		class RoomEditorTilesetsWidget;
 		class RoomEditorViewsWidget;
@@ -39,6 +62,8 @@ namespace hvn3 {
 			template <typename>
 			friend class RoomEditorXmlResourceAdapter;
 			friend class RoomEditorBackgroundsWidget;
+			friend class RoomEditorMinimapWidget;
+			friend class RoomEditorRoomViewWidget;
 			friend class RoomEditorTilesetsWidget;
 			friend class RoomEditorViewsWidget;
 
@@ -96,17 +121,85 @@ namespace hvn3 {
 			std::string _resource_base_directory;
 			std::string _last_directory;
 			detail::ObjectList _object_list;
+			detail::ObjectRenderer _object_renderer;
+			detail::JobSystem _jobs;
+			detail::DiskImageCache _disk_image_cache;
+			detail::BitmapCache _bitmap_cache;
+			detail::IconAtlas _icon_atlas;
+			// Watches the images used by tilesets and backgrounds, so that they can be reloaded when they're modified.
+			detail::FileWatcher _file_watcher;
+			std::unordered_map<std::string, detail::JobPtr> _reload_jobs;
+			detail::JobPtr _save_job;
+			detail::JobPtr _load_job;
+			// Objects from the room being loaded that haven't been created yet. The document is kept alive until they have.
+			std::shared_ptr<Xml::XmlDocument> _pending_document;
+			std::vector<const Xml::XmlElement*> _pending_objects;
+			size_t _pending_objects_loaded;
+			detail::TileLayerList _tile_layers;
+			detail::TileOverview _tile_overview;
+			// Keeps only the parts of large rooms near the view in memory.
+			detail::RoomStreamer _room_streamer;
+			// The page file referenced by the room being loaded, which is opened once the rest of the room has been loaded.
+			std::string _pending_pages_file;
+			// Chunks from pages that aren't in memory, which were copied to the room's tile manager for the current export.
+			std::vector<std::tuple<int, int, int>> _exported_chunks;
+			// Cells selected with "Select Matching Tiles", stored as a layer where selected cells are 1.
+			detail::TileLayer _tile_selection;
+			int _tile_selection_layer;
+			size_t _tile_selection_count;
 			//std::unordered_map<IObject*, std::vector<std::pair<String, String>>> _object_properties;
 
 			bool _editor_initialized;
 			bool _has_unsaved_changes;
+			// Incremented by every change to the room, so that a save can tell whether the room was changed while it was being written.
+			size_t _change_revision;
 			int _zoom_level;
+			PointF _zoom_center;
+			// True if the room is drawn by the editor instead of the RoomView.
+			bool _room_view_detached;
 			PointF _mouse_position;
 			KeyModifiers _key_modifiers;
 			MouseButton _mouse_buttons;
 			EDITOR_MODE _editor_mode;
 			detail::ObjectList::Item _selected_object;
+			// Objects found with "Find Objects".
+			std::vector<detail::ObjectList::Item> _selected_objects;
+			std::string _last_object_query;
+			// When enabled, dragging in objects mode paints objects of the type selected in the palette.
+			detail::ScatterBrush _scatter_brush;
+			bool _scatter_brush_enabled;
+			// Dragging with Ctrl+Shift held selects the tiles (on the current layer) and objects inside of a rectangle. The starting corner is in room coordinates.
+			bool _marquee_active;
+			PointF _marquee_start;
+			// Positions painted since the last update, where objects are placed all at once.
+			std::vector<PointF> _scatter_positions;
+			// The edges of the objects around the view, which dragged objects are snapped to. It's rebuilt when a drag starts, or when the view moves too far away from the region it was built for.
+			detail::SnapIndex _snap_index;
+			bool _snap_index_valid;
+			RectangleF _snap_index_region;
+			// Lines (in room coordinates) showing the edges the dragged object was snapped to.
+			std::vector<std::pair<PointF, PointF>> _snap_guides;
+			detail::Clipboard _clipboard;
 			ObjectRegistry _object_registry;
+			// Type IDs of the object names found in room files, so that each name is only looked up in the registry once.
+			std::unordered_map<std::string, ObjectRegistry::type_id_type> _import_type_ids;
+			std::string _last_import_type_name;
+			ObjectRegistry::type_id_type _last_import_type_id;
+			// The number of object properties in the room being loaded that didn't match their type's schema.
+			size_t _invalid_property_count;
+			// The number of tile chunks in the room being loaded that couldn't be decoded.
+			size_t _invalid_chunk_count;
+			// The attributes of objects whose types aren't in the registry. They can't be created, so they're kept as they were read and written back when the room is saved.
+			std::vector<detail::ObjectList::property_list_type> _unknown_objects;
+			// The number of objects in pages of the streamed room whose types aren't in the registry. Unlike the ones above, they're lost if their page is modified.
+			size_t _unknown_page_object_count;
+			// The objects listed in the outliner, and the index of each of them in the list. These are kept in sync with the object list as objects are added and removed, rather than copied from it.
+			std::vector<detail::ObjectList::Item> _outliner_items;
+			std::unordered_map<IObject*, size_t> _outliner_indices;
+			// The indices of objects removed since the outliner was last updated, whose items have been cleared.
+			std::vector<size_t> _outliner_removed;
+			// True if objects have been added or removed since the outliner was last updated.
+			bool _outliner_changed;
 			std::function<IRoomPtr(const SizeI&)> _room_provider;
 			bool _properties_exit_with_esc;
 			hvn3::IRoomPtr _room;
@@ -114,14 +207,68 @@ namespace hvn3 {
 
 			hvn3::Gui::GuiManager _widgets;
 			hvn3::Gui::Window* _left_panel;
-			hvn3::Gui::ListBox* _objects_view;
+			// Lists the types in the object registry, so that one can be chosen for placing objects.
+			RoomEditorListWidget* _objects_view;
+			// Lists the objects placed in the room.
+			RoomEditorListWidget* _outliner_view;
 			hvn3::Gui::RoomView* _room_view;
 			RoomEditorTilesetsWidget* _tileset_view;
 			RoomEditorBackgroundsWidget* _backgrounds_view;
 			RoomEditorViewsWidget* _views_view;
+			RoomEditorMinimapWidget* _minimap_view;
 			RoomEditorStatusStripWidget* _status_strip;
 
+			// Draws the room and everything over it inside of the room view. Called by the room view when it's drawn.
+			void _drawRoomView(DrawEventArgs& e);
 			void _drawTileCursor(DrawEventArgs& e);
+			void _drawObjects(DrawEventArgs& e);
+			void _drawTileSelection(DrawEventArgs& e);
+			void _drawObjectSelection(DrawEventArgs& e);
+			// Outlines the area covered by the scatter brush around the cursor.
+			void _drawScatterBrush(DrawEventArgs& e);
+			void _drawSnapGuides(DrawEventArgs& e);
+			void _drawMarquee(DrawEventArgs& e);
+			void _drawDetachedRoom(DrawEventArgs& e);
+			void _drawTile(Graphics::Graphics& graphics, detail::TileLayer::tile_id_type id, float x, float y, float scale);
+			// Returns the bitmap for the given tile index, or nullptr if no tileset contains it.
+			const Graphics::Bitmap* _getTileBitmap(detail::TileLayer::tile_id_type id);
+			Color _getTileColor(detail::TileLayer::tile_id_type id);
+			void _onTileChanged(int x, int y, detail::TileLayer::tile_id_type id, int layer);
+			// Updates everything that depends on the tile layers after the given chunks were changed all at once. This is much faster than calling _onTileChanged for each tile.
+			void _onTileChunksChanged(int layer, const std::vector<std::pair<int, int>>& chunks);
+			// Copies the tiles in the given chunk to the room's tile manager, or clears the chunk from it if it's null.
+			void _copyChunkToRoom(int layer, int chunk_x, int chunk_y, const detail::TileLayer::Chunk* chunk);
+			// Replaces every tile in the range [first_id, last_id] on every layer with the given tile.
+			void _replaceTiles(detail::TileLayer::tile_id_type first_id, detail::TileLayer::tile_id_type last_id, detail::TileLayer::tile_id_type replacement);
+			// Selects every cell on the given layer containing the given tile.
+			void _selectTiles(detail::TileLayer::tile_id_type id, int layer);
+			void _clearTileSelection();
+			void _eraseSelectedTiles();
+			// Selects the tiles on the current layer and the objects inside of the given region (in room coordinates), replacing the current selection.
+			void _selectRegion(const RectangleF& region);
+			// Selects every object matching the given property query. Returns false if the query isn't valid.
+			bool _selectObjects(const std::string& query);
+			void _clearObjectSelection();
+			// Reloads a tileset or background image that was modified on disk.
+			void _reloadImage(const std::string& file_path);
+			void _applyReloadedImage(const std::string& file_path, const detail::ImageData& image, uint64_t content_hash);
+			// Creates an object of the given type at each of the given positions (in room coordinates) that can be edited, and selects the last one. Returns the number of objects created.
+			// If a prototype is given, the objects are copies of it with the same properties. Otherwise, they're created using their default constructor. If properties are given, they're used instead of the prototype's.
+			size_t _placeObjects(ObjectRegistry::type_id_type type_id, const detail::ObjectList::Item* prototype, const std::vector<PointF>& positions, const detail::ObjectList::property_list_type* properties = nullptr);
+			// Checks the given packed properties against the schema of the type they name, like the properties of objects read from room files. Values are stored in their canonical form, and ones equal to the default (unless the properties are for an instance of a prefab) or invalid are removed.
+			// Returns the number of properties that were unknown, invalid or out of range.
+			size_t _validateProperties(detail::ObjectList::property_list_type& properties);
+			// Removes the given objects from the room and the object list all at once.
+			void _removeObjects(const std::vector<detail::ObjectList::Item>& items);
+			// Copies the selected tiles and objects to the clipboard, removing them from the room if cut is true.
+			void _copySelection(bool cut);
+			// Pastes the contents of the clipboard with its top-left corner at the tile under the cursor.
+			void _pasteClipboard();
+			// Places objects at the positions painted with the scatter brush since the last call.
+			void _placeScatteredObjects();
+			bool _isScatterPositionValid(const PointF& position);
+			// Returns the position to move the given object to when it's dragged to the given position (in room coordinates), snapped to the grid and to the edges and centers of the objects around it.
+			PointF _snapObjectPosition(detail::ObjectList::Item& item, const PointF& position);
 			void _unsubscribeEditorListeners();
 			void _resubscribeEditorListeners();
 			std::string _makePathRelativeToResourceBaseDirectory(const std::string& path);
@@ -132,22 +279,62 @@ namespace hvn3 {
 			void _initializeToolStrip();
 
 			void _updateWindowTitle();
+			void _markUnsavedChanges();
+			void _updateJobProgress();
 			void _hideAllPanelWindows();
+			// Updates the outliner if it's visible and objects have been added or removed since it was last updated.
+			void _updateOutliner();
+
+			float _zoomScale() const;
+			// Sets the zoom level, keeping the room position under the given display position in place.
+			void _setZoomLevel(int level, const PointF& anchor);
+			// Moves the view so that it's centered on the given room position. The view stays there until it's moved again, or reset with "Reset View".
+			void _setViewCenter(const PointF& position);
+			// Takes over drawing the room from the RoomView, which is needed to zoom or move the view.
+			void _detachRoomView();
+			// Detaches the RoomView and shows the top-left corner of the room. Called when a room is created or loaded, and by "Reset View".
+			void _resetRoomView();
+			// These account for the zoom level, and should be used instead of the RoomView's equivalent methods.
+			PointF _displayPositionToWorldPosition(const PointF& position, bool snap_to_grid);
+			PointF _worldPositionToDisplayPosition(const PointF& position);
+			PointF _displayPositionToGridCell(const PointF& position);
 
 			void _showPreferencesDialog();
 			void _showRoomNewDialog();
 			void _showRoomOpenDialog();
 			void _showRoomSaveDialog();
 			void _showRoomSaveAsDialog();
+			void _showRoomExportDialog();
 			void _showRoomViewContextMenu();
+			void _showFindObjectsDialog();
+			void _showScatterBrushDialog();
+			void _showCreatePrefabDialog();
+			void _showBakeCollisionDialog();
 
 			void _loadPreferences(); // Loads user preferences from disk if preferences file exists.
 			void _savePreferences(); // Saves user preferences to disk.
 
 			void _createNewRoom(int width, int height);
 			IRoomPtr _loadRoomFromFileIntoMemory(const std::string& file_path, bool load_resources_into_editor);
+			// Reads the file on a worker thread, then loads the room into the editor. Objects are created over the following frames.
 			void _loadRoomFromFileIntoEditor(const std::string& file_path);
-			void _saveRoomToFile(const std::string& file_path, bool is_temporary_file);
+			void _loadRoomFromDocumentIntoEditor(const std::string& file_path, const std::shared_ptr<Xml::XmlDocument>& document);
+			// Creates up to the given number of objects from the room being loaded.
+			void _loadPendingObjects(size_t max_count);
+			void _finishLoadingObjects();
+			void _cancelLoading();
+			// Returns false if the room couldn't be exported. Rooms that aren't temporary are written on a worker thread, so they can still fail to be written after this returns.
+			bool _saveRoomToFile(const std::string& file_path, bool is_temporary_file);
+			// Copies all of the room's tiles to its tile manager, which only holds them while the room is being exported in the base format, and collects the objects of streamed pages that aren't in memory.
+			// Returns false if any of the pages couldn't be read. _endExport should be called either way.
+			bool _beginExport(std::vector<detail::RoomStreamer::PageObject>& unloaded_objects);
+			void _endExport();
+			// Starts streaming the room from a page file next to it, which is written the next time it's saved.
+			void _enableStreaming();
+			// Writes the flags of the room's tiles to a collision file next to the room file, which the game can memory-map instead of looking up each tile's flags.
+			void _bakeCollision(bool merge_rectangles);
+			// Saves a copy of the room with the images of its tilesets and backgrounds packed into a few atlases, which are written next to it.
+			void _exportRoomWithAtlases(const std::string& file_path);
 			void _startPlaytest();
 
 			void _roomView_OnMouseDown(Gui::WidgetMouseDownEventArgs& e);
@@ -1,8 +1,15 @@
 #pragma once
+#include "hvn3/io/Path.h"
+#include "hvn3/xml/XmlDocument.h"
 #include "hvn3/xml/XmlResourceAdapterBase.h"
 
 #include "editor/RoomEditor.h"
 
+#include <sstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
 namespace hvn3 {
 	namespace editor {
 
@@ -11,13 +18,35 @@ namespace hvn3 {
 			public BaseAdapterT {
 
 		public:
-			RoomEditorXmlResourceAdapter(RoomEditor* editor, bool loadResourcesIntoEditor) {
+			// Where an image was packed into an atlas when exporting.
+			struct AtlasRegion {
+				// The path of the atlas image, relative to the resource base directory.
+				std::string atlas;
+				RectangleI region;
+			};
+
+			typedef std::unordered_map<std::string, AtlasRegion> atlas_region_map_type;
+
+			RoomEditorXmlResourceAdapter(RoomEditor* editor, bool loadResourcesIntoEditor, bool deferObjects = false) {
 
 				_editor = editor;
 				_load_resources_into_editor = loadResourcesIntoEditor;
+				_defer_objects = deferObjects;
+				_atlas_regions = nullptr;
+				_unloaded_objects = nullptr;
+				_is_streamed_room = false;
 
 			}
 
+			// Sets where each tileset and background image (by ID) was packed, so that exported rooms can refer to the atlases instead. The ID is still written, so that the editor can open the room.
+			void SetAtlasRegions(const atlas_region_map_type* regions) {
+				_atlas_regions = regions;
+			}
+			// Sets the objects of streamed pages that aren't in memory, which are exported along with the ones in the editor's object list.
+			void SetUnloadedObjects(const std::vector<detail::RoomStreamer::PageObject>* objects) {
+				_unloaded_objects = objects;
+			}
+
 			IRoomPtr ImportRoom(const Xml::XmlElement& node) const override {
 
 				IRoomPtr room;
@@ -31,6 +60,35 @@ namespace hvn3 {
 				else
 					room = hvn3::make_room<>(SizeI(width, height));
 
+				// Streamed rooms are also written in the base format, but the editor loads their tiles and objects from their page file instead. It's found before anything else is imported, so that the rest can be skipped.
+				// If the page file is missing, the room is loaded from the base format like any other room.
+
+				_is_streamed_room = false;
+
+				if (_load_resources_into_editor) {
+
+					for (auto i = node.ChildrenBegin(); i != node.ChildrenEnd(); ++i) {
+
+						const Xml::XmlElement* pages_node = (*i)->GetChild("pages");
+
+						if (pages_node == nullptr)
+							continue;
+
+						std::string pages_path = IO::Path::Combine(_editor->_resource_base_directory, pages_node->GetAttribute("file"));
+
+						if (IO::File::Exists(pages_path)) {
+
+							_is_streamed_room = true;
+							_editor->_pending_pages_file = pages_path;
+
+						}
+
+						break;
+
+					}
+
+				}
+
 				ReadDefaultProperties(room, node);
 
 				return room;
@@ -48,8 +106,8 @@ namespace hvn3 {
 					if (ptr != nullptr)
 						return *ptr;
 
-					// Load the background into the background view widget.
-					Background bg(Graphics::Bitmap::FromFile(id));
+					// Load the background into the background view widget. Images are shared through the bitmap cache, so reopening a room (or playtesting it) doesn't decode them again.
+					Background bg(_editor->_bitmap_cache.Load(id));
 
 					Xml::XmlResourceAdapterBase<>::ReadDefaultProperties(bg, node);
 
@@ -75,7 +133,9 @@ namespace hvn3 {
 						int tile_w = StringUtils::Parse<int>((*i)->GetAttribute("tile_w"));
 						int tile_h = StringUtils::Parse<int>((*i)->GetAttribute("tile_h"));
 
-						Tileset tileset = Tileset::FromFile(id, SizeI(tile_w, tile_h));
+						Tileset tileset(_editor->_bitmap_cache.Load(id), SizeI(tile_w, tile_h));
+
+						_readTilesetFlags(tileset, id);
 
 						if (_load_resources_into_editor)
 							_editor->_tileset_view->AddTileset(tileset, id);
@@ -88,22 +148,190 @@ namespace hvn3 {
 
 				BaseAdapterT::ImportTiles(data, node);
 
+				// The editor keeps the room's tiles in its tile layers instead of the room's tile manager, which only holds them while they're being exported. Rooms loaded for playtesting keep them where they are.
+
+				if (_load_resources_into_editor) {
+
+					detail::TileLayerList layers;
+
+					// Rooms saved by earlier versions of the editor also store their tiles as sparse chunks, which are read in place of the base tiles.
+					// The tiles of streamed rooms are read from their page file instead, so the base tiles are only cleared from the tile manager.
+
+					const Xml::XmlElement* layers_node = _is_streamed_room ? nullptr : node.GetChild("layers");
+
+					if (layers_node != nullptr) {
+
+						for (auto i = layers_node->ChildrenBegin(); i != layers_node->ChildrenEnd(); ++i) {
+
+							// Layers with an invalid depth would create every layer before them, so their chunks are rejected like any other invalid chunk.
+
+							int depth = StringUtils::Parse<int>((*i)->GetAttribute("depth"));
+
+							if (depth < 0 || depth >= detail::TileLayerList::MAX_LAYERS) {
+
+								for (auto j = (*i)->ChildrenBegin(); j != (*i)->ChildrenEnd(); ++j)
+									++_editor->_invalid_chunk_count;
+
+								continue;
+
+							}
+
+							detail::TileLayer& layer = layers.GetOrCreateLayer(depth);
+
+							// Chunks that can't be decoded are left empty rather than aborting the import, and are reported once the room has been loaded.
+
+							for (auto j = (*i)->ChildrenBegin(); j != (*i)->ChildrenEnd(); ++j)
+								if (!layer.DecodeChunk(StringUtils::Parse<int>((*j)->GetAttribute("x")), StringUtils::Parse<int>((*j)->GetAttribute("y")), (*j)->Text()))
+									++_editor->_invalid_chunk_count;
+
+						}
+
+					}
+
+					// Move the base tiles out of the tile manager. Tiles on layers beyond the last one the editor supports are left there, so that they're still written when the room is saved.
+
+					for (int depth = 0; depth < data.LayerCount() && depth < detail::TileLayerList::MAX_LAYERS; ++depth)
+						for (int y = 0; y < data.Rows(); ++y)
+							for (int x = 0; x < data.Columns(); ++x) {
+
+								detail::TileLayer::tile_id_type id = static_cast<detail::TileLayer::tile_id_type>(data.At(x, y, depth).id);
+
+								if (id == 0)
+									continue;
+
+								if (layers_node == nullptr && !_is_streamed_room)
+									layers.GetOrCreateLayer(depth).SetTile(x, y, id);
+
+								data.SetTile(x, y, 0, depth);
+
+							}
+
+					_editor->_tile_layers = std::move(layers);
+
+				}
+
+			}
+			void ImportObjects(IObjectManager& data, const Xml::XmlElement& node) const override {
+
+				// Prefabs are defined before any objects are created, so that their instances can refer to them.
+
+				const Xml::XmlElement* prefabs_node = node.GetChild("prefabs");
+
+				if (prefabs_node != nullptr && _load_resources_into_editor) {
+
+					for (auto i = prefabs_node->ChildrenBegin(); i != prefabs_node->ChildrenEnd(); ++i) {
+
+						detail::ObjectList::property_list_type properties;
+
+						for (auto j = (*i)->AttributesBegin(); j != (*i)->AttributesEnd(); ++j)
+							if (!(j->first == "id"))
+								properties.push_back(detail::ObjectList::property_pair_type(j->first, j->second));
+
+						_editor->_object_list.SetPrefab((*i)->GetAttribute("id"), properties);
+
+					}
+
+				}
+
+				// The objects of streamed rooms are created as their pages are loaded.
+
+				if (_is_streamed_room)
+					return;
+
+				if (!_defer_objects) {
+
+					// Objects of types that aren't in the registry aren't added to the room.
+
+					for (auto i = node.ChildrenBegin(); i != node.ChildrenEnd(); ++i) {
+
+						if (&**i == prefabs_node)
+							continue;
+
+						IObjectPtr ptr = ImportObject(**i);
+
+						if (ptr)
+							data.Add(ptr);
+
+					}
+
+					return;
+
+				}
+
+				// Let the editor create the objects later, a few at a time, so that the rest of the room can be shown first.
+
+				for (auto i = node.ChildrenBegin(); i != node.ChildrenEnd(); ++i)
+					if (&**i != prefabs_node)
+						_editor->_pending_objects.push_back(&**i);
+
 			}
 			IObjectPtr ImportObject(const Xml::XmlElement& node) const override {
 
 				std::string name = node.GetAttribute("name");
 
-				IObjectPtr ptr = _editor->_object_registry.MakeObject(name);
+				ObjectRegistry::type_id_type type_id = _resolveTypeId(name);
+				IObjectPtr ptr = _editor->_object_registry.MakeObject(type_id);
+
+				// Objects of types that aren't in the registry can't be created. The editor keeps their attributes so that they aren't lost when the room is saved.
+
+				if (!ptr) {
+
+					if (_load_resources_into_editor) {
+
+						detail::ObjectList::property_list_type attributes;
+
+						for (auto i = node.AttributesBegin(); i != node.AttributesEnd(); ++i)
+							attributes.push_back(detail::ObjectList::property_pair_type(i->first, i->second));
+
+						_editor->_unknown_objects.push_back(std::move(attributes));
+
+					}
+
+					return ptr;
+
+				}
 
 				if (_load_resources_into_editor) {
 
 					_editor->_object_list.Add(ptr);
+
+					// Instances of prefabs only store the properties they override.
+
+					bool is_instance = node.HasAttribute("prefab") && _editor->_object_list.SetObjectPrefab(ptr.get(), node.GetAttribute("prefab"));
+
 					_editor->_object_list.SetProperty(ptr, "name", name);
 
-					for (auto i = node.AttributesBegin(); i != node.AttributesEnd(); ++i)
-						if (!_isDefaultAttribute(i->first))
+					// Properties are checked against the type's schema and stored in their canonical form, so nothing needs to parse them again. Properties left at their default values aren't stored at all.
+					// Unknown properties (which are likely to be typos) are kept so that nothing is lost, but are counted along with invalid values so that they can be reported.
+
+					const PropertySchema& schema = _editor->_object_registry.GetSchema(type_id);
+					std::string value;
+
+					for (auto i = node.AttributesBegin(); i != node.AttributesEnd(); ++i) {
+
+						if (_isDefaultAttribute(i->first))
+							continue;
+
+						if (schema.Empty()) {
+
 							_editor->_object_list.SetProperty(ptr, i->first, i->second);
 
+							continue;
+
+						}
+
+						PropertySchema::Result result = schema.Normalize(i->first, i->second, value);
+
+						if (result != PropertySchema::Result::Valid && result != PropertySchema::Result::Default)
+							++_editor->_invalid_property_count;
+
+						// An instance overriding its prefab's value with the default still has to store it.
+
+						if ((result != PropertySchema::Result::Default || is_instance) && result != PropertySchema::Result::Invalid)
+							_editor->_object_list.SetProperty(ptr, i->first, value);
+
+					}
+
 				}
 
 				Xml::XmlResourceAdapterBase<>::ReadDefaultProperties(ptr, node);
@@ -120,6 +348,8 @@ namespace hvn3 {
 
 				node.SetAttribute("id", _editor->_makePathRelativeToResourceBaseDirectory(id));
 
+				_writeAtlasRegion(id, node);
+
 				BaseAdapterT::ExportBackground(data, node);
 
 			}
@@ -131,19 +361,87 @@ namespace hvn3 {
 
 				for (auto i = _editor->_tileset_view->Tilesets().begin(); i != _editor->_tileset_view->Tilesets().end(); ++i) {
 
+					String id = _editor->_tileset_view->GetIdByTileset(*i);
+
 					Xml::XmlElement* tileset_node = tilesets_node->AddChild("tileset");
-					tileset_node->SetAttribute("id", _editor->_makePathRelativeToResourceBaseDirectory(_editor->_tileset_view->GetIdByTileset(*i)));
+					tileset_node->SetAttribute("id", _editor->_makePathRelativeToResourceBaseDirectory(id));
 					tileset_node->SetAttribute("tile_w", i->TileSize().width);
 					tileset_node->SetAttribute("tile_h", i->TileSize().height);
 
+					_writeAtlasRegion(id, *tileset_node);
+
 				}
 
+				// Streamed rooms are written to their page file before the room is exported, so only the path to it is needed. Rooms that haven't been saved yet don't have one.
+
+				if (_editor->_room_streamer.IsOpen() && !_editor->_room_streamer.FilePath().empty()) {
+
+					Xml::XmlElement* pages_node = node.AddChild("pages");
+					pages_node->SetAttribute("file", _editor->_makePathRelativeToResourceBaseDirectory(_editor->_room_streamer.FilePath()));
+
+				}
+
+				// Tiles are always written in the base format, which is the one the game loads rooms from. The editor copies all of the room's tiles to the tile manager while it's being exported, and rebuilds its layers from them on import.
+
 				BaseAdapterT::ExportTiles(data, node);
 
+			}
+			void ExportObjects(const IObjectManager& data, Xml::XmlElement& node) const override {
+
+				// Prefabs are written even for streamed rooms, since the objects in their pages refer to them.
+
+				std::vector<String> prefabs = _editor->_object_list.Prefabs();
+
+				if (!prefabs.empty()) {
+
+					Xml::XmlElement* prefabs_node = node.AddChild("prefabs");
+
+					for (auto i = prefabs.begin(); i != prefabs.end(); ++i) {
+
+						Xml::XmlElement* prefab_node = prefabs_node->AddChild("prefab");
+						const detail::ObjectList::property_list_type& properties = *_editor->_object_list.GetPrefab(*i);
+
+						prefab_node->SetAttribute("id", *i);
+
+						for (auto j = properties.begin(); j != properties.end(); ++j)
+							prefab_node->SetAttribute(j->first, j->second);
+
+					}
+
+				}
+
+				// The objects of streamed rooms aren't in the room, so they're written from the editor's object list and the pages that aren't in memory instead.
+
+				if (!_editor->_room_streamer.IsOpen())
+					BaseAdapterT::ExportObjects(data, node);
+				else {
+
+					for (auto i = _editor->_object_list.begin(); i != _editor->_object_list.end(); ++i)
+						ExportObject(i->Object(), *node.AddChild("object"));
+
+					if (_unloaded_objects != nullptr)
+						for (auto i = _unloaded_objects->begin(); i != _unloaded_objects->end(); ++i)
+							_exportPageObject(*i, node);
+
+				}
+
+				// Objects of types that aren't in the registry are written back exactly as they were read.
+
+				for (auto i = _editor->_unknown_objects.begin(); i != _editor->_unknown_objects.end(); ++i) {
+
+					Xml::XmlElement* object_node = node.AddChild("object");
+
+					for (auto j = i->begin(); j != i->end(); ++j)
+						object_node->SetAttribute(j->first, j->second);
+
+				}
+
 			}
 			void ExportObject(const IObjectPtr& data, Xml::XmlElement& node) const override {
 
-				auto properties = _editor->_object_list.GetProperties(data);
+				// Instances of prefabs are written as a reference to the prefab and the properties they override.
+
+				auto properties = _editor->_object_list.GetPackedProperties(data.get());
 
 				for (auto i = properties.begin(); i != properties.end(); ++i)
 					node.SetAttribute(i->first, i->second);
@@ -155,15 +453,106 @@ namespace hvn3 {
 		private:
 			RoomEditor* _editor;
 			bool _load_resources_into_editor;
+			bool _defer_objects;
+			const atlas_region_map_type* _atlas_regions;
+			const std::vector<detail::RoomStreamer::PageObject>* _unloaded_objects;
+			// True if the room being imported is streamed from its page file.
+			mutable bool _is_streamed_room;
+
+			ObjectRegistry::type_id_type _resolveTypeId(const std::string& name) const {
+
+				// Rooms usually contain many instances of only a few types, so each name is only looked up in the registry once per file. Instances of the same type also tend to be stored together.
+
+				if (name == _editor->_last_import_type_name)
+					return _editor->_last_import_type_id;
+
+				auto id_iter = _editor->_import_type_ids.find(name);
+
+				if (id_iter == _editor->_import_type_ids.end())
+					id_iter = _editor->_import_type_ids.emplace(name, _editor->_object_registry.GetTypeId(name)).first;
+
+				_editor->_last_import_type_name = name;
+				_editor->_last_import_type_id = id_iter->second;
+
+				return id_iter->second;
+
+			}
+			void _exportPageObject(const detail::RoomStreamer::PageObject& object, Xml::XmlElement& objects_node) const {
+
+				// Pages store the same packed properties that are written for objects in the editor, so they're written as they are. The object is only created for the base properties, such as its position.
+				// Objects of types that aren't in the registry (which were reported when their page was loaded) can't be written without them.
+
+				std::string name;
+
+				for (auto i = object.properties.begin(); i != object.properties.end(); ++i)
+					if (i->first == "name")
+						name = i->second;
+
+				IObjectPtr ptr = _editor->_object_registry.MakeObject(name);
 
+				if (!ptr)
+					return;
+
+				ptr->SetPosition(object.position);
+
+				Xml::XmlElement* node = objects_node.AddChild("object");
+
+				for (auto i = object.properties.begin(); i != object.properties.end(); ++i)
+					node->SetAttribute(i->first, i->second);
+
+				BaseAdapterT::ExportObject(ptr, *node);
+
+			}
+			void _writeAtlasRegion(const String& id, Xml::XmlElement& node) const {
+
+				if (_atlas_regions == nullptr)
+					return;
+
+				auto region_iter = _atlas_regions->find(static_cast<std::string>(id));
+
+				if (region_iter == _atlas_regions->end())
+					return;
+
+				const RectangleI& region = region_iter->second.region;
+
+				node.SetAttribute("atlas", region_iter->second.atlas);
+				node.SetAttribute("atlas_x", region.X());
+				node.SetAttribute("atlas_y", region.Y());
+				node.SetAttribute("atlas_w", region.Width());
+				node.SetAttribute("atlas_h", region.Height());
+
+			}
 			bool _isDefaultAttribute(const String& attribute) const {
 
 				return attribute == "name" ||
+					attribute == "prefab" ||
 					attribute == "x" ||
 					attribute == "y" ||
 					attribute == "id";
 
 			}
+			static void _readTilesetFlags(Tileset& tileset, const String& id) {
+
+				// Tile flags are stored in the tileset's metadata file, as a comma-separated list.
+
+				std::string metadata_path = IO::Path::SetExtension(id, ".xml");
+
+				if (!IO::File::Exists(metadata_path))
+					return;
+
+				Xml::XmlDocument metadata = Xml::XmlDocument::Open(metadata_path);
+				const Xml::XmlElement* flags_node = metadata.Root().GetChild("flags");
+
+				if (flags_node == nullptr)
+					return;
+
+				std::stringstream flags(static_cast<std::string>(flags_node->Text()));
+				std::string flag;
+
+				for (size_t i = 0; i < tileset.Count() && std::getline(flags, flag, ','); ++i)
+					tileset.At(i).flag = static_cast<decltype(tileset.At(i).flag)>(StringUtils::Parse<int>(flag));
+
+			}
 
 		};
 
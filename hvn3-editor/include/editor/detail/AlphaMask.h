@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			// A bit-packed mask of the opaque pixels in an image.
+			class AlphaMask {
+
+			public:
+				AlphaMask();
+				AlphaMask(int width, int height);
+
+				int Width() const;
+				int Height() const;
+				// Returns true if the mask has no size.
+				bool IsEmpty() const;
+
+				void Set(int x, int y, bool value);
+				// Returns true if the pixel at the given position is opaque. Positions outside of the mask are never opaque.
+				bool Test(int x, int y) const;
+
+			private:
+				int _width;
+				int _height;
+				// Number of 64-bit words in each row.
+				int _stride;
+				std::vector<uint64_t> _bits;
+
+			};
+
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+#pragma once
+
+#include "hvn3/math/Size.h"
+
+#include <cstddef>
+#include <vector>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			// Packs rectangles into as few square pages as it can, using a skyline: each page keeps the height of its filled area along the x-axis, and each rectangle is placed where it ends up lowest.
+			// This is much faster than keeping track of every free rectangle, and wastes little space when the rectangles are packed from tallest to shortest.
+			class AtlasPacker {
+
+			public:
+				struct Placement {
+					size_t page;
+					int x;
+					int y;
+				};
+
+				// Pages are at most max_size pixels wide and tall. Rectangles larger than that are each given a page of their own size.
+				AtlasPacker(int max_size, int padding);
+
+				// Adds a rectangle to be packed, and returns its index.
+				size_t Add(int width, int height);
+				// Places all of the rectangles that were added.
+				void Pack();
+
+				// Returns where the rectangle with the given index was placed.
+				const Placement& At(size_t index) const;
+				size_t PageCount() const;
+				// Returns the size of the given page, which is trimmed to the rectangles placed on it.
+				SizeI PageSize(size_t page) const;
+				// Returns the fraction of the pages' area covered by rectangles (from 0 to 1).
+				float Efficiency() const;
+
+			private:
+				struct Segment {
+					int x;
+					int y;
+					int width;
+				};
+
+				struct Page {
+					std::vector<Segment> skyline;
+					int width;
+					int height;
+				};
+
+				int _max_size;
+				int _padding;
+				std::vector<SizeI> _sizes;
+				std::vector<Placement> _placements;
+				std::vector<Page> _pages;
+
+				// Finds the lowest position on the given page where a rectangle of the given size fits. Returns false if it doesn't fit anywhere.
+				bool _find(const Page& page, int width, int height, int& x, int& y) const;
+				void _place(Page& page, int x, int y, int width, int height);
+
+			};
+
+		}
+	}
+}
\ No newline at end of file
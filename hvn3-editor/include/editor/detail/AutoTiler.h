@@ -0,0 +1,74 @@
+#pragma once
+
+#include "editor/detail/TileLayer.h"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			// Compiles auto-tiling rules for a tileset into lookup tables, and applies them to tile layers.
+			// Each cell's 8 neighbors are encoded as a bitmask (NW, N, NE, W, E, SW, S, SE from the lowest bit to the highest), which is mapped to a tile through a precomputed table.
+			class AutoTiler {
+
+			public:
+				typedef TileLayer::tile_id_type tile_id_type;
+				typedef std::function<void(int, int, tile_id_type)> changed_callback_type;
+
+				enum class Layout {
+					// 47 tiles covering every combination of edges and inner corners, ordered by their neighbor bitmask.
+					Blob47,
+					// 16 tiles covering every combination of edges (N, E, S, W from the lowest bit to the highest), ignoring corners.
+					Edge16
+				};
+
+				// Terrain IDs are stored in 8 bits, and 0 is reserved for "no terrain".
+				static const int MAX_TERRAINS = 255;
+				// The largest tile index a terrain's tiles can extend to, which limits the size of the table mapping tiles to terrains.
+				static const tile_id_type MAX_TILE = 1 << 20;
+
+				AutoTiler();
+
+				// Adds a terrain whose tiles begin at the given tile index. Returns the terrain's index, or -1 if there are already MAX_TERRAINS terrains or the terrain's tiles aren't between 1 and MAX_TILE.
+				int AddTerrain(tile_id_type first_tile, Layout layout);
+				int TerrainCount() const;
+				tile_id_type TerrainFirstTile(int terrain) const;
+				Layout TerrainLayout(int terrain) const;
+				// Removes all terrains.
+				void Clear();
+
+				// Returns the index of the terrain that the given tile belongs to, or -1 if it doesn't belong to one.
+				int TerrainOf(tile_id_type tile) const;
+
+				// Returns the number of tiles in a terrain with the given layout.
+				static int TileCount(Layout layout);
+
+				// Re-tiles the 3x3 neighborhood around the given cell. The callback is invoked for every tile that was changed.
+				void ApplyAt(TileLayer& layer, int x, int y, const changed_callback_type& on_changed) const;
+				// Re-tiles every cell in the given region of the layer. The callback is invoked for every tile that was changed.
+				void Apply(TileLayer& layer, int columns, int rows, const changed_callback_type& on_changed) const;
+
+			private:
+				struct Terrain {
+					tile_id_type first_tile;
+					Layout layout;
+					std::array<uint8_t, 256> table;
+				};
+
+				std::vector<Terrain> _terrains;
+				// Maps tile indices to the terrain they belong to (offset by 1 so that 0 means "no terrain").
+				std::vector<uint8_t> _membership;
+
+				void _compile(Terrain& terrain);
+				uint8_t _terrainIdOf(tile_id_type tile) const;
+				tile_id_type _tileFor(uint8_t terrain_id, uint8_t mask) const;
+
+			};
+
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "hvn3/graphics/Bitmap.h"
+
+#include <cstdint>
+#include <ctime>
+#include <list>
+#include <string>
+#include <unordered_map>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			class DiskImageCache;
+
+			// Keeps bitmaps loaded from files so that the same image is never decoded twice.
+			// Files are identified by their normalized path and modification time, and files with identical contents share a single bitmap.
+			// Bitmaps are shared by reference, so evicting one (in least-recently-used order, once the memory budget is exceeded) only frees it once nothing else is using it.
+			// This class isn't thread-safe, and should only be used from the main thread.
+			class BitmapCache {
+
+			public:
+				static const uint64_t FNV_OFFSET_BASIS = 14695981039346656037ULL;
+
+				BitmapCache();
+
+				// Returns the bitmap for the given file, loading it if it isn't cached or the file has been modified since it was loaded.
+				Graphics::Bitmap Load(const std::string& file_path);
+				// Records that the bitmap for the given file has been updated in place to match the file's current contents, which have the given hash.
+				void Refresh(const std::string& file_path, uint64_t content_hash);
+				// Sets the approximate amount of decoded pixel data (in bytes) kept in the cache.
+				void SetMemoryBudget(size_t bytes);
+				// Images that aren't in memory will be looked up in the given disk cache before they're decoded.
+				void SetDiskCache(DiskImageCache* disk_cache);
+				// Removes all bitmaps from the cache.
+				void Clear();
+
+				size_t Count() const;
+				// Returns the approximate amount of decoded pixel data (in bytes) kept in the cache.
+				size_t MemoryUsage() const;
+
+				// Returns the path in a form that's the same for all paths referring to the same file.
+				static std::string NormalizePath(const std::string& file_path);
+				// Returns a 64-bit FNV-1a hash of the file's contents.
+				static uint64_t HashFile(const std::string& file_path);
+				// Continues the given 64-bit FNV-1a hash with the given data. This allows several pieces of data to be hashed together.
+				static uint64_t HashData(const void* data, size_t size, uint64_t hash = FNV_OFFSET_BASIS);
+
+			private:
+				struct Image {
+					Graphics::Bitmap bitmap;
+					size_t size;
+					// The number of paths referring to this image. Once none do, the image is removed from the cache.
+					int ref_count;
+					std::list<uint64_t>::iterator lru_iter;
+				};
+
+				struct File {
+					time_t modified;
+					uint64_t content_hash;
+				};
+
+				std::unordered_map<std::string, File> _files;
+				std::unordered_map<uint64_t, Image> _images;
+				std::list<uint64_t> _lru;
+				size_t _memory_budget;
+				size_t _memory_usage;
+				DiskImageCache* _disk_cache;
+
+				// Releases a path's reference to the image, removing the image once nothing refers to it.
+				void _release(uint64_t content_hash);
+				void _evict();
+
+				static bool _getModificationTime(const std::string& file_path, time_t& modified);
+
+			};
+
+		}
+	}
+}
\ No newline at end of file
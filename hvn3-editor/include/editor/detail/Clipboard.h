@@ -0,0 +1,98 @@
+#pragma once
+
+#include "hvn3/math/Point2d.h"
+
+#include "editor/detail/ObjectList.h"
+#include "editor/detail/TileLayer.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			// A copied block of tiles and objects, which is stored on the system clipboard so that it can be pasted into other rooms and other instances of the editor.
+			// It's encoded in a compact binary format: tiles are stored as runs, and the strings used by the objects' properties are stored once, as are lists of properties shared by many objects.
+			class Clipboard {
+
+			public:
+				typedef TileLayer::tile_id_type tile_id_type;
+
+				// Marks cells that weren't copied, which are left as they are when pasting.
+				static const tile_id_type NO_TILE;
+				// The largest number of cells (including ones that weren't copied) a block of tiles can cover.
+				static const int MAX_CELLS = 1 << 20;
+
+				struct Object {
+					// The position of the object relative to the top-left corner of the copied block.
+					PointF position;
+					// The index of the object's properties, which can be retrieved with GetProperties.
+					size_t properties;
+				};
+
+				// A prefab used by the copied objects, so that they can be pasted into rooms that don't define it.
+				struct Prefab {
+					std::string name;
+					// The index of the prefab's properties, which can be retrieved with GetProperties.
+					size_t properties;
+				};
+
+				Clipboard();
+
+				void Clear();
+				bool Empty() const;
+
+				// Sets the copied tiles, stored row by row.
+				void SetTiles(int columns, int rows, std::vector<tile_id_type>&& tiles);
+				int Columns() const;
+				int Rows() const;
+				const std::vector<tile_id_type>& Tiles() const;
+
+				void AddObject(const PointF& position, const ObjectList::property_list_type& properties);
+				const std::vector<Object>& Objects() const;
+				// Returns the number of distinct property lists used by the objects.
+				size_t PropertyListCount() const;
+				ObjectList::property_list_type GetProperties(size_t index) const;
+				// Returns the given properties with their "prefab" property replaced by the properties of the copied prefab it refers to.
+				ObjectList::property_list_type GetUnpackedProperties(size_t index) const;
+
+				void AddPrefab(const String& name, const ObjectList::property_list_type& properties);
+				const std::vector<Prefab>& Prefabs() const;
+
+				void Encode(std::vector<uint8_t>& data) const;
+				// Replaces the contents of the clipboard with the given data. Returns false (leaving the clipboard empty) if the data isn't valid.
+				bool Decode(const std::vector<uint8_t>& data);
+
+				// Stores the clipboard on the system clipboard.
+				void Store() const;
+				// Replaces the contents of the clipboard with the system clipboard's. Returns false if the system clipboard doesn't contain anything copied from the editor.
+				bool Load();
+
+			private:
+				typedef std::vector<std::pair<uint32_t, uint32_t>> property_list_type;
+
+				int _columns;
+				int _rows;
+				std::vector<tile_id_type> _tiles;
+				std::vector<Object> _objects;
+				std::vector<Prefab> _prefabs;
+				std::vector<std::string> _strings;
+				std::unordered_map<std::string, uint32_t> _string_ids;
+				// Property lists, where each property is a pair of indices into the string table.
+				std::vector<property_list_type> _property_lists;
+				std::map<property_list_type, size_t> _property_list_ids;
+
+				uint32_t _intern(const std::string& value);
+				size_t _internProperties(const property_list_type& properties);
+				size_t _internProperties(const ObjectList::property_list_type& properties);
+
+			};
+
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "hvn3/math/Size.h"
+
+#include "editor/detail/TileLayer.h"
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			// Combines a room's tile layers with its tilesets' flags into bit-packed grids, one for each flag used on each layer, so that the game can look up a tile's flags with a single bit test.
+			// Solid regions can also be merged into rectangles, for physics engines and other code that works with shapes rather than tiles.
+			// The grids are written to a file laid out so that it can be memory-mapped and used as it is: every value is little-endian and aligned to its own size.
+			class CollisionBake {
+
+			public:
+				static const uint32_t VERSION = 1;
+
+				// The file begins with the header, followed by a table of planes. Each plane's bits and rectangles are stored at the offsets given in its entry.
+				struct Header {
+					char magic[4];
+					uint32_t version;
+					uint32_t columns;
+					uint32_t rows;
+					uint32_t tile_width;
+					uint32_t tile_height;
+					// The number of 64-bit words in each row of a plane. The bit for the tile at (x, y) is bit (x % 64) of word (y * words_per_row + x / 64).
+					uint32_t words_per_row;
+					uint32_t plane_count;
+					uint64_t planes_offset;
+				};
+
+				struct PlaneEntry {
+					uint32_t layer;
+					// The flag whose tiles are set in the plane, which is always a single bit.
+					uint32_t flag;
+					uint64_t bits_offset;
+					uint64_t rectangles_offset;
+					uint32_t rectangle_count;
+					uint32_t reserved;
+				};
+
+				// A rectangle of tiles that are all set in a plane (in tiles).
+				struct Rectangle {
+					uint32_t x;
+					uint32_t y;
+					uint32_t width;
+					uint32_t height;
+				};
+
+				CollisionBake(int columns, int rows, const SizeI& tile_size);
+
+				// Sets the flags of each tile, indexed by tile. Tiles outside of the list have no flags.
+				void SetFlags(std::vector<uint32_t>&& flags);
+				// Sets the bits of the tiles in the given chunk that have flags. Tiles outside of the room are ignored.
+				void AddChunk(int layer, int chunk_x, int chunk_y, const TileLayer::Chunk& chunk);
+				// Covers the set bits of every plane with as few rectangles as it can find, so that each tile is covered exactly once.
+				void MergeRectangles();
+
+				// Returns the number of planes, which is the number of distinct flags used on each layer.
+				size_t PlaneCount() const;
+				size_t RectangleCount() const;
+
+				bool Write(const std::string& file_path) const;
+
+			private:
+				struct Plane {
+					std::vector<uint64_t> bits;
+					std::vector<Rectangle> rectangles;
+				};
+
+				int _columns;
+				int _rows;
+				SizeI _tile_size;
+				size_t _words_per_row;
+				std::vector<uint32_t> _flags;
+				// Planes are created the first time a tile with their flag is found on their layer, and are kept sorted by layer and flag.
+				std::map<std::pair<int, uint32_t>, Plane> _planes;
+
+				Plane& _getPlane(int layer, uint32_t flag);
+				void _mergeRectangles(Plane& plane) const;
+
+			};
+
+		}
+	}
+}
\ No newline at end of file
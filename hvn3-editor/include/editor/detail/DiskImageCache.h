@@ -0,0 +1,89 @@
+#pragma once
+
+#include "hvn3/graphics/Bitmap.h"
+
+#include "editor/detail/JobSystem.h"
+
+#include <cstdint>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			// Stores decoded images on disk, so that large images don't need to be decoded again the next time the editor is started.
+			// Each entry is a single file named after the hash of the source file's contents, holding a small header followed by the raw RGBA pixel rows. Entries are memory-mapped and copied straight into a new bitmap.
+			// An index file records when each entry was last used. Entries whose source file has changed are removed when the new version is stored, and entries that haven't been used in a while are removed by Flush.
+			// Entries are only added to the index once they've been written successfully.
+			class DiskImageCache {
+
+			public:
+				static const uint32_t VERSION = 1;
+
+				DiskImageCache(const std::string& directory);
+
+				// Entries will be written on the given job system's worker threads instead of the calling thread. Their completions need to be processed on the thread using the cache.
+				void SetJobSystem(JobSystem* jobs);
+				// Sets the maximum total size of all entries (in bytes).
+				void SetMaxSize(uint64_t bytes);
+				// Sets the number of days after which unused entries are removed.
+				void SetMaxAge(int days);
+
+				// Returns the decoded image for the given source file, or nullptr if it isn't cached.
+				std::unique_ptr<Graphics::Bitmap> Load(const std::string& source_path, uint64_t content_hash);
+				// Stores the decoded image for the given source file.
+				void Store(const std::string& source_path, uint64_t content_hash, const Graphics::Bitmap& bitmap);
+				// Waits for entries that are being written, removes stale entries and writes the index.
+				void Flush();
+
+			private:
+				struct Header {
+					char magic[4];
+					uint32_t version;
+					uint64_t content_hash;
+					uint32_t width;
+					uint32_t height;
+					// The distance between the start of each row (in bytes).
+					uint32_t stride;
+					// The offset of the first row from the start of the file (in bytes).
+					uint32_t pixels_offset;
+				};
+
+				struct Entry {
+					std::string source_path;
+					time_t last_used;
+					uint64_t size;
+				};
+
+				struct PendingWrite {
+					JobPtr job;
+					Entry entry;
+					// Set if the entry was removed while it was being written, in which case its file is deleted once the write has finished.
+					bool removed;
+				};
+
+				std::string _directory;
+				JobSystem* _jobs;
+				uint64_t _max_size;
+				int _max_age;
+				bool _index_loaded;
+				std::unordered_map<uint64_t, Entry> _entries;
+				// Entries being written on worker threads. There's never more than one write for the same entry.
+				std::unordered_map<uint64_t, PendingWrite> _pending_writes;
+
+				void _loadIndex();
+				void _saveIndex();
+				void _remove(uint64_t content_hash);
+				// Called on the main thread once an entry has been written, or has failed to be.
+				void _finishWrite(uint64_t content_hash, bool failed);
+				std::string _getEntryPath(uint64_t content_hash) const;
+				std::string _getIndexPath() const;
+
+			};
+
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <chrono>
+#include <ctime>
+#include <functional>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			// Notices when watched files are modified or replaced on disk.
+			// On Linux, the directories containing the files are watched with inotify, which also catches programs that save by writing a new file and renaming it over the old one. Elsewhere, the modification times of the files are checked periodically.
+			// This class isn't thread-safe. Changes are only reported from Poll, which should be called regularly from the main thread.
+			class FileWatcher {
+
+			public:
+				// Called once for each watched file that changed since the last call to Poll.
+				typedef std::function<void(const std::string&)> callback_type;
+
+				FileWatcher();
+				FileWatcher(const FileWatcher&) = delete;
+				FileWatcher& operator=(const FileWatcher&) = delete;
+				~FileWatcher();
+
+				void SetCallback(callback_type&& callback);
+				// Sets how often modification times are checked when inotify isn't available.
+				void SetPollInterval(std::chrono::milliseconds interval);
+
+				// Starts watching the given file. The path passed to the callback is the same as the one given here.
+				void Watch(const std::string& file_path);
+				void Unwatch(const std::string& file_path);
+				void Clear();
+				bool IsWatching(const std::string& file_path) const;
+
+				// Calls the callback for each watched file that changed.
+				void Poll();
+
+			private:
+				struct File {
+					std::string path;
+					std::string directory;
+					time_t modified;
+				};
+
+				// Watched files, by normalized path.
+				std::unordered_map<std::string, File> _files;
+				callback_type _callback;
+				std::chrono::milliseconds _poll_interval;
+				std::chrono::steady_clock::time_point _last_poll;
+#ifdef __linux__
+				int _inotify;
+				// Watch descriptors and the number of watched files in each directory, by directory.
+				std::unordered_map<std::string, std::pair<int, int>> _directories;
+				// Directories by watch descriptor. Different paths to the same directory share a watch descriptor.
+				std::unordered_map<int, std::vector<std::string>> _watches;
+#endif
+
+				void _addDirectory(const std::string& directory);
+				void _removeDirectory(const std::string& directory);
+
+				static std::string _getDirectory(const std::string& normalized_path);
+				static time_t _getModificationTime(const std::string& file_path);
+
+			};
+
+		}
+	}
+}
\ No newline at end of file
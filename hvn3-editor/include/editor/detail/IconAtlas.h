@@ -0,0 +1,46 @@
+#pragma once
+
+#include "hvn3/graphics/Bitmap.h"
+#include "hvn3/math/Rectangle.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			class DiskImageCache;
+
+			// Packs a set of small images into a single bitmap, so that they share a texture and can be drawn in a single batch.
+			// The layout only depends on the images' names and sizes, which are read from the PNG headers. The packed bitmap is stored in the disk cache under a hash of the files' names, sizes and modification times, so once it's been stored, only the headers need to be read again.
+			class IconAtlas {
+
+			public:
+				// The number of transparent pixels between images, which keeps filtering from bleeding neighboring images into each other.
+				static const int PADDING = 1;
+
+				// Packs the PNG files with the given names (without extension) from the given directory. If a disk cache is given, the packed bitmap is read from it when none of the files' sizes or modification times have changed.
+				void Load(const std::string& directory, const std::vector<std::string>& names, DiskImageCache* disk_cache);
+
+				// Returns the image with the given name, as a sub-bitmap of the packed bitmap.
+				Graphics::Bitmap Icon(const std::string& name) const;
+				// Returns the region of the packed bitmap holding the image with the given name.
+				const RectangleI& Region(const std::string& name) const;
+				// Returns the packed bitmap, or nullptr if nothing has been loaded.
+				const Graphics::Bitmap* Bitmap() const;
+
+			private:
+				std::unique_ptr<Graphics::Bitmap> _bitmap;
+				std::unordered_map<std::string, RectangleI> _regions;
+
+				// Reads the size of the image from the header of the given PNG data. Returns false if it isn't valid PNG data.
+				static bool _readPngSize(const std::vector<char>& data, int& width, int& height);
+
+			};
+
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "hvn3/graphics/Bitmap.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			// The decoded pixels of an image, as RGBA rows.
+			// Unlike a bitmap, this doesn't belong to a display, so it can be loaded on a worker thread and copied into a bitmap on the main thread afterwards.
+			class ImageData {
+
+			public:
+				ImageData();
+
+				// Decodes the given image file. Returns false if it couldn't be loaded.
+				bool Load(const std::string& file_path);
+				// Encodes the image to the given file, in the format given by its extension. Returns false if it couldn't be saved.
+				bool Save(const std::string& file_path) const;
+				// Replaces the image with a transparent image of the given size.
+				void Create(int width, int height);
+				// Copies the given image into this one, with its top-left corner at the given position. Pixels that fall outside of this image are left out.
+				void Draw(const ImageData& image, int x, int y);
+				// Overwrites the pixels of the given bitmap. Returns false if the bitmap isn't the same size as the image, or if it couldn't be locked.
+				bool CopyTo(Graphics::Bitmap& bitmap) const;
+
+				int Width() const;
+				int Height() const;
+
+			private:
+				int _width;
+				int _height;
+				std::vector<uint8_t> _pixels;
+
+			};
+
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,128 @@
+#pragma once
+
+#include "editor/detail/MpscQueue.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			// The state of a job submitted to a JobSystem, shared between the job's work function and whoever submitted it.
+			class Job {
+
+			public:
+				Job(const std::string& name);
+
+				const std::string& Name() const;
+
+				// Requests that the job stop. Jobs that haven't started yet are skipped, and the completion callback of a cancelled job is never called.
+				void Cancel();
+				bool IsCancelled() const;
+				// Jobs are cancellable by the user unless their owner depends on them completing, in which case only the owner should cancel them.
+				void SetCancellable(bool value);
+				bool IsCancellable() const;
+
+				// Returns the progress of the job (from 0 to 1).
+				float Progress() const;
+				// Sets the progress of the job (from 0 to 1). Can be called from the work function to report progress.
+				void SetProgress(float progress);
+
+				// Returns true if the job's work function has returned (or was skipped).
+				bool IsFinished() const;
+				// Returns true if the job's work function threw an exception. Only meaningful once the job has finished.
+				bool IsFailed() const;
+				// Returns the message of the exception thrown by the job's work function, if any.
+				const std::string& Error() const;
+
+			private:
+				friend class JobSystem;
+
+				std::string _name;
+				std::atomic<bool> _cancelled;
+				// Only used on the main thread.
+				bool _cancellable;
+				std::atomic<float> _progress;
+				std::atomic<bool> _finished;
+				// Written by the worker before the job is marked as finished, so they're safe to read once it has.
+				bool _failed;
+				std::string _error;
+
+			};
+
+			typedef std::shared_ptr<Job> JobPtr;
+
+			// Runs work on a pool of worker threads, and passes the results back to the main thread.
+			// Each worker has its own queue, and workers that run out of work steal from the queues of the others. Finished jobs are pushed onto a lock-free queue, whose completion callbacks are run on the main thread by ProcessCompletions.
+			class JobSystem {
+
+			public:
+				// Runs on a worker thread.
+				typedef std::function<void(Job&)> work_type;
+				// Runs on the main thread once the work has finished, including when the work failed.
+				typedef std::function<void(const Job&)> completion_type;
+
+				// Creates a job system with one worker for each hardware thread, except the main thread.
+				JobSystem();
+				JobSystem(int thread_count);
+				JobSystem(const JobSystem&) = delete;
+				JobSystem& operator=(const JobSystem&) = delete;
+				// Waits for all jobs that haven't been cancelled to finish, without calling their completion callbacks.
+				~JobSystem();
+
+				JobPtr Submit(const std::string& name, work_type&& work, completion_type&& on_complete = nullptr);
+				// Blocks until the given job has finished, then calls the completion callbacks of all finished jobs. The given job's completion callback has always been called when this returns.
+				void Wait(const JobPtr& job);
+				// Blocks until the given job has finished, without calling any completion callbacks. They're called by the next call to ProcessCompletions instead.
+				void Join(const JobPtr& job);
+				// Calls the completion callbacks of all finished jobs. Returns the number of jobs completed.
+				size_t ProcessCompletions();
+
+				// Returns the jobs that have been submitted but not completed yet, in the order they were submitted.
+				const std::vector<JobPtr>& ActiveJobs() const;
+				int ThreadCount() const;
+
+			private:
+				struct Task :
+					MpscQueueNode {
+					JobPtr job;
+					work_type work;
+					completion_type on_complete;
+				};
+
+				struct Worker {
+					std::thread thread;
+					std::mutex mutex;
+					std::deque<Task*> tasks;
+				};
+
+				std::vector<std::unique_ptr<Worker>> _workers;
+				std::atomic<size_t> _next_worker;
+				// The number of tasks that haven't been picked up by a worker yet.
+				std::atomic<int> _pending_count;
+				std::mutex _wake_mutex;
+				std::condition_variable _wake;
+				bool _stopping;
+				MpscQueue<Task> _completions;
+				// Held while a job is marked as finished and pushed onto the completion queue, so that Join can wait for both.
+				std::mutex _finished_mutex;
+				std::condition_variable _finished;
+				std::vector<JobPtr> _active_jobs;
+
+				void _initialize(int thread_count);
+				void _run(size_t worker_index);
+				Task* _takeTask(size_t worker_index);
+
+			};
+
+		}
+	}
+}
\ No newline at end of file
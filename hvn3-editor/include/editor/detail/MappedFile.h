@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			// A read-only view of a file's contents, mapped into memory.
+			class MappedFile {
+
+			public:
+				MappedFile();
+				MappedFile(const MappedFile&) = delete;
+				MappedFile& operator=(const MappedFile&) = delete;
+				~MappedFile();
+
+				// Maps the given file into memory. Returns false if the file couldn't be opened or is empty.
+				bool Open(const std::string& file_path);
+				void Close();
+
+				bool IsOpen() const;
+				const uint8_t* Data() const;
+				size_t Size() const;
+
+			private:
+				const uint8_t* _data;
+				size_t _size;
+#ifdef _WIN32
+				void* _file;
+				void* _mapping;
+#else
+				int _file;
+#endif
+
+			};
+
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,85 @@
+#pragma once
+
+#include "hvn3/graphics/Bitmap.h"
+#include "hvn3/graphics/Color.h"
+#include "hvn3/math/Point2d.h"
+#include "hvn3/math/Rectangle.h"
+#include "hvn3/math/Size.h"
+
+#include "editor/detail/TileLayer.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			// Keeps a low-resolution image of a room, where each pixel shows the average color of the tiles it covers, tinted by the number of objects inside of it.
+			// Edits only mark the pixels they touch as dirty, and dirty pixels are redrawn a limited number at a time.
+			class Minimap {
+
+			public:
+				// Returns the color that represents the given tile.
+				typedef std::function<Color(TileLayer::tile_id_type)> tile_color_callback_type;
+
+				// The maximum width or height of the image (in pixels).
+				static const int MAX_SIZE = 256;
+
+				Minimap();
+
+				// Resizes the image to fit a room of the given size, and marks every pixel as dirty.
+				void Reset(const SizeI& room_size, const SizeI& tile_size);
+				void SetTileColorCallback(tile_color_callback_type&& callback);
+				// Sets the maximum number of pixels that can be redrawn during a single call to Update.
+				void SetUpdateBudget(size_t budget);
+
+				// Returns the size of the image (in pixels).
+				SizeI Size() const;
+				// Returns the size of the area covered by a single pixel (in room pixels).
+				float Scale() const;
+				// Returns the image, or nullptr if the minimap hasn't been reset yet.
+				const Graphics::Bitmap* Bitmap() const;
+
+				// Marks the pixel containing the given tile as dirty.
+				void InvalidateTile(int x, int y);
+				// Marks the pixels containing any of the tiles in the given region as dirty.
+				void InvalidateRegion(const RectangleI& tiles);
+				// Marks every pixel as dirty.
+				void InvalidateAll();
+				// Forgets the colors of the tiles in the given range, and marks the pixels containing them as dirty. This should be called when the appearance of those tiles changes.
+				void InvalidateTiles(const TileLayerList& layers, TileLayer::tile_id_type first_id, TileLayer::tile_id_type last_id);
+				void AddObject(const PointF& position);
+				void RemoveObject(const PointF& position);
+				void MoveObject(const PointF& from, const PointF& to);
+
+				// Redraws dirty pixels, up to the update budget.
+				void Update(const TileLayerList& layers);
+
+			private:
+				SizeI _size;
+				SizeI _tile_size;
+				float _scale;
+				size_t _update_budget;
+				tile_color_callback_type _tile_color;
+				std::unordered_map<TileLayer::tile_id_type, Color> _tile_colors;
+				std::vector<uint16_t> _object_counts;
+				std::vector<bool> _dirty;
+				std::vector<int> _dirty_pixels;
+				std::unique_ptr<Graphics::Bitmap> _bitmap;
+				std::vector<TileLayer::tile_id_type> _row;
+
+				// Returns the index of the pixel containing the given room position, or -1 if it's outside of the image.
+				int _pixelAt(float x, float y) const;
+				void _invalidatePixel(int index);
+				Color _computePixel(const TileLayerList& layers, int index);
+				const Color& _getTileColor(TileLayer::tile_id_type id);
+
+			};
+
+		}
+	}
+}
\ No newline at end of file
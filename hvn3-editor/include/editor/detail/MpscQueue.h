@@ -0,0 +1,101 @@
+#pragma once
+
+#include <atomic>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			// Base class for nodes that can be stored in an MpscQueue.
+			struct MpscQueueNode {
+				std::atomic<MpscQueueNode*> next;
+			};
+
+			// An intrusive, lock-free queue that any number of threads can push to, but only a single thread can pop from.
+			// Pushing never blocks or allocates. The queue doesn't own its nodes.
+			template <typename T>
+			class MpscQueue {
+
+			public:
+				MpscQueue() :
+					_head(&_stub),
+					_tail(&_stub) {
+
+					_stub.next.store(nullptr, std::memory_order_relaxed);
+
+				}
+				MpscQueue(const MpscQueue&) = delete;
+				MpscQueue& operator=(const MpscQueue&) = delete;
+
+				// Adds a node to the back of the queue. Can be called from any thread.
+				void Push(T* node) {
+					_push(node);
+				}
+				// Removes and returns the node at the front of the queue, or nullptr if the queue is empty (or a push is still in progress). Must only be called from the consumer thread.
+				T* Pop() {
+
+					MpscQueueNode* tail = _tail;
+					MpscQueueNode* next = tail->next.load(std::memory_order_acquire);
+
+					if (tail == &_stub) {
+
+						if (next == nullptr)
+							return nullptr;
+
+						_tail = next;
+						tail = next;
+						next = next->next.load(std::memory_order_acquire);
+
+					}
+
+					if (next != nullptr) {
+
+						_tail = next;
+
+						return static_cast<T*>(tail);
+
+					}
+
+					// The tail is the last node, unless another thread is in the middle of pushing.
+
+					if (tail != _head.load(std::memory_order_acquire))
+						return nullptr;
+
+					// Push the stub node so that the tail can be detached from the queue.
+
+					_push(&_stub);
+
+					next = tail->next.load(std::memory_order_acquire);
+
+					if (next != nullptr) {
+
+						_tail = next;
+
+						return static_cast<T*>(tail);
+
+					}
+
+					return nullptr;
+
+				}
+
+			private:
+				std::atomic<MpscQueueNode*> _head;
+				MpscQueueNode* _tail;
+				MpscQueueNode _stub;
+
+				void _push(MpscQueueNode* node) {
+
+					node->next.store(nullptr, std::memory_order_relaxed);
+
+					MpscQueueNode* previous = _head.exchange(node, std::memory_order_acq_rel);
+
+					previous->next.store(node, std::memory_order_release);
+
+				}
+
+			};
+
+		}
+	}
+}
\ No newline at end of file
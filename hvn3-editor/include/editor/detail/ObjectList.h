@@ -5,9 +5,17 @@
 #include "hvn3/objects/ObjectDefs.h"
 #include "hvn3/utility/Utf8String.h"
 
+#include "editor/PropertySchema.h"
+#include "editor/detail/PropertyIndex.h"
+#include "editor/detail/PropertyQuery.h"
+#include "editor/detail/SnapIndex.h"
+
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
 #include <unordered_map>
 #include <utility>
-#include <utility>
 #include <vector>
 
 namespace hvn3 {
@@ -39,25 +47,110 @@ namespace hvn3 {
 				typedef Item value_type;
 				typedef std::pair<String, String> property_pair_type;
 				typedef std::vector<property_pair_type> property_list_type;
+				typedef std::vector<value_type>::iterator iterator;
+				typedef std::function<bool(value_type&, const PointF&)> hit_test_type;
+				typedef std::function<void(const value_type&)> item_added_callback_type;
+				typedef std::function<void(const IObjectPtr&)> item_removed_callback_type;
+				// Returns the schema of the type with the given name, or nullptr if it doesn't have one.
+				typedef std::function<std::shared_ptr<const PropertySchema>(const String&)> schema_lookup_type;
+
+				ObjectList();
 
-				// Adds an object to the list.
+				// Adds an object to the list. If the object is already in the list, it's left as it is and its existing item is returned.
 				const value_type& Add(IObjectPtr object);
 				// Removes an object from the list.
 				void Remove(const IObjectPtr& object);
+				// Removes all objects for which the given function returns true. This is much faster than removing them one at a time.
+				void RemoveIf(const std::function<bool(const IObjectPtr&)>& predicate);
+				// Removes all objects from the list.
+				void Clear();
+				// Sets the function called after an object is added to the list.
+				void SetItemAddedCallback(item_added_callback_type&& callback);
+				// Sets the function called for each object removed from the list, including by RemoveIf and Clear. It's called while the list is being modified, so it shouldn't access the list.
+				void SetItemRemovedCallback(item_removed_callback_type&& callback);
+				// Sets the function used to find the schema of each object's type, by its "name" property. Properties in the schema are parsed as they're set, so that their typed values can be read with GetValues.
+				void SetSchemaLookup(schema_lookup_type&& lookup);
 				// Sets the value of the given property to the given object.
 				void SetProperty(const IObjectPtr& object, const String& name, const String& value);
 				// Sets the value of the given property to the given object.
 				void SetProperty(const IObject* object, const String& name, const String& value);
 
-				const property_list_type& GetProperties(const IObjectPtr& object) const;
-				const property_list_type& GetProperties(const IObject* object) const;
+				// Returns all of the object's properties, including the ones it gets from its prefab.
+				property_list_type GetProperties(const IObjectPtr& object) const;
+				// Returns all of the object's properties, including the ones it gets from its prefab.
+				property_list_type GetProperties(const IObject* object) const;
+				// Returns the value of the given property of the object, or nullptr if it doesn't have it. Unlike GetProperties, this doesn't copy the object's properties.
+				const String* GetProperty(const IObject* object, const String& name) const;
+				// Returns the typed values of the object's properties, which were parsed when they were set.
+				const PropertyValues& GetValues(const IObject* object) const;
+
+				// Defines a prefab, which is a named list of properties that instances share. Existing instances keep their properties when a prefab is redefined, and are stored as overrides of the new definition.
+				void SetPrefab(const String& name, const property_list_type& properties);
+				// Returns the properties of the given prefab, or nullptr if there's no such prefab.
+				const property_list_type* GetPrefab(const String& name) const;
+				// Returns the names of all prefabs, in alphabetical order.
+				std::vector<String> Prefabs() const;
+				// Makes the object an instance of the given prefab, replacing its properties with the prefab's. Returns false if there's no such prefab.
+				// Instances only store the properties they override with SetProperty, and read everything else from the prefab.
+				bool SetObjectPrefab(const IObject* object, const String& name);
+				// Returns the name of the prefab the object is an instance of, or nullptr if it isn't one.
+				const String* GetObjectPrefab(const IObject* object) const;
+				// Returns the object's properties with a "prefab" property in place of the ones it shares with its prefab. The "name" property is always included.
+				// This is how objects are stored in room files, pages and the clipboard, so that their size depends on the number of overridden properties rather than the number of instances.
+				property_list_type GetPackedProperties(const IObject* object) const;
+				// Sets properties returned by GetPackedProperties to the object. If the prefab they refer to doesn't exist, only the object's own properties are set.
+				void SetPackedProperties(const IObject* object, const property_list_type& properties);
+
+				// Returns the objects matching the given query, in the order they appear in the list.
+				std::vector<value_type> Query(const PropertyQuery& query) const;
+				// Returns the index of the objects' properties, which is kept up to date as objects and properties are added and removed.
+				const PropertyIndex& Index() const;
 
 				// Returns the topmost object whose bounding box contains the given position.
 				const value_type& Pick(const PointF& at);
+				// Returns the topmost object whose bounding box contains the given position and passes the given hit test.
+				// The hit test is only performed for objects whose bounding box contains the position.
+				const value_type& Pick(const PointF& at, const hit_test_type& hit_test);
+				// Clears the given index, and adds the bounding boxes of the objects positioned inside of the given region to it.
+				// Computing an object's bounding box requires drawing it the first time, so the region should be kept to the area that can be seen.
+				void BuildSnapIndex(const RectangleF& region, SnapIndex& index);
+
+				// Returns the number of objects in the list.
+				size_t Count() const;
+				// Returns a number that changes whenever objects are added to or removed from the list.
+				size_t Revision() const;
+
+				iterator begin();
+				iterator end();
 
 			private:
+				struct Prefab {
+					String name;
+					property_list_type properties;
+				};
+
+				struct ObjectProperties {
+					// The object's own properties. For instances of a prefab, these are only the ones whose values differ from the prefab's.
+					property_list_type overrides;
+					std::shared_ptr<const Prefab> prefab;
+					PropertyValues values;
+				};
+
 				std::vector<value_type> _items;
-				std::unordered_map<IObject*, property_list_type> _properties;
+				std::unordered_map<IObject*, ObjectProperties> _properties;
+				std::map<std::string, std::shared_ptr<const Prefab>> _prefabs;
+				PropertyIndex _index;
+				size_t _revision;
+				item_added_callback_type _item_added;
+				item_removed_callback_type _item_removed;
+				schema_lookup_type _schema_lookup;
+
+				// Calls the given function with the name and value of each of the object's properties, including the ones it gets from its prefab.
+				void _forEachProperty(const ObjectProperties& object_properties, const std::function<void(const String&, const String&)>& func) const;
+				const String* _getProperty(const ObjectProperties& object_properties, const String& name) const;
+				void _removeFromIndex(IObject* object, const ObjectProperties& object_properties);
+				// Parses all of the object's properties again, with the schema of its current type.
+				void _updateValues(ObjectProperties& object_properties);
 
 			};
 
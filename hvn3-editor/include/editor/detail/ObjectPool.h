@@ -0,0 +1,114 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			// Hands out fixed-size blocks of memory carved from large chunks, so that many objects of the same type can be created without going through the general-purpose allocator for each one.
+			// The block size is fixed by the first allocation. Freed blocks are reused, but chunks are only released when the pool is destroyed.
+			class ObjectPool {
+
+			public:
+				ObjectPool();
+				ObjectPool(const ObjectPool&) = delete;
+				~ObjectPool();
+
+				ObjectPool& operator=(const ObjectPool&) = delete;
+
+				// Returns a block of at least the given size, or nullptr if the pool's blocks are smaller than that. If this is the first allocation, the block size is set to the given size.
+				void* Allocate(size_t size);
+				// Returns a block allocated from this pool to it.
+				void Free(void* block);
+				// Returns true if blocks of the given size are allocated from this pool.
+				bool Fits(size_t size) const;
+				// Makes sure that at least the given number of blocks can be allocated without allocating another chunk. Does nothing until the block size has been set.
+				void Reserve(size_t count);
+
+				size_t BlockSize() const;
+				// Returns the number of blocks in use.
+				size_t Count() const;
+				// Returns the total number of blocks in all chunks.
+				size_t Capacity() const;
+
+			private:
+				static const size_t MIN_CHUNK_BLOCKS = 64;
+				static const size_t MAX_CHUNK_BLOCKS = 4096;
+
+				// Objects may be released on any thread holding the last reference to them.
+				mutable std::mutex _mutex;
+				size_t _block_size;
+				std::vector<void*> _chunks;
+				void* _free_list;
+				size_t _free_count;
+				size_t _capacity;
+
+				void _allocateChunk(size_t blocks);
+
+			};
+
+			// Allocates single objects from an ObjectPool, and anything else from the general-purpose allocator. It can be used with std::allocate_shared, in which case the object and its control block share a block.
+			template <typename T>
+			class PoolAllocator {
+
+				template <typename U>
+				friend class PoolAllocator;
+
+			public:
+				typedef T value_type;
+
+				PoolAllocator(const std::shared_ptr<ObjectPool>& pool) noexcept :
+					_pool(pool) {
+				}
+				template <typename U>
+				PoolAllocator(const PoolAllocator<U>& other) noexcept :
+					_pool(other._pool) {
+				}
+
+				T* allocate(size_t n) {
+
+					void* block = _usesPool(n) ? _pool->Allocate(sizeof(T)) : nullptr;
+
+					if (block == nullptr)
+						block = ::operator new(n * sizeof(T));
+
+					return static_cast<T*>(block);
+
+				}
+				void deallocate(T* p, size_t n) noexcept {
+
+					// The pool's block size never changes once set, so this makes the same choice allocate did.
+
+					if (_usesPool(n) && _pool->Fits(sizeof(T)))
+						_pool->Free(p);
+					else
+						::operator delete(p);
+
+				}
+
+				template <typename U>
+				bool operator==(const PoolAllocator<U>& other) const noexcept {
+					return _pool == other._pool;
+				}
+				template <typename U>
+				bool operator!=(const PoolAllocator<U>& other) const noexcept {
+					return _pool != other._pool;
+				}
+
+			private:
+				std::shared_ptr<ObjectPool> _pool;
+
+				bool _usesPool(size_t n) const noexcept {
+					return n == 1 && alignof(T) <= alignof(std::max_align_t);
+				}
+
+			};
+
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,100 @@
+#pragma once
+
+#include "hvn3/graphics/Bitmap.h"
+#include "hvn3/math/Point2d.h"
+#include "hvn3/math/Rectangle.h"
+
+#include "editor/detail/AlphaMask.h"
+#include "editor/detail/ObjectList.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace hvn3 {
+
+	namespace Graphics {
+		class Graphics;
+	}
+
+	namespace editor {
+		namespace detail {
+
+			// Draws the instances in an object list as batches of cached sprites, one batch per object type.
+			// Each type is drawn offscreen once, and instances are culled against the visible region using a uniform grid.
+			class ObjectRenderer {
+
+			public:
+				ObjectRenderer();
+
+				// Marks the spatial index as out of date, so that it's rebuilt from the whole object list on the next draw. This should only be called after many instances were changed at once, such as when a room is loaded.
+				void Invalidate();
+				// Adds an instance to the spatial index.
+				void Insert(ObjectList& objects, ObjectList::Item item);
+				// Moves an instance to the part of the spatial index covering its current position. This should be called whenever an instance is moved.
+				void Move(const IObject* object);
+				// Removes an instance from the spatial index.
+				void Remove(const IObject* object);
+				// Clears all cached sprites and the spatial index.
+				void Clear();
+
+				// Draws all instances that intersect the given region (in room coordinates). Instances are drawn at their room position multiplied by the scale, plus the given offset.
+				void Draw(Graphics::Graphics& graphics, ObjectList& objects, const RectangleF& region, const PointF& offset, float scale = 1.0f);
+
+				// Returns true if the given position (in room coordinates) lies on an opaque pixel of the given instance's sprite.
+				bool HitTest(ObjectList& objects, ObjectList::Item& item, const PointF& at);
+
+				// Returns the number of instances drawn during the last call to Draw.
+				size_t DrawnCount() const;
+				// Returns the number of batches submitted during the last call to Draw.
+				size_t BatchCount() const;
+
+			private:
+				struct Sprite {
+					// Null for objects that don't draw anything.
+					std::unique_ptr<Graphics::Bitmap> bitmap;
+					// Offset of the bitmap from the object's position.
+					PointF origin;
+					SizeF size;
+					int depth;
+					// Opaque pixels of the bitmap, built the first time an instance of this type is hit-tested.
+					AlphaMask mask;
+					bool has_mask;
+					// Positions of the visible instances of this type, collected anew every frame.
+					std::vector<PointF> batch;
+				};
+
+				struct GridEntry {
+					IObject* object;
+					Sprite* sprite;
+				};
+
+				static const int GRID_CELL_SIZE = 256;
+
+				std::unordered_map<std::string, Sprite> _sprites;
+				std::unordered_map<uint64_t, std::vector<GridEntry>> _grid;
+				// The grid cell each instance is in, so that it can be found without knowing where it was before it was moved.
+				std::unordered_map<const IObject*, uint64_t> _cells;
+				std::vector<Sprite*> _batches;
+				float _max_sprite_extent;
+				bool _grid_invalidated;
+				size_t _drawn_count;
+				size_t _batch_count;
+
+				void _rebuildGrid(ObjectList& objects);
+				// Removes the instance from the given cell, and returns its entry.
+				GridEntry _removeFromCell(const IObject* object, uint64_t key);
+				Sprite* _getSprite(ObjectList::Item& item, const String& type);
+				void _buildMask(Sprite& sprite);
+
+				static String _typeOf(const ObjectList& objects, const IObjectPtr& object);
+				static uint64_t _makeKey(int cell_x, int cell_y);
+				static int _cellCoordinate(float value);
+
+			};
+
+		}
+	}
+}
\ No newline at end of file
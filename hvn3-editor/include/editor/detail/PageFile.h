@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			// Stores the contents of a room as separate pages, so that any page can be read without reading the rest of the room.
+			// The file begins with a header, followed by the pages and an index recording where each page is stored. Saving appends the modified pages and a new index, and only updates the header once they've been written, so an interrupted save leaves the previous version intact.
+			// Pages that were replaced are left in the file until they take up more space than the pages in use, at which point the file is rewritten.
+			class PageFile {
+
+			public:
+				typedef std::unordered_map<uint64_t, std::vector<uint8_t>> page_map_type;
+
+				static const uint32_t VERSION = 1;
+
+				struct Location {
+					uint64_t offset;
+					uint32_t size;
+				};
+
+				PageFile();
+
+				// Opens the given file and reads its index. Returns false if the file doesn't exist or isn't valid.
+				bool Open(const std::string& file_path);
+				void Close();
+
+				bool IsOpen() const;
+				const std::string& Path() const;
+				// Returns the width and height of each page (in tiles).
+				int PageSize() const;
+				// Gets where the given page is stored. Returns false if the page isn't stored in the file.
+				bool GetLocation(uint64_t key, Location& location) const;
+				// Returns the keys of all pages stored in the file.
+				std::vector<uint64_t> Keys() const;
+
+				// Writes the given pages to the given file, replacing any stored pages with the same keys. Pages given without any data are removed.
+				// If the file isn't the one that's open, it's created with the given pages and the open file's other pages. Either way, the written file is open afterwards.
+				bool Write(const std::string& file_path, int page_size, const page_map_type& pages);
+
+				// Reads a page from the given file. This doesn't depend on any open file, so it can be used on any thread.
+				static bool Read(const std::string& file_path, const Location& location, std::vector<uint8_t>& data);
+
+			private:
+				struct Header {
+					char magic[4];
+					uint32_t version;
+					uint32_t page_size;
+					uint32_t page_count;
+					uint64_t index_offset;
+					// The total size of the pages that have been replaced (in bytes).
+					uint64_t unused_size;
+				};
+
+				struct IndexEntry {
+					uint64_t key;
+					uint64_t offset;
+					uint32_t size;
+					uint32_t reserved;
+				};
+
+				std::string _path;
+				int _page_size;
+				uint64_t _unused_size;
+				std::unordered_map<uint64_t, Location> _index;
+
+				bool _append(const page_map_type& pages);
+				bool _rewrite(const std::string& file_path, int page_size, const page_map_type& pages);
+
+			};
+
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace hvn3 {
+
+	class IObject;
+
+	namespace editor {
+		namespace detail {
+
+			// Maps the values of each property key to the objects that have them, so that objects can be found by their properties without visiting every object.
+			// Values are kept ordered, so that prefixes and ranges can be found without visiting every value. Values that are numbers are also indexed by their numeric value.
+			class PropertyIndex {
+
+			public:
+				enum class Comparison {
+					Equal,
+					NotEqual,
+					Less,
+					LessOrEqual,
+					Greater,
+					GreaterOrEqual
+				};
+
+				// Records that the given object has the given value for the given key.
+				void Add(IObject* object, const std::string& key, const std::string& value);
+				// Removes a value that was previously added for the given object.
+				void Remove(IObject* object, const std::string& key, const std::string& value);
+				void Clear();
+
+				// Appends every object whose value for the given key compares to the given value in the given way. Objects without the key never match.
+				// If the value is a number, values are compared numerically (non-numeric values never match). Otherwise, they're compared as strings, and '*' in the value matches any sequence of characters when comparing for (in)equality.
+				// The results are sorted by address and don't contain duplicates, as long as the results vector was empty.
+				void Find(const std::string& key, Comparison comparison, const std::string& value, std::vector<IObject*>& results) const;
+
+				// Returns the number of objects that have the given key.
+				size_t Count(const std::string& key) const;
+
+				// Parses the given string as a number. Returns false if it isn't one.
+				static bool ParseNumber(const std::string& value, double& number);
+				// Returns true if the given string matches the given pattern, where '*' matches any sequence of characters.
+				static bool Match(const char* pattern, const char* value);
+
+			private:
+				typedef std::unordered_set<IObject*> bucket_type;
+
+				struct KeyIndex {
+					std::map<std::string, bucket_type> values;
+					std::map<double, bucket_type> numbers;
+					size_t count;
+				};
+
+				std::unordered_map<std::string, KeyIndex> _keys;
+
+				void _findEqual(const KeyIndex& index, const std::string& value, std::vector<IObject*>& results) const;
+				void _findAll(const KeyIndex& index, std::vector<IObject*>& results) const;
+
+				template <typename IteratorType>
+				static void _append(IteratorType begin, IteratorType end, std::vector<IObject*>& results);
+
+			};
+
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "editor/detail/PropertyIndex.h"
+
+#include <string>
+#include <vector>
+
+namespace hvn3 {
+
+	class IObject;
+
+	namespace editor {
+		namespace detail {
+
+			// A query over object properties, such as "enemy and health > 50" or "name = door_*".
+			// A query is made up of conditions of the form "key op value", where op is one of =, !=, <, <=, > or >=, combined with "and" and "or" ("and" is applied first). A value on its own is compared to the "name" property, which holds the object's type.
+			// Values containing spaces or operators can be enclosed in double quotes.
+			class PropertyQuery {
+
+			public:
+				PropertyQuery();
+
+				// Parses the given query, replacing the current one. Returns false if the query isn't valid, in which case ErrorMessage describes the problem.
+				bool Parse(const std::string& query);
+				const std::string& ErrorMessage() const;
+				bool Empty() const;
+
+				// Returns the objects matching the query, sorted by address.
+				std::vector<IObject*> Execute(const PropertyIndex& index) const;
+
+			private:
+				struct Condition {
+					std::string key;
+					PropertyIndex::Comparison comparison;
+					std::string value;
+				};
+
+				struct Token {
+					enum class Type {
+						Value,
+						Operator,
+						And,
+						Or
+					} type;
+					std::string text;
+				};
+
+				// Groups of conditions that must all hold, any of which can match.
+				std::vector<std::vector<Condition>> _groups;
+				std::string _error_message;
+
+				bool _tokenize(const std::string& query, std::vector<Token>& tokens);
+
+				static bool _parseOperator(const std::string& text, PropertyIndex::Comparison& comparison);
+
+			};
+
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "hvn3/math/Point2d.h"
+#include "hvn3/math/Rectangle.h"
+#include "hvn3/math/Size.h"
+
+#include "editor/detail/JobSystem.h"
+#include "editor/detail/ObjectList.h"
+#include "editor/detail/PageFile.h"
+#include "editor/detail/TileLayer.h"
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			// Edits rooms that are too large to keep in memory all at once, by splitting them into square pages that are loaded and unloaded as the view moves.
+			// Each page holds the tile chunks and objects inside of it. Pages near the view are read and decoded on worker threads, then moved into the tile layers and object list on the main thread. Pages that are far away are taken back out, and if they were modified, encoded on a worker thread and kept until the next save.
+			// Tiles and objects can only be edited in pages that are resident, since anything written to other pages would be overwritten once they're loaded.
+			class RoomStreamer {
+
+			public:
+				// An object stored in a page.
+				struct PageObject {
+					PointF position;
+					ObjectList::property_list_type properties;
+				};
+
+				// Creates an object that was loaded from a page. The second argument is true if this is the first time the page has been loaded.
+				typedef std::function<void(const PageObject&, bool)> object_loaded_callback_type;
+				// Called after a page has been loaded, with the region it covers (in tiles). The second argument is true if this is the first time the page has been loaded.
+				typedef std::function<void(const RectangleI&, bool)> page_loaded_callback_type;
+				// Called after a page has been unloaded, with the region it covers (in room coordinates).
+				typedef std::function<void(const RectangleF&)> page_evicted_callback_type;
+				// Called with the layer, the chunk coordinates and the contents of a chunk.
+				typedef std::function<void(int, int, int, const TileLayer::Chunk&)> chunk_callback_type;
+				// Called with an object stored in a page.
+				typedef std::function<void(const PageObject&)> object_callback_type;
+
+				// The width and height of each page (in chunks and in tiles).
+				static const int PAGE_CHUNKS = 4;
+				static const int PAGE_SIZE = PAGE_CHUNKS * TileLayer::CHUNK_SIZE;
+				// Rooms covering at least this many pages are large enough to be worth streaming.
+				static const int MIN_STREAMED_PAGES = 64;
+
+				RoomStreamer(JobSystem& jobs, TileLayerList& layers, ObjectList& objects);
+				RoomStreamer(const RoomStreamer&) = delete;
+				RoomStreamer& operator=(const RoomStreamer&) = delete;
+
+				// Starts streaming a room from the given page file. The tile layers and object list should be empty.
+				bool Open(const std::string& file_path, const SizeI& tile_size);
+				// Starts streaming the room that's currently in the tile layers and object list. All of it is considered modified, so it's written in full on the next save.
+				void Attach(const SizeI& tile_size);
+				// Stops streaming. Modifications that haven't been saved are lost.
+				void Close();
+
+				bool IsOpen() const;
+				// Returns the path of the page file, which is empty until the room has been saved.
+				const std::string& FilePath() const;
+				// Sets the maximum number of pages kept in memory.
+				void SetCapacity(size_t pages);
+				void SetObjectLoadedCallback(object_loaded_callback_type&& callback);
+				void SetPageLoadedCallback(page_loaded_callback_type&& callback);
+				void SetPageEvictedCallback(page_evicted_callback_type&& callback);
+
+				// Starts loading the pages covering the given region (in room coordinates) and the pages around them, and unloads the least recently used pages outside of it once there are too many.
+				void Update(const RectangleF& region);
+
+				// Returns true if the page containing the given tile is in memory and can be edited.
+				bool IsResident(int tile_x, int tile_y) const;
+				// Returns true if the page containing the given room position is in memory and can be edited.
+				bool IsResident(const PointF& position) const;
+				// Marks the page containing the given tile as modified, so that it's written on the next save.
+				void MarkModified(int tile_x, int tile_y);
+				// Marks the page containing the given room position as modified, so that it's written on the next save.
+				void MarkModified(const PointF& position);
+
+				// Calls the given functions for each chunk and object in the pages that aren't in memory, which are read and decoded one at a time. Either function can be null. The contents of resident pages are in the tile layers and object list instead.
+				// Returns false if any of the pages couldn't be read.
+				bool ForEachUnloaded(const chunk_callback_type& chunk_func, const object_callback_type& object_func);
+
+				// Writes all modified pages to the given file. If it isn't the file being streamed from, the other pages are copied to it, and it's streamed from afterwards.
+				bool Save(const std::string& file_path);
+
+				// Returns the number of pages in memory.
+				size_t ResidentCount() const;
+				// Returns the number of pages being loaded.
+				size_t LoadingCount() const;
+
+				// Returns true if a room with the given number of columns and rows is large enough to be worth streaming. Rooms are only streamed when the user asks for it, but this is used to suggest it.
+				static bool IsLargeRoom(int columns, int rows);
+
+			private:
+				enum class PageState {
+					Loading,
+					Resident,
+					// The page has been removed from memory, but hasn't finished being encoded yet.
+					Evicting
+				};
+
+				struct Page {
+					PageState state;
+					bool modified;
+					JobPtr job;
+					std::list<uint64_t>::iterator lru_iter;
+				};
+
+				struct PageChunk {
+					int layer;
+					int x;
+					int y;
+					std::unique_ptr<TileLayer::Chunk> chunk;
+				};
+
+				struct PageContents {
+					std::vector<PageChunk> chunks;
+					std::vector<PageObject> objects;
+				};
+
+				JobSystem& _jobs;
+				TileLayerList& _layers;
+				ObjectList& _objects;
+				PageFile _file;
+				bool _open;
+				SizeI _tile_size;
+				size_t _capacity;
+				std::unordered_map<uint64_t, Page> _pages;
+				// Resident and loading pages, from most to least recently used.
+				std::list<uint64_t> _lru;
+				// Encoded pages that were modified and unloaded since the last save. Empty pages are stored without any data.
+				std::unordered_map<uint64_t, std::shared_ptr<std::vector<uint8_t>>> _modified;
+				// Pages that have been loaded at least once.
+				std::unordered_set<uint64_t> _loaded_pages;
+				// Pages whose data couldn't be read. They're never loaded, so that they can't be overwritten.
+				std::unordered_set<uint64_t> _unreadable_pages;
+				object_loaded_callback_type _object_loaded;
+				page_loaded_callback_type _page_loaded;
+				page_evicted_callback_type _page_evicted;
+
+				void _load(uint64_t key);
+				void _evict(uint64_t key);
+				void _applyPage(uint64_t key, PageContents& contents);
+				// Collects the contents of a resident page. If remove is true, they're removed from the tile layers and object list.
+				PageContents _collectPage(uint64_t key, bool remove);
+				// Blocks until all pages being loaded or unloaded are done.
+				void _wait();
+				RectangleI _pageTiles(uint64_t key) const;
+				RectangleF _pageBounds(uint64_t key) const;
+				uint64_t _pageAt(const PointF& position) const;
+
+				static void _encode(const PageContents& contents, std::vector<uint8_t>& data);
+				static bool _decode(const std::vector<uint8_t>& data, PageContents& contents);
+				static uint64_t _makeKey(int page_x, int page_y);
+				static int _pageX(uint64_t key);
+				static int _pageY(uint64_t key);
+				static int _floorDivide(int value, int divisor);
+
+			};
+
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,78 @@
+#pragma once
+
+#include "hvn3/math/Point2d.h"
+
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			// Generates positions for objects painted with a circular brush, using Poisson-disk sampling so that no two positions are closer than the minimum spacing.
+			// Positions are kept in a grid where each cell can hold at most one of them, so checking a candidate only requires looking at the cells around it. Positions are remembered across strokes until the brush is cleared, so painting over the same area again doesn't place objects on top of each other.
+			class ScatterBrush {
+
+			public:
+				// Returns true if an object can be placed at the given position.
+				typedef std::function<bool(const PointF&)> accept_callback_type;
+
+				ScatterBrush();
+
+				// Sets the radius of the brush (in pixels).
+				void SetRadius(float radius);
+				// Sets the minimum distance between positions (in pixels). Changing the spacing clears the brush.
+				void SetSpacing(float spacing);
+				// Sets the fraction of the positions that are kept, between 0 and 1. At 1, the brush is filled as densely as the spacing allows.
+				void SetDensity(float density);
+				float Radius() const;
+				float Spacing() const;
+				float Density() const;
+
+				// Starts a new stroke at the given position, and stamps the brush there.
+				void BeginStroke(const PointF& position, const accept_callback_type& accept, std::vector<PointF>& results);
+				// Continues the current stroke to the given position, stamping the brush along the way. Does nothing if a stroke hasn't been started.
+				void ContinueStroke(const PointF& position, const accept_callback_type& accept, std::vector<PointF>& results);
+				void EndStroke();
+				bool InStroke() const;
+				// Forgets all positions generated so far.
+				void Clear();
+
+			private:
+				// The number of candidates generated around each position before giving up on it.
+				static const int MAX_ATTEMPTS = 30;
+
+				struct Cell {
+					PointF position;
+					// True if no more positions fit around this one, so it doesn't need to be tried again by later stamps.
+					bool closed;
+				};
+
+				float _radius;
+				float _spacing;
+				float _density;
+				float _cell_size;
+				bool _in_stroke;
+				PointF _last_stamp;
+				// Positions generated by the brush, including those thinned out by the density, so that they keep their spacing.
+				std::unordered_map<uint64_t, Cell> _grid;
+				// Cells that new positions can still be grown from during the current stamp.
+				std::vector<uint64_t> _active;
+				std::mt19937 _random;
+
+				// Fills the brush centered at the given position.
+				void _stamp(const PointF& center, const accept_callback_type& accept, std::vector<PointF>& results);
+				// Adds the given position to the grid and returns the key of its cell, and appends the position to the results if it's kept.
+				uint64_t _insert(const PointF& position, std::vector<PointF>& results);
+				bool _isFarEnough(const PointF& position) const;
+				uint64_t _cellKey(int x, int y) const;
+				int _cellIndex(float value) const;
+
+			};
+
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "hvn3/math/Rectangle.h"
+#include "hvn3/objects/ObjectDefs.h"
+
+#include <vector>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			// Keeps the edges and centers of objects' bounding boxes sorted along each axis, so that the ones closest to a dragged object can be found with a binary search.
+			class SnapIndex {
+
+			public:
+				struct Edge {
+					// The position of the edge along the axis it was found on.
+					float value;
+					// The extent of the object's bounding box along the other axis, used for drawing guides.
+					float from;
+					float to;
+					const IObject* object;
+				};
+
+				SnapIndex();
+
+				// Adds the edges and center of the given bounding box along both axes. Build must be called after adding objects, before searching.
+				void Add(const IObject* object, const RectangleF& bounds);
+				void Build();
+				void Clear();
+				bool Empty() const;
+
+				// Finds the vertical edge (left, center or right) closest to any of the given x-coordinates, ignoring the given object. Returns false if none are within the tolerance.
+				// On success, delta is the distance to move by to line up with the edge, and edge is the edge that was found.
+				bool FindX(const float* values, size_t count, float tolerance, const IObject* ignore, float& delta, Edge& edge) const;
+				// Finds the horizontal edge (top, center or bottom) closest to any of the given y-coordinates, ignoring the given object. Returns false if none are within the tolerance.
+				bool FindY(const float* values, size_t count, float tolerance, const IObject* ignore, float& delta, Edge& edge) const;
+
+			private:
+				std::vector<Edge> _x_edges;
+				std::vector<Edge> _y_edges;
+
+				static bool _find(const std::vector<Edge>& edges, const float* values, size_t count, float tolerance, const IObject* ignore, float& delta, Edge& edge);
+
+			};
+
+		}
+	}
+}
\ No newline at end of file
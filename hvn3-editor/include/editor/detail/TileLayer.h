@@ -0,0 +1,150 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			// Sparse tile storage for a single layer. Tiles are grouped into fixed-size square chunks that are only allocated once they contain a non-empty tile.
+			class TileLayer {
+
+			public:
+				typedef uint32_t tile_id_type;
+
+				// The width and height of each chunk (in tiles).
+				static const int CHUNK_SIZE = 32;
+				static const int CHUNK_AREA = CHUNK_SIZE * CHUNK_SIZE;
+
+				class Chunk {
+
+				public:
+					Chunk();
+
+					tile_id_type At(int x, int y) const;
+					// Sets the tile at the given chunk-local position. Returns true if the value changed.
+					bool SetTile(int x, int y, tile_id_type id);
+					// Returns the number of non-empty tiles in the chunk.
+					int Count() const;
+					// Replaces every tile in the range [first_id, last_id] with the given tile. Returns the number of tiles that changed.
+					int Replace(tile_id_type first_id, tile_id_type last_id, tile_id_type replacement);
+					// Adds the number of times each non-empty tile appears in the chunk to the given counts, which are indexed by tile and grown as needed.
+					void CountTiles(std::vector<uint32_t>& counts) const;
+					// Appends the index (y * CHUNK_SIZE + x) of every tile in the range [first_id, last_id] to the given list. Returns the number of tiles found.
+					int FindTiles(tile_id_type first_id, tile_id_type last_id, std::vector<int>* indices) const;
+					// Returns true if tiles are stored using 16 bits each.
+					bool IsNarrow() const;
+					size_t MemoryUsage() const;
+
+				private:
+					// Tiles are stored as 16-bit indices until an index that doesn't fit is written, at which point the chunk is widened to 32 bits.
+					std::vector<uint16_t> _narrow;
+					std::vector<uint32_t> _wide;
+					int _count;
+
+					void _widen();
+
+				};
+
+				typedef std::unordered_map<uint64_t, std::unique_ptr<Chunk>> chunk_map_type;
+
+				TileLayer();
+				TileLayer(TileLayer&& other) = default;
+				TileLayer& operator=(TileLayer&& other) = default;
+
+				// Returns the tile at the given position, or 0 if the position is empty.
+				tile_id_type At(int x, int y) const;
+				// Sets the tile at the given position. Returns true if the value changed.
+				bool SetTile(int x, int y, tile_id_type id);
+				// Copies a horizontal run of tiles into the given buffer. This only looks up each chunk once, which makes it much faster than calling At for every tile.
+				void ReadRow(int x, int y, int count, tile_id_type* out) const;
+				// Replaces every tile in the range [first_id, last_id] with the given tile, and appends the coordinates of each chunk that changed to the given list. Returns the number of tiles that changed.
+				// Empty tiles are only replaced inside of allocated chunks.
+				size_t ReplaceTiles(tile_id_type first_id, tile_id_type last_id, tile_id_type replacement, std::vector<std::pair<int, int>>* changed_chunks = nullptr);
+				// Adds the number of times each non-empty tile appears in the layer to the given counts, which are indexed by tile and grown as needed.
+				void CountTiles(std::vector<uint32_t>& counts) const;
+				// Appends the position of every tile in the range [first_id, last_id] to the given list. Returns the number of tiles found.
+				size_t FindTiles(tile_id_type first_id, tile_id_type last_id, std::vector<std::pair<int, int>>& positions) const;
+				// Removes all tiles from the layer.
+				void Clear();
+
+				// Returns the number of allocated chunks.
+				size_t ChunkCount() const;
+				// Returns the approximate number of bytes used by the layer.
+				size_t MemoryUsage() const;
+
+				// Returns the chunk at the given chunk coordinates, or nullptr if the chunk is empty.
+				const Chunk* GetChunk(int chunk_x, int chunk_y) const;
+				// Replaces the chunk at the given chunk coordinates. Empty chunks are discarded.
+				void SetChunk(int chunk_x, int chunk_y, std::unique_ptr<Chunk> chunk);
+				// Removes the chunk at the given chunk coordinates from the layer and returns it, or returns nullptr if the chunk is empty.
+				std::unique_ptr<Chunk> TakeChunk(int chunk_x, int chunk_y);
+
+				// Calls the given function for each allocated chunk with its chunk coordinates.
+				template<typename FunctionType>
+				void ForEachChunk(FunctionType&& func) const;
+
+				// Encodes the contents of a chunk as a run-length encoded string ("count*id" pairs separated by commas).
+				static std::string EncodeChunk(const Chunk& chunk);
+				// Decodes a string created with EncodeChunk and writes its contents into the chunk at the given chunk coordinates. Returns false (leaving the layer unchanged) if the string isn't valid.
+				bool DecodeChunk(int chunk_x, int chunk_y, const std::string& data);
+				// Decodes a string created with EncodeChunk into the given chunk. Unlike the above, this doesn't touch a layer, so it can be used on any thread. Returns false if the string isn't valid.
+				static bool DecodeChunk(const std::string& data, Chunk& chunk);
+
+			private:
+				chunk_map_type _chunks;
+				size_t _chunk_memory_usage;
+
+				static uint64_t _makeKey(int chunk_x, int chunk_y);
+				static int _chunkCoordinate(int value);
+				static int _localCoordinate(int value);
+
+			};
+
+			// An ordered list of tile layers. Layers are created on demand when written to.
+			class TileLayerList {
+
+			public:
+				// The maximum number of layers, which also bounds the depths read from room files.
+				static const int MAX_LAYERS = 256;
+
+				TileLayerList();
+
+				// Returns the layer at the given index, creating it (and any layers before it) if it does not exist.
+				TileLayer& GetOrCreateLayer(int index);
+				// Returns the layer at the given index, or nullptr if it does not exist.
+				TileLayer* FindLayer(int index);
+				const TileLayer* FindLayer(int index) const;
+				int Count() const;
+
+				TileLayer::tile_id_type At(int x, int y, int layer) const;
+				// Sets the tile at the given position on the given layer. Returns true if the value changed.
+				bool SetTile(int x, int y, TileLayer::tile_id_type id, int layer);
+				// Removes all layers except for the first, which is cleared.
+				void Clear();
+
+				// Returns the approximate number of bytes used by all layers.
+				size_t MemoryUsage() const;
+
+			private:
+				std::vector<TileLayer> _layers;
+
+			};
+
+			template<typename FunctionType>
+			void TileLayer::ForEachChunk(FunctionType&& func) const {
+
+				for (auto i = _chunks.begin(); i != _chunks.end(); ++i)
+					func(static_cast<int>(static_cast<int32_t>(i->first >> 32)), static_cast<int>(static_cast<int32_t>(i->first & 0xFFFFFFFF)), *i->second);
+
+			}
+
+		}
+	}
+}
\ No newline at end of file
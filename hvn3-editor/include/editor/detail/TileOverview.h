@@ -0,0 +1,90 @@
+#pragma once
+
+#include "hvn3/graphics/Bitmap.h"
+#include "hvn3/math/Point2d.h"
+#include "hvn3/math/Rectangle.h"
+
+#include "editor/detail/TileLayer.h"
+
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+namespace hvn3 {
+
+	namespace Graphics {
+		class Graphics;
+	}
+
+	namespace editor {
+		namespace detail {
+
+			// Caches downsampled images of tile layers for drawing rooms while zoomed out.
+			// Each zoom level halves the scale of the previous one. At every level, the room is split into square images of the same pixel size, so the number of images visible at once doesn't depend on the zoom level.
+			// Images are built on demand, kept up to date as tiles change, and evicted in least-recently-used order.
+			class TileOverview {
+
+			public:
+				// Draws the given tile at the given position and scale.
+				typedef std::function<void(Graphics::Graphics&, TileLayer::tile_id_type, float, float, float)> draw_tile_callback_type;
+
+				// The width and height of each image (in pixels).
+				static const int IMAGE_SIZE = 256;
+				static const int MAX_LEVEL = 5;
+
+				TileOverview();
+
+				void SetTileSize(const SizeI& tile_size);
+				void SetDrawTileCallback(draw_tile_callback_type&& callback);
+				// Sets the maximum number of images that are kept in memory.
+				void SetCapacity(size_t capacity);
+				// Sets the maximum number of images that can be built during a single call to Draw. Images that aren't ready yet are skipped until a later frame.
+				void SetBuildBudget(int budget);
+
+				// Removes all cached images.
+				void Clear();
+				// Updates the cached images containing the given tile.
+				void UpdateTile(const TileLayerList& layers, int x, int y, int layer);
+				// Marks the cached images containing any tile in the given range as needing to be rebuilt. This should be called when the appearance of those tiles changes.
+				void InvalidateTiles(const TileLayerList& layers, TileLayer::tile_id_type first_id, TileLayer::tile_id_type last_id);
+				// Marks the cached images covering any part of the given region (in tiles) as needing to be rebuilt.
+				void InvalidateRegion(const TileLayerList& layers, const RectangleI& tiles);
+
+				// Draws all layers at the given level (where the scale is 1 / 2^level) for the given region (in room coordinates). Tiles are drawn at their room position multiplied by the scale, plus the given offset.
+				void Draw(Graphics::Graphics& graphics, const TileLayerList& layers, int level, const RectangleF& region, const PointF& offset);
+
+				// Returns the number of images currently cached.
+				size_t Count() const;
+
+			private:
+				struct Image {
+					std::unique_ptr<Graphics::Bitmap> bitmap;
+					// True if the image needs to be rebuilt before it's drawn.
+					bool invalidated;
+					std::list<uint64_t>::iterator lru_iter;
+				};
+
+				SizeI _tile_size;
+				draw_tile_callback_type _draw_tile;
+				size_t _capacity;
+				int _build_budget;
+				std::unordered_map<uint64_t, Image> _images;
+				std::list<uint64_t> _lru;
+
+				Image* _getImage(const TileLayerList& layers, int layer, int level, int image_x, int image_y, int& build_budget);
+				void _buildImage(Image& image, const TileLayer& layer, int level, int image_x, int image_y);
+				void _drawTiles(Graphics::Graphics& graphics, const TileLayer& layer, float scale, int first_x, int first_y, int last_x, int last_y, const PointF& offset);
+				void _evict();
+				// Returns the size of the region covered by a single image at the given level (in tiles).
+				SizeI _imageTileCount(int level) const;
+
+				static uint64_t _makeKey(int layer, int level, int image_x, int image_y);
+				static int _floorDivide(int value, int divisor);
+
+			};
+
+		}
+	}
+}
\ No newline at end of file
@@ -24,6 +24,7 @@ namespace hvn3 {
 		public:
 			RoomEditorBackgroundsWidget(RoomEditor* editor);
 
+			const std::vector<Background>& Backgrounds() const;
 			String GetIdByBackground(const Background& background) const;
 			const Background* GetBackgroundById(const String& id) const;
 			void AddBackground(const String& id, const Background& background);
@@ -0,0 +1,75 @@
+#pragma once
+#include "hvn3/gui2/Window.h"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace hvn3 {
+
+	namespace Gui {
+		class ListBox;
+		class TextBox;
+	}
+
+	namespace editor {
+
+		// A list that can hold any number of items, with a text box for filtering them by prefix.
+		// Rows are only created for as many items as fit in the list, and are filled in with the text of whichever items are scrolled into view, so the cost of drawing the list doesn't depend on the number of items.
+		class RoomEditorListWidget :
+			public Gui::Window {
+
+		public:
+			typedef std::function<String(size_t)> item_text_callback_type;
+			typedef std::function<void(size_t)> selected_item_changed_callback_type;
+
+			static const size_t NO_ITEM;
+
+			RoomEditorListWidget();
+
+			// Sets the number of items, and the function used to get the text of the item at each index. The text is only requested for items that are scrolled into view, and for filtering.
+			// The current filter is applied to the new items, and the selection is cleared.
+			void SetItems(size_t count, item_text_callback_type&& callback);
+			// Inserts the given number of items at the given index, moving the items after them down. Only the new items are checked against the filter.
+			void Insert(size_t index, size_t count);
+			// Removes the items at the given indices, which must be sorted in ascending order, moving the items after them up.
+			void Remove(const std::vector<size_t>& items);
+			// Sets the function called when the user selects an item, with the index of the item.
+			void SetSelectedItemChangedCallback(selected_item_changed_callback_type&& callback);
+
+			// Returns the index of the selected item, or NO_ITEM if no item is selected.
+			size_t SelectedItem() const;
+			// Returns the number of items.
+			size_t Count() const;
+			// Returns the number of items that match the filter.
+			size_t FilteredCount() const;
+			// Scrolls the list by the given number of rows.
+			void Scroll(int rows);
+
+			void OnUpdate(Gui::WidgetUpdateEventArgs& e) override;
+
+		private:
+			Gui::TextBox* _filter_textbox;
+			Gui::ListBox* _rows;
+			size_t _count;
+			item_text_callback_type _item_text;
+			selected_item_changed_callback_type _selected_item_changed;
+			// Indices of the items that match the filter.
+			std::vector<size_t> _filtered;
+			// The lowercase filter that _filtered was built from.
+			std::string _filter;
+			size_t _first_row;
+			size_t _visible_rows;
+			size_t _selected_item;
+			bool _block_selection_update;
+
+			// Updates the filtered items. If the new filter begins with the current one, only the items that matched the current filter are checked.
+			void _applyFilter(const std::string& filter, bool incremental);
+			// Fills the rows with the text of the items in view.
+			void _updateRows();
+			bool _matchesFilter(size_t item, const std::string& filter) const;
+
+		};
+
+	}
+}
\ No newline at end of file
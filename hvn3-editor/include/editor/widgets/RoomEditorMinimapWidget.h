@@ -0,0 +1,36 @@
+#pragma once
+#include "hvn3/gui2/WidgetBase.h"
+
+#include "editor/detail/Minimap.h"
+
+namespace hvn3 {
+	namespace editor {
+
+		class RoomEditor;
+
+		// Shows a low-resolution overview of the whole room, along with the region visible in the room view. Clicking on it moves the room view to the clicked position.
+		class RoomEditorMinimapWidget :
+			public Gui::WidgetBase {
+
+		public:
+			RoomEditorMinimapWidget(RoomEditor* editor);
+
+			detail::Minimap& Minimap();
+
+			void OnDraw(Gui::WidgetDrawEventArgs& e) override;
+			void OnUpdate(Gui::WidgetUpdateEventArgs& e) override;
+			void OnMouseDown(Gui::WidgetMouseDownEventArgs& e) override;
+
+		private:
+			RoomEditor* _editor;
+			detail::Minimap _minimap;
+
+			// Returns the scale at which the room is drawn so that it fits inside of the widget.
+			float _roomScale() const;
+			// Returns the display position of the room's top-left corner.
+			PointF _roomOffset() const;
+
+		};
+
+	}
+}
\ No newline at end of file
@@ -0,0 +1,24 @@
+#pragma once
+#include "hvn3/gui2/RoomView.h"
+
+namespace hvn3 {
+	namespace editor {
+
+		class RoomEditor;
+
+		// The view the room is edited in. The room and everything drawn over it are drawn along with the widget, so that menus and other widgets drawn after it stay on top.
+		class RoomEditorRoomViewWidget :
+			public Gui::RoomView {
+
+		public:
+			RoomEditorRoomViewWidget(RoomEditor* editor);
+
+			void OnDraw(Gui::WidgetDrawEventArgs& e) override;
+
+		private:
+			RoomEditor* _editor;
+
+		};
+
+	}
+}
\ No newline at end of file
@@ -14,10 +14,13 @@ namespace hvn3 {
 
 			void PopText(const String& text);
 			void SetText(const String& text) override;
+			// Sets the text shown for background work, such as the progress of jobs. Hidden if empty.
+			void SetProgressText(const String& text);
 			void OnUpdate(Gui::WidgetUpdateEventArgs& e) override;
 
 		private:
 			Gui::Label* _label;
+			Gui::Label* _progress_label;
 			String _temp_text;
 			Graphics::Tween<float> _pop_animation;
 
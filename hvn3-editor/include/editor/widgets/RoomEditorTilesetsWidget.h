@@ -2,12 +2,16 @@
 #include "hvn3/gui2/Window.h"
 #include "hvn3/tilesets/Tileset.h"
 
+#include "editor/detail/AutoTiler.h"
+#include "editor/detail/TileLayer.h"
+
 #include <vector>
 
 namespace hvn3 {
 
 	namespace Gui {
 		class ContextMenu;
+		class ContextMenuItem;
 		class TilesetView;
 	}
 
@@ -27,14 +31,41 @@ namespace hvn3 {
 			Tileset* GetTilesetById(const String& id);
 			void AddTileset(const Tileset& tileset, const String& id);
 
+			// Returns the auto-tiling rules for the given tileset, or nullptr if the tileset hasn't been added.
+			detail::AutoTiler* GetAutoTilerByTileset(const Tileset& tileset);
+			// Returns true if auto-tiling should be applied when placing tiles.
+			bool AutoTilingEnabled() const;
+
+			// Returns the index of the layer that tiles are currently placed on.
+			int CurrentLayer() const;
+			void SetCurrentLayer(int layer);
+			// Adds menu items for any layers that don't have one yet, removes the items of layers that no longer exist, and updates the memory usage shown for each layer.
+			// Called when layers are created or removed, and when the layers menu is opened.
+			void UpdateLayers();
+
 		private:
 			RoomEditor* _editor;
 			Gui::ContextMenu* tilesets_context_menu;
 			Gui::ContextMenu* layers_context_menu;
+			Gui::ContextMenu* autotile_context_menu;
+			Gui::ContextMenu* find_context_menu;
 			Gui::TilesetView* tileset_view;
 			std::vector<Tileset> _tilesets;
+			std::vector<detail::AutoTiler> _auto_tilers;
+			bool _auto_tiling_enabled;
+			std::vector<Gui::ContextMenuItem*> _layer_items;
+			int _current_layer;
 
 			void _openTileset();
+			void _addLayer();
+			void _addTerrainFromSelection(detail::AutoTiler::Layout layout);
+			void _applyAutoTilingToLayer();
+			// Returns the top-left tile of the selection in the tileset view, or 0 if there is no tileset.
+			detail::TileLayer::tile_id_type _selectedTile() const;
+			void _selectMatchingTiles();
+			void _showReplaceTilesDialog();
+			void _showTileUsageDialog();
+			void _loadTilesetMetadata(const String& id, const Tileset& tileset, detail::AutoTiler& auto_tiler);
 
 		};
 
@@ -2,19 +2,220 @@
 
 #include "editor/ObjectRegistry.h"
 
+#include <algorithm>
+#include <cctype>
+#include <limits>
+
 namespace hvn3 {
 	namespace editor {
 
+		const ObjectRegistry::type_id_type ObjectRegistry::INVALID_TYPE_ID = std::numeric_limits<ObjectRegistry::type_id_type>::max();
+
+		ObjectRegistry::type_id_type ObjectRegistry::GetTypeId(const std::string& name) const {
+
+			auto id_iter = _ids.find(name);
+
+			return id_iter == _ids.end() ? INVALID_TYPE_ID : id_iter->second;
+
+		}
+		const std::string& ObjectRegistry::GetName(type_id_type id) const {
+
+			static const std::string empty;
+
+			return id < _types.size() ? _types[id].name : empty;
+
+		}
+		const std::string& ObjectRegistry::GetCategory(type_id_type id) const {
+
+			static const std::string empty;
+
+			return id < _types.size() ? _types[id].category : empty;
+
+		}
+		const PropertySchema& ObjectRegistry::GetSchema(type_id_type id) const {
+
+			static const PropertySchema empty;
+
+			return id < _types.size() ? *_types[id].schema : empty;
+
+		}
+		std::shared_ptr<const PropertySchema> ObjectRegistry::GetSharedSchema(type_id_type id) const {
+
+			if (id >= _types.size() || _types[id].schema->Empty())
+				return nullptr;
+
+			return _types[id].schema;
+
+		}
+		size_t ObjectRegistry::Count() const {
+			return _types.size();
+		}
+		const std::vector<ObjectRegistry::type_id_type>& ObjectRegistry::Types() const {
+			return _sorted;
+		}
+		std::vector<std::string> ObjectRegistry::Categories() const {
+
+			std::vector<std::string> categories;
+
+			for (auto i = _categories.begin(); i != _categories.end(); ++i)
+				categories.push_back(i->first);
+
+			return categories;
+
+		}
+		void ObjectRegistry::FindByPrefix(const std::string& prefix, std::vector<type_id_type>& results) const {
+
+			// Types whose names begin with the prefix are next to each other in the sorted index.
+
+			std::string key = _toLower(prefix);
+
+			auto first = std::lower_bound(_sorted.begin(), _sorted.end(), key, [this](type_id_type lhs, const std::string& rhs) {
+				return _types[lhs].key < rhs;
+			});
+
+			for (auto i = first; i != _sorted.end() && _types[*i].key.compare(0, key.size(), key) == 0; ++i)
+				results.push_back(*i);
+
+		}
+		void ObjectRegistry::FindBySubstring(const std::string& substring, std::vector<type_id_type>& results) const {
+
+			std::string key = _toLower(substring);
+
+			for (auto i = _sorted.begin(); i != _sorted.end(); ++i)
+				if (_types[*i].key.find(key) != std::string::npos)
+					results.push_back(*i);
+
+		}
+		void ObjectRegistry::FindByCategory(const std::string& category, std::vector<type_id_type>& results) const {
+
+			auto category_iter = _categories.find(category);
+
+			if (category_iter != _categories.end())
+				results.insert(results.end(), category_iter->second.begin(), category_iter->second.end());
+
+		}
 		IObjectPtr ObjectRegistry::MakeObject(const std::string& key) const {
 
-			return _registry.at(key)->New();
+			return MakeObject(GetTypeId(key));
+
+		}
+		IObjectPtr ObjectRegistry::MakeObject(type_id_type id) const {
+
+			if (id >= _types.size())
+				return nullptr;
+
+			return _types[id].item->New();
 
 		}
-		ObjectRegistry::registry_type::iterator ObjectRegistry::begin() {
-			return _registry.begin();
+		void ObjectRegistry::MakeObjects(type_id_type id, size_t count, std::vector<IObjectPtr>& results) const {
+
+			if (id >= _types.size() || count == 0)
+				return;
+
+			const IObjectRegistryItem& item = *_types[id].item;
+
+			item.Reserve(count);
+			results.reserve(results.size() + count);
+
+			for (size_t i = 0; i < count; ++i)
+				results.push_back(item.New());
+
+		}
+		void ObjectRegistry::MakeObjects(const std::string& key, size_t count, std::vector<IObjectPtr>& results) const {
+
+			MakeObjects(GetTypeId(key), count, results);
+
+		}
+		void ObjectRegistry::CloneObjects(type_id_type id, const IObject& prototype, size_t count, std::vector<IObjectPtr>& results) const {
+
+			if (id >= _types.size() || count == 0)
+				return;
+
+			const IObjectRegistryItem& item = *_types[id].item;
+
+			item.Reserve(count);
+			results.reserve(results.size() + count);
+
+			for (size_t i = 0; i < count; ++i)
+				results.push_back(item.Clone(prototype));
+
 		}
-		ObjectRegistry::registry_type::iterator ObjectRegistry::end() {
-			return _registry.end();
+
+		void ObjectRegistry::_register(const std::string& name, const std::string& category, PropertySchema&& schema, std::shared_ptr<IObjectRegistryItem>&& item) {
+
+			auto id_iter = _ids.find(name);
+
+			if (id_iter != _ids.end()) {
+
+				// Replace the existing type, moving it to its new category if it changed.
+
+				type_id_type id = id_iter->second;
+				Type& type = _types[id];
+
+				if (type.category != category) {
+
+					auto category_iter = _categories.find(type.category);
+
+					if (category_iter != _categories.end()) {
+
+						category_iter->second.erase(std::remove(category_iter->second.begin(), category_iter->second.end(), id), category_iter->second.end());
+
+						if (category_iter->second.empty())
+							_categories.erase(category_iter);
+
+					}
+
+					if (!category.empty())
+						_insertSorted(_categories[category], id);
+
+					type.category = category;
+
+				}
+
+				type.schema = std::make_shared<const PropertySchema>(std::move(schema));
+				type.item = std::move(item);
+
+				return;
+
+			}
+
+			type_id_type id = static_cast<type_id_type>(_types.size());
+
+			Type type;
+			type.name = name;
+			type.key = _toLower(name);
+			type.category = category;
+			type.schema = std::make_shared<const PropertySchema>(std::move(schema));
+			type.item = std::move(item);
+
+			_types.push_back(std::move(type));
+			_ids[name] = id;
+
+			_insertSorted(_sorted, id);
+
+			if (!category.empty())
+				_insertSorted(_categories[category], id);
+
+		}
+		void ObjectRegistry::_insertSorted(std::vector<type_id_type>& ids, type_id_type id) const {
+
+			// Names that only differ by case are ordered by their original names, so that the order doesn't depend on the order they were registered in.
+
+			auto position = std::upper_bound(ids.begin(), ids.end(), id, [this](type_id_type lhs, type_id_type rhs) {
+				return _types[lhs].key < _types[rhs].key || (_types[lhs].key == _types[rhs].key && _types[lhs].name < _types[rhs].name);
+			});
+
+			ids.insert(position, id);
+
+		}
+		std::string ObjectRegistry::_toLower(const std::string& value) {
+
+			std::string result = value;
+
+			std::transform(result.begin(), result.end(), result.begin(), [](char x) { return static_cast<char>(std::tolower(static_cast<unsigned char>(x))); });
+
+			return result;
+
 		}
 
 	}
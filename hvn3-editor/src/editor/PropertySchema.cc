@@ -0,0 +1,280 @@
+#include "editor/PropertySchema.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+
+namespace hvn3 {
+	namespace editor {
+
+		bool PropertySchema::Empty() const {
+			return _properties.empty();
+		}
+		const std::vector<PropertySchema::Definition>& PropertySchema::Properties() const {
+			return _properties;
+		}
+		const PropertySchema::Definition* PropertySchema::Find(const std::string& name) const {
+
+			int index = IndexOf(name);
+
+			return index < 0 ? nullptr : &_properties[index];
+
+		}
+		int PropertySchema::IndexOf(const std::string& name) const {
+
+			// Schemas only have a handful of properties, so a linear search is faster than anything else.
+
+			for (size_t i = 0; i < _properties.size(); ++i)
+				if (_properties[i].name == name)
+					return static_cast<int>(i);
+
+			return -1;
+
+		}
+		PropertySchema::Result PropertySchema::Normalize(const std::string& name, const std::string& value, std::string& normalized) const {
+
+			const Definition* property = Find(name);
+
+			if (property == nullptr) {
+
+				normalized = value;
+
+				return Result::Unknown;
+
+			}
+
+			if (property->type == PropertyType::String) {
+
+				normalized = value;
+
+				return value == property->default_string ? Result::Default : Result::Valid;
+
+			}
+
+			double number;
+
+			if (!_parseNumber(property->type, value, number)) {
+
+				normalized = _formatNumber(property->type, property->default_number);
+
+				return Result::Invalid;
+
+			}
+
+			Result result = Result::Valid;
+
+			if (number < property->min || number > property->max) {
+
+				number = number < property->min ? property->min : property->max;
+				result = Result::Clamped;
+
+			}
+
+			normalized = _formatNumber(property->type, number);
+
+			if (result == Result::Valid && number == property->default_number)
+				result = Result::Default;
+
+			return result;
+
+		}
+
+		void PropertySchema::_add(const Property<bool>& property) {
+
+			_addNumber(property.Name(), PropertyType::Bool, property.DefaultValue() ? 1.0 : 0.0, property.Min() ? 1.0 : 0.0, property.Max() ? 1.0 : 0.0);
+
+		}
+		void PropertySchema::_add(const Property<int>& property) {
+
+			_addNumber(property.Name(), PropertyType::Int, property.DefaultValue(), property.Min(), property.Max());
+
+		}
+		void PropertySchema::_add(const Property<float>& property) {
+
+			_addNumber(property.Name(), PropertyType::Float, property.DefaultValue(), property.Min(), property.Max());
+
+		}
+		void PropertySchema::_add(const Property<const char*>& property) {
+
+			Definition definition;
+			definition.name = property.Name();
+			definition.type = PropertyType::String;
+			definition.default_number = 0.0;
+			definition.min = 0.0;
+			definition.max = 0.0;
+			definition.default_string = property.DefaultValue() == nullptr ? "" : property.DefaultValue();
+
+			_properties.push_back(std::move(definition));
+
+		}
+		void PropertySchema::_addNumber(const char* name, PropertyType type, double default_value, double min, double max) {
+
+			Definition definition;
+			definition.name = name;
+			definition.type = type;
+			definition.default_number = default_value;
+			definition.min = std::min(min, max);
+			definition.max = std::max(min, max);
+
+			_properties.push_back(std::move(definition));
+
+		}
+		bool PropertySchema::_parseNumber(PropertyType type, const std::string& value, double& number) {
+
+			if (value.empty())
+				return false;
+
+			if (type == PropertyType::Bool) {
+
+				std::string lower = value;
+				std::transform(lower.begin(), lower.end(), lower.begin(), [](char x) { return static_cast<char>(std::tolower(static_cast<unsigned char>(x))); });
+
+				if (lower == "1" || lower == "true") {
+					number = 1.0;
+					return true;
+				}
+				else if (lower == "0" || lower == "false") {
+					number = 0.0;
+					return true;
+				}
+
+				return false;
+
+			}
+
+			const char* first = value.c_str();
+			char* last;
+
+			errno = 0;
+
+			if (type == PropertyType::Int) {
+
+				long result = std::strtol(first, &last, 10);
+
+				if (errno == ERANGE || result < std::numeric_limits<int>::lowest() || result > std::numeric_limits<int>::max()) {
+
+					// Out-of-range integers are clamped like any other out-of-range value.
+
+					number = first[0] == '-' ? std::numeric_limits<int>::lowest() : std::numeric_limits<int>::max();
+
+					return *last == '\0';
+
+				}
+
+				number = static_cast<double>(result);
+
+			}
+			else {
+
+				number = std::strtod(first, &last);
+
+				if (!std::isfinite(number))
+					return false;
+
+			}
+
+			return last != first && *last == '\0';
+
+		}
+		std::string PropertySchema::_formatNumber(PropertyType type, double number) {
+
+			char buffer[32];
+
+			switch (type) {
+
+			case PropertyType::Bool:
+				return number != 0.0 ? "1" : "0";
+
+			case PropertyType::Int:
+				std::snprintf(buffer, sizeof(buffer), "%d", static_cast<int>(number));
+				return buffer;
+
+			default:
+
+				// Use the shortest representation that reads back as the same float.
+
+				float value = static_cast<float>(number);
+
+				for (int precision = 1; precision < 9; ++precision) {
+
+					std::snprintf(buffer, sizeof(buffer), "%.*g", precision, value);
+
+					if (std::strtof(buffer, nullptr) == value)
+						return buffer;
+
+				}
+
+				std::snprintf(buffer, sizeof(buffer), "%.9g", value);
+
+				return buffer;
+
+			}
+
+		}
+
+		PropertyValues::PropertyValues() {}
+		void PropertyValues::Reset(std::shared_ptr<const PropertySchema> schema) {
+
+			_schema = std::move(schema);
+			_numbers.clear();
+			_strings.clear();
+
+			if (!_schema)
+				return;
+
+			for (auto i = _schema->_properties.begin(); i != _schema->_properties.end(); ++i) {
+
+				_numbers.push_back(i->default_number);
+				_strings.push_back(i->default_string);
+
+			}
+
+		}
+		void PropertyValues::Set(const std::string& name, const std::string& value) {
+
+			if (!_schema)
+				return;
+
+			int index = _schema->IndexOf(name);
+
+			if (index < 0)
+				return;
+
+			const PropertySchema::Definition& property = _schema->_properties[index];
+
+			if (property.type == PropertyType::String) {
+
+				_strings[index] = value;
+
+				return;
+
+			}
+
+			double number;
+
+			if (!PropertySchema::_parseNumber(property.type, value, number))
+				number = property.default_number;
+
+			_numbers[index] = std::max(property.min, std::min(number, property.max));
+
+		}
+		double PropertyValues::_getNumber(const std::string& name) const {
+
+			int index = !_schema ? -1 : _schema->IndexOf(name);
+
+			return index < 0 ? 0.0 : _numbers[index];
+
+		}
+		std::string PropertyValues::_getString(const std::string& name) const {
+
+			int index = !_schema ? -1 : _schema->IndexOf(name);
+
+			return index < 0 ? "" : _strings[index];
+
+		}
+
+	}
+}
\ No newline at end of file
@@ -4,9 +4,9 @@
 #include "hvn3/io/Path.h"
 #include "hvn3/rooms/RoomManager.h"
 #include "hvn3/gui2/Button.h"
+#include "hvn3/gui2/CheckBox.h"
 #include "hvn3/gui2/DataGrid.h"
 #include "hvn3/gui2/MenuStrip.h"
-#include "hvn3/gui2/ListBox.h"
 #include "hvn3/gui2/RoomView.h"
 #include "hvn3/gui2/TextBox.h"
 #include "hvn3/gui2/TilesetView.h"
@@ -16,14 +16,33 @@
 
 #include "editor/RoomEditor.h"
 #include "editor/RoomEditorXmlResourceAdapter.h"
+#include "editor/detail/AtlasPacker.h"
+#include "editor/detail/CollisionBake.h"
+#include "editor/detail/ImageData.h"
 #include "editor/widgets/RoomEditorBackgroundsWidget.h"
+#include "editor/widgets/RoomEditorListWidget.h"
+#include "editor/widgets/RoomEditorMinimapWidget.h"
+#include "editor/widgets/RoomEditorRoomViewWidget.h"
 #include "editor/widgets/RoomEditorStatusStripWidget.h"
 #include "editor/widgets/RoomEditorTilesetsWidget.h"
 #include "editor/widgets/RoomEditorViewsWidget.h"
+#include <allegro5/allegro.h>
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <exception>
+#include <memory>
+#include <unordered_set>
 
 namespace hvn3 {
 	namespace editor {
 
+		// Zoom levels are powers of two. Zooming out further than the tile overview supports isn't allowed.
+		const int MIN_ZOOM_LEVEL = -detail::TileOverview::MAX_LEVEL;
+		const int MAX_ZOOM_LEVEL = 3;
+		// The maximum width and height of the atlases written when exporting, which most graphics cards support.
+		const int MAX_ATLAS_SIZE = 4096;
+
 		void BLOCK_LISTENERS() {
 
 			Keyboard::Listeners::SetBlocked(true);
@@ -38,6 +57,24 @@ namespace hvn3 {
 			ListenerCollection<IDisplayListener>::SetBlocked(false);
 
 		}
+		// Returns the directory the editor keeps its caches in, which is the user's data directory for the application, or the working directory if there isn't one.
+		std::string GET_DATA_DIRECTORY() {
+
+			ALLEGRO_PATH* path = al_get_standard_path(ALLEGRO_USER_DATA_PATH);
+
+			if (path == nullptr)
+				return ".";
+
+			std::string directory = al_path_cstr(path, ALLEGRO_NATIVE_PATH_SEP);
+
+			al_destroy_path(path);
+
+			while (directory.size() > 1 && (directory.back() == '/' || directory.back() == '\\'))
+				directory.pop_back();
+
+			return directory;
+
+		}
 
 
 		RoomEditor::BackToEditorObject::BackToEditorObject(IRoomPtr editor) :
@@ -56,7 +93,9 @@ namespace hvn3 {
 
 
 		RoomEditor::RoomEditor() :
-			hvn3::Room(0, 0) {
+			hvn3::Room(0, 0),
+			_disk_image_cache(GET_DATA_DIRECTORY() + "/image_cache"),
+			_room_streamer(_jobs, _tile_layers, _object_list) {
 
 			_editor_name = "hvn3 Room Editor";
 			_default_file_ext = ".hvn3room";
@@ -64,11 +103,131 @@ namespace hvn3 {
 			_editor_mode = EDITOR_MODE_TILES;
 
 			_zoom_level = 0;
+			_room_view_detached = false;
+			_pending_objects_loaded = 0;
+			_outliner_changed = false;
+			_last_import_type_id = ObjectRegistry::INVALID_TYPE_ID;
+			_invalid_property_count = 0;
+			_invalid_chunk_count = 0;
+			_unknown_page_object_count = 0;
+			_scatter_brush_enabled = false;
+			_marquee_active = false;
+			_snap_index_valid = false;
+			_tile_selection_layer = 0;
+			_tile_selection_count = 0;
 			_key_modifiers = (KeyModifiers)0;
 			_mouse_buttons = (MouseButton)0;
 			_editor_initialized = false;
 			_properties_exit_with_esc = false;
 			_has_unsaved_changes = false;
+			_change_revision = 0;
+
+			// Decoded images are cached on disk (in the user's data directory), so that large images don't need to be decoded again when the editor is restarted.
+			_disk_image_cache.SetJobSystem(&_jobs);
+			_bitmap_cache.SetDiskCache(&_disk_image_cache);
+
+			_tile_overview.SetDrawTileCallback([this](Graphics::Graphics& graphics, detail::TileLayer::tile_id_type id, float x, float y, float scale) {
+				_drawTile(graphics, id, x, y, scale);
+			});
+
+			_file_watcher.SetCallback([this](const std::string& file_path) {
+				_reloadImage(file_path);
+			});
+
+			_object_list.SetSchemaLookup([this](const String& name) {
+				return _object_registry.GetSharedSchema(_object_registry.GetTypeId(name));
+			});
+
+			// Objects in streamed rooms are created whenever the page containing them is loaded, but only added to the minimap the first time.
+
+			_room_streamer.SetObjectLoadedCallback([this](const detail::RoomStreamer::PageObject& object, bool first_load) {
+
+				std::string name;
+
+				for (auto i = object.properties.begin(); i != object.properties.end(); ++i)
+					if (i->first == "name")
+						name = i->second;
+
+				BLOCK_LISTENERS();
+
+				IObjectPtr ptr = _object_registry.MakeObject(name);
+
+				UNBLOCK_LISTENERS();
+
+				// Objects of types that aren't in the registry can't be created, so they're left out (and dropped from the page if it's modified). They're reported so that the type can be registered before anything is lost.
+
+				if (!ptr) {
+
+					_status_strip->SetText(StringUtils::Format("{0} objects have types that aren't registered, and will be lost if the pages they're in are modified", ++_unknown_page_object_count));
+
+					return;
+
+				}
+
+				ptr->SetPosition(object.position);
+
+				// Pages can be written by other versions of the editor, with other schemas, so their properties are checked like the properties in room files.
+
+				detail::ObjectList::property_list_type properties = object.properties;
+
+				_invalid_property_count += _validateProperties(properties);
+
+				const detail::ObjectList::Item& item = _object_list.Add(ptr);
+				_object_list.SetPackedProperties(ptr.get(), properties);
+
+				if (first_load)
+					_minimap_view->Minimap().AddObject(object.position);
+
+				_object_renderer.Insert(_object_list, item);
+
+			});
+
+			_room_streamer.SetPageLoadedCallback([this](const RectangleI& tiles, bool first_load) {
+
+				_tile_overview.InvalidateRegion(_tile_layers, tiles);
+
+				if (first_load)
+					_minimap_view->Minimap().InvalidateRegion(tiles);
+
+			});
+
+			_room_streamer.SetPageEvictedCallback([this](const RectangleF& bounds) {
+
+				// Selected objects in the page are no longer in the object list.
+
+				_selected_objects.erase(std::remove_if(_selected_objects.begin(), _selected_objects.end(), [&](const detail::ObjectList::Item& x) {
+					return x.Object()->Position().In(bounds);
+				}), _selected_objects.end());
+
+			});
+
+			// Objects are added to and removed from the outliner as they're added to and removed from the object list. Removed objects are only marked here, and taken out of the outliner together when it's next updated.
+
+			_object_list.SetItemAddedCallback([this](const detail::ObjectList::Item& item) {
+
+				_outliner_indices[item.Object().get()] = _outliner_items.size();
+				_outliner_items.push_back(item);
+				_outliner_changed = true;
+
+			});
+
+			_object_list.SetItemRemovedCallback([this](const IObjectPtr& object) {
+
+				// Objects removed for any reason (including pages of streamed rooms being unloaded) have to be taken out of the renderer before they're destroyed.
+
+				_object_renderer.Remove(object.get());
+
+				auto index_iter = _outliner_indices.find(object.get());
+
+				if (index_iter == _outliner_indices.end())
+					return;
+
+				_outliner_items[index_iter->second] = detail::ObjectList::Item();
+				_outliner_removed.push_back(index_iter->second);
+				_outliner_indices.erase(index_iter);
+				_outliner_changed = true;
+
+			});
 
 		}
 		void RoomEditor::OnCreate(RoomCreateEventArgs& e) {
@@ -133,27 +292,71 @@ namespace hvn3 {
 
 			Room::OnRender(e);
 
+			// The room is drawn by the room view, so that the widgets drawn after it (such as menus) aren't covered by it.
+
 			_widgets.OnDraw(e);
 
+			//_drawTileCursor(e);
+
+		}
+		void RoomEditor::_drawRoomView(DrawEventArgs& e) {
+
+			_drawDetachedRoom(e);
+			_drawObjects(e);
+			_drawTileSelection(e);
+			_drawObjectSelection(e);
+			_drawScatterBrush(e);
+			_drawSnapGuides(e);
+			_drawMarquee(e);
+
 			if (_selected_object) {
 
-				RectangleF rect = _selected_object.BoundingBox();
-				rect.SetPosition(_room_view->WorldPositionToDisplayPosition(rect.Position()));
+				RectangleF bounding_box = _selected_object.BoundingBox();
+				PointF position = _worldPositionToDisplayPosition(bounding_box.Position());
+				RectangleF rect(position.x, position.y, bounding_box.Width() * _zoomScale(), bounding_box.Height() * _zoomScale());
 
+				e.Graphics().SetClip(_room_view->Bounds());
 				e.Graphics().SetBlendMode(Graphics::BlendOperation::Invert);
 				e.Graphics().DrawRectangle(rect, Color::White, 1.0f);
 				e.Graphics().ResetBlendMode();
+				e.Graphics().ResetClip();
 
 			}
 
-			//_drawTileCursor(e);
-
 		}
 		void RoomEditor::OnUpdate(UpdateEventArgs& e) {
 			Room::OnUpdate(e);
 
 			_widgets.OnUpdate(e);
 
+			// Start reloading any images that were modified, and apply the results of any background work on the main thread.
+
+			_file_watcher.Poll();
+			_jobs.ProcessCompletions();
+
+			// Load the pages of streamed rooms around the view, and unload the ones far away from it.
+
+			if (_room && _room_streamer.IsOpen()) {
+
+				float scale = _zoomScale();
+				RectangleF bounds = _room_view->Bounds();
+				PointF region_position = _displayPositionToWorldPosition(bounds.Position(), false);
+
+				_room_streamer.Update(RectangleF(region_position.x, region_position.y, bounds.Width() / scale, bounds.Height() / scale));
+
+				if (_selected_object && !_room_streamer.IsResident(_selected_object.Object()->Position()))
+					_selected_object = detail::ObjectList::Item::NULL_ITEM;
+
+			}
+
+			// Objects from a room that's being loaded are created a few at a time, so that the editor stays responsive.
+
+			_loadPendingObjects(256);
+
+			_placeScatteredObjects();
+			_updateOutliner();
+			_updateJobProgress();
+
 		}
 		void RoomEditor::OnDisplaySizeChanged(DisplaySizeChangedEventArgs& e) {
 
@@ -178,14 +381,54 @@ namespace hvn3 {
 			if (!_room)
 				return;
 
-			PointF room_position = _room_view->DisplayPositionToWorldPosition(e.Position(), !HasFlag(_key_modifiers, KeyModifiers::Alt));
+			// The view can be panned by dragging with the middle mouse button.
+
+			if (HasFlag(_mouse_buttons, MouseButton::Middle) && e.Position().In(_room_view->Bounds())) {
+
+				float scale = _zoomScale();
+				PointF view_center = _displayPositionToWorldPosition(PointF(_room_view->Bounds().X() + _room_view->Bounds().Width() / 2.0f, _room_view->Bounds().Y() + _room_view->Bounds().Height() / 2.0f), false);
+
+				_setViewCenter(PointF(view_center.x - (e.Position().x - _mouse_position.x) / scale, view_center.y - (e.Position().y - _mouse_position.y) / scale));
+
+			}
+
+			_mouse_position = e.Position();
+
+			PointF room_position = _displayPositionToWorldPosition(e.Position(), !HasFlag(_key_modifiers, KeyModifiers::Alt));
 
 			switch (_editor_mode) {
 
 			case EDITOR_MODE_OBJECTS:
 
-				if (HasFlag(_mouse_buttons, MouseButton::Left) && _selected_object)
-					_selected_object.Object()->SetPosition(room_position);
+				// Objects painted with the scatter brush are placed during the next update.
+
+				if (_scatter_brush.InStroke()) {
+
+					_scatter_brush.ContinueStroke(_displayPositionToWorldPosition(e.Position(), false), [this](const PointF& position) { return _isScatterPositionValid(position); }, _scatter_positions);
+
+					break;
+
+				}
+
+				// Dragged objects snap to the grid and to the objects around them, unless Alt is held. Objects can't be moved into pages of streamed rooms that haven't been loaded yet.
+
+				if (HasFlag(_mouse_buttons, MouseButton::Left) && _selected_object && !_marquee_active) {
+
+					PointF object_position = HasFlag(_key_modifiers, KeyModifiers::Alt) ? room_position : _snapObjectPosition(_selected_object, _displayPositionToWorldPosition(e.Position(), false));
+
+					if (!_room_streamer.IsResident(object_position))
+						break;
+
+					_room_streamer.MarkModified(_selected_object.Object()->Position());
+					_room_streamer.MarkModified(object_position);
+
+					_minimap_view->Minimap().MoveObject(_selected_object.Object()->Position(), object_position);
+
+					_selected_object.Object()->SetPosition(object_position);
+
+					_object_renderer.Move(_selected_object.Object().get());
+
+				}
 
 				break;
 
@@ -198,14 +441,71 @@ namespace hvn3 {
 
 			_mouse_buttons &= ~e.Button();
 
+			// Objects may have been moved, so the snap index is rebuilt when the next drag starts.
+
+			if (e.Button() == MouseButton::Left) {
+
+				if (_marquee_active) {
+
+					PointF end = _displayPositionToWorldPosition(_mouse_position, false);
+
+					_marquee_active = false;
+
+					_selectRegion(RectangleF(std::min(_marquee_start.x, end.x), std::min(_marquee_start.y, end.y), std::abs(end.x - _marquee_start.x), std::abs(end.y - _marquee_start.y)));
+
+				}
+
+				_scatter_brush.EndStroke();
+
+				_snap_index_valid = false;
+				_snap_guides.clear();
+
+			}
+
+		}
+		void RoomEditor::OnMouseScroll(MouseScrollEventArgs& e) {
+
+			// Lists are scrolled three rows at a time.
+
+			for (auto i : { _objects_view, _outliner_view })
+				if (i->Visible() && e.Position().In(i->Bounds())) {
+
+					i->Scroll(e.Delta() > 0 ? -3 : 3);
+
+					return;
+
+				}
+
+			if (!_room || !e.Position().In(_room_view->Bounds()))
+				return;
+
+			// Zoom towards the cursor, so that whatever is under it stays in place.
+			_setZoomLevel(_zoom_level + (e.Delta() > 0 ? 1 : -1), e.Position());
+
 		}
-		void RoomEditor::OnMouseScroll(MouseScrollEventArgs& e) {}
 		void RoomEditor::OnKeyPressed(KeyPressedEventArgs& e) {
 
 			_key_modifiers = e.Modifiers();
 
 			if (e.Key() == Key::F5)
 				_startPlaytest();
+			else if (e.Key() == Key::Escape && !_jobs.ActiveJobs().empty()) {
+
+				// Jobs like saving and streaming pages can't be cancelled, since the room's data would be lost with them.
+
+				for (auto i = _jobs.ActiveJobs().begin(); i != _jobs.ActiveJobs().end(); ++i)
+					if ((*i)->IsCancellable())
+						(*i)->Cancel();
+
+				_status_strip->SetText("Cancelled background work.");
+
+			}
+			else if (e.Key() == Key::Escape && _tile_selection_count > 0)
+				_clearTileSelection();
+			else if (e.Key() == Key::Escape && !_selected_objects.empty())
+				_clearObjectSelection();
+			else if (e.Key() == Key::Delete && _editor_mode == EDITOR_MODE_TILES && _tile_selection_count > 0)
+				_eraseSelectedTiles();
 			else if (HasFlag(e.Modifiers(), KeyModifiers::Control)) {
 
 				switch (e.Key()) {
@@ -219,6 +519,21 @@ namespace hvn3 {
 					if (_room)
 						_showRoomSaveDialog();
 					break;
+				case Key::F:
+					_showFindObjectsDialog();
+					break;
+				case Key::B:
+					_showScatterBrushDialog();
+					break;
+				case Key::C:
+					_copySelection(false);
+					break;
+				case Key::X:
+					_copySelection(true);
+					break;
+				case Key::V:
+					_pasteClipboard();
+					break;
 				}
 
 			}
@@ -233,7 +548,15 @@ namespace hvn3 {
 			return _room;
 		}
 		void RoomEditor::SetObjectRegistry(const ObjectRegistry& registry) {
+
 			_object_registry = registry;
+
+			// Type IDs are only meaningful to the registry they came from.
+
+			_import_type_ids.clear();
+			_last_import_type_name.clear();
+			_last_import_type_id = ObjectRegistry::INVALID_TYPE_ID;
+
 		}
 		void RoomEditor::SetRoomProvider(std::function<IRoomPtr(const SizeI&)>&& provider) {
 			_room_provider = std::move(provider);
@@ -268,650 +591,2916 @@ namespace hvn3 {
 			//	}
 
 		}
-		void RoomEditor::_initializeUi() {
+		void RoomEditor::_drawObjects(DrawEventArgs& e) {
 
-			_initializeUiStyles();
+			if (!_room)
+				return;
 
-			_updateWindowTitle();
-			_initializeMenuStrip();
-			_initializeToolStrip();
+			// Placed objects are drawn by the object renderer rather than by the room, so that instances of the same type can be drawn in a single batch.
 
-			_tileset_view = new RoomEditorTilesetsWidget(this);
-			_tileset_view->SetDockStyle(hvn3::Gui::DockStyle::Fill);
+			float scale = _zoomScale();
+			RectangleF bounds = _room_view->Bounds();
+			PointF region_position = _displayPositionToWorldPosition(bounds.Position(), false);
+			RectangleF region(region_position.x, region_position.y, bounds.Width() / scale, bounds.Height() / scale);
 
-			_objects_view = new hvn3::Gui::ListBox();
-			_objects_view->SetVisible(false);
-			_objects_view->SetDockStyle(hvn3::Gui::DockStyle::Fill);
+			e.Graphics().SetClip(bounds);
 
-			for (auto i = _object_registry.begin(); i != _object_registry.end(); ++i)
-				_objects_view->AddItem(i->second->Name());
+			_object_renderer.Draw(e.Graphics(), _object_list, region, _worldPositionToDisplayPosition(PointF(0.0f, 0.0f)), scale);
 
-			_backgrounds_view = new RoomEditorBackgroundsWidget(this);
+			e.Graphics().ResetClip();
 
-			_views_view = new RoomEditorViewsWidget;
+		}
+		void RoomEditor::_drawTileSelection(DrawEventArgs& e) {
 
-			hvn3::Gui::Window* window = new hvn3::Gui::Window(0.0f, 0.0f, 300.0f, 0.0f, "");
-			window->SetDockStyle(hvn3::Gui::DockStyle::Left);
-			window->SetTitleBarVisible(false);
-			window->GetChildren().Add(_tileset_view);
-			window->GetChildren().Add(_objects_view);
-			window->GetChildren().Add(_backgrounds_view);
-			window->GetChildren().Add(_views_view);
+			if (!_room || _tile_selection_count == 0)
+				return;
 
-			_status_strip = new RoomEditorStatusStripWidget;
-			_status_strip->SetDockStyle(Gui::DockStyle::Bottom);
-			_status_strip->SetText("Create a new room with \"File > New Room\".");
+			float scale = _zoomScale();
+			SizeF tile_size = static_cast<SizeF>(_room->Tiles().TileSize());
 
-			_room_view = new Gui::RoomView;
-			_room_view->SetWidth(200.0f);
-			_room_view->SetDockStyle(Gui::DockStyle::Fill);
-			_room_view->SetEventHandler<Gui::WidgetEventType::OnMouseDown>([this](Gui::WidgetMouseDownEventArgs& e) { _roomView_OnMouseDown(e); });
-			_room_view->SetEventHandler<Gui::WidgetEventType::OnMousePressed>([this](Gui::WidgetMousePressedEventArgs& e) { _roomView_OnMousePressed(e); });
+			// Cells smaller than a couple of pixels can't be told apart, so the selection is only outlined when zoomed in far enough.
 
-			_widgets.Add(window);
-			_widgets.Add(_status_strip);
-			_widgets.Add(_room_view);
+			if (tile_size.width * scale < 2.0f || tile_size.height * scale < 2.0f)
+				return;
 
-			_left_panel = window;
+			RectangleF bounds = _room_view->Bounds();
+			PointF region_position = _displayPositionToWorldPosition(bounds.Position(), false);
+			RectangleF region(region_position.x, region_position.y, bounds.Width() / scale, bounds.Height() / scale);
+			PointF offset = _worldPositionToDisplayPosition(PointF(0.0f, 0.0f));
+			int first_x = static_cast<int>(std::floor(region.X() / tile_size.width));
+			int first_y = static_cast<int>(std::floor(region.Y() / tile_size.height));
+			int last_x = static_cast<int>(std::floor((region.X() + region.Width()) / tile_size.width));
+			int last_y = static_cast<int>(std::floor((region.Y() + region.Height()) / tile_size.height));
 
-		}
-		void RoomEditor::_initializeUiStyles() {
+			std::vector<detail::TileLayer::tile_id_type> row(static_cast<size_t>(last_x - first_x + 1));
 
-			// Create a style instance that will be used as a template for a few different buttons.
+			e.Graphics().SetClip(bounds);
+			e.Graphics().SetBlendMode(Graphics::BlendOperation::Invert);
 
-			Gui::WidgetStyle style;
+			for (int y = first_y; y <= last_y; ++y) {
 
-			Gui::WidgetStyle::BackgroundPositionProperty background_position;
-			background_position.flags = Gui::WidgetStyle::PositionFlags::Center;
-			style.SetProperty<Gui::WidgetProperty::BackgroundPosition>(background_position);
+				_tile_selection.ReadRow(first_x, y, static_cast<int>(row.size()), row.data());
 
-			// Create and add styles.
+				// Outline each run of selected cells as a single rectangle.
 
-			style.SetProperty<Gui::WidgetProperty::BackgroundImage>(Graphics::Bitmap::FromFile("bin/system/icons/tile.png"));
-			_widgets.Renderer()->AddStyle(".tile_btn", style);
+				for (size_t x = 0; x < row.size();) {
 
-			style.SetProperty<Gui::WidgetProperty::BackgroundImage>(Graphics::Bitmap::FromFile("bin/system/icons/object.png"));
-			_widgets.Renderer()->AddStyle(".object_btn", style);
+					if (row[x] == 0) {
 
-			style.SetProperty<Gui::WidgetProperty::BackgroundImage>(Graphics::Bitmap::FromFile("bin/system/icons/background.png"));
-			_widgets.Renderer()->AddStyle(".background_btn", style);
+						++x;
 
-			style.SetProperty<Gui::WidgetProperty::BackgroundImage>(Graphics::Bitmap::FromFile("bin/system/icons/arrow_d.png"));
-			_widgets.Renderer()->AddStyle(".arrow_d", style);
+						continue;
 
-			style.SetProperty<Gui::WidgetProperty::BackgroundImage>(Graphics::Bitmap::FromFile("bin/system/icons/arrow_u.png"));
-			_widgets.Renderer()->AddStyle(".arrow_u", style);
+					}
 
-			style.SetProperty<Gui::WidgetProperty::BackgroundImage>(Graphics::Bitmap::FromFile("bin/system/icons/camera.png"));
-			_widgets.Renderer()->AddStyle(".view_btn", style);
+					size_t run_start = x;
 
-			style.SetProperty<Gui::WidgetProperty::BackgroundImage>(Graphics::Bitmap::FromFile("bin/system/icons/tileset.png"));
-			_widgets.Renderer()->AddStyle(".tileset_btn", style);
+					while (x < row.size() && row[x] != 0)
+						++x;
 
-			style.SetProperty<Gui::WidgetProperty::BackgroundImage>(Graphics::Bitmap::FromFile("bin/system/icons/layers.png"));
-			_widgets.Renderer()->AddStyle(".layers_btn", style);
+					RectangleF rect(offset.x + (first_x + run_start) * tile_size.width * scale, offset.y + y * tile_size.height * scale, (x - run_start) * tile_size.width * scale, tile_size.height * scale);
 
-			style.SetProperty<Gui::WidgetProperty::BackgroundImage>(Graphics::Bitmap::FromFile("bin/system/icons/flags.png"));
-			_widgets.Renderer()->AddStyle(".flags_btn", style);
+					e.Graphics().DrawRectangle(rect, Color::White, 1.0f);
+
+				}
+
+			}
+
+			e.Graphics().ResetBlendMode();
+			e.Graphics().ResetClip();
 
 		}
-		void RoomEditor::_initializeMenuStrip() {
+		void RoomEditor::_drawMarquee(DrawEventArgs& e) {
 
-			hvn3::Gui::ContextMenu* file_cm = new hvn3::Gui::ContextMenu;
-			file_cm->AddItem("New\t\t\t\tCtrl+N")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) { _showRoomNewDialog(); });
-			file_cm->AddItem("Open...\t\tCtrl+O")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) { _showRoomOpenDialog(); });
-			file_cm->AddItem("Save\t\t\t\tCtrl+S")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) {	_showRoomSaveDialog(); });
-			file_cm->AddItem("Save As...")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) {	_showRoomSaveAsDialog(); });
-			file_cm->AddSeparator();
-			file_cm->AddItem("Preferences...")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) { _showPreferencesDialog(); });
-			file_cm->AddSeparator();
-			file_cm->AddItem("Exit")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) {	_context.Get<GAME_MANAGER>().Exit(); });
+			if (!_room || !_marquee_active)
+				return;
 
-			hvn3::Gui::ContextMenu* view_cm = new hvn3::Gui::ContextMenu;
+			PointF start = _worldPositionToDisplayPosition(_marquee_start);
 
-			auto view_cm_grid_item = view_cm->AddItem("Grid", true);
+			e.Graphics().SetClip(_room_view->Bounds());
+			e.Graphics().SetBlendMode(Graphics::BlendOperation::Invert);
+			e.Graphics().DrawRectangle(RectangleF(std::min(start.x, _mouse_position.x), std::min(start.y, _mouse_position.y), std::abs(_mouse_position.x - start.x), std::abs(_mouse_position.y - start.y)), Color::White, 1.0f);
+			e.Graphics().ResetBlendMode();
+			e.Graphics().ResetClip();
 
-			view_cm_grid_item->SetEventHandler<Gui::WidgetEventType::OnMousePressed>([=](Gui::WidgetMousePressedEventArgs& e) {
-				view_cm_grid_item->SetChecked(!view_cm_grid_item->Checked());
-				_room_view->SetGridVisible(view_cm_grid_item->Checked());
-			});
+		}
+		void RoomEditor::_drawObjectSelection(DrawEventArgs& e) {
 
-			auto view_cm_foregrounds_item = view_cm->AddItem("Foregrounds", true);
+			if (!_room || _selected_objects.empty())
+				return;
 
-			view_cm_foregrounds_item->SetEventHandler<Gui::WidgetEventType::OnMousePressed>([=](Gui::WidgetMousePressedEventArgs& e) {
+			// Computing an object's bounding box requires drawing it, so they're only computed for objects positioned close enough to the view to be visible.
 
-				if (!_room)
-					return;
+			const float margin = 256.0f;
 
-				view_cm_foregrounds_item->SetChecked(!view_cm_foregrounds_item->Checked());
+			float scale = _zoomScale();
+			RectangleF bounds = _room_view->Bounds();
+			PointF region_position = _displayPositionToWorldPosition(bounds.Position(), false);
+			RectangleF region(region_position.x, region_position.y, bounds.Width() / scale, bounds.Height() / scale);
+			RectangleF near_region(region.X() - margin, region.Y() - margin, region.Width() + margin * 2.0f, region.Height() + margin * 2.0f);
 
-				Room()->Backgrounds().ForEach([=](Background& i) {
+			e.Graphics().SetClip(bounds);
+			e.Graphics().SetBlendMode(Graphics::BlendOperation::Invert);
 
-					if (i.IsForeground())
-						i.SetVisible(view_cm_foregrounds_item->Checked());
+			for (auto i = _selected_objects.begin(); i != _selected_objects.end(); ++i) {
 
-					HVN3_CONTINUE;
+				if (!i->Object()->Position().In(near_region))
+					continue;
 
-				});
+				RectangleF bounding_box = i->BoundingBox();
+				PointF position = _worldPositionToDisplayPosition(bounding_box.Position());
 
-			});
+				e.Graphics().DrawRectangle(RectangleF(position.x, position.y, bounding_box.Width() * scale, bounding_box.Height() * scale), Color::White, 1.0f);
 
-			hvn3::Gui::ContextMenu* test_cm = new hvn3::Gui::ContextMenu;
-			test_cm->AddItem("Playtest\t\t\tF5")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) { _startPlaytest(); });
+			}
 
-			hvn3::Gui::MenuStrip* ms = new hvn3::Gui::MenuStrip;
-			ms->AddItem("File")->SetContextMenu(file_cm);
-			ms->AddItem("View")->SetContextMenu(view_cm);
-			ms->AddItem("Test")->SetContextMenu(test_cm);
+			e.Graphics().ResetBlendMode();
+			e.Graphics().ResetClip();
 
-			_widgets.Add(ms);
+		}
+		void RoomEditor::_drawScatterBrush(DrawEventArgs& e) {
+
+			if (!_room || !_scatter_brush_enabled || _editor_mode != EDITOR_MODE_OBJECTS || !_mouse_position.In(_room_view->Bounds()))
+				return;
+
+			e.Graphics().SetClip(_room_view->Bounds());
+			e.Graphics().SetBlendMode(Graphics::BlendOperation::Invert);
+			e.Graphics().DrawCircle(_mouse_position.x, _mouse_position.y, _scatter_brush.Radius() * _zoomScale(), Color::White, 1.0f);
+			e.Graphics().ResetBlendMode();
+			e.Graphics().ResetClip();
 
 		}
-		void RoomEditor::_initializeToolStrip() {
+		void RoomEditor::_drawSnapGuides(DrawEventArgs& e) {
 
-			Gui::MenuStrip* ms = new Gui::MenuStrip;
-			Gui::MenuStripItem* item = nullptr;
+			if (_snap_guides.empty())
+				return;
 
-			// Add button (tiles).
-			item = ms->AddItem("");
-			item->AddId(".tile_btn");
-			item->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) {
-				_hideAllPanelWindows();
-				_tileset_view->SetVisible(true);
-				_editor_mode = EDITOR_MODE_TILES;
-			});
+			e.Graphics().SetClip(_room_view->Bounds());
+			e.Graphics().SetBlendMode(Graphics::BlendOperation::Invert);
 
-			// Add button (objects).
-			item = ms->AddItem("");
-			item->AddId(".object_btn");
-			item->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) {
-				_hideAllPanelWindows();
-				_objects_view->SetVisible(true);
-				_editor_mode = EDITOR_MODE_OBJECTS;
-			});
+			for (auto i = _snap_guides.begin(); i != _snap_guides.end(); ++i) {
 
-			// Add button (backgrounds).
-			item = ms->AddItem("");
-			item->AddId(".background_btn");
-			item->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) {
-				_hideAllPanelWindows();
-				_backgrounds_view->SetVisible(true);
-				_editor_mode = EDITOR_MODE_BACKGROUNDS;
-			});
+				PointF from = _worldPositionToDisplayPosition(i->first);
+				PointF to = _worldPositionToDisplayPosition(i->second);
+
+				e.Graphics().DrawLine(from.x, from.y, to.x, to.y, Color::White, 1.0f);
+
+			}
+
+			e.Graphics().ResetBlendMode();
+			e.Graphics().ResetClip();
+
+		}
+		void RoomEditor::_drawDetachedRoom(DrawEventArgs& e) {
+
+			if (!_room || !_room_view_detached)
+				return;
+
+			float scale = _zoomScale();
+			RectangleF bounds = _room_view->Bounds();
+			PointF region_position = _displayPositionToWorldPosition(bounds.Position(), false);
+			RectangleF region(region_position.x, region_position.y, bounds.Width() / scale, bounds.Height() / scale);
+			PointF offset = _worldPositionToDisplayPosition(PointF(0.0f, 0.0f));
+			SizeF room_size = static_cast<SizeF>(_room->Size());
+
+			e.Graphics().SetClip(bounds);
+
+			e.Graphics().DrawFilledRectangle(RectangleF(offset.x, offset.y, room_size.width * scale, room_size.height * scale), _room->BackgroundColor());
+
+			_room->Backgrounds().ForEach([&](Background& i) {
+
+				if (i.Visible() && !i.IsForeground())
+					e.Graphics().DrawBitmap(offset.x + i.Offset().x * scale, offset.y + i.Offset().y * scale, i.Bitmap(), scale, scale);
+
+				HVN3_CONTINUE;
 
-			// Add button (views).
-			item = ms->AddItem("");
-			item->AddId(".view_btn");
-			item->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) {
-				_hideAllPanelWindows();
-				_views_view->SetVisible(true);
-				_editor_mode = EDITOR_MODE_VIEWS;
 			});
 
-			_widgets.Add(ms);
+			if (_zoom_level < 0) {
+
+				// Zoomed out, there can be far too many tiles on screen to draw individually, so draw them from the downsampled overview instead.
+				_tile_overview.Draw(e.Graphics(), _tile_layers, -_zoom_level, region, offset);
+
+			}
+			else {
+
+				// Zoomed in, only a few tiles are visible, so they can be drawn directly.
+
+				SizeF tile_size = static_cast<SizeF>(_room->Tiles().TileSize());
+				int first_x = std::max(0, static_cast<int>(std::floor(region.X() / tile_size.width)));
+				int first_y = std::max(0, static_cast<int>(std::floor(region.Y() / tile_size.height)));
+				int last_x = std::min(static_cast<int>(_room->Tiles().Columns()) - 1, static_cast<int>(std::floor((region.X() + region.Width()) / tile_size.width)));
+				int last_y = std::min(static_cast<int>(_room->Tiles().Rows()) - 1, static_cast<int>(std::floor((region.Y() + region.Height()) / tile_size.height)));
+
+				if (first_x <= last_x) {
+
+					std::vector<detail::TileLayer::tile_id_type> row(static_cast<size_t>(last_x - first_x + 1));
+
+					for (int layer = 0; layer < _tile_layers.Count(); ++layer)
+						for (int y = first_y; y <= last_y; ++y) {
+
+							_tile_layers.FindLayer(layer)->ReadRow(first_x, y, static_cast<int>(row.size()), row.data());
+
+							for (size_t x = 0; x < row.size(); ++x)
+								if (row[x] != 0)
+									_drawTile(e.Graphics(), row[x], offset.x + (first_x + x) * tile_size.width * scale, offset.y + y * tile_size.height * scale, scale);
+
+						}
+
+				}
+
+			}
+
+			// Draw the grid over the tiles, like the RoomView does.
+
+			if (_room_view->GridVisible()) {
+
+				SizeF cell_size = _room_view->GridCellSize();
+				float right = offset.x + room_size.width * scale;
+				float bottom = offset.y + room_size.height * scale;
+
+				// Grid lines closer than a few pixels apart would just fill the view.
+
+				if (cell_size.width * scale >= 4.0f && cell_size.height * scale >= 4.0f) {
+
+					for (float x = std::floor(region.X() / cell_size.width) * cell_size.width; x <= region.X() + region.Width(); x += cell_size.width)
+						if (x >= 0.0f && x <= room_size.width)
+							e.Graphics().DrawLine(offset.x + x * scale, offset.y, offset.x + x * scale, bottom, Color::Black, 1.0f);
+
+					for (float y = std::floor(region.Y() / cell_size.height) * cell_size.height; y <= region.Y() + region.Height(); y += cell_size.height)
+						if (y >= 0.0f && y <= room_size.height)
+							e.Graphics().DrawLine(offset.x, offset.y + y * scale, right, offset.y + y * scale, Color::Black, 1.0f);
+
+				}
+
+			}
+
+			e.Graphics().ResetClip();
 
 		}
-		void RoomEditor::_updateWindowTitle() {
+		void RoomEditor::_drawTile(Graphics::Graphics& graphics, detail::TileLayer::tile_id_type id, float x, float y, float scale) {
 
-			if (!_context)
+			const Graphics::Bitmap* bitmap = _getTileBitmap(id);
+
+			if (bitmap != nullptr)
+				graphics.DrawBitmap(x, y, *bitmap, scale, scale);
+
+		}
+		const Graphics::Bitmap* RoomEditor::_getTileBitmap(detail::TileLayer::tile_id_type id) {
+
+			// Tile indices continue from one tileset to the next, in the order the tilesets were added.
+
+			size_t index = static_cast<size_t>(id - 1);
+
+			for (auto i = _tileset_view->Tilesets().begin(); i != _tileset_view->Tilesets().end(); ++i) {
+
+				if (index < i->Count())
+					return &i->At(index).bitmap;
+
+				index -= i->Count();
+
+			}
+
+			return nullptr;
+
+		}
+		Color RoomEditor::_getTileColor(detail::TileLayer::tile_id_type id) {
+
+			// Use the average color of the tile's opaque pixels.
+
+			const Graphics::Bitmap* bitmap = _getTileBitmap(id);
+
+			if (bitmap == nullptr)
+				return Color::White;
+
+			float r = 0.0f;
+			float g = 0.0f;
+			float b = 0.0f;
+			int count = 0;
+
+			for (int y = 0; y < bitmap->Height(); ++y)
+				for (int x = 0; x < bitmap->Width(); ++x) {
+
+					Color pixel = bitmap->GetPixel(x, y);
+
+					if (pixel.Alpha() <= 0)
+						continue;
+
+					r += pixel.R();
+					g += pixel.G();
+					b += pixel.B();
+					++count;
+
+				}
+
+			if (count == 0)
+				return Color::Transparent;
+
+			return Color(r / count, g / count, b / count);
+
+		}
+		void RoomEditor::_onTileChanged(int x, int y, detail::TileLayer::tile_id_type id, int layer) {
+
+			// The tile layers are the only copy of the room's tiles, so only what's drawn from them needs to be updated.
+
+			if (_room_streamer.IsOpen())
+				_room_streamer.MarkModified(x, y);
+
+			_tile_overview.UpdateTile(_tile_layers, x, y, layer);
+			_minimap_view->Minimap().InvalidateTile(x, y);
+
+		}
+		void RoomEditor::_onTileChunksChanged(int layer, const std::vector<std::pair<int, int>>& chunks) {
+
+			for (auto i = chunks.begin(); i != chunks.end(); ++i) {
+
+				RectangleI region(i->first * detail::TileLayer::CHUNK_SIZE, i->second * detail::TileLayer::CHUNK_SIZE, detail::TileLayer::CHUNK_SIZE, detail::TileLayer::CHUNK_SIZE);
+
+				_tile_overview.InvalidateRegion(_tile_layers, region);
+				_minimap_view->Minimap().InvalidateRegion(region);
+
+				if (_room_streamer.IsOpen())
+					_room_streamer.MarkModified(region.X(), region.Y());
+
+			}
+
+		}
+		void RoomEditor::_copyChunkToRoom(int layer, int chunk_x, int chunk_y, const detail::TileLayer::Chunk* chunk) {
+
+			TileManager& tiles = _room->Tiles();
+
+			for (int y = 0; y < detail::TileLayer::CHUNK_SIZE; ++y)
+				for (int x = 0; x < detail::TileLayer::CHUNK_SIZE; ++x) {
+
+					int tile_x = chunk_x * detail::TileLayer::CHUNK_SIZE + x;
+					int tile_y = chunk_y * detail::TileLayer::CHUNK_SIZE + y;
+					detail::TileLayer::tile_id_type id = chunk == nullptr ? 0 : chunk->At(x, y);
+
+					if (tile_x >= 0 && tile_y >= 0 && tile_x < tiles.Columns() && tile_y < tiles.Rows() && (id != 0 || chunk == nullptr))
+						tiles.SetTile(tile_x, tile_y, id, layer);
+
+				}
+
+		}
+		void RoomEditor::_replaceTiles(detail::TileLayer::tile_id_type first_id, detail::TileLayer::tile_id_type last_id, detail::TileLayer::tile_id_type replacement) {
+
+			if (!_room)
 				return;
 
-			std::string title;
+			// Empty tiles are only stored inside of chunks that contain other tiles, so replacing them wouldn't fill the rest of the room.
 
-			if (_current_file.size() > 0)
-				title = IO::Path::GetFileName(_current_file);
+			if (first_id == 0) {
+
+				_status_strip->SetText("Empty tiles can't be replaced.");
+
+				return;
+
+			}
+
+			size_t changed = 0;
+			std::vector<std::pair<int, int>> chunks;
+
+			for (int layer = 0; layer < _tile_layers.Count(); ++layer) {
+
+				chunks.clear();
+
+				changed += _tile_layers.FindLayer(layer)->ReplaceTiles(first_id, last_id, replacement, &chunks);
+
+				_onTileChunksChanged(layer, chunks);
+
+			}
+
+			if (changed > 0) {
+
+				_markUnsavedChanges();
+
+			}
+
+			// Only the pages of streamed rooms that are in memory can be edited.
+
+			if (_room_streamer.IsOpen())
+				_status_strip->SetText(StringUtils::Format("Replaced {0} tiles in the loaded part of the room", changed));
 			else
-				title = "untitled";
+				_status_strip->SetText(StringUtils::Format("Replaced {0} tiles", changed));
 
-			if (_has_unsaved_changes)
-				title.push_back('*');
+		}
+		void RoomEditor::_selectTiles(detail::TileLayer::tile_id_type id, int layer) {
 
-			title += " - " + _editor_name;
+			_clearTileSelection();
 
-			_context.Get<GAME_MANAGER>().Display().SetTitle(title);
+			const detail::TileLayer* tile_layer = _tile_layers.FindLayer(layer);
+
+			if (tile_layer == nullptr)
+				return;
+
+			std::vector<std::pair<int, int>> positions;
+
+			tile_layer->FindTiles(id, id, positions);
+
+			for (auto i = positions.begin(); i != positions.end(); ++i)
+				_tile_selection.SetTile(i->first, i->second, 1);
+
+			_tile_selection_layer = layer;
+			_tile_selection_count = positions.size();
+
+			_status_strip->SetText(StringUtils::Format("Selected {0} tiles (press Delete to erase them)", _tile_selection_count));
 
 		}
-		void RoomEditor::_hideAllPanelWindows() {
+		void RoomEditor::_selectRegion(const RectangleF& region) {
 
-			_objects_view->SetVisible(false);
-			_tileset_view->SetVisible(false);
-			_backgrounds_view->SetVisible(false);
-			_views_view->SetVisible(false);
+			if (!_room)
+				return;
+
+			SizeI tile_size = _room->Tiles().TileSize();
+			int layer = _tileset_view->CurrentLayer();
+
+			// Only the cells inside of the room are selected, and only the ones that aren't empty, so that pasting the block doesn't erase the tiles under its gaps.
+
+			int first_x = std::max(0, static_cast<int>(std::floor(region.X() / tile_size.width)));
+			int first_y = std::max(0, static_cast<int>(std::floor(region.Y() / tile_size.height)));
+			int last_x = std::min(_room->Tiles().Columns() - 1, static_cast<int>(std::floor((region.X() + region.Width()) / tile_size.width)));
+			int last_y = std::min(_room->Tiles().Rows() - 1, static_cast<int>(std::floor((region.Y() + region.Height()) / tile_size.height)));
+
+			if (last_x >= first_x && last_y >= first_y && static_cast<int64_t>(last_x - first_x + 1) * (last_y - first_y + 1) > detail::Clipboard::MAX_CELLS) {
+
+				_status_strip->SetText("The selected region is too large to be copied");
+
+				return;
+
+			}
+
+			_clearTileSelection();
+
+			const detail::TileLayer* tile_layer = _tile_layers.FindLayer(layer);
+
+			if (tile_layer != nullptr && last_x >= first_x) {
+
+				std::vector<detail::TileLayer::tile_id_type> row(static_cast<size_t>(last_x - first_x + 1));
+
+				for (int y = first_y; y <= last_y; ++y) {
+
+					tile_layer->ReadRow(first_x, y, static_cast<int>(row.size()), row.data());
+
+					for (size_t x = 0; x < row.size(); ++x)
+						if (row[x] != 0) {
+
+							_tile_selection.SetTile(first_x + static_cast<int>(x), y, 1);
+
+							++_tile_selection_count;
+
+						}
+
+				}
+
+			}
+
+			_tile_selection_layer = layer;
+
+			// Objects are selected by their position, like they're placed.
+
+			_selected_objects.clear();
+
+			for (auto i = _object_list.begin(); i != _object_list.end(); ++i)
+				if (i->Object()->Position().In(region))
+					_selected_objects.push_back(*i);
+
+			_status_strip->SetText(StringUtils::Format("Selected {0} tiles and {1} objects (press Ctrl+C to copy them)", _tile_selection_count, _selected_objects.size()));
 
 		}
-		void RoomEditor::_showPreferencesDialog() {
+		void RoomEditor::_clearTileSelection() {
 
-			Gui::Window* dialog = new  Gui::Window(250, 200, "Preferences");
+			_tile_selection.Clear();
+			_tile_selection_count = 0;
 
-			Gui::Label* label_resource_base_dir = new Gui::Label("Resource base directory");
-			Gui::TextBox* textbox_resource_base_dir = new Gui::TextBox(200);
-			Gui::Button* button_resource_base_dir = new Gui::Button("...");
-			Gui::Label* label_grid_w = new Gui::Label("Grid Width");
-			Gui::Label* label_grid_h = new Gui::Label("Grid Height");
-			Gui::TextBox* textbox_grid_w = new Gui::TextBox(100, Gui::InputType::Numeric);
-			Gui::TextBox* textbox_grid_h = new Gui::TextBox(100, Gui::InputType::Numeric);
-			Gui::Button* button_ok = new Gui::Button("OK");
-			button_ok->SetWidth(100);
+		}
+		void RoomEditor::_eraseSelectedTiles() {
 
-			textbox_resource_base_dir->SetAnchor(Gui::Anchor::Left | Gui::Anchor::Right);
-			textbox_resource_base_dir->SetText(_resource_base_directory);
-			textbox_grid_w->SetText(StringUtils::ToString(_room_view->GridCellSize().width));
-			textbox_grid_h->SetText(StringUtils::ToString(_room_view->GridCellSize().height));
-			button_ok->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([=](Gui::WidgetMouseClickEventArgs& e) {
+			if (!_room)
+				return;
 
-				SizeF grid_cell_size = _room_view->GridCellSize();
+			detail::TileLayer* tile_layer = _tile_layers.FindLayer(_tile_selection_layer);
 
-				StringUtils::TryParse(textbox_grid_w->Text(), grid_cell_size.width);
-				StringUtils::TryParse(textbox_grid_h->Text(), grid_cell_size.height);
+			if (tile_layer == nullptr)
+				return;
 
-				_room_view->SetGridCellSize(grid_cell_size);
+			std::vector<std::pair<int, int>> chunks;
+			std::vector<int> indices;
 
-				dialog->Close();
+			_tile_selection.ForEachChunk([&](int chunk_x, int chunk_y, const detail::TileLayer::Chunk& chunk) {
 
-			});
-			button_resource_base_dir->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([=](Gui::WidgetMouseClickEventArgs& e) {
+				bool changed = false;
 
-				FileDialog fd(FileDialogFlags::Folder);
-				fd.SetInitialDirectory(_resource_base_directory);
+				indices.clear();
+
+				chunk.FindTiles(1, 1, &indices);
+
+				for (auto i = indices.begin(); i != indices.end(); ++i) {
+
+					int x = chunk_x * detail::TileLayer::CHUNK_SIZE + *i % detail::TileLayer::CHUNK_SIZE;
+					int y = chunk_y * detail::TileLayer::CHUNK_SIZE + *i / detail::TileLayer::CHUNK_SIZE;
+
+					if (_room_streamer.IsResident(x, y) && tile_layer->SetTile(x, y, 0))
+						changed = true;
 
-				if (fd.ShowDialog()) {
-					_resource_base_directory = fd.FileName();
-					textbox_resource_base_dir->SetText(_resource_base_directory);
 				}
 
+				if (changed)
+					chunks.push_back(std::make_pair(chunk_x, chunk_y));
+
 			});
 
-			dialog->GetChildren().Add(label_resource_base_dir);
-			dialog->GetChildren().Add(textbox_resource_base_dir);
-			dialog->GetChildren().Add(button_resource_base_dir);
-			dialog->GetChildren().Add(label_grid_w);
-			dialog->GetChildren().Add(label_grid_h);
-			dialog->GetChildren().Add(textbox_grid_w);
-			dialog->GetChildren().Add(textbox_grid_h);
-			dialog->GetChildren().Add(button_ok);
+			_onTileChunksChanged(_tile_selection_layer, chunks);
+			_clearTileSelection();
 
-			_widgets.ShowDialog(std::unique_ptr<Gui::IWidget>(dialog));
+			if (!chunks.empty()) {
 
-			Gui::WidgetLayoutBuilder builder;
+				_markUnsavedChanges();
 
-			builder.PlaceAt(label_resource_base_dir, PointF(0.0f, 0.0f));
-			builder.PlaceBottom(textbox_resource_base_dir);
-			builder.PlaceRight(button_resource_base_dir);
-			builder.PlaceBottomOf(label_grid_w, textbox_resource_base_dir);
-			builder.PlaceBottom(textbox_grid_w);
-			builder.PlaceRight(textbox_grid_h);
-			builder.PlaceTop(label_grid_h);
-			builder.AnchorToInnerEdge(button_ok, Gui::Anchor::Bottom | Gui::Anchor::Right);
+			}
+
+		}
+		bool RoomEditor::_selectObjects(const std::string& query) {
+
+			detail::PropertyQuery property_query;
+
+			if (!property_query.Parse(query)) {
+
+				_status_strip->SetText(property_query.ErrorMessage());
+
+				return false;
+
+			}
+
+			_last_object_query = query;
+			_selected_object = detail::ObjectList::Item::NULL_ITEM;
+			_selected_objects = _object_list.Query(property_query);
+
+			// Objects in pages of streamed rooms that haven't been loaded aren't in the object list, so they can't be found.
+
+			if (_room_streamer.IsOpen())
+				_status_strip->SetText(StringUtils::Format("Selected {0} objects in the loaded part of the room", _selected_objects.size()));
+			else
+				_status_strip->SetText(StringUtils::Format("Selected {0} objects", _selected_objects.size()));
+
+			return true;
+
+		}
+		void RoomEditor::_clearObjectSelection() {
+
+			_selected_objects.clear();
+
+		}
+		void RoomEditor::_reloadImage(const std::string& file_path) {
+
+			// If the image is modified again before the previous reload finishes, the previous reload is out of date.
+
+			auto job_iter = _reload_jobs.find(file_path);
+
+			if (job_iter != _reload_jobs.end())
+				job_iter->second->Cancel();
+
+			// The image is decoded on a worker thread, and copied into the existing bitmap afterwards.
+
+			std::shared_ptr<detail::ImageData> image = std::make_shared<detail::ImageData>();
+			std::shared_ptr<uint64_t> content_hash = std::make_shared<uint64_t>(0);
+			std::shared_ptr<bool> loaded = std::make_shared<bool>(false);
+
+			_reload_jobs[file_path] = _jobs.Submit("Reloading " + IO::Path::GetFileName(file_path), [image, content_hash, loaded, file_path](detail::Job& job) {
+
+				*content_hash = detail::BitmapCache::HashFile(file_path);
+				*loaded = image->Load(file_path);
+
+			}, [this, image, content_hash, loaded, file_path](const detail::Job& job) {
+
+				_reload_jobs.erase(file_path);
+
+				if (job.IsFailed())
+					_status_strip->SetText("Failed to reload " + IO::Path::GetFileName(file_path) + ": " + job.Error());
+				else if (*loaded)
+					_applyReloadedImage(file_path, *image, *content_hash);
+				else
+					_status_strip->SetText("Failed to reload " + IO::Path::GetFileName(file_path));
+
+			});
+
+		}
+		void RoomEditor::_applyReloadedImage(const std::string& file_path, const detail::ImageData& image, uint64_t content_hash) {
+
+			// Tilesets and backgrounds share their bitmaps with the room (and tiles are sub-bitmaps of their tileset's bitmap), so overwriting the pixels updates everything at once.
+			// Only the caches built from the tiles need to be updated. Backgrounds are drawn straight from their bitmaps, so nothing needs to be done for them.
+
+			std::string key = detail::BitmapCache::NormalizePath(file_path);
+			bool found = false;
+			bool resized = false;
+			bool failed = false;
+			detail::TileLayer::tile_id_type first_id = 1;
+
+			for (auto i = _tileset_view->Tilesets().begin(); i != _tileset_view->Tilesets().end(); first_id += static_cast<detail::TileLayer::tile_id_type>(i->Count()), ++i) {
+
+				if (detail::BitmapCache::NormalizePath(_tileset_view->GetIdByTileset(*i)) != key)
+					continue;
+
+				Graphics::Bitmap bitmap = i->Bitmap();
+
+				found = true;
+
+				if (bitmap.Width() != image.Width() || bitmap.Height() != image.Height()) {
+
+					resized = true;
+
+					continue;
+
+				}
+
+				if (!image.CopyTo(bitmap)) {
+
+					failed = true;
+
+					continue;
+
+				}
+
+				detail::TileLayer::tile_id_type last_id = first_id + static_cast<detail::TileLayer::tile_id_type>(i->Count()) - 1;
+
+				_tile_overview.InvalidateTiles(_tile_layers, first_id, last_id);
+				_minimap_view->Minimap().InvalidateTiles(_tile_layers, first_id, last_id);
+
+			}
+
+			for (auto i = _backgrounds_view->Backgrounds().begin(); i != _backgrounds_view->Backgrounds().end(); ++i) {
+
+				if (detail::BitmapCache::NormalizePath(_backgrounds_view->GetIdByBackground(*i)) != key)
+					continue;
+
+				Graphics::Bitmap bitmap = i->Bitmap();
+
+				found = true;
+
+				if (bitmap.Width() != image.Width() || bitmap.Height() != image.Height())
+					resized = true;
+				else if (!image.CopyTo(bitmap))
+					failed = true;
+
+			}
+
+			if (!found)
+				return;
+
+			// A tileset with a different size would have a different number of tiles, which can't be updated in place.
+
+			if (resized) {
+
+				_status_strip->SetText(IO::Path::GetFileName(file_path) + " has changed size, and will be updated when the room is reopened");
+
+				return;
+
+			}
+
+			// The cache keeps the old hash, so the file will be reloaded again the next time it changes.
+
+			if (failed) {
+
+				_status_strip->SetText("Failed to update the bitmap for " + IO::Path::GetFileName(file_path));
+
+				return;
+
+			}
+
+			_bitmap_cache.Refresh(file_path, content_hash);
+
+			_status_strip->SetText("Reloaded " + IO::Path::GetFileName(file_path));
+
+		}
+		void RoomEditor::_initializeUi() {
+
+			_initializeUiStyles();
+
+			_updateWindowTitle();
+			_initializeMenuStrip();
+			_initializeToolStrip();
+
+			_tileset_view = new RoomEditorTilesetsWidget(this);
+			_tileset_view->SetDockStyle(hvn3::Gui::DockStyle::Fill);
+
+			// Registries can hold thousands of types, so they're listed in a virtualized list rather than creating a widget for each one. The registry keeps them sorted by name.
+
+			_objects_view = new RoomEditorListWidget;
+			_objects_view->SetVisible(false);
+			_objects_view->SetDockStyle(hvn3::Gui::DockStyle::Fill);
+			_objects_view->SetItems(_object_registry.Count(), [this](size_t index) { return String(_object_registry.GetName(_object_registry.Types()[index])); });
+
+			// Selecting an object in the outliner selects it in the room, and moves the view to it.
+
+			_outliner_view = new RoomEditorListWidget;
+			_outliner_view->SetVisible(false);
+			_outliner_view->SetDockStyle(hvn3::Gui::DockStyle::Bottom);
+			_outliner_view->SetHeight(250.0f);
+			_outliner_view->SetItems(0, [this](size_t index) -> String {
+
+				if (index >= _outliner_items.size() || !_outliner_items[index])
+					return String();
+
+				const IObjectPtr& object = _outliner_items[index].Object();
+				const String* name = _object_list.GetProperty(object.get(), "name");
+				PointF position = object->Position();
+
+				return StringUtils::Format("{0} ({1}, {2})", name == nullptr ? String() : *name, position.x, position.y);
+
+			});
+			_outliner_view->SetSelectedItemChangedCallback([this](size_t index) {
+
+				if (index >= _outliner_items.size() || !_outliner_items[index] || !_room)
+					return;
+
+				_selected_object = _outliner_items[index];
+
+				_setViewCenter(_selected_object.Object()->Position());
+
+			});
+
+			_backgrounds_view = new RoomEditorBackgroundsWidget(this);
+
+			_views_view = new RoomEditorViewsWidget;
+
+			_minimap_view = new RoomEditorMinimapWidget(this);
+			_minimap_view->Minimap().SetTileColorCallback([this](detail::TileLayer::tile_id_type id) { return _getTileColor(id); });
+
+			hvn3::Gui::Window* window = new hvn3::Gui::Window(0.0f, 0.0f, 300.0f, 0.0f, "");
+			window->SetDockStyle(hvn3::Gui::DockStyle::Left);
+			window->SetTitleBarVisible(false);
+			window->GetChildren().Add(_tileset_view);
+			window->GetChildren().Add(_objects_view);
+			window->GetChildren().Add(_outliner_view);
+			window->GetChildren().Add(_backgrounds_view);
+			window->GetChildren().Add(_views_view);
+			window->GetChildren().Add(_minimap_view);
+
+			_status_strip = new RoomEditorStatusStripWidget;
+			_status_strip->SetDockStyle(Gui::DockStyle::Bottom);
+			_status_strip->SetText("Create a new room with \"File > New Room\".");
+
+			_room_view = new RoomEditorRoomViewWidget(this);
+			_room_view->SetWidth(200.0f);
+			_room_view->SetDockStyle(Gui::DockStyle::Fill);
+			_room_view->SetEventHandler<Gui::WidgetEventType::OnMouseDown>([this](Gui::WidgetMouseDownEventArgs& e) { _roomView_OnMouseDown(e); });
+			_room_view->SetEventHandler<Gui::WidgetEventType::OnMousePressed>([this](Gui::WidgetMousePressedEventArgs& e) { _roomView_OnMousePressed(e); });
+
+			_widgets.Add(window);
+			_widgets.Add(_status_strip);
+			_widgets.Add(_room_view);
+
+			_left_panel = window;
+
+		}
+		void RoomEditor::_initializeUiStyles() {
+
+			// Create a style instance that will be used as a template for a few different buttons.
+
+			Gui::WidgetStyle style;
+
+			Gui::WidgetStyle::BackgroundPositionProperty background_position;
+			background_position.flags = Gui::WidgetStyle::PositionFlags::Center;
+			style.SetProperty<Gui::WidgetProperty::BackgroundPosition>(background_position);
+
+			// Buttons use icons from a single packed bitmap, so that they share a texture. After the first run, the packed bitmap is read from the disk cache instead of decoding each icon.
+
+			_icon_atlas.Load("bin/system/icons", { "tile", "object", "background", "arrow_d", "arrow_u", "camera", "tileset", "layers", "flags" }, &_disk_image_cache);
+
+			// Create and add styles.
+
+			style.SetProperty<Gui::WidgetProperty::BackgroundImage>(_icon_atlas.Icon("tile"));
+			_widgets.Renderer()->AddStyle(".tile_btn", style);
+
+			style.SetProperty<Gui::WidgetProperty::BackgroundImage>(_icon_atlas.Icon("object"));
+			_widgets.Renderer()->AddStyle(".object_btn", style);
+
+			style.SetProperty<Gui::WidgetProperty::BackgroundImage>(_icon_atlas.Icon("background"));
+			_widgets.Renderer()->AddStyle(".background_btn", style);
+
+			style.SetProperty<Gui::WidgetProperty::BackgroundImage>(_icon_atlas.Icon("arrow_d"));
+			_widgets.Renderer()->AddStyle(".arrow_d", style);
+
+			style.SetProperty<Gui::WidgetProperty::BackgroundImage>(_icon_atlas.Icon("arrow_u"));
+			_widgets.Renderer()->AddStyle(".arrow_u", style);
+
+			style.SetProperty<Gui::WidgetProperty::BackgroundImage>(_icon_atlas.Icon("camera"));
+			_widgets.Renderer()->AddStyle(".view_btn", style);
+
+			style.SetProperty<Gui::WidgetProperty::BackgroundImage>(_icon_atlas.Icon("tileset"));
+			_widgets.Renderer()->AddStyle(".tileset_btn", style);
+
+			style.SetProperty<Gui::WidgetProperty::BackgroundImage>(_icon_atlas.Icon("layers"));
+			_widgets.Renderer()->AddStyle(".layers_btn", style);
+
+			style.SetProperty<Gui::WidgetProperty::BackgroundImage>(_icon_atlas.Icon("flags"));
+			_widgets.Renderer()->AddStyle(".flags_btn", style);
+
+		}
+		void RoomEditor::_initializeMenuStrip() {
+
+			hvn3::Gui::ContextMenu* file_cm = new hvn3::Gui::ContextMenu;
+			file_cm->AddItem("New\t\t\t\tCtrl+N")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) { _showRoomNewDialog(); });
+			file_cm->AddItem("Open...\t\tCtrl+O")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) { _showRoomOpenDialog(); });
+			file_cm->AddItem("Save\t\t\t\tCtrl+S")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) {	_showRoomSaveDialog(); });
+			file_cm->AddItem("Save As...")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) {	_showRoomSaveAsDialog(); });
+			file_cm->AddItem("Export with Atlases...")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) { _showRoomExportDialog(); });
+			file_cm->AddItem("Stream Room")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) { _enableStreaming(); });
+			file_cm->AddItem("Bake Collision...")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) { _showBakeCollisionDialog(); });
+			file_cm->AddSeparator();
+			file_cm->AddItem("Preferences...")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) { _showPreferencesDialog(); });
+			file_cm->AddSeparator();
+			file_cm->AddItem("Exit")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) {	_context.Get<GAME_MANAGER>().Exit(); });
+
+			hvn3::Gui::ContextMenu* view_cm = new hvn3::Gui::ContextMenu;
+
+			auto view_cm_grid_item = view_cm->AddItem("Grid", true);
+
+			view_cm_grid_item->SetEventHandler<Gui::WidgetEventType::OnMousePressed>([=](Gui::WidgetMousePressedEventArgs& e) {
+				view_cm_grid_item->SetChecked(!view_cm_grid_item->Checked());
+				_room_view->SetGridVisible(view_cm_grid_item->Checked());
+			});
+
+			auto view_cm_foregrounds_item = view_cm->AddItem("Foregrounds", true);
+
+			view_cm_foregrounds_item->SetEventHandler<Gui::WidgetEventType::OnMousePressed>([=](Gui::WidgetMousePressedEventArgs& e) {
+
+				if (!_room)
+					return;
+
+				view_cm_foregrounds_item->SetChecked(!view_cm_foregrounds_item->Checked());
+
+				Room()->Backgrounds().ForEach([=](Background& i) {
+
+					if (i.IsForeground())
+						i.SetVisible(view_cm_foregrounds_item->Checked());
+
+					HVN3_CONTINUE;
+
+				});
+
+			});
+
+			view_cm->AddSeparator();
+
+			// The view stays wherever it's moved to (by the minimap, the outliner or dragging), so this returns it to where it starts when a room is opened.
+
+			view_cm->AddItem("Reset View")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) {
+
+				if (!_room)
+					return;
+
+				_zoom_level = 0;
+				_resetRoomView();
+
+				_status_strip->SetText("Zoom: 1x");
+
+			});
+
+			hvn3::Gui::ContextMenu* edit_cm = new hvn3::Gui::ContextMenu;
+			edit_cm->AddItem("Cut\t\t\t\tCtrl+X")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) { _copySelection(true); });
+			edit_cm->AddItem("Copy\t\t\t\tCtrl+C")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) { _copySelection(false); });
+			edit_cm->AddItem("Paste\t\t\t\tCtrl+V")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) { _pasteClipboard(); });
+			edit_cm->AddSeparator();
+			edit_cm->AddItem("Find Objects...\tCtrl+F")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) { _showFindObjectsDialog(); });
+			edit_cm->AddItem("Clear Object Selection")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) { _clearObjectSelection(); });
+			edit_cm->AddSeparator();
+			edit_cm->AddItem("Create Prefab from Selected Object...")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) { _showCreatePrefabDialog(); });
+			edit_cm->AddItem("Scatter Brush...\tCtrl+B")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) { _showScatterBrushDialog(); });
+
+			hvn3::Gui::ContextMenu* test_cm = new hvn3::Gui::ContextMenu;
+			test_cm->AddItem("Playtest\t\t\tF5")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) { _startPlaytest(); });
+
+			hvn3::Gui::MenuStrip* ms = new hvn3::Gui::MenuStrip;
+			ms->AddItem("File")->SetContextMenu(file_cm);
+			ms->AddItem("Edit")->SetContextMenu(edit_cm);
+			ms->AddItem("View")->SetContextMenu(view_cm);
+			ms->AddItem("Test")->SetContextMenu(test_cm);
+
+			_widgets.Add(ms);
+
+		}
+		void RoomEditor::_initializeToolStrip() {
+
+			Gui::MenuStrip* ms = new Gui::MenuStrip;
+			Gui::MenuStripItem* item = nullptr;
+
+			// Add button (tiles).
+			item = ms->AddItem("");
+			item->AddId(".tile_btn");
+			item->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) {
+				_hideAllPanelWindows();
+				_tileset_view->SetVisible(true);
+				_editor_mode = EDITOR_MODE_TILES;
+			});
+
+			// Add button (objects).
+			item = ms->AddItem("");
+			item->AddId(".object_btn");
+			item->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) {
+				_hideAllPanelWindows();
+				_objects_view->SetVisible(true);
+				_outliner_view->SetVisible(true);
+				_editor_mode = EDITOR_MODE_OBJECTS;
+			});
+
+			// Add button (backgrounds).
+			item = ms->AddItem("");
+			item->AddId(".background_btn");
+			item->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) {
+				_hideAllPanelWindows();
+				_backgrounds_view->SetVisible(true);
+				_editor_mode = EDITOR_MODE_BACKGROUNDS;
+			});
+
+			// Add button (views).
+			item = ms->AddItem("");
+			item->AddId(".view_btn");
+			item->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) {
+				_hideAllPanelWindows();
+				_views_view->SetVisible(true);
+				_editor_mode = EDITOR_MODE_VIEWS;
+			});
+
+			_widgets.Add(ms);
+
+		}
+		void RoomEditor::_updateWindowTitle() {
+
+			if (!_context)
+				return;
+
+			std::string title;
+
+			if (_current_file.size() > 0)
+				title = IO::Path::GetFileName(_current_file);
+			else
+				title = "untitled";
+
+			if (_has_unsaved_changes)
+				title.push_back('*');
+
+			title += " - " + _editor_name;
+
+			_context.Get<GAME_MANAGER>().Display().SetTitle(title);
+
+		}
+		void RoomEditor::_markUnsavedChanges() {
+
+			_has_unsaved_changes = true;
+			++_change_revision;
+
+			_updateWindowTitle();
+
+		}
+		void RoomEditor::_updateJobProgress() {
+
+			const std::vector<detail::JobPtr>& jobs = _jobs.ActiveJobs();
+
+			if (!_pending_objects.empty()) {
+
+				_status_strip->SetProgressText(StringUtils::Format("Loading objects ({0}%)", static_cast<int>(100 * _pending_objects_loaded / _pending_objects.size())));
+
+				return;
+
+			}
+
+			if (jobs.empty()) {
+
+				_status_strip->SetProgressText("");
+
+				return;
+
+			}
+
+			// Show the progress of the oldest job, since it'll usually finish first.
+
+			String text = StringUtils::Format("{0} ({1}%)", jobs.front()->Name(), static_cast<int>(jobs.front()->Progress() * 100.0f));
+
+			if (jobs.size() > 1)
+				text += StringUtils::Format(" and {0} more", jobs.size() - 1);
+
+			_status_strip->SetProgressText(text);
+
+		}
+		void RoomEditor::_updateOutliner() {
+
+			if (!_outliner_changed)
+				return;
+
+			_outliner_changed = false;
+
+			// The list is patched with the objects removed and added since it was last updated, so only the names of new objects are looked up (when there's a filter to check them against).
+			// Objects keep their place in the list, in the order they were added.
+
+			if (!_outliner_removed.empty()) {
+
+				std::sort(_outliner_removed.begin(), _outliner_removed.end());
+
+				// Objects that were added since the last update aren't in the list yet.
+				auto added_iter = std::lower_bound(_outliner_removed.begin(), _outliner_removed.end(), _outliner_view->Count());
+
+				_outliner_view->Remove(std::vector<size_t>(_outliner_removed.begin(), added_iter));
+
+				size_t count = _outliner_removed.front();
+
+				for (size_t i = count; i < _outliner_items.size(); ++i) {
+
+					if (!_outliner_items[i])
+						continue;
+
+					_outliner_indices[_outliner_items[i].Object().get()] = count;
+					_outliner_items[count++] = std::move(_outliner_items[i]);
+
+				}
+
+				_outliner_items.resize(count);
+				_outliner_removed.clear();
+
+			}
+
+			if (_outliner_items.size() > _outliner_view->Count())
+				_outliner_view->Insert(_outliner_view->Count(), _outliner_items.size() - _outliner_view->Count());
+
+		}
+		void RoomEditor::_hideAllPanelWindows() {
+
+			_objects_view->SetVisible(false);
+			_outliner_view->SetVisible(false);
+			_tileset_view->SetVisible(false);
+			_backgrounds_view->SetVisible(false);
+			_views_view->SetVisible(false);
+
+		}
+		float RoomEditor::_zoomScale() const {
+
+			return _zoom_level >= 0 ? static_cast<float>(1 << _zoom_level) : 1.0f / static_cast<float>(1 << -_zoom_level);
+
+		}
+		void RoomEditor::_setZoomLevel(int level, const PointF& anchor) {
+
+			level = std::max(MIN_ZOOM_LEVEL, std::min(MAX_ZOOM_LEVEL, level));
+
+			if (level == _zoom_level)
+				return;
+
+			PointF anchor_position = _displayPositionToWorldPosition(anchor, false);
+
+			_detachRoomView();
+
+			float old_scale = _zoomScale();
+
+			_zoom_level = level;
+
+			float new_scale = _zoomScale();
+
+			_zoom_center = PointF(anchor_position.x + (_zoom_center.x - anchor_position.x) * old_scale / new_scale, anchor_position.y + (_zoom_center.y - anchor_position.y) * old_scale / new_scale);
+
+			_status_strip->SetText(_zoom_level >= 0 ? StringUtils::Format("Zoom: {0}x", 1 << _zoom_level) : StringUtils::Format("Zoom: 1/{0}x", 1 << -_zoom_level));
+
+		}
+		void RoomEditor::_setViewCenter(const PointF& position) {
+
+			// Rooms are drawn by the editor once they're opened, so this only detaches the RoomView if no room has been opened yet.
+
+			_detachRoomView();
+
+			_zoom_center = position;
+
+		}
+		void RoomEditor::_detachRoomView() {
+
+			if (_room_view_detached)
+				return;
+
+			// Start from whatever the RoomView is currently showing.
+
+			RectangleF bounds = _room_view->Bounds();
+
+			_zoom_center = _room_view->DisplayPositionToWorldPosition(PointF(bounds.X() + bounds.Width() / 2.0f, bounds.Y() + bounds.Height() / 2.0f), false);
+
+			// The RoomView has no way to move its view, so the room is drawn by the editor from now on. Detach it from the RoomView to avoid drawing it twice.
+
+			IRoomPtr no_room;
+			_room_view->SetRoom(no_room);
+
+			_room_view_detached = true;
+
+		}
+		void RoomEditor::_resetRoomView() {
+
+			// Rooms are always drawn by the editor, starting from their top-left corner like the RoomView would.
+
+			RectangleF bounds = _room_view->Bounds();
+
+			_room_view_detached = false;
+
+			_detachRoomView();
+
+			_zoom_center = PointF(bounds.Width() / 2.0f, bounds.Height() / 2.0f);
+
+		}
+		PointF RoomEditor::_displayPositionToWorldPosition(const PointF& position, bool snap_to_grid) {
+
+			if (!_room_view_detached)
+				return _room_view->DisplayPositionToWorldPosition(position, snap_to_grid);
+
+			float scale = _zoomScale();
+			RectangleF bounds = _room_view->Bounds();
+			PointF world_position(_zoom_center.x + (position.x - (bounds.X() + bounds.Width() / 2.0f)) / scale, _zoom_center.y + (position.y - (bounds.Y() + bounds.Height() / 2.0f)) / scale);
+
+			if (snap_to_grid) {
+
+				SizeF cell_size = _room_view->GridCellSize();
+
+				world_position.x = std::floor(world_position.x / cell_size.width) * cell_size.width;
+				world_position.y = std::floor(world_position.y / cell_size.height) * cell_size.height;
+
+			}
+
+			return world_position;
+
+		}
+		PointF RoomEditor::_worldPositionToDisplayPosition(const PointF& position) {
+
+			if (!_room_view_detached)
+				return _room_view->WorldPositionToDisplayPosition(position);
+
+			float scale = _zoomScale();
+			RectangleF bounds = _room_view->Bounds();
+
+			return PointF(bounds.X() + bounds.Width() / 2.0f + (position.x - _zoom_center.x) * scale, bounds.Y() + bounds.Height() / 2.0f + (position.y - _zoom_center.y) * scale);
+
+		}
+		PointF RoomEditor::_displayPositionToGridCell(const PointF& position) {
+
+			if (!_room_view_detached)
+				return _room_view->DisplayPositionToGridCell(position);
+
+			PointF world_position = _displayPositionToWorldPosition(position, false);
+			SizeF cell_size = _room_view->GridCellSize();
+
+			return PointF(std::floor(world_position.x / cell_size.width), std::floor(world_position.y / cell_size.height));
+
+		}
+		void RoomEditor::_showPreferencesDialog() {
+
+			Gui::Window* dialog = new  Gui::Window(250, 200, "Preferences");
+
+			Gui::Label* label_resource_base_dir = new Gui::Label("Resource base directory");
+			Gui::TextBox* textbox_resource_base_dir = new Gui::TextBox(200);
+			Gui::Button* button_resource_base_dir = new Gui::Button("...");
+			Gui::Label* label_grid_w = new Gui::Label("Grid Width");
+			Gui::Label* label_grid_h = new Gui::Label("Grid Height");
+			Gui::TextBox* textbox_grid_w = new Gui::TextBox(100, Gui::InputType::Numeric);
+			Gui::TextBox* textbox_grid_h = new Gui::TextBox(100, Gui::InputType::Numeric);
+			Gui::Button* button_ok = new Gui::Button("OK");
+			button_ok->SetWidth(100);
+
+			textbox_resource_base_dir->SetAnchor(Gui::Anchor::Left | Gui::Anchor::Right);
+			textbox_resource_base_dir->SetText(_resource_base_directory);
+			textbox_grid_w->SetText(StringUtils::ToString(_room_view->GridCellSize().width));
+			textbox_grid_h->SetText(StringUtils::ToString(_room_view->GridCellSize().height));
+			button_ok->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([=](Gui::WidgetMouseClickEventArgs& e) {
+
+				SizeF grid_cell_size = _room_view->GridCellSize();
+
+				StringUtils::TryParse(textbox_grid_w->Text(), grid_cell_size.width);
+				StringUtils::TryParse(textbox_grid_h->Text(), grid_cell_size.height);
+
+				_room_view->SetGridCellSize(grid_cell_size);
+
+				dialog->Close();
+
+			});
+			button_resource_base_dir->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([=](Gui::WidgetMouseClickEventArgs& e) {
+
+				FileDialog fd(FileDialogFlags::Folder);
+				fd.SetInitialDirectory(_resource_base_directory);
+
+				if (fd.ShowDialog()) {
+					_resource_base_directory = fd.FileName();
+					textbox_resource_base_dir->SetText(_resource_base_directory);
+				}
+
+			});
+
+			dialog->GetChildren().Add(label_resource_base_dir);
+			dialog->GetChildren().Add(textbox_resource_base_dir);
+			dialog->GetChildren().Add(button_resource_base_dir);
+			dialog->GetChildren().Add(label_grid_w);
+			dialog->GetChildren().Add(label_grid_h);
+			dialog->GetChildren().Add(textbox_grid_w);
+			dialog->GetChildren().Add(textbox_grid_h);
+			dialog->GetChildren().Add(button_ok);
+
+			_widgets.ShowDialog(std::unique_ptr<Gui::IWidget>(dialog));
+
+			Gui::WidgetLayoutBuilder builder;
+
+			builder.PlaceAt(label_resource_base_dir, PointF(0.0f, 0.0f));
+			builder.PlaceBottom(textbox_resource_base_dir);
+			builder.PlaceRight(button_resource_base_dir);
+			builder.PlaceBottomOf(label_grid_w, textbox_resource_base_dir);
+			builder.PlaceBottom(textbox_grid_w);
+			builder.PlaceRight(textbox_grid_h);
+			builder.PlaceTop(label_grid_h);
+			builder.AnchorToInnerEdge(button_ok, Gui::Anchor::Bottom | Gui::Anchor::Right);
+
+		}
+		void RoomEditor::_showRoomNewDialog() {
+
+			Gui::Window* dialog = new  Gui::Window(250, 200, "New Room");
+			Gui::Button* button_create = new Gui::Button(0, 0, 100, 25, "Create");
+			Gui::Button* button_cancel = new Gui::Button(0, 0, 100, 25, "Cancel");
+
+			Gui::Label* label_w = new Gui::Label("Width (px)");
+			Gui::TextBox* textbox_w = new Gui::TextBox(100, Gui::InputType::Numeric);
+			textbox_w->SetText("640");
+
+			Gui::Label* label_h = new Gui::Label("Height (px)");
+			Gui::TextBox* textbox_h = new Gui::TextBox(100, Gui::InputType::Numeric);
+			textbox_h->SetText("480");
+
+			button_create->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([=](Gui::WidgetMouseClickEventArgs& e) {
+
+				_createNewRoom(StringUtils::Parse<int>(textbox_w->Text()), StringUtils::Parse<int>(textbox_h->Text()));
+				dialog->Close();
+
+			});
+
+			button_cancel->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([=](Gui::WidgetMouseClickEventArgs& e) {
+				dialog->Close();
+			});
+
+			dialog->GetChildren().Add(label_w);
+			dialog->GetChildren().Add(label_h);
+			dialog->GetChildren().Add(textbox_w);
+			dialog->GetChildren().Add(textbox_h);
+			dialog->GetChildren().Add(button_create);
+			dialog->GetChildren().Add(button_cancel);
+
+			_widgets.ShowDialog(std::unique_ptr<Gui::IWidget>(dialog));
+
+			Gui::WidgetLayoutBuilder builder;
+
+			builder.PlaceAt(label_w, PointF(0.0f, 0.0f));
+			builder.PlaceBottom(textbox_w);
+			builder.PlaceRight(textbox_h);
+			builder.CenterHorizontally({ textbox_w, textbox_h });
+			builder.PlaceTopOf(label_w, textbox_w);
+			builder.PlaceTopOf(label_h, textbox_h);
+			builder.AnchorToInnerEdge(button_cancel, Gui::Anchor::Bottom | Gui::Anchor::Right);
+			builder.PlaceLeftOf(button_create, button_cancel);
+
+		}
+		void RoomEditor::_showRoomOpenDialog() {
+
+			FileDialog f(FileDialogFlags::FileMustExist);
+			f.SetFilter("HVN3 Room|*" + _default_file_ext);
+
+			if (_last_directory.size() > 0)
+				f.SetInitialDirectory(_last_directory);
+
+			if (f.ShowDialog())
+				_loadRoomFromFileIntoEditor(f.FileName());
+
+		}
+		void RoomEditor::_showRoomSaveDialog() {
+
+			if (!_room)
+				return;
+
+			if (IO::File::Exists(_current_file))
+				_saveRoomToFile(_current_file, false);
+			else
+				_showRoomSaveAsDialog();
+
+		}
+		void RoomEditor::_showRoomSaveAsDialog() {
+
+			if (!_room)
+				return;
+
+			std::string fname = IO::Path::GetFileName(_current_file);
+
+			if (fname.size() <= 0)
+				fname = "untitled";
+
+			if (!StringUtils::EndsWith(fname, _default_file_ext))
+				fname += _default_file_ext;
+
+			FileDialog f(FileDialogFlags::Save);
+			f.SetDefaultExtension(_default_file_ext);
+			f.SetFilter("hvn3 Room|*" + _default_file_ext);
+			f.SetFileName(IO::Path::GetFileName(fname));
+
+			if (_last_directory.size() > 0)
+				f.SetInitialDirectory(_last_directory);
+
+			if (f.ShowDialog())
+				_saveRoomToFile(f.FileName(), false);
+
+		}
+		void RoomEditor::_showRoomExportDialog() {
+
+			if (!_room)
+				return;
+
+			std::string fname = IO::Path::GetFileName(_current_file);
+
+			if (fname.size() <= 0)
+				fname = "untitled";
+
+			if (!StringUtils::EndsWith(fname, _default_file_ext))
+				fname += _default_file_ext;
+
+			FileDialog f(FileDialogFlags::Save);
+			f.SetDefaultExtension(_default_file_ext);
+			f.SetFilter("hvn3 Room|*" + _default_file_ext);
+			f.SetFileName(IO::Path::GetFileName(fname));
+
+			if (_last_directory.size() > 0)
+				f.SetInitialDirectory(_last_directory);
+
+			if (f.ShowDialog())
+				_exportRoomWithAtlases(f.FileName());
+
+		}
+		void RoomEditor::_showRoomViewContextMenu() {
+
+
+
+		}
+		void RoomEditor::_showFindObjectsDialog() {
+
+			if (!_room)
+				return;
+
+			Gui::Window* dialog = new Gui::Window(300, 150, "Find Objects");
+
+			Gui::Label* label_query = new Gui::Label("Query (e.g. \"enemy and health > 50\")");
+			Gui::TextBox* textbox_query = new Gui::TextBox(250);
+			Gui::Button* button_ok = new Gui::Button("Find");
+
+			textbox_query->SetAnchor(Gui::Anchor::Left | Gui::Anchor::Right);
+			textbox_query->SetText(_last_object_query);
+			button_ok->SetWidth(100);
+
+			// The dialog stays open if the query isn't valid, so that it can be corrected.
+
+			button_ok->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([=](Gui::WidgetMouseClickEventArgs& e) {
+
+				if (_selectObjects(textbox_query->Text()))
+					dialog->Close();
+
+			});
+
+			dialog->GetChildren().Add(label_query);
+			dialog->GetChildren().Add(textbox_query);
+			dialog->GetChildren().Add(button_ok);
+
+			_widgets.ShowDialog(std::unique_ptr<Gui::IWidget>(dialog));
+
+			Gui::WidgetLayoutBuilder builder;
+
+			builder.PlaceAt(label_query, PointF(0.0f, 0.0f));
+			builder.PlaceBottom(textbox_query);
+			builder.AnchorToInnerEdge(button_ok, Gui::Anchor::Bottom | Gui::Anchor::Right);
+
+		}
+		void RoomEditor::_showScatterBrushDialog() {
+
+			Gui::Window* dialog = new Gui::Window(300, 200, "Scatter Brush");
+
+			Gui::Label* label_radius = new Gui::Label("Radius");
+			Gui::Label* label_spacing = new Gui::Label("Spacing");
+			Gui::Label* label_density = new Gui::Label("Density (%)");
+			Gui::TextBox* textbox_radius = new Gui::TextBox(80, Gui::InputType::Numeric);
+			Gui::TextBox* textbox_spacing = new Gui::TextBox(80, Gui::InputType::Numeric);
+			Gui::TextBox* textbox_density = new Gui::TextBox(80, Gui::InputType::Numeric);
+			Gui::Button* button_enable = new Gui::Button("Enable");
+			Gui::Button* button_disable = new Gui::Button("Disable");
+
+			textbox_radius->SetText(StringUtils::ToString(_scatter_brush.Radius()));
+			textbox_spacing->SetText(StringUtils::ToString(_scatter_brush.Spacing()));
+			textbox_density->SetText(StringUtils::ToString(static_cast<int>(std::round(_scatter_brush.Density() * 100.0f))));
+			button_enable->SetWidth(100);
+			button_disable->SetWidth(100);
+
+			button_enable->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([=](Gui::WidgetMouseClickEventArgs& e) {
+
+				float radius = _scatter_brush.Radius();
+				float spacing = _scatter_brush.Spacing();
+				float density = _scatter_brush.Density() * 100.0f;
+
+				StringUtils::TryParse(textbox_radius->Text(), radius);
+				StringUtils::TryParse(textbox_spacing->Text(), spacing);
+				StringUtils::TryParse(textbox_density->Text(), density);
+
+				_scatter_brush.SetRadius(radius);
+				_scatter_brush.SetSpacing(spacing);
+				_scatter_brush.SetDensity(density / 100.0f);
+				_scatter_brush_enabled = true;
+
+				_status_strip->SetText("Drag in objects mode to paint the object selected in the palette");
+
+				dialog->Close();
+
+			});
+			button_disable->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([=](Gui::WidgetMouseClickEventArgs& e) {
+
+				_scatter_brush_enabled = false;
+				_scatter_brush.EndStroke();
+
+				dialog->Close();
+
+			});
+
+			dialog->GetChildren().Add(label_radius);
+			dialog->GetChildren().Add(label_spacing);
+			dialog->GetChildren().Add(label_density);
+			dialog->GetChildren().Add(textbox_radius);
+			dialog->GetChildren().Add(textbox_spacing);
+			dialog->GetChildren().Add(textbox_density);
+			dialog->GetChildren().Add(button_enable);
+			dialog->GetChildren().Add(button_disable);
+
+			_widgets.ShowDialog(std::unique_ptr<Gui::IWidget>(dialog));
+
+			Gui::WidgetLayoutBuilder builder;
+
+			builder.PlaceAt(label_radius, PointF(0.0f, 0.0f));
+			builder.PlaceBottom(textbox_radius);
+			builder.PlaceRight(textbox_spacing);
+			builder.PlaceTop(label_spacing);
+			builder.PlaceRightOf(label_density, label_spacing);
+			builder.PlaceBottom(textbox_density);
+			builder.AnchorToInnerEdge(button_enable, Gui::Anchor::Bottom | Gui::Anchor::Right);
+			builder.PlaceLeftOf(button_disable, button_enable);
+
+		}
+		void RoomEditor::_showCreatePrefabDialog() {
+
+			if (!_room || !_selected_object) {
+
+				_status_strip->SetText("Select an object to create a prefab from");
+
+				return;
+
+			}
+
+			Gui::Window* dialog = new Gui::Window(300, 150, "Create Prefab");
+
+			Gui::Label* label_name = new Gui::Label("Prefab name");
+			Gui::TextBox* textbox_name = new Gui::TextBox(250);
+			Gui::Button* button_ok = new Gui::Button("Create");
+
+			textbox_name->SetAnchor(Gui::Anchor::Left | Gui::Anchor::Right);
+			button_ok->SetWidth(100);
+
+			button_ok->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([=](Gui::WidgetMouseClickEventArgs& e) {
+
+				String name = textbox_name->Text();
+
+				if (name.Length() == 0 || !_selected_object)
+					return;
+
+				// The selected object becomes the first instance of the prefab. Other objects can be made instances by copying it.
+
+				const IObjectPtr& object = _selected_object.Object();
+
+				_object_list.SetPrefab(name, _object_list.GetProperties(object));
+				_object_list.SetObjectPrefab(object.get(), name);
+
+				if (_room_streamer.IsOpen())
+					_room_streamer.MarkModified(object->Position());
+
+				_markUnsavedChanges();
+
+				_status_strip->SetText(StringUtils::Format("Created prefab \"{0}\"", name));
+
+				dialog->Close();
+
+			});
+
+			dialog->GetChildren().Add(label_name);
+			dialog->GetChildren().Add(textbox_name);
+			dialog->GetChildren().Add(button_ok);
+
+			_widgets.ShowDialog(std::unique_ptr<Gui::IWidget>(dialog));
+
+			Gui::WidgetLayoutBuilder builder;
+
+			builder.PlaceAt(label_name, PointF(0.0f, 0.0f));
+			builder.PlaceBottom(textbox_name);
+			builder.AnchorToInnerEdge(button_ok, Gui::Anchor::Bottom | Gui::Anchor::Right);
+
+		}
+		void RoomEditor::_showBakeCollisionDialog() {
+
+			if (!_room)
+				return;
+
+			// The collision file is written next to the room file, so the room needs to have been saved first.
+
+			if (!IO::File::Exists(_current_file)) {
+
+				_status_strip->SetText("Save the room before baking its collision");
+
+				return;
+
+			}
+
+			Gui::Window* dialog = new Gui::Window(300, 150, "Bake Collision");
+
+			Gui::Label* label_file = new Gui::Label("Output: " + IO::Path::GetFileName(_current_file) + ".collision");
+			Gui::CheckBox* checkbox_rectangles = new Gui::CheckBox("Merge flagged tiles into rectangles");
+			Gui::Button* button_ok = new Gui::Button("Bake");
+
+			checkbox_rectangles->SetChecked(true);
+			button_ok->SetWidth(100);
+
+			button_ok->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([=](Gui::WidgetMouseClickEventArgs& e) {
+
+				_bakeCollision(checkbox_rectangles->Checked());
+
+				dialog->Close();
+
+			});
+
+			dialog->GetChildren().Add(label_file);
+			dialog->GetChildren().Add(checkbox_rectangles);
+			dialog->GetChildren().Add(button_ok);
+
+			_widgets.ShowDialog(std::unique_ptr<Gui::IWidget>(dialog));
+
+			Gui::WidgetLayoutBuilder builder;
+
+			builder.PlaceAt(label_file, PointF(0.0f, 0.0f));
+			builder.PlaceBottom(checkbox_rectangles);
+			builder.AnchorToInnerEdge(button_ok, Gui::Anchor::Bottom | Gui::Anchor::Right);
+
+		}
+		void RoomEditor::_loadPreferences() {
+
+			SizeF room_view_grid_cell_size(32.0f, 32.0f);
+
+			if (IO::File::Exists("editor_preferences.xml")) {
+
+				Xml::XmlDocument pref = Xml::XmlDocument::Open("editor_preferences.xml");
+				Xml::XmlElement* node = nullptr;
+
+				if (node = pref.Root().GetChild("last_directory"), node != nullptr)
+					_last_directory = node->Text();
+
+				if (node = pref.Root().GetChild("last_file"), node != nullptr)
+					_current_file = node->Text();
+
+				if (node = pref.Root().GetChild("resource_base_directory"), node != nullptr)
+					_resource_base_directory = node->Text();
+
+				if (node = pref.Root().GetChild("grid"), node != nullptr)
+					room_view_grid_cell_size = SizeF(StringUtils::Parse<float>(node->GetAttribute("w")), StringUtils::Parse<float>(node->GetAttribute("h")));
+
+			}
+
+			// Apply loaded preferences.
+
+			if (_room_view != nullptr)
+				_room_view->SetGridCellSize(room_view_grid_cell_size);
+
+			if (_current_file.size() > 0 && IO::File::Exists(_current_file))
+				_loadRoomFromFileIntoEditor(_current_file);
+
+		}
+		void RoomEditor::_savePreferences() {
+
+			Xml::XmlDocument pref("preferences");
+			pref.Root().AddChild("last_directory")->SetText(_last_directory);
+			pref.Root().AddChild("last_file")->SetText(_current_file);
+			pref.Root().AddChild("resource_base_directory")->SetText(_resource_base_directory);
+
+			Xml::XmlElement* node = pref.Root().AddChild("grid");
+			node->SetAttribute("w", _room_view->GridCellSize().width);
+			node->SetAttribute("h", _room_view->GridCellSize().height);
+
+			pref.Save("editor_preferences.xml");
+
+			_disk_image_cache.Flush();
+
+		}
+		void RoomEditor::_createNewRoom(int width, int height) {
+
+			_cancelLoading();
+			_room_streamer.Close();
+			_clearTileSelection();
+
+			// Create a new room instance and set it as the current instance.
+			if (_room_provider)
+				_room = _room_provider(SizeI(width, height));
+			else
+				_room = hvn3::make_room<>(width, height);
+
+			// Set the room's starting background color.
+			_room->SetBackgroundColor(Color::Silver);
+
+			// Set the tile size to match the grid size.
+			_room->Tiles().SetTileSize(static_cast<SizeI>(_room_view->GridCellSize()));
+
+			// Provide context to the room (normally done by a RoomManager, so we need to handle it manually).
+			ContextChangedEventArgs args(_context);
+			_room->OnContextChanged(args);
+
+			// The room is drawn by the editor rather than the RoomView, since its tiles are only kept in the tile layers.
+			_zoom_level = 0;
+			_resetRoomView();
+
+			_tile_layers.Clear();
+			_tile_overview.SetTileSize(_room->Tiles().TileSize());
+			_tileset_view->SetCurrentLayer(0);
+
+			_selected_object = detail::ObjectList::Item::NULL_ITEM;
+			_selected_objects.clear();
+			_object_renderer.Clear();
+			_object_list.Clear();
+			_unknown_objects.clear();
+			_unknown_page_object_count = 0;
+			_scatter_brush.Clear();
+			_scatter_positions.clear();
+			_snap_index_valid = false;
+
+			_minimap_view->Minimap().Reset(_room->Size(), _room->Tiles().TileSize());
+
+			_current_file = "";
+
+			_markUnsavedChanges();
+
+		}
+		IRoomPtr RoomEditor::_loadRoomFromFileIntoMemory(const std::string& file_path, bool load_resources_into_editor) {
+
+			RoomEditorXmlResourceAdapter<Xml::XmlResourceAdapterBase<>> adapter(this, load_resources_into_editor);
+			Xml::XmlDocument document = Xml::XmlDocument::Open(file_path);
+
+			IRoomPtr room = adapter.ImportRoom(document.Root());
+
+			// Provide context to the room (normally done by a RoomManager, so we need to handle it manually).
+
+			if (room) {
+
+				ContextChangedEventArgs args(_context);
+				room->OnContextChanged(args);
+
+			}
+
+			return room;
+
+		}
+		void RoomEditor::_loadRoomFromFileIntoEditor(const std::string& file_path) {
+
+			_cancelLoading();
+
+			// Reading and parsing the file doesn't touch the editor, so it's done on a worker thread. Everything else needs to happen on the main thread.
+
+			std::shared_ptr<Xml::XmlDocument> document = std::make_shared<Xml::XmlDocument>();
+			std::shared_ptr<std::string> error = std::make_shared<std::string>();
+
+			_load_job = _jobs.Submit("Loading " + IO::Path::GetFileName(file_path), [document, error, file_path](detail::Job& job) {
+
+				try {
+					*document = Xml::XmlDocument::Open(file_path);
+				}
+				catch (const std::exception& ex) {
+					*error = ex.what();
+				}
+
+			}, [this, document, error, file_path](const detail::Job& job) {
+
+				if (job.IsFailed())
+					*error = job.Error();
+
+				if (error->empty())
+					_loadRoomFromDocumentIntoEditor(file_path, document);
+				else
+					_status_strip->SetText("Failed to load room from " + IO::Path::GetFileName(file_path) + ": " + *error);
+
+			});
+
+		}
+		void RoomEditor::_loadRoomFromDocumentIntoEditor(const std::string& file_path, const std::shared_ptr<Xml::XmlDocument>& document) {
+
+			BLOCK_LISTENERS();
+
+			_room_streamer.Close();
+			_pending_pages_file.clear();
+			_tile_layers.Clear();
+			_clearTileSelection();
+
+			_selected_object = detail::ObjectList::Item::NULL_ITEM;
+			_selected_objects.clear();
+			_object_renderer.Clear();
+			_object_list.Clear();
+			_unknown_objects.clear();
+			_unknown_page_object_count = 0;
+			_scatter_brush.Clear();
+			_scatter_positions.clear();
+			_snap_index_valid = false;
+
+			// Everything except for objects is loaded now, so that the room can be shown and edited right away.
+
+			RoomEditorXmlResourceAdapter<Xml::XmlResourceAdapterBase<>> adapter(this, true, true);
+
+			_pending_document = document;
+			_pending_objects.clear();
+			_pending_objects_loaded = 0;
+			_invalid_property_count = 0;
+			_invalid_chunk_count = 0;
+
+			_room = adapter.ImportRoom(document->Root());
+
+			ContextChangedEventArgs args(_context);
+			_room->OnContextChanged(args);
+
+			_tile_overview.SetTileSize(_room->Tiles().TileSize());
+			_tileset_view->SetCurrentLayer(0);
+
+			_zoom_level = 0;
+			_resetRoomView();
+			_room_view->SetGridCellSize(static_cast<SizeF>(_room->Tiles().TileSize()));
+
+			// The minimap is redrawn over the next few frames rather than all at once.
+			_minimap_view->Minimap().Reset(_room->Size(), _room->Tiles().TileSize());
+
+			_last_directory = IO::Path::GetDirectoryName(file_path);
+			_current_file = file_path;
+
+			_has_unsaved_changes = false;
+			_updateWindowTitle();
+
+			UNBLOCK_LISTENERS();
+
+			// The tiles and objects of large rooms are streamed from their page file as the view moves, which requires the editor to draw the room itself.
+
+			if (!_pending_pages_file.empty()) {
+
+				bool opened = _room_streamer.Open(_pending_pages_file, _room->Tiles().TileSize());
+				std::string pages_file_name = IO::Path::GetFileName(_pending_pages_file);
+
+				_pending_pages_file.clear();
+
+				if (!opened) {
+
+					_status_strip->SetText("Failed to open " + pages_file_name);
+
+					return;
+
+				}
+
+			}
+
+			_status_strip->SetText("Successfully loaded room from " + IO::Path::GetFileName(file_path));
+
+		}
+		void RoomEditor::_loadPendingObjects(size_t max_count) {
+
+			if (_pending_objects.empty())
+				return;
+
+			RoomEditorXmlResourceAdapter<Xml::XmlResourceAdapterBase<>> adapter(this, true);
+
+			BLOCK_LISTENERS();
+
+			size_t last = std::min(_pending_objects.size(), _pending_objects_loaded + max_count);
+
+			for (; _pending_objects_loaded < last; ++_pending_objects_loaded) {
+
+				IObjectPtr object = adapter.ImportObject(*_pending_objects[_pending_objects_loaded]);
+
+				// Objects of types that aren't in the registry are kept by the adapter instead.
+
+				if (!object)
+					continue;
+
+				_room->Objects().Add(object);
+				_minimap_view->Minimap().AddObject(object->Position());
+
+			}
+
+			UNBLOCK_LISTENERS();
+
+			_object_renderer.Invalidate();
+
+			if (_pending_objects_loaded >= _pending_objects.size()) {
+
+				_pending_objects.clear();
+				_pending_document.reset();
+
+				// Unreadable chunks are reported over everything else, since their tiles have been lost rather than corrected.
+
+				if (_invalid_chunk_count > 0)
+					_status_strip->SetText(StringUtils::Format("{0} tile chunks could not be read, and have been left empty", _invalid_chunk_count));
+				else if (!_unknown_objects.empty())
+					_status_strip->SetText(StringUtils::Format("{0} objects have types that aren't registered. They'll be saved as they are, but can't be edited", _unknown_objects.size()));
+				else if (_invalid_property_count > 0)
+					_status_strip->SetText(StringUtils::Format("{0} object properties were unknown or invalid, and have been corrected", _invalid_property_count));
+
+			}
+
+		}
+		void RoomEditor::_finishLoadingObjects() {
+
+			_loadPendingObjects(_pending_objects.size());
+
+		}
+		void RoomEditor::_cancelLoading() {
+
+			if (_load_job)
+				_load_job->Cancel();
+
+			_pending_objects.clear();
+			_pending_document.reset();
+
+		}
+		bool RoomEditor::_beginExport(std::vector<detail::RoomStreamer::PageObject>& unloaded_objects) {
+
+			// The pages that aren't in memory are read first, since waiting for the pages being loaded can make more of them resident.
+
+			_exported_chunks.clear();
+
+			bool success = _room_streamer.ForEachUnloaded([&](int layer, int chunk_x, int chunk_y, const detail::TileLayer::Chunk& chunk) {
+
+				_copyChunkToRoom(layer, chunk_x, chunk_y, &chunk);
+
+				_exported_chunks.emplace_back(layer, chunk_x, chunk_y);
+
+			}, [&](const detail::RoomStreamer::PageObject& object) {
+				unloaded_objects.push_back(object);
+			});
+
+			for (int i = 0; i < _tile_layers.Count(); ++i) {
+
+				_tile_layers.FindLayer(i)->ForEachChunk([&](int chunk_x, int chunk_y, const detail::TileLayer::Chunk& chunk) {
+					_copyChunkToRoom(i, chunk_x, chunk_y, &chunk);
+				});
+
+			}
+
+			return success;
+
+		}
+		void RoomEditor::_endExport() {
+
+			for (int i = 0; i < _tile_layers.Count(); ++i) {
+
+				_tile_layers.FindLayer(i)->ForEachChunk([&](int chunk_x, int chunk_y, const detail::TileLayer::Chunk&) {
+					_copyChunkToRoom(i, chunk_x, chunk_y, nullptr);
+				});
+
+			}
+
+			for (auto i = _exported_chunks.begin(); i != _exported_chunks.end(); ++i)
+				_copyChunkToRoom(std::get<0>(*i), std::get<1>(*i), std::get<2>(*i), nullptr);
+
+			_exported_chunks.clear();
+
+		}
+		void RoomEditor::_enableStreaming() {
+
+			if (!_room)
+				return;
+
+			if (_room_streamer.IsOpen()) {
+
+				_status_strip->SetText("This room is already being streamed");
+
+				return;
+
+			}
+
+			// Objects that haven't been loaded yet would otherwise be left out of the pages.
+			_finishLoadingObjects();
+
+			_room_streamer.Attach(_room->Tiles().TileSize());
+
+			// The objects of streamed rooms are stored in their pages instead of the room.
+
+			for (auto i = _object_list.begin(); i != _object_list.end(); ++i)
+				i->Object()->Destroy();
+
+			_markUnsavedChanges();
+
+			_status_strip->SetText("The room will be streamed from a page file next to it once it's saved");
+
+		}
+		bool RoomEditor::_saveRoomToFile(const std::string& file_path, bool is_temporary_file) {
+
+			assert(static_cast<bool>(_room));
+
+			// Objects that haven't been loaded yet would otherwise be missing from the file.
+			_finishLoadingObjects();
+
+			if (!is_temporary_file) {
+
+				// Wait for the previous save to finish before anything is written, so that saves to the same file are written in order.
+				// Its completion is left for the next update, rather than running (along with any others) in the middle of this save.
+
+				if (_save_job)
+					_jobs.Join(_save_job);
+
+				// Streamed rooms also store their tiles and objects in a separate page file, which the editor streams them from when they're opened again.
+				// The page file is written first, since the room file refers to it.
+
+				if (_room_streamer.IsOpen() && !_room_streamer.Save(file_path + ".pages")) {
+
+					_status_strip->SetText("Failed to save room to " + IO::Path::GetFileName(file_path));
+
+					return false;
+
+				}
+
+			}
+
+			RoomEditorXmlResourceAdapter<Xml::XmlResourceAdapterBase<>> adapter(this, false);
+			std::shared_ptr<Xml::XmlDocument> document = std::make_shared<Xml::XmlDocument>();
+			std::vector<detail::RoomStreamer::PageObject> unloaded_objects;
+
+			// The whole room is always written in the base format, which is the one the game loads rooms from, including the parts of streamed rooms that aren't in memory.
+
+			bool exported = _beginExport(unloaded_objects);
+
+			if (exported) {
+
+				adapter.SetUnloadedObjects(&unloaded_objects);
+				adapter.ExportRoom(_room, document->Root());
+
+			}
+
+			_endExport();
+
+			if (!exported) {
+
+				_status_strip->SetText("Failed to save room to " + IO::Path::GetFileName(file_path) + ": some of its pages couldn't be read");
+
+				return false;
+
+			}
+
+			if (is_temporary_file)
+				document->Save(file_path);
+			else {
+
+				// Writing large rooms can take a while, so the file is written on a worker thread.
+				// The room is only marked as saved once the file has been written, and only if it wasn't changed in the meantime.
+
+				std::string file_name = IO::Path::GetFileName(file_path);
+				size_t change_revision = _change_revision;
+
+				_save_job = _jobs.Submit("Saving " + file_name, [document, file_path](detail::Job& job) {
+					document->Save(file_path);
+				}, [this, file_name, change_revision](const detail::Job& job) {
+
+					if (job.IsFailed()) {
+
+						_status_strip->SetText("Failed to save room to " + file_name + ": " + job.Error());
+
+						return;
+
+					}
+
+					if (change_revision == _change_revision) {
+
+						_has_unsaved_changes = false;
+						_updateWindowTitle();
+
+					}
+
+					// Streaming is only suggested, since the page file is only read by the editor.
+
+					if (!_room_streamer.IsOpen() && detail::RoomStreamer::IsLargeRoom(_room->Tiles().Columns(), _room->Tiles().Rows()))
+						_status_strip->SetText("Successfully saved room to " + file_name + ". It's large enough that streaming it (File > Stream Room) would make it faster to edit.");
+					else
+						_status_strip->SetText("Successfully saved room to " + file_name);
+
+				});
+
+				_save_job->SetCancellable(false);
+
+			}
+
+			// Write metadata files for tilesets.
+
+			// Update the tileset list with the current tileset in case it was modified (flags, etc.).
+
+			if (_tileset_view->Tilesets().size() > 0)
+				*_tileset_view->GetTilesetById(_tileset_view->GetIdByTileset(_tileset_view->TilesetView()->Tileset())) = _tileset_view->TilesetView()->Tileset();
+
+			for (auto i = _tileset_view->Tilesets().begin(); i != _tileset_view->Tilesets().end(); ++i) {
+
+				Xml::XmlDocument meta("tileset");
+
+				meta.Root().SetAttribute("version", 0.1f);
+				meta.Root().SetAttribute("tile_width", i->TileSize().width);
+				meta.Root().SetAttribute("tile_height", i->TileSize().height);
+
+				std::stringstream flags;
+				for (size_t j = 0; j < i->Count(); ++j)
+					flags << i->At(j).flag << ',';
+
+				meta.Root().AddChild("flags")->SetText(flags.str());
+
+				const detail::AutoTiler* auto_tiler = _tileset_view->GetAutoTilerByTileset(*i);
+
+				if (auto_tiler != nullptr && auto_tiler->TerrainCount() > 0) {
+
+					Xml::XmlElement* terrains_node = meta.Root().AddChild("terrains");
+
+					for (int j = 0; j < auto_tiler->TerrainCount(); ++j) {
+
+						Xml::XmlElement* terrain_node = terrains_node->AddChild("terrain");
+						terrain_node->SetAttribute("first", auto_tiler->TerrainFirstTile(j));
+						terrain_node->SetAttribute("layout", auto_tiler->TerrainLayout(j) == detail::AutoTiler::Layout::Edge16 ? "edge16" : "blob47");
+
+					}
+
+				}
+
+				meta.Save(IO::Path::SetExtension(_tileset_view->GetIdByTileset(*i), ".xml"));
+
+			}
+
+			if (!is_temporary_file) {
+
+				_last_directory = IO::Path::GetDirectoryName(file_path);
+				_current_file = file_path;
+
+				_updateWindowTitle();
+
+			}
+
+			return true;
+
+		}
+		void RoomEditor::_bakeCollision(bool merge_rectangles) {
+
+			assert(static_cast<bool>(_room));
+
+			// Update the tileset list with the current tileset in case its flags were modified.
+
+			if (_tileset_view->Tilesets().size() > 0)
+				*_tileset_view->GetTilesetById(_tileset_view->GetIdByTileset(_tileset_view->TilesetView()->Tileset())) = _tileset_view->TilesetView()->Tileset();
+
+			// Tile indices continue from one tileset to the next, in the order the tilesets were added. Index 0 is the empty tile.
+
+			std::vector<uint32_t> flags(1, 0);
+
+			for (auto i = _tileset_view->Tilesets().begin(); i != _tileset_view->Tilesets().end(); ++i)
+				for (size_t j = 0; j < i->Count(); ++j)
+					flags.push_back(static_cast<uint32_t>(i->At(j).flag));
+
+			std::shared_ptr<detail::CollisionBake> bake = std::make_shared<detail::CollisionBake>(_room->Tiles().Columns(), _room->Tiles().Rows(), _room->Tiles().TileSize());
+
+			bake->SetFlags(std::move(flags));
+
+			// The tiles are read on the main thread, since that's where the tile layers are edited. Merging and writing are done on a worker thread.
+			// Streamed rooms also need the pages that aren't in memory, which are read directly from the page file.
+
+			for (int i = 0; i < _tile_layers.Count(); ++i)
+				_tile_layers.FindLayer(i)->ForEachChunk([&](int chunk_x, int chunk_y, const detail::TileLayer::Chunk& chunk) {
+					bake->AddChunk(i, chunk_x, chunk_y, chunk);
+				});
+
+			if (_room_streamer.IsOpen() && !_room_streamer.ForEachUnloaded([&](int layer, int chunk_x, int chunk_y, const detail::TileLayer::Chunk& chunk) {
+				bake->AddChunk(layer, chunk_x, chunk_y, chunk);
+			}, nullptr)) {
+
+				_status_strip->SetText("Failed to bake collision, since some of the room's pages couldn't be read");
+
+				return;
+
+			}
+
+			std::string file_path = _current_file + ".collision";
+			std::string file_name = IO::Path::GetFileName(file_path);
+			std::shared_ptr<bool> success = std::make_shared<bool>(false);
+
+			_jobs.Submit("Baking " + file_name, [bake, merge_rectangles, file_path, success](detail::Job& job) {
+
+				if (merge_rectangles)
+					bake->MergeRectangles();
+
+				*success = bake->Write(file_path);
+
+			}, [this, bake, file_name, success](const detail::Job& job) {
+
+				if (job.IsFailed())
+					_status_strip->SetText("Failed to bake collision to " + file_name + ": " + job.Error());
+				else if (*success)
+					_status_strip->SetText(StringUtils::Format("Baked {0} flag grids and {1} rectangles to {2}", bake->PlaneCount(), bake->RectangleCount(), file_name));
+				else
+					_status_strip->SetText("Failed to write " + file_name);
+
+			});
+
+		}
+		void RoomEditor::_exportRoomWithAtlases(const std::string& file_path) {
+
+			assert(static_cast<bool>(_room));
+
+			// Objects that haven't been loaded yet would otherwise be missing from the file.
+			_finishLoadingObjects();
+
+			// Collect the images of every tileset and background, once each.
+
+			std::vector<std::string> image_ids;
+			std::unordered_set<std::string> normalized_ids;
+
+			auto addImage = [&](const std::string& id) {
+				if (!id.empty() && normalized_ids.insert(detail::BitmapCache::NormalizePath(id)).second)
+					image_ids.push_back(id);
+			};
+
+			for (auto i = _tileset_view->Tilesets().begin(); i != _tileset_view->Tilesets().end(); ++i)
+				addImage(_tileset_view->GetIdByTileset(*i));
+
+			for (auto i = _backgrounds_view->Backgrounds().begin(); i != _backgrounds_view->Backgrounds().end(); ++i)
+				addImage(_backgrounds_view->GetIdByBackground(*i));
+
+			if (image_ids.empty()) {
+
+				_status_strip->SetText("The room doesn't use any images to pack");
+
+				return;
+
+			}
+
+			// Only the sizes of the images are needed to pack them, and they're already loaded. The atlases themselves are drawn on a worker thread.
+
+			detail::AtlasPacker packer(MAX_ATLAS_SIZE, 1);
+
+			for (auto i = image_ids.begin(); i != image_ids.end(); ++i) {
+
+				Graphics::Bitmap bitmap = _bitmap_cache.Load(*i);
+
+				packer.Add(bitmap.Width(), bitmap.Height());
+
+			}
+
+			packer.Pack();
+
+			std::vector<std::string> atlas_paths;
+			std::vector<SizeI> atlas_sizes;
+
+			for (size_t i = 0; i < packer.PageCount(); ++i) {
+
+				atlas_paths.push_back(StringUtils::Format("{0}.atlas{1}.png", file_path, i));
+				atlas_sizes.push_back(packer.PageSize(i));
+
+			}
+
+			RoomEditorXmlResourceAdapter<Xml::XmlResourceAdapterBase<>>::atlas_region_map_type regions;
+
+			for (size_t i = 0; i < image_ids.size(); ++i) {
+
+				const detail::AtlasPacker::Placement& placement = packer.At(i);
+				Graphics::Bitmap bitmap = _bitmap_cache.Load(image_ids[i]);
+
+				RoomEditorXmlResourceAdapter<Xml::XmlResourceAdapterBase<>>::AtlasRegion region;
+				region.atlas = _makePathRelativeToResourceBaseDirectory(atlas_paths[placement.page]);
+				region.region = RectangleI(placement.x, placement.y, bitmap.Width(), bitmap.Height());
+
+				regions.emplace(image_ids[i], region);
+
+			}
+
+			RoomEditorXmlResourceAdapter<Xml::XmlResourceAdapterBase<>> adapter(this, false);
+			std::shared_ptr<Xml::XmlDocument> document = std::make_shared<Xml::XmlDocument>();
+
+			std::vector<detail::RoomStreamer::PageObject> unloaded_objects;
+
+			adapter.SetAtlasRegions(&regions);
+
+			bool exported = _beginExport(unloaded_objects);
+
+			if (exported) {
+
+				adapter.SetUnloadedObjects(&unloaded_objects);
+				adapter.ExportRoom(_room, document->Root());
+
+			}
+
+			_endExport();
+
+			if (!exported) {
+
+				_status_strip->SetText("Failed to export " + IO::Path::GetFileName(file_path) + ": some of its pages couldn't be read");
+
+				return;
+
+			}
+
+			std::vector<detail::AtlasPacker::Placement> placements;
+
+			for (size_t i = 0; i < image_ids.size(); ++i)
+				placements.push_back(packer.At(i));
+
+			std::shared_ptr<bool> success = std::make_shared<bool>(true);
+			std::string file_name = IO::Path::GetFileName(file_path);
+			float efficiency = packer.Efficiency();
+
+			_jobs.Submit("Exporting " + file_name, [document, file_path, image_ids, placements, atlas_paths, atlas_sizes, success](detail::Job& job) {
+
+				std::vector<detail::ImageData> atlases(atlas_sizes.size());
+
+				for (size_t i = 0; i < atlases.size(); ++i)
+					atlases[i].Create(atlas_sizes[i].width, atlas_sizes[i].height);
+
+				// Each image is decoded once and copied into its atlas.
+
+				for (size_t i = 0; i < image_ids.size(); ++i) {
+
+					detail::ImageData image;
+
+					if (!image.Load(image_ids[i]))
+						*success = false;
+					else
+						atlases[placements[i].page].Draw(image, placements[i].x, placements[i].y);
+
+					job.SetProgress(static_cast<float>(i + 1) / static_cast<float>(image_ids.size()));
+
+				}
+
+				for (size_t i = 0; i < atlases.size(); ++i)
+					if (!atlases[i].Save(atlas_paths[i]))
+						*success = false;
+
+				document->Save(file_path);
+
+			}, [this, file_name, success, image_ids, atlas_paths, efficiency](const detail::Job& job) {
+
+				if (job.IsFailed())
+					_status_strip->SetText("Failed to export " + file_name + ": " + job.Error());
+				else if (*success)
+					_status_strip->SetText(StringUtils::Format("Exported {0} with {1} images packed into {2} atlases ({3}% of the atlas area used)", file_name, image_ids.size(), atlas_paths.size(), static_cast<int>(std::round(efficiency * 100.0f))));
+				else
+					_status_strip->SetText("Exported " + file_name + ", but some of its images couldn't be packed");
+
+			});
+
+		}
+		void RoomEditor::_startPlaytest() {
+
+			if (!_room)
+				return;
+
+			// Export the room to a temporary file.
+			std::string temp_path = IO::Path::GetTemporaryFilePath();
+
+			if (!_saveRoomToFile(temp_path, true))
+				return;
+
+			// Import the room back from the temporary file (why not just parse XML from string?).
+			IRoomPtr test_room = _loadRoomFromFileIntoMemory(temp_path, false);
+			test_room->Objects().Create<BackToEditorObject>(_context.Get<ROOM_MANAGER>().Room());
+
+			_properties_exit_with_esc = _context.Get<GAME_MANAGER>().Properties().ExitWithEscapeKey;
+			_context.Get<GAME_MANAGER>().Properties().ExitWithEscapeKey = false;
+
+			_context.Get<ROOM_MANAGER>().SetRoom(test_room);
+
+		}
+		void RoomEditor::_roomView_OnMouseDown(Gui::WidgetMouseDownEventArgs& e) {
+
+			if (!_room)
+				return;
+
+			if (_editor_mode == EDITOR_MODE_TILES) {
+
+				if (_tileset_view->TilesetView() == nullptr || !_room_view->HasFocus())
+					return;
+
+				if (e.Button() != MouseButton::Left && e.Button() != MouseButton::Right)
+					return;
+
+				// Tiles aren't painted while selecting a region.
+
+				if (_marquee_active || (HasFlag(_key_modifiers, KeyModifiers::Control) && HasFlag(_key_modifiers, KeyModifiers::Shift)))
+					return;
+
+				hvn3::RectangleI tile_selection = _tileset_view->TilesetView()->SelectedRegion();
+				hvn3::PointF tile_map_position = _displayPositionToGridCell(e.Position());
+
+				if (tile_map_position.x < 0.0f || tile_map_position.y < 0.0f || tile_map_position.x >= _room->Tiles().Columns() || tile_map_position.y >= _room->Tiles().Rows())
+					return;
+
+				int tile_index = 0;
+				int layer = _tileset_view->CurrentLayer();
+				int tile_x = static_cast<int>(tile_map_position.x);
+				int tile_y = static_cast<int>(tile_map_position.y);
+
+				// Tiles in pages that haven't been loaded yet would be overwritten once they're loaded.
+				if (!_room_streamer.IsResident(tile_x, tile_y))
+					return;
+
+				if (e.Button() == MouseButton::Left)
+					// Calculate the value that will be assigned to the tile.
+					tile_index = (tile_selection.Y() * _tileset_view->TilesetView()->Tileset().Columns()) + tile_selection.X() + 1;
+
+				// Holding the mouse button down over the same cell would otherwise rewrite the same tile every frame.
+				if (!_tile_layers.SetTile(tile_x, tile_y, static_cast<detail::TileLayer::tile_id_type>(tile_index), layer))
+					return;
+
+				// Assign the tile to the tile map, and apply auto-tiling if applicable.
+				_onTileChanged(tile_x, tile_y, static_cast<detail::TileLayer::tile_id_type>(tile_index), layer);
+
+				detail::AutoTiler* auto_tiler = _tileset_view->GetAutoTilerByTileset(_tileset_view->TilesetView()->Tileset());
+
+				if (_tileset_view->AutoTilingEnabled() && auto_tiler != nullptr) {
+
+					auto_tiler->ApplyAt(_tile_layers.GetOrCreateLayer(layer), tile_x, tile_y, [&](int x, int y, detail::AutoTiler::tile_id_type id) {
+						_onTileChanged(x, y, id, layer);
+					});
+
+				}
+
+				_markUnsavedChanges();
+
+			}
+
+		}
+		void RoomEditor::_roomView_OnMousePressed(Gui::WidgetMousePressedEventArgs& e) {
+
+			/*
+			Left-click: Create an object at the clicked position
+			Ctrl+Left-click: Select the clicked object so that it can be moved around
+			Shift+Left-click: Create a copy of the selected object at the clicked position
+			Ctrl+Shift+Left-drag: Select the tiles and objects inside of a rectangle (in either mode)
+			*/
+
+			if (_room && e.Button() == MouseButton::Left && HasFlag(_key_modifiers, KeyModifiers::Control) && HasFlag(_key_modifiers, KeyModifiers::Shift)) {
+
+				if (!e.Position().In(_room_view->Bounds()))
+					return;
+
+				_marquee_active = true;
+				_marquee_start = _displayPositionToWorldPosition(e.Position(), false);
+
+				return;
+
+			}
+
+			if (_editor_mode == EDITOR_MODE_OBJECTS) {
+
+				if (e.Button() == MouseButton::Left) {
+
+					if (HasFlag(_key_modifiers, KeyModifiers::Control)) {
+
+						// Convert the click position to room coordinates.
+						PointF pos = _displayPositionToWorldPosition(e.Position(), false);
+
+						// Get the object that was clicked. Objects are only selected when clicking on one of their opaque pixels, so that overlapping objects can be told apart.
+
+						detail::ObjectList::Item item = _object_list.Pick(pos, [this](detail::ObjectList::Item& candidate, const PointF& at) {
+							return _object_renderer.HitTest(_object_list, candidate, at);
+						});
+						_selected_object = item;
+
+					}
+					else if (HasFlag(_key_modifiers, KeyModifiers::Shift)) {
+
+						// Place a copy of the selected object, with the same properties, at the mouse position.
+
+						if (!_selected_object || !e.Position().In(_room_view->Bounds()))
+							return;
+
+						ObjectRegistry::type_id_type type_id = ObjectRegistry::INVALID_TYPE_ID;
+						const String* name = _object_list.GetProperty(_selected_object.Object().get(), "name");
+
+						if (name != nullptr)
+							type_id = _object_registry.GetTypeId(*name);
+
+						// The selection changes to the new object, so the prototype is copied first.
+						detail::ObjectList::Item prototype = _selected_object;
+
+						if (_placeObjects(type_id, &prototype, { _displayPositionToWorldPosition(e.Position(), true) }) == 0)
+							return;
+
+					}
+					else {
+
+						// Create a new object at the mouse position, or start painting objects with the scatter brush.
+
+						if (!e.Position().In(_room_view->Bounds()))
+							return;
+
+						size_t selected_item = _objects_view->SelectedItem();
+
+						if (selected_item == RoomEditorListWidget::NO_ITEM)
+							return;
+
+						if (_scatter_brush_enabled) {
+
+							_scatter_brush.BeginStroke(_displayPositionToWorldPosition(e.Position(), false), [this](const PointF& position) { return _isScatterPositionValid(position); }, _scatter_positions);
+
+							return;
+
+						}
+
+						if (_placeObjects(_object_registry.Types()[selected_item], nullptr, { _displayPositionToWorldPosition(e.Position(), true) }) == 0)
+							return;
+
+					}
+
+					_markUnsavedChanges();
+
+				}
+
+			}
+
+		}
+		size_t RoomEditor::_placeObjects(ObjectRegistry::type_id_type type_id, const detail::ObjectList::Item* prototype, const std::vector<PointF>& positions, const detail::ObjectList::property_list_type* properties) {
+
+			if (!_room || type_id == ObjectRegistry::INVALID_TYPE_ID)
+				return 0;
+
+			// Objects can't be placed in pages of streamed rooms that haven't been loaded yet.
+
+			std::vector<PointF> resident_positions;
+
+			for (auto i = positions.begin(); i != positions.end(); ++i)
+				if (_room_streamer.IsResident(*i))
+					resident_positions.push_back(*i);
+
+			if (resident_positions.empty())
+				return 0;
+
+			// Store the "name" property so that it can be saved when the map is saved.
+			// Both the name and ID of the object are required to be saved later (since different objects can have the same ID).
+
+			detail::ObjectList::property_list_type object_properties;
+
+			if (properties != nullptr)
+				object_properties = *properties;
+			else if (prototype != nullptr && *prototype)
+				object_properties = _object_list.GetPackedProperties(prototype->Object().get());
+			else
+				object_properties.push_back(std::make_pair(String("name"), String(_object_registry.GetName(type_id))));
+
+			// The properties are shared by all of the objects, so they only need to be checked once. Properties that were given (such as pasted ones) may come from another room or another version of the editor.
+
+			_validateProperties(object_properties);
+
+			// All of the objects are created at once, so that their memory is allocated together.
+
+			std::vector<IObjectPtr> objects;
+
+			BLOCK_LISTENERS();
+
+			if (prototype != nullptr && *prototype)
+				_object_registry.CloneObjects(type_id, *prototype->Object(), resident_positions.size(), objects);
+			else
+				_object_registry.MakeObjects(type_id, resident_positions.size(), objects);
+
+			for (size_t i = 0; i < objects.size(); ++i) {
+
+				IObjectPtr& obj = objects[i];
+				PointF pos = resident_positions[i];
+
+				obj->SetPosition(pos);
+
+				_selected_object = _object_list.Add(obj);
+				_object_list.SetPackedProperties(obj.get(), object_properties);
+
+				_object_renderer.Insert(_object_list, _selected_object);
+
+				// The objects of streamed rooms are stored in their pages instead of the room.
+
+				if (_room_streamer.IsOpen())
+					_room_streamer.MarkModified(pos);
+				else
+					_room->Objects().Add(obj);
+
+				_minimap_view->Minimap().AddObject(pos);
+
+			}
+
+			UNBLOCK_LISTENERS();
+
+			return objects.size();
 
 		}
-		void RoomEditor::_showRoomNewDialog() {
+		size_t RoomEditor::_validateProperties(detail::ObjectList::property_list_type& properties) {
 
-			Gui::Window* dialog = new  Gui::Window(250, 200, "New Room");
-			Gui::Button* button_create = new Gui::Button(0, 0, 100, 25, "Create");
-			Gui::Button* button_cancel = new Gui::Button(0, 0, 100, 25, "Cancel");
+			ObjectRegistry::type_id_type type_id = ObjectRegistry::INVALID_TYPE_ID;
+			bool is_instance = false;
 
-			Gui::Label* label_w = new Gui::Label("Width (px)");
-			Gui::TextBox* textbox_w = new Gui::TextBox(100, Gui::InputType::Numeric);
-			textbox_w->SetText("640");
+			for (auto i = properties.begin(); i != properties.end(); ++i) {
 
-			Gui::Label* label_h = new Gui::Label("Height (px)");
-			Gui::TextBox* textbox_h = new Gui::TextBox(100, Gui::InputType::Numeric);
-			textbox_h->SetText("480");
+				if (i->first == "name")
+					type_id = _object_registry.GetTypeId(i->second);
+				else if (i->first == "prefab")
+					is_instance = true;
 
-			button_create->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([=](Gui::WidgetMouseClickEventArgs& e) {
+			}
 
-				_createNewRoom(StringUtils::Parse<int>(textbox_w->Text()), StringUtils::Parse<int>(textbox_h->Text()));
-				dialog->Close();
+			const PropertySchema& schema = _object_registry.GetSchema(type_id);
 
-			});
+			if (schema.Empty())
+				return 0;
 
-			button_cancel->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([=](Gui::WidgetMouseClickEventArgs& e) {
-				dialog->Close();
-			});
+			detail::ObjectList::property_list_type validated;
+			std::string value;
+			size_t invalid_count = 0;
 
-			dialog->GetChildren().Add(label_w);
-			dialog->GetChildren().Add(label_h);
-			dialog->GetChildren().Add(textbox_w);
-			dialog->GetChildren().Add(textbox_h);
-			dialog->GetChildren().Add(button_create);
-			dialog->GetChildren().Add(button_cancel);
+			for (auto i = properties.begin(); i != properties.end(); ++i) {
 
-			_widgets.ShowDialog(std::unique_ptr<Gui::IWidget>(dialog));
+				if (i->first == "name" || i->first == "prefab") {
 
-			Gui::WidgetLayoutBuilder builder;
+					validated.push_back(*i);
 
-			builder.PlaceAt(label_w, PointF(0.0f, 0.0f));
-			builder.PlaceBottom(textbox_w);
-			builder.PlaceRight(textbox_h);
-			builder.CenterHorizontally({ textbox_w, textbox_h });
-			builder.PlaceTopOf(label_w, textbox_w);
-			builder.PlaceTopOf(label_h, textbox_h);
-			builder.AnchorToInnerEdge(button_cancel, Gui::Anchor::Bottom | Gui::Anchor::Right);
-			builder.PlaceLeftOf(button_create, button_cancel);
+					continue;
 
-		}
-		void RoomEditor::_showRoomOpenDialog() {
+				}
 
-			FileDialog f(FileDialogFlags::FileMustExist);
-			f.SetFilter("HVN3 Room|*" + _default_file_ext);
+				PropertySchema::Result result = schema.Normalize(i->first, i->second, value);
 
-			if (_last_directory.size() > 0)
-				f.SetInitialDirectory(_last_directory);
+				if (result != PropertySchema::Result::Valid && result != PropertySchema::Result::Default)
+					++invalid_count;
 
-			if (f.ShowDialog())
-				_loadRoomFromFileIntoEditor(f.FileName());
+				if ((result != PropertySchema::Result::Default || is_instance) && result != PropertySchema::Result::Invalid)
+					validated.push_back(detail::ObjectList::property_pair_type(i->first, value));
+
+			}
+
+			properties = std::move(validated);
+
+			return invalid_count;
 
 		}
-		void RoomEditor::_showRoomSaveDialog() {
+		void RoomEditor::_removeObjects(const std::vector<detail::ObjectList::Item>& items) {
 
-			if (!_room)
+			if (items.empty())
 				return;
 
-			if (IO::File::Exists(_current_file))
-				_saveRoomToFile(_current_file, false);
-			else
-				_showRoomSaveAsDialog();
+			std::unordered_set<const IObject*> removed;
+
+			for (auto i = items.begin(); i != items.end(); ++i) {
+
+				const IObjectPtr& object = i->Object();
+
+				if (!removed.insert(object.get()).second)
+					continue;
+
+				_minimap_view->Minimap().RemoveObject(object->Position());
+
+				// The objects of streamed rooms are stored in their pages instead of the room, so the page only needs to be rewritten.
+
+				if (_room_streamer.IsOpen())
+					_room_streamer.MarkModified(object->Position());
+				else
+					object->Destroy();
+
+			}
+
+			_object_list.RemoveIf([&](const IObjectPtr& object) {
+				return removed.count(object.get()) > 0;
+			});
+
+			if (_selected_object && removed.count(_selected_object.Object().get()) > 0)
+				_selected_object = detail::ObjectList::Item::NULL_ITEM;
+
+			_selected_objects.clear();
+			_snap_index_valid = false;
 
 		}
-		void RoomEditor::_showRoomSaveAsDialog() {
+		void RoomEditor::_copySelection(bool cut) {
 
 			if (!_room)
 				return;
 
-			std::string fname = IO::Path::GetFileName(_current_file);
+			std::vector<detail::ObjectList::Item> objects = _selected_objects;
 
-			if (fname.size() <= 0)
-				fname = "untitled";
+			if (objects.empty() && _selected_object)
+				objects.push_back(_selected_object);
 
-			if (!StringUtils::EndsWith(fname, _default_file_ext))
-				fname += _default_file_ext;
+			if (_tile_selection_count == 0 && objects.empty()) {
 
-			FileDialog f(FileDialogFlags::Save);
-			f.SetDefaultExtension(_default_file_ext);
-			f.SetFilter("hvn3 Room|*" + _default_file_ext);
-			f.SetFileName(IO::Path::GetFileName(fname));
+				_status_strip->SetText("Select tiles or objects to copy first");
 
-			if (_last_directory.size() > 0)
-				f.SetInitialDirectory(_last_directory);
+				return;
 
-			if (f.ShowDialog())
-				_saveRoomToFile(f.FileName(), false);
+			}
 
-		}
-		void RoomEditor::_showRoomViewContextMenu() {
+			// The copied block starts at the top-left-most selected tile or object, aligned to the tile grid so that pasted objects keep their positions relative to the tiles.
 
+			SizeI tile_size = _room->Tiles().TileSize();
+			std::vector<std::pair<int, int>> cells;
+			std::vector<int> indices;
+			int first_x = INT_MAX;
+			int first_y = INT_MAX;
+			int last_x = INT_MIN;
+			int last_y = INT_MIN;
 
+			_tile_selection.ForEachChunk([&](int chunk_x, int chunk_y, const detail::TileLayer::Chunk& chunk) {
 
-		}
-		void RoomEditor::_loadPreferences() {
+				indices.clear();
 
-			SizeF room_view_grid_cell_size(32.0f, 32.0f);
+				chunk.FindTiles(1, 1, &indices);
 
-			if (IO::File::Exists("editor_preferences.xml")) {
+				for (auto i = indices.begin(); i != indices.end(); ++i) {
 
-				Xml::XmlDocument pref = Xml::XmlDocument::Open("editor_preferences.xml");
-				Xml::XmlElement* node = nullptr;
+					int x = chunk_x * detail::TileLayer::CHUNK_SIZE + *i % detail::TileLayer::CHUNK_SIZE;
+					int y = chunk_y * detail::TileLayer::CHUNK_SIZE + *i / detail::TileLayer::CHUNK_SIZE;
 
-				if (node = pref.Root().GetChild("last_directory"), node != nullptr)
-					_last_directory = node->Text();
+					cells.push_back(std::make_pair(x, y));
 
-				if (node = pref.Root().GetChild("last_file"), node != nullptr)
-					_current_file = node->Text();
+					first_x = std::min(first_x, x);
+					first_y = std::min(first_y, y);
+					last_x = std::max(last_x, x);
+					last_y = std::max(last_y, y);
 
-				if (node = pref.Root().GetChild("resource_base_directory"), node != nullptr)
-					_resource_base_directory = node->Text();
+				}
 
-				if (node = pref.Root().GetChild("grid"), node != nullptr)
-					room_view_grid_cell_size = SizeF(StringUtils::Parse<float>(node->GetAttribute("w")), StringUtils::Parse<float>(node->GetAttribute("h")));
+			});
+
+			for (auto i = objects.begin(); i != objects.end(); ++i) {
+
+				first_x = std::min(first_x, static_cast<int>(std::floor(i->Object()->Position().x / tile_size.width)));
+				first_y = std::min(first_y, static_cast<int>(std::floor(i->Object()->Position().y / tile_size.height)));
 
 			}
 
-			// Apply loaded preferences.
+			// Tiles selected with "Select Matching Tiles" can be spread across the whole room, so the block they'd cover is checked against the largest one that can be pasted.
 
-			if (_room_view != nullptr)
-				_room_view->SetGridCellSize(room_view_grid_cell_size);
+			if (!cells.empty() && static_cast<int64_t>(last_x - first_x + 1) * (last_y - first_y + 1) > detail::Clipboard::MAX_CELLS) {
 
-			if (_current_file.size() > 0 && IO::File::Exists(_current_file))
-				_loadRoomFromFileIntoEditor(_current_file);
+				_status_strip->SetText("The selected tiles are too far apart to be copied");
 
-		}
-		void RoomEditor::_savePreferences() {
+				return;
 
-			Xml::XmlDocument pref("preferences");
-			pref.Root().AddChild("last_directory")->SetText(_last_directory);
-			pref.Root().AddChild("last_file")->SetText(_current_file);
-			pref.Root().AddChild("resource_base_directory")->SetText(_resource_base_directory);
+			}
 
-			Xml::XmlElement* node = pref.Root().AddChild("grid");
-			node->SetAttribute("w", _room_view->GridCellSize().width);
-			node->SetAttribute("h", _room_view->GridCellSize().height);
+			_clipboard.Clear();
 
-			pref.Save("editor_preferences.xml");
+			if (!cells.empty()) {
 
-		}
-		void RoomEditor::_createNewRoom(int width, int height) {
+				int columns = last_x - first_x + 1;
+				int rows = last_y - first_y + 1;
+				std::vector<detail::Clipboard::tile_id_type> tiles(static_cast<size_t>(columns) * static_cast<size_t>(rows), detail::Clipboard::NO_TILE);
 
-			// Create a new room instance and set it as the current instance.
-			if (_room_provider)
-				_room = _room_provider(SizeI(width, height));
-			else
-				_room = hvn3::make_room<>(width, height);
+				for (auto i = cells.begin(); i != cells.end(); ++i)
+					tiles[static_cast<size_t>(i->second - first_y) * columns + static_cast<size_t>(i->first - first_x)] = _tile_layers.At(i->first, i->second, _tile_selection_layer);
 
-			// Set the room's starting background color.
-			_room->SetBackgroundColor(Color::Silver);
+				_clipboard.SetTiles(columns, rows, std::move(tiles));
 
-			// Set the tile size to match the grid size.
-			_room->Tiles().SetTileSize(static_cast<SizeI>(_room_view->GridCellSize()));
+			}
 
-			// Provide context to the room (normally done by a RoomManager, so we need to handle it manually).
-			ContextChangedEventArgs args(_context);
-			_room->OnContextChanged(args);
+			PointF origin(static_cast<float>(first_x * tile_size.width), static_cast<float>(first_y * tile_size.height));
+			std::unordered_set<std::string> prefabs;
 
-			// Update the room tied to the RoomView widget.
-			_room_view->SetRoom(_room);
+			for (auto i = objects.begin(); i != objects.end(); ++i) {
 
-			_current_file = "";
-			_has_unsaved_changes = true;
+				PointF position = i->Object()->Position();
 
-			_updateWindowTitle();
+				_clipboard.AddObject(PointF(position.x - origin.x, position.y - origin.y), _object_list.GetPackedProperties(i->Object().get()));
 
-		}
-		IRoomPtr RoomEditor::_loadRoomFromFileIntoMemory(const std::string& file_path, bool load_resources_into_editor) {
+				// The prefabs the objects are instances of are copied with them, so that they can be pasted into rooms that don't have them.
 
-			RoomEditorXmlResourceAdapter<Xml::XmlResourceAdapterBase<>> adapter(this, load_resources_into_editor);
-			Xml::XmlDocument document = Xml::XmlDocument::Open(file_path);
+				const String* prefab = _object_list.GetObjectPrefab(i->Object().get());
+				const detail::ObjectList::property_list_type* prefab_properties = prefab == nullptr ? nullptr : _object_list.GetPrefab(*prefab);
 
-			IRoomPtr room = adapter.ImportRoom(document.Root());
+				if (prefab_properties != nullptr && prefabs.insert(static_cast<std::string>(*prefab)).second)
+					_clipboard.AddPrefab(*prefab, *prefab_properties);
 
-			// Provide context to the room (normally done by a RoomManager, so we need to handle it manually).
+			}
 
-			if (room) {
+			_clipboard.Store();
 
-				ContextChangedEventArgs args(_context);
-				room->OnContextChanged(args);
+			size_t tile_count = cells.size();
+
+			if (cut) {
+
+				_eraseSelectedTiles();
+				_removeObjects(objects);
+
+				_markUnsavedChanges();
 
 			}
 
-			return room;
+			_status_strip->SetText(StringUtils::Format(cut ? "Cut {0} tiles and {1} objects" : "Copied {0} tiles and {1} objects", tile_count, objects.size()));
 
 		}
-		void RoomEditor::_loadRoomFromFileIntoEditor(const std::string& file_path) {
+		void RoomEditor::_pasteClipboard() {
 
-			BLOCK_LISTENERS();
+			if (!_room)
+				return;
 
-			_room = _loadRoomFromFileIntoMemory(file_path, true);
+			if (!_clipboard.Load()) {
 
-			_room_view->SetRoom(_room);
-			_room_view->SetGridCellSize(static_cast<SizeF>(_room->Tiles().TileSize()));
+				_status_strip->SetText("The clipboard doesn't contain anything that can be pasted");
 
-			_last_directory = IO::Path::GetDirectoryName(file_path);
-			_current_file = file_path;
+				return;
 
-			_has_unsaved_changes = false;
-			_updateWindowTitle();
+			}
 
-			UNBLOCK_LISTENERS();
+			SizeI tile_size = _room->Tiles().TileSize();
+			PointF mouse_position = _displayPositionToWorldPosition(_mouse_position, false);
+			int origin_x = static_cast<int>(std::floor(mouse_position.x / tile_size.width));
+			int origin_y = static_cast<int>(std::floor(mouse_position.y / tile_size.height));
 
-			_status_strip->SetText("Successfully loaded room from " + IO::Path::GetFileName(file_path));
+			// Write all of the tiles first, and then update everything that depends on them once for each chunk that changed.
 
-		}
-		void RoomEditor::_saveRoomToFile(const std::string& file_path, bool is_temporary_file) {
+			int layer = _tileset_view->CurrentLayer();
+			detail::TileLayer& tile_layer = _tile_layers.GetOrCreateLayer(layer);
+			const std::vector<detail::Clipboard::tile_id_type>& tiles = _clipboard.Tiles();
+			std::unordered_set<uint64_t> changed_chunks;
+			std::vector<std::pair<int, int>> chunks;
+			size_t tile_count = 0;
 
-			assert(static_cast<bool>(_room));
+			for (int y = 0; y < _clipboard.Rows(); ++y)
+				for (int x = 0; x < _clipboard.Columns(); ++x) {
 
-			RoomEditorXmlResourceAdapter<Xml::XmlResourceAdapterBase<>> adapter(this, false);
-			Xml::XmlDocument document;
+					detail::Clipboard::tile_id_type id = tiles[static_cast<size_t>(y) * _clipboard.Columns() + static_cast<size_t>(x)];
+					int tile_x = origin_x + x;
+					int tile_y = origin_y + y;
 
-			adapter.ExportRoom(_room, document.Root());
-			document.Save(file_path);
+					if (id == detail::Clipboard::NO_TILE || tile_x < 0 || tile_y < 0 || tile_x >= _room->Tiles().Columns() || tile_y >= _room->Tiles().Rows() || !_room_streamer.IsResident(tile_x, tile_y))
+						continue;
 
-			// Write metadata files for tilesets.
+					++tile_count;
 
-			// Update the tileset list with the current tileset in case it was modified (flags, etc.).
+					if (!tile_layer.SetTile(tile_x, tile_y, id))
+						continue;
 
-			if (_tileset_view->Tilesets().size() > 0)
-				*_tileset_view->GetTilesetById(_tileset_view->GetIdByTileset(_tileset_view->TilesetView()->Tileset())) = _tileset_view->TilesetView()->Tileset();
+					int chunk_x = tile_x / detail::TileLayer::CHUNK_SIZE;
+					int chunk_y = tile_y / detail::TileLayer::CHUNK_SIZE;
 
-			for (auto i = _tileset_view->Tilesets().begin(); i != _tileset_view->Tilesets().end(); ++i) {
+					if (changed_chunks.insert((static_cast<uint64_t>(chunk_x) << 32) | static_cast<uint32_t>(chunk_y)).second)
+						chunks.push_back(std::make_pair(chunk_x, chunk_y));
 
-				Xml::XmlDocument meta("tileset");
+				}
 
-				meta.Root().SetAttribute("version", 0.1f);
-				meta.Root().SetAttribute("tile_width", i->TileSize().width);
-				meta.Root().SetAttribute("tile_height", i->TileSize().height);
+			_onTileChunksChanged(layer, chunks);
 
-				std::stringstream flags;
-				for (size_t j = 0; j < i->Count(); ++j)
-					flags << i->At(j).flag << ',';
+			// Copied prefabs that this room doesn't have are added to it. If it has a different prefab with the same name, objects are pasted with the copied prefab's properties rather than as instances of this room's.
 
-				meta.Root().AddChild("flags")->SetText(flags.str());
+			std::unordered_set<std::string> conflicting_prefabs;
+			size_t prefab_count = 0;
 
-				meta.Save(IO::Path::SetExtension(_tileset_view->GetIdByTileset(*i), ".xml"));
+			for (auto i = _clipboard.Prefabs().begin(); i != _clipboard.Prefabs().end(); ++i) {
 
-			}
+				detail::ObjectList::property_list_type prefab_properties = _clipboard.GetProperties(i->properties);
+				const detail::ObjectList::property_list_type* existing_properties = _object_list.GetPrefab(i->name);
 
-			if (!is_temporary_file) {
+				if (existing_properties == nullptr) {
 
-				_last_directory = IO::Path::GetDirectoryName(file_path);
-				_current_file = file_path;
+					_object_list.SetPrefab(i->name, prefab_properties);
+
+					++prefab_count;
+
+				}
+				else if (!(*existing_properties == prefab_properties))
+					conflicting_prefabs.insert(i->name);
 
-				_has_unsaved_changes = false;
-				_updateWindowTitle();
 			}
 
-		}
-		void RoomEditor::_startPlaytest() {
+			// Objects with the same properties are created together, which usually means all of the objects of each type are.
 
-			if (!_room)
-				return;
+			std::vector<std::vector<PointF>> positions(_clipboard.PropertyListCount());
+			PointF origin(static_cast<float>(origin_x * tile_size.width), static_cast<float>(origin_y * tile_size.height));
+			size_t object_count = 0;
 
-			// Export the room to a temporary file.
-			std::string temp_path = IO::Path::GetTemporaryFilePath();
-			_saveRoomToFile(temp_path, true);
+			for (auto i = _clipboard.Objects().begin(); i != _clipboard.Objects().end(); ++i)
+				positions[i->properties].push_back(PointF(origin.x + i->position.x, origin.y + i->position.y));
 
-			// Import the room back from the temporary file (why not just parse XML from string?).
-			IRoomPtr test_room = _loadRoomFromFileIntoMemory(temp_path, false);
-			test_room->Objects().Create<BackToEditorObject>(_context.Get<ROOM_MANAGER>().Room());
+			for (size_t i = 0; i < positions.size(); ++i) {
 
-			_properties_exit_with_esc = _context.Get<GAME_MANAGER>().Properties().ExitWithEscapeKey;
-			_context.Get<GAME_MANAGER>().Properties().ExitWithEscapeKey = false;
+				// Some of the property lists only belong to prefabs.
 
-			_context.Get<ROOM_MANAGER>().SetRoom(test_room);
+				if (positions[i].empty())
+					continue;
 
-		}
-		void RoomEditor::_roomView_OnMouseDown(Gui::WidgetMouseDownEventArgs& e) {
+				detail::ObjectList::property_list_type properties = _clipboard.GetProperties(i);
+				ObjectRegistry::type_id_type type_id = ObjectRegistry::INVALID_TYPE_ID;
 
-			if (!_room)
-				return;
+				for (auto j = properties.begin(); j != properties.end(); ++j)
+					if (j->first == "prefab" && conflicting_prefabs.count(static_cast<std::string>(j->second)) > 0) {
 
-			if (_editor_mode == EDITOR_MODE_TILES) {
+						properties = _clipboard.GetUnpackedProperties(i);
 
-				if (_tileset_view->TilesetView() == nullptr || !_room_view->HasFocus())
-					return;
+						break;
 
-				if (e.Button() != MouseButton::Left && e.Button() != MouseButton::Right)
-					return;
+					}
 
-				hvn3::RectangleI tile_selection = _tileset_view->TilesetView()->SelectedRegion();
-				hvn3::PointF tile_map_position = _room_view->DisplayPositionToGridCell(e.Position());
+				for (auto j = properties.begin(); j != properties.end(); ++j)
+					if (j->first == "name")
+						type_id = _object_registry.GetTypeId(j->second);
 
-				if (tile_map_position.x < 0.0f || tile_map_position.y < 0.0f || tile_map_position.x >= _room->Tiles().Columns() || tile_map_position.y >= _room->Tiles().Rows())
-					return;
+				// Objects of types that aren't in this editor's registry are skipped.
+				object_count += _placeObjects(type_id, nullptr, positions[i], &properties);
 
-				int tile_index = 0;
+			}
 
-				if (e.Button() == MouseButton::Left)
-					// Calculate the value that will be assigned to the tile.
-					tile_index = (tile_selection.Y() * _tileset_view->TilesetView()->Tileset().Columns()) + tile_selection.X() + 1;
+			if (!chunks.empty() || object_count > 0 || prefab_count > 0) {
 
-				// Assign the tile to the tile map, and apply auto-tiling if applicable.
-				_room->Tiles().SetTile(tile_map_position.x, tile_map_position.y, tile_index, 0);
-				//AutoTileRenderer().ApplyAutoTilingAt(_room->GetTiles(), tile_map_position.x, tile_map_position.y, 0);
+				_markUnsavedChanges();
 
-				_has_unsaved_changes = true;
-				_updateWindowTitle();
+			}
+
+			if (prefab_count > 0)
+				_status_strip->SetText(StringUtils::Format("Pasted {0} tiles and {1} objects, and added {2} prefabs", tile_count, object_count, prefab_count));
+			else
+				_status_strip->SetText(StringUtils::Format("Pasted {0} tiles and {1} objects", tile_count, object_count));
+
+		}
+		void RoomEditor::_placeScatteredObjects() {
+
+			// Objects painted during a frame are placed together, so that painting thousands of them only updates the object list and renderer once per frame.
+
+			if (_scatter_positions.empty())
+				return;
+
+			size_t selected_item = _objects_view->SelectedItem();
+
+			if (selected_item != RoomEditorListWidget::NO_ITEM && _placeObjects(_object_registry.Types()[selected_item], nullptr, _scatter_positions) > 0) {
+
+				_markUnsavedChanges();
 
 			}
 
+			_scatter_positions.clear();
+
 		}
-		void RoomEditor::_roomView_OnMousePressed(Gui::WidgetMousePressedEventArgs& e) {
+		PointF RoomEditor::_snapObjectPosition(detail::ObjectList::Item& item, const PointF& position) {
 
-			/*
-			Left-click: Create an object at the clicked position
-			Ctrl+Left-click: Select the clicked object so that it can be moved around
-			*/
+			// Edges within this distance (in display pixels) are snapped to.
+			const float snap_distance = 8.0f;
 
-			if (_editor_mode == EDITOR_MODE_OBJECTS) {
+			_snap_guides.clear();
 
-				if (e.Button() == MouseButton::Left) {
+			// Rebuild the index if the view has moved outside of the region it was built for. The region extends past the view in every direction, so that the view can be moved a little without rebuilding it.
 
-					if (HasFlag(_key_modifiers, KeyModifiers::Control)) {
+			float scale = _zoomScale();
+			RectangleF bounds = _room_view->Bounds();
+			PointF view_position = _displayPositionToWorldPosition(bounds.Position(), false);
+			RectangleF view(view_position.x, view_position.y, bounds.Width() / scale, bounds.Height() / scale);
 
-						// Convert the click position to room coordinates.
-						PointF pos = _room_view->DisplayPositionToWorldPosition(e.Position(), false);
+			bool view_in_region = view.X() >= _snap_index_region.X() && view.Y() >= _snap_index_region.Y() &&
+				view.X() + view.Width() <= _snap_index_region.X() + _snap_index_region.Width() &&
+				view.Y() + view.Height() <= _snap_index_region.Y() + _snap_index_region.Height();
 
-						// Get the object that was clicked.
+			if (!_snap_index_valid || !view_in_region) {
 
-						detail::ObjectList::Item item = _object_list.Pick(pos);
-						_selected_object = item;
+				_snap_index_region = RectangleF(view.X() - view.Width(), view.Y() - view.Height(), view.Width() * 3.0f, view.Height() * 3.0f);
+				_object_list.BuildSnapIndex(_snap_index_region, _snap_index);
 
-					}
-					else {
+				_snap_index_valid = true;
 
-						// Create a new object at the mouse position.
+			}
 
-						if (!e.Position().In(_room_view->Bounds()))
-							return;
+			// Snap to the grid first. Object edges take precedence where they're close enough.
 
-						auto selected_item = _objects_view->SelectedItem();
+			SizeF cell_size = _room_view->GridCellSize();
+			PointF snapped(std::floor(position.x / cell_size.width) * cell_size.width, std::floor(position.y / cell_size.height) * cell_size.height);
 
-						if (selected_item == nullptr)
-							return;
+			// Find the edges closest to the object's edges and center at the unsnapped position.
 
-						BLOCK_LISTENERS();
+			RectangleF bounding_box = item.BoundingBox();
+			float offset_x = bounding_box.X() - item.Object()->Position().x;
+			float offset_y = bounding_box.Y() - item.Object()->Position().y;
+			float left = position.x + offset_x;
+			float top = position.y + offset_y;
+			float xs[] = { left, left + bounding_box.Width() / 2.0f, left + bounding_box.Width() };
+			float ys[] = { top, top + bounding_box.Height() / 2.0f, top + bounding_box.Height() };
 
-						IObjectPtr obj = _object_registry.MakeObject(selected_item->Text());
-						PointF pos = _room_view->DisplayPositionToWorldPosition(e.Position(), true);
+			float delta_x, delta_y;
+			detail::SnapIndex::Edge edge_x, edge_y;
+			bool snapped_x = _snap_index.FindX(xs, 3, snap_distance / scale, item.Object().get(), delta_x, edge_x);
+			bool snapped_y = _snap_index.FindY(ys, 3, snap_distance / scale, item.Object().get(), delta_y, edge_y);
 
-						obj->SetPosition(pos);
+			if (snapped_x)
+				snapped.x = position.x + delta_x;
 
-						// Store the "name" property so that it can be saved when the map is saved.
-						// Both the name and ID of the object are required to be saved later (since different objects can have the same ID).
-						_selected_object = _object_list.Add(obj);
-						_object_list.SetProperty(obj, "name", selected_item->Text());
+			if (snapped_y)
+				snapped.y = position.y + delta_y;
 
-						_room->Objects().Add(obj);
+			// Draw guides along the edges that were snapped to, spanning both objects.
 
-						UNBLOCK_LISTENERS();
+			float snapped_top = snapped.y + offset_y;
+			float snapped_left = snapped.x + offset_x;
 
-					}
+			if (snapped_x)
+				_snap_guides.push_back(std::make_pair(PointF(edge_x.value, std::min(edge_x.from, snapped_top)), PointF(edge_x.value, std::max(edge_x.to, snapped_top + bounding_box.Height()))));
 
-					_has_unsaved_changes = true;
-					_updateWindowTitle();
+			if (snapped_y)
+				_snap_guides.push_back(std::make_pair(PointF(std::min(edge_y.from, snapped_left), edge_y.value), PointF(std::max(edge_y.to, snapped_left + bounding_box.Width()), edge_y.value)));
 
-				}
+			return snapped;
 
-			}
+		}
+		bool RoomEditor::_isScatterPositionValid(const PointF& position) {
+
+			// Objects can't be placed outside of the room, or in pages of streamed rooms that haven't been loaded yet.
+
+			return position.In(RectangleF(static_cast<SizeF>(_room->Size()))) && _room_streamer.IsResident(position);
 
 		}
 		void RoomEditor::_unsubscribeEditorListeners() {
@@ -0,0 +1,54 @@
+#include "editor/detail/AlphaMask.h"
+
+#include <cassert>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			AlphaMask::AlphaMask() :
+				AlphaMask(0, 0) {
+			}
+			AlphaMask::AlphaMask(int width, int height) :
+				_width(width),
+				_height(height),
+				_stride((width + 63) / 64),
+				_bits(static_cast<size_t>(_stride) * static_cast<size_t>(height), 0) {
+
+				assert(width >= 0 && height >= 0);
+
+			}
+			int AlphaMask::Width() const {
+				return _width;
+			}
+			int AlphaMask::Height() const {
+				return _height;
+			}
+			bool AlphaMask::IsEmpty() const {
+				return _width <= 0 || _height <= 0;
+			}
+			void AlphaMask::Set(int x, int y, bool value) {
+
+				assert(x >= 0 && y >= 0 && x < _width && y < _height);
+
+				uint64_t& word = _bits[static_cast<size_t>(y * _stride + x / 64)];
+				uint64_t bit = uint64_t(1) << (x % 64);
+
+				if (value)
+					word |= bit;
+				else
+					word &= ~bit;
+
+			}
+			bool AlphaMask::Test(int x, int y) const {
+
+				if (x < 0 || y < 0 || x >= _width || y >= _height)
+					return false;
+
+				return (_bits[static_cast<size_t>(y * _stride + x / 64)] >> (x % 64)) & 1;
+
+			}
+
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,182 @@
+#include "editor/detail/AtlasPacker.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			AtlasPacker::AtlasPacker(int max_size, int padding) :
+				_max_size(max_size),
+				_padding(padding) {
+			}
+			size_t AtlasPacker::Add(int width, int height) {
+
+				_sizes.push_back(SizeI(width, height));
+
+				return _sizes.size() - 1;
+
+			}
+			void AtlasPacker::Pack() {
+
+				_pages.clear();
+				_placements.assign(_sizes.size(), Placement());
+
+				// Pack the tallest rectangles first, which keeps the skyline flat.
+
+				std::vector<size_t> order(_sizes.size());
+
+				for (size_t i = 0; i < order.size(); ++i)
+					order[i] = i;
+
+				std::stable_sort(order.begin(), order.end(), [this](size_t lhs, size_t rhs) {
+					return _sizes[lhs].height > _sizes[rhs].height || (_sizes[lhs].height == _sizes[rhs].height && _sizes[lhs].width > _sizes[rhs].width);
+				});
+
+				for (auto i = order.begin(); i != order.end(); ++i) {
+
+					// Every rectangle is surrounded by padding, so neighboring rectangles don't bleed into each other when filtered.
+
+					int width = _sizes[*i].width + _padding * 2;
+					int height = _sizes[*i].height + _padding * 2;
+					Placement& placement = _placements[*i];
+					bool placed = false;
+
+					for (size_t page = 0; page < _pages.size() && !placed; ++page) {
+
+						int x, y;
+
+						if (_find(_pages[page], width, height, x, y)) {
+
+							_place(_pages[page], x, y, width, height);
+
+							placement.page = page;
+							placement.x = x + _padding;
+							placement.y = y + _padding;
+							placed = true;
+
+						}
+
+					}
+
+					if (placed)
+						continue;
+
+					Page page;
+					page.skyline.push_back({ 0, 0, std::max(_max_size, width) });
+					page.width = 0;
+					page.height = 0;
+
+					_pages.push_back(page);
+					_place(_pages.back(), 0, 0, width, height);
+
+					placement.page = _pages.size() - 1;
+					placement.x = _padding;
+					placement.y = _padding;
+
+				}
+
+			}
+			const AtlasPacker::Placement& AtlasPacker::At(size_t index) const {
+
+				assert(index < _placements.size());
+
+				return _placements[index];
+
+			}
+			size_t AtlasPacker::PageCount() const {
+				return _pages.size();
+			}
+			SizeI AtlasPacker::PageSize(size_t page) const {
+				return SizeI(_pages[page].width, _pages[page].height);
+			}
+			float AtlasPacker::Efficiency() const {
+
+				double used_area = 0.0;
+				double page_area = 0.0;
+
+				for (auto i = _sizes.begin(); i != _sizes.end(); ++i)
+					used_area += static_cast<double>(i->width) * i->height;
+
+				for (auto i = _pages.begin(); i != _pages.end(); ++i)
+					page_area += static_cast<double>(i->width) * i->height;
+
+				return page_area > 0.0 ? static_cast<float>(used_area / page_area) : 0.0f;
+
+			}
+
+			bool AtlasPacker::_find(const Page& page, int width, int height, int& x, int& y) const {
+
+				bool found = false;
+
+				for (size_t i = 0; i < page.skyline.size(); ++i) {
+
+					int left = page.skyline[i].x;
+
+					if (left + width > _max_size)
+						break;
+
+					// The rectangle rests on the highest segment it spans.
+
+					int top = 0;
+
+					for (size_t j = i; j < page.skyline.size() && page.skyline[j].x < left + width; ++j)
+						top = std::max(top, page.skyline[j].y);
+
+					if (top + height > _max_size || (found && top >= y))
+						continue;
+
+					x = left;
+					y = top;
+					found = true;
+
+				}
+
+				return found;
+
+			}
+			void AtlasPacker::_place(Page& page, int x, int y, int width, int height) {
+
+				// Replace the segments under the rectangle with a single segment at its top, splitting the last one if the rectangle ends inside of it.
+
+				std::vector<Segment>& skyline = page.skyline;
+				auto first = std::find_if(skyline.begin(), skyline.end(), [x](const Segment& segment) { return segment.x == x; });
+				auto last = first;
+
+				while (last != skyline.end() && last->x + last->width <= x + width)
+					++last;
+
+				if (last != skyline.end() && last->x < x + width) {
+
+					last->width -= x + width - last->x;
+					last->x = x + width;
+
+				}
+
+				last = skyline.erase(first, last);
+				last = skyline.insert(last, { x, y + height, width });
+
+				// Merge neighboring segments of the same height, which keeps the skyline short.
+
+				for (size_t i = 0; i + 1 < skyline.size(); ) {
+
+					if (skyline[i].y == skyline[i + 1].y) {
+
+						skyline[i].width += skyline[i + 1].width;
+						skyline.erase(skyline.begin() + static_cast<std::ptrdiff_t>(i) + 1);
+
+					}
+					else
+						++i;
+
+				}
+
+				page.width = std::max(page.width, x + width);
+				page.height = std::max(page.height, y + height);
+
+			}
+
+		}
+	}
+}
\ No newline at end of file
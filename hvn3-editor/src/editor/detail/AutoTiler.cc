@@ -0,0 +1,297 @@
+#include "editor/detail/AutoTiler.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			namespace {
+
+				enum NEIGHBOR : uint8_t {
+					NEIGHBOR_NW = 1 << 0,
+					NEIGHBOR_N = 1 << 1,
+					NEIGHBOR_NE = 1 << 2,
+					NEIGHBOR_W = 1 << 3,
+					NEIGHBOR_E = 1 << 4,
+					NEIGHBOR_SW = 1 << 5,
+					NEIGHBOR_S = 1 << 6,
+					NEIGHBOR_SE = 1 << 7
+				};
+
+				// Clears corner bits whose adjacent edges aren't both set, since those corners don't affect how the tile looks.
+				uint8_t reduceBlobMask(int mask) {
+
+					uint8_t reduced = static_cast<uint8_t>(mask & (NEIGHBOR_N | NEIGHBOR_W | NEIGHBOR_E | NEIGHBOR_S));
+
+					if ((mask & NEIGHBOR_NW) && (mask & NEIGHBOR_N) && (mask & NEIGHBOR_W))
+						reduced |= NEIGHBOR_NW;
+					if ((mask & NEIGHBOR_NE) && (mask & NEIGHBOR_N) && (mask & NEIGHBOR_E))
+						reduced |= NEIGHBOR_NE;
+					if ((mask & NEIGHBOR_SW) && (mask & NEIGHBOR_S) && (mask & NEIGHBOR_W))
+						reduced |= NEIGHBOR_SW;
+					if ((mask & NEIGHBOR_SE) && (mask & NEIGHBOR_S) && (mask & NEIGHBOR_E))
+						reduced |= NEIGHBOR_SE;
+
+					return reduced;
+
+				}
+			}
+
+			AutoTiler::AutoTiler() {}
+			int AutoTiler::AddTerrain(tile_id_type first_tile, Layout layout) {
+
+				// Tile indices are checked before the membership table is resized to fit them, since they can come from metadata files.
+
+				if (_terrains.size() >= static_cast<size_t>(MAX_TERRAINS) || first_tile == 0 || first_tile > MAX_TILE - static_cast<tile_id_type>(TileCount(layout)))
+					return -1;
+
+				Terrain terrain;
+				terrain.first_tile = first_tile;
+				terrain.layout = layout;
+
+				_compile(terrain);
+
+				_terrains.push_back(terrain);
+
+				// Update the membership table so that tiles can be mapped back to their terrain in constant time.
+
+				tile_id_type last_tile = first_tile + static_cast<tile_id_type>(TileCount(layout));
+
+				if (_membership.size() < last_tile)
+					_membership.resize(last_tile, 0);
+
+				for (tile_id_type i = first_tile; i < last_tile; ++i)
+					_membership[i] = static_cast<uint8_t>(_terrains.size());
+
+				return static_cast<int>(_terrains.size()) - 1;
+
+			}
+			int AutoTiler::TerrainCount() const {
+				return static_cast<int>(_terrains.size());
+			}
+			AutoTiler::tile_id_type AutoTiler::TerrainFirstTile(int terrain) const {
+				return _terrains[static_cast<size_t>(terrain)].first_tile;
+			}
+			AutoTiler::Layout AutoTiler::TerrainLayout(int terrain) const {
+				return _terrains[static_cast<size_t>(terrain)].layout;
+			}
+			void AutoTiler::Clear() {
+
+				_terrains.clear();
+				_membership.clear();
+
+			}
+			int AutoTiler::TerrainOf(tile_id_type tile) const {
+
+				return static_cast<int>(_terrainIdOf(tile)) - 1;
+
+			}
+			int AutoTiler::TileCount(Layout layout) {
+
+				switch (layout) {
+				case Layout::Blob47:
+					return 47;
+				case Layout::Edge16:
+				default:
+					return 16;
+				}
+
+			}
+			void AutoTiler::ApplyAt(TileLayer& layer, int x, int y, const changed_callback_type& on_changed) const {
+
+				if (_terrains.empty())
+					return;
+
+				// Changing a single tile can only affect the masks of the tile itself and its immediate neighbors.
+
+				for (int cell_y = y - 1; cell_y <= y + 1; ++cell_y)
+					for (int cell_x = x - 1; cell_x <= x + 1; ++cell_x) {
+
+						tile_id_type tile = layer.At(cell_x, cell_y);
+						uint8_t terrain_id = _terrainIdOf(tile);
+
+						if (terrain_id == 0)
+							continue;
+
+						uint8_t mask = 0;
+						uint8_t bit = 1;
+
+						for (int neighbor_y = cell_y - 1; neighbor_y <= cell_y + 1; ++neighbor_y)
+							for (int neighbor_x = cell_x - 1; neighbor_x <= cell_x + 1; ++neighbor_x) {
+
+								if (neighbor_x == cell_x && neighbor_y == cell_y)
+									continue;
+
+								if (_terrainIdOf(layer.At(neighbor_x, neighbor_y)) == terrain_id)
+									mask |= bit;
+
+								bit <<= 1;
+
+							}
+
+						tile_id_type new_tile = _tileFor(terrain_id, mask);
+
+						if (layer.SetTile(cell_x, cell_y, new_tile) && on_changed)
+							on_changed(cell_x, cell_y, new_tile);
+
+					}
+
+			}
+			void AutoTiler::Apply(TileLayer& layer, int columns, int rows, const changed_callback_type& on_changed) const {
+
+				if (_terrains.empty() || columns <= 0 || rows <= 0)
+					return;
+
+				// The layer is processed one row at a time, keeping the terrain IDs of the rows above and below the current row.
+				// Rows are padded by one cell on either side so that the mask loop below doesn't need any bounds checks, which lets the compiler vectorize it.
+
+				size_t padded_columns = static_cast<size_t>(columns) + 2;
+
+				std::vector<tile_id_type> current_tiles(static_cast<size_t>(columns));
+				std::vector<tile_id_type> next_tiles(static_cast<size_t>(columns));
+				std::vector<uint8_t> above(padded_columns, 0);
+				std::vector<uint8_t> current(padded_columns, 0);
+				std::vector<uint8_t> below(padded_columns, 0);
+				std::vector<uint8_t> masks(static_cast<size_t>(columns));
+
+				auto load_row = [&](int y, std::vector<tile_id_type>& tiles, std::vector<uint8_t>& terrain_ids) -> bool {
+
+					bool has_terrain = false;
+
+					if (y >= rows) {
+						std::fill(terrain_ids.begin(), terrain_ids.end(), 0);
+						return false;
+					}
+
+					layer.ReadRow(0, y, columns, tiles.data());
+
+					for (size_t x = 0; x < tiles.size(); ++x) {
+
+						uint8_t terrain_id = _terrainIdOf(tiles[x]);
+
+						terrain_ids[x + 1] = terrain_id;
+						has_terrain |= terrain_id != 0;
+
+					}
+
+					return has_terrain;
+
+				};
+
+				bool current_has_terrain = false;
+				bool next_has_terrain = load_row(0, next_tiles, below);
+
+				for (int y = 0; y < rows; ++y) {
+
+					std::swap(above, current);
+					std::swap(current, below);
+					std::swap(current_tiles, next_tiles);
+					current_has_terrain = next_has_terrain;
+
+					next_has_terrain = load_row(y + 1, next_tiles, below);
+
+					if (!current_has_terrain)
+						continue;
+
+					const uint8_t* a = above.data();
+					const uint8_t* c = current.data();
+					const uint8_t* b = below.data();
+					uint8_t* m = masks.data();
+
+					for (int x = 0; x < columns; ++x) {
+
+						uint8_t id = c[x + 1];
+
+						m[x] = static_cast<uint8_t>(
+							((a[x] == id) << 0) |
+							((a[x + 1] == id) << 1) |
+							((a[x + 2] == id) << 2) |
+							((c[x] == id) << 3) |
+							((c[x + 2] == id) << 4) |
+							((b[x] == id) << 5) |
+							((b[x + 1] == id) << 6) |
+							((b[x + 2] == id) << 7));
+
+					}
+
+					for (int x = 0; x < columns; ++x) {
+
+						uint8_t terrain_id = c[x + 1];
+
+						if (terrain_id == 0)
+							continue;
+
+						tile_id_type new_tile = _tileFor(terrain_id, m[x]);
+
+						if (new_tile != current_tiles[static_cast<size_t>(x)]) {
+
+							layer.SetTile(x, y, new_tile);
+
+							if (on_changed)
+								on_changed(x, y, new_tile);
+
+						}
+
+					}
+
+				}
+
+			}
+
+			void AutoTiler::_compile(Terrain& terrain) {
+
+				switch (terrain.layout) {
+
+				case Layout::Blob47: {
+
+					// Every reduced mask corresponds to one of the 47 tiles, in ascending order.
+
+					std::vector<uint8_t> reduced_masks;
+
+					for (int mask = 0; mask < 256; ++mask)
+						reduced_masks.push_back(reduceBlobMask(mask));
+
+					std::sort(reduced_masks.begin(), reduced_masks.end());
+					reduced_masks.erase(std::unique(reduced_masks.begin(), reduced_masks.end()), reduced_masks.end());
+
+					assert(reduced_masks.size() == 47);
+
+					for (int mask = 0; mask < 256; ++mask)
+						terrain.table[static_cast<size_t>(mask)] = static_cast<uint8_t>(std::lower_bound(reduced_masks.begin(), reduced_masks.end(), reduceBlobMask(mask)) - reduced_masks.begin());
+
+					break;
+
+				}
+
+				case Layout::Edge16:
+
+					for (int mask = 0; mask < 256; ++mask)
+						terrain.table[static_cast<size_t>(mask)] = static_cast<uint8_t>(
+							((mask & NEIGHBOR_N) ? 1 : 0) |
+							((mask & NEIGHBOR_E) ? 2 : 0) |
+							((mask & NEIGHBOR_S) ? 4 : 0) |
+							((mask & NEIGHBOR_W) ? 8 : 0));
+
+					break;
+
+				}
+
+			}
+			uint8_t AutoTiler::_terrainIdOf(tile_id_type tile) const {
+
+				return tile < _membership.size() ? _membership[tile] : 0;
+
+			}
+			AutoTiler::tile_id_type AutoTiler::_tileFor(uint8_t terrain_id, uint8_t mask) const {
+
+				const Terrain& terrain = _terrains[terrain_id - 1];
+
+				return terrain.first_tile + terrain.table[mask];
+
+			}
+
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,331 @@
+#include "editor/detail/BitmapCache.h"
+#include "editor/detail/DiskImageCache.h"
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <algorithm>
+#include <cctype>
+#include <fstream>
+#include <memory>
+#include <vector>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			BitmapCache::BitmapCache() :
+				_memory_budget(256 * 1024 * 1024),
+				_memory_usage(0),
+				_disk_cache(nullptr) {
+			}
+			Graphics::Bitmap BitmapCache::Load(const std::string& file_path) {
+
+				std::string key = NormalizePath(file_path);
+				time_t modified = 0;
+
+				_getModificationTime(file_path, modified);
+
+				// If the file hasn't changed since it was last loaded, the cached bitmap can be returned without touching the file's contents.
+
+				auto file_iter = _files.find(key);
+
+				if (file_iter != _files.end() && file_iter->second.modified == modified) {
+
+					Image& image = _images.find(file_iter->second.content_hash)->second;
+
+					_lru.splice(_lru.begin(), _lru, image.lru_iter);
+
+					return image.bitmap;
+
+				}
+
+				uint64_t content_hash = HashFile(file_path);
+
+				if (file_iter != _files.end()) {
+
+					// Files are often saved without their contents changing, in which case the bitmap is still valid.
+
+					if (file_iter->second.content_hash == content_hash) {
+
+						file_iter->second.modified = modified;
+
+						Image& image = _images.find(content_hash)->second;
+
+						_lru.splice(_lru.begin(), _lru, image.lru_iter);
+
+						return image.bitmap;
+
+					}
+
+					_release(file_iter->second.content_hash);
+					_files.erase(file_iter);
+
+				}
+
+				// Files with identical contents (e.g. copies of the same image in different directories) share a bitmap.
+
+				auto image_iter = _images.find(content_hash);
+
+				if (image_iter == _images.end()) {
+
+					// Decoding large images is slow, so check the disk cache first.
+
+					std::unique_ptr<Graphics::Bitmap> cached;
+
+					if (_disk_cache != nullptr)
+						cached = _disk_cache->Load(file_path, content_hash);
+
+					_lru.push_front(content_hash);
+
+					Image image = { cached ? *cached : Graphics::Bitmap::FromFile(file_path), 0, 0, _lru.begin() };
+
+					if (!cached && _disk_cache != nullptr)
+						_disk_cache->Store(file_path, content_hash, image.bitmap);
+
+					image.size = static_cast<size_t>(image.bitmap.Width()) * static_cast<size_t>(image.bitmap.Height()) * 4;
+
+					_memory_usage += image.size;
+
+					image_iter = _images.emplace(content_hash, std::move(image)).first;
+
+				}
+				else
+					_lru.splice(_lru.begin(), _lru, image_iter->second.lru_iter);
+
+				++image_iter->second.ref_count;
+
+				File file;
+				file.modified = modified;
+				file.content_hash = content_hash;
+
+				_files[key] = file;
+
+				Graphics::Bitmap bitmap = image_iter->second.bitmap;
+
+				_evict();
+
+				return bitmap;
+
+			}
+			void BitmapCache::Refresh(const std::string& file_path, uint64_t content_hash) {
+
+				auto file_iter = _files.find(NormalizePath(file_path));
+
+				if (file_iter == _files.end())
+					return;
+
+				File& file = file_iter->second;
+
+				_getModificationTime(file_path, file.modified);
+
+				if (file.content_hash == content_hash)
+					return;
+
+				// Other files sharing the bitmap still have the old contents, so forget them and load them again next time.
+
+				for (auto i = _files.begin(); i != _files.end();) {
+					if (i != file_iter && i->second.content_hash == file.content_hash) {
+						_release(i->second.content_hash);
+						i = _files.erase(i);
+					}
+					else
+						++i;
+				}
+
+				auto image_iter = _images.find(file.content_hash);
+				Image image = image_iter->second;
+
+				_images.erase(image_iter);
+
+				// If another image already has the new contents, the file refers to that one instead. The updated bitmap is left to whoever refreshed it.
+
+				auto existing_iter = _images.find(content_hash);
+
+				if (existing_iter != _images.end()) {
+
+					_memory_usage -= image.size;
+					_lru.erase(image.lru_iter);
+
+					++existing_iter->second.ref_count;
+
+					file.content_hash = content_hash;
+
+					return;
+
+				}
+
+				// Otherwise, move the image to its new contents' hash, so that it's found by files with the same contents.
+
+				*image.lru_iter = content_hash;
+
+				if (_disk_cache != nullptr)
+					_disk_cache->Store(file_path, content_hash, image.bitmap);
+
+				_images.emplace(content_hash, std::move(image));
+
+				file.content_hash = content_hash;
+
+			}
+			void BitmapCache::SetMemoryBudget(size_t bytes) {
+
+				_memory_budget = bytes;
+
+				_evict();
+
+			}
+			void BitmapCache::SetDiskCache(DiskImageCache* disk_cache) {
+				_disk_cache = disk_cache;
+			}
+			void BitmapCache::Clear() {
+
+				_files.clear();
+				_images.clear();
+				_lru.clear();
+				_memory_usage = 0;
+
+			}
+			size_t BitmapCache::Count() const {
+				return _images.size();
+			}
+			size_t BitmapCache::MemoryUsage() const {
+				return _memory_usage;
+			}
+			std::string BitmapCache::NormalizePath(const std::string& file_path) {
+
+				std::vector<std::string> parts;
+				std::string part;
+				bool is_absolute = !file_path.empty() && (file_path[0] == '/' || file_path[0] == '\\');
+
+				// Resolve "." and ".." components, and use the same separator everywhere.
+
+				for (size_t i = 0; i <= file_path.size(); ++i) {
+
+					if (i < file_path.size() && file_path[i] != '/' && file_path[i] != '\\') {
+
+						part.push_back(file_path[i]);
+
+						continue;
+
+					}
+
+					if (part == "..") {
+						if (!parts.empty() && parts.back() != "..")
+							parts.pop_back();
+						else if (!is_absolute)
+							parts.push_back(part);
+					}
+					else if (!part.empty() && part != ".")
+						parts.push_back(part);
+
+					part.clear();
+
+				}
+
+				std::string normalized = is_absolute ? "/" : "";
+
+				for (size_t i = 0; i < parts.size(); ++i) {
+
+					if (i > 0)
+						normalized.push_back('/');
+
+					normalized += parts[i];
+
+				}
+
+#ifdef _WIN32
+				// Paths aren't case-sensitive on Windows.
+				std::transform(normalized.begin(), normalized.end(), normalized.begin(), [](char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); });
+#endif
+
+				return normalized;
+
+			}
+			uint64_t BitmapCache::HashFile(const std::string& file_path) {
+
+				std::ifstream file(file_path, std::ios::binary);
+				uint64_t hash = FNV_OFFSET_BASIS;
+				char buffer[64 * 1024];
+
+				while (file) {
+
+					file.read(buffer, sizeof(buffer));
+
+					hash = HashData(buffer, static_cast<size_t>(file.gcount()), hash);
+
+				}
+
+				return hash;
+
+			}
+			uint64_t BitmapCache::HashData(const void* data, size_t size, uint64_t hash) {
+
+				const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+				for (size_t i = 0; i < size; ++i) {
+
+					hash ^= bytes[i];
+					hash *= 1099511628211ULL;
+
+				}
+
+				return hash;
+
+			}
+
+			void BitmapCache::_release(uint64_t content_hash) {
+
+				auto image_iter = _images.find(content_hash);
+
+				if (image_iter == _images.end() || --image_iter->second.ref_count > 0)
+					return;
+
+				// The image can only be found again by loading a file with the same contents, so it's freed now rather than taking up the memory budget until it's evicted.
+
+				_memory_usage -= image_iter->second.size;
+				_lru.erase(image_iter->second.lru_iter);
+				_images.erase(image_iter);
+
+			}
+			void BitmapCache::_evict() {
+
+				// Evict least recently used images until the cache is within budget, but always keep the most recently used one.
+
+				while (_memory_usage > _memory_budget && _lru.size() > 1) {
+
+					uint64_t content_hash = _lru.back();
+					auto image_iter = _images.find(content_hash);
+
+					_memory_usage -= image_iter->second.size;
+
+					// Forget the paths referring to this image, so that they're loaded again next time.
+
+					for (auto i = _files.begin(); i != _files.end();) {
+						if (i->second.content_hash == content_hash)
+							i = _files.erase(i);
+						else
+							++i;
+					}
+
+					_images.erase(image_iter);
+					_lru.pop_back();
+
+				}
+
+			}
+			bool BitmapCache::_getModificationTime(const std::string& file_path, time_t& modified) {
+
+				struct stat info;
+
+				if (stat(file_path.c_str(), &info) != 0)
+					return false;
+
+				modified = info.st_mtime;
+
+				return true;
+
+			}
+
+		}
+	}
+}
\ No newline at end of file
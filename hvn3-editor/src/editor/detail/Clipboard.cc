@@ -0,0 +1,574 @@
+#include "editor/detail/Clipboard.h"
+
+#include <allegro5/allegro.h>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			namespace {
+
+				// Identifies clipboard text created by the editor.
+				const char TEXT_PREFIX[] = "hvn3-editor-clipboard:";
+				// Version 2 added the prefabs used by the copied objects.
+				const uint32_t VERSION = 2;
+
+				// Used if the system clipboard isn't available, so that copy and paste still work within the editor.
+				std::string fallback_text;
+
+				const char BASE64_DIGITS[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+				// Integers are written 7 bits at a time, so that the small values most of them hold only take a byte or two.
+				void writeVarint(std::vector<uint8_t>& data, uint64_t value) {
+
+					while (value >= 0x80) {
+
+						data.push_back(static_cast<uint8_t>(value | 0x80));
+						value >>= 7;
+
+					}
+
+					data.push_back(static_cast<uint8_t>(value));
+
+				}
+				void writeFloat(std::vector<uint8_t>& data, float value) {
+
+					uint8_t bytes[sizeof(float)];
+					std::memcpy(bytes, &value, sizeof(float));
+
+					data.insert(data.end(), bytes, bytes + sizeof(float));
+
+				}
+
+				// Reads values written by the functions above, failing instead of reading past the end of the data.
+				class ClipboardReader {
+
+				public:
+					ClipboardReader(const std::vector<uint8_t>& data) :
+						_data(data),
+						_position(0) {
+					}
+					bool ReadVarint(uint64_t& value) {
+
+						value = 0;
+
+						for (int shift = 0; shift < 64; shift += 7) {
+
+							if (_position >= _data.size())
+								return false;
+
+							uint8_t byte = _data[_position++];
+
+							value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+
+							if ((byte & 0x80) == 0)
+								return true;
+
+						}
+
+						return false;
+
+					}
+					bool ReadCount(size_t& value) {
+
+						// Counts can't be larger than the remaining data, which keeps corrupted data from causing huge allocations.
+
+						uint64_t count;
+
+						if (!ReadVarint(count) || count > _data.size() - _position)
+							return false;
+
+						value = static_cast<size_t>(count);
+
+						return true;
+
+					}
+					bool ReadFloat(float& value) {
+
+						if (_data.size() - _position < sizeof(float))
+							return false;
+
+						std::memcpy(&value, _data.data() + _position, sizeof(float));
+
+						_position += sizeof(float);
+
+						return true;
+
+					}
+					bool ReadString(std::string& value) {
+
+						size_t size;
+
+						if (!ReadCount(size))
+							return false;
+
+						value.assign(reinterpret_cast<const char*>(_data.data()) + _position, size);
+
+						_position += size;
+
+						return true;
+
+					}
+
+				private:
+					const std::vector<uint8_t>& _data;
+					size_t _position;
+
+				};
+
+				std::string encodeBase64(const std::vector<uint8_t>& data) {
+
+					std::string result;
+					result.reserve((data.size() + 2) / 3 * 4);
+
+					for (size_t i = 0; i < data.size(); i += 3) {
+
+						uint32_t group = static_cast<uint32_t>(data[i]) << 16;
+
+						if (i + 1 < data.size())
+							group |= static_cast<uint32_t>(data[i + 1]) << 8;
+
+						if (i + 2 < data.size())
+							group |= data[i + 2];
+
+						result.push_back(BASE64_DIGITS[(group >> 18) & 0x3F]);
+						result.push_back(BASE64_DIGITS[(group >> 12) & 0x3F]);
+						result.push_back(i + 1 < data.size() ? BASE64_DIGITS[(group >> 6) & 0x3F] : '=');
+						result.push_back(i + 2 < data.size() ? BASE64_DIGITS[group & 0x3F] : '=');
+
+					}
+
+					return result;
+
+				}
+				bool decodeBase64(const char* text, std::vector<uint8_t>& data) {
+
+					uint32_t group = 0;
+					int bits = 0;
+
+					data.clear();
+
+					for (const char* i = text; *i != '\0' && *i != '='; ++i) {
+
+						const char* digit = std::strchr(BASE64_DIGITS, *i);
+
+						if (digit == nullptr)
+							return false;
+
+						group = (group << 6) | static_cast<uint32_t>(digit - BASE64_DIGITS);
+						bits += 6;
+
+						if (bits >= 8) {
+
+							bits -= 8;
+							data.push_back(static_cast<uint8_t>((group >> bits) & 0xFF));
+
+						}
+
+					}
+
+					return true;
+
+				}
+
+			}
+
+			const Clipboard::tile_id_type Clipboard::NO_TILE = std::numeric_limits<Clipboard::tile_id_type>::max();
+
+			Clipboard::Clipboard() {
+
+				_columns = 0;
+				_rows = 0;
+
+			}
+			void Clipboard::Clear() {
+
+				_columns = 0;
+				_rows = 0;
+				_tiles.clear();
+				_objects.clear();
+				_prefabs.clear();
+				_strings.clear();
+				_string_ids.clear();
+				_property_lists.clear();
+				_property_list_ids.clear();
+
+			}
+			bool Clipboard::Empty() const {
+				return _tiles.empty() && _objects.empty();
+			}
+			void Clipboard::SetTiles(int columns, int rows, std::vector<tile_id_type>&& tiles) {
+
+				_columns = columns;
+				_rows = rows;
+				_tiles = std::move(tiles);
+
+			}
+			int Clipboard::Columns() const {
+				return _columns;
+			}
+			int Clipboard::Rows() const {
+				return _rows;
+			}
+			const std::vector<Clipboard::tile_id_type>& Clipboard::Tiles() const {
+				return _tiles;
+			}
+			void Clipboard::AddObject(const PointF& position, const ObjectList::property_list_type& properties) {
+
+				Object object;
+				object.position = position;
+				object.properties = _internProperties(properties);
+
+				_objects.push_back(object);
+
+			}
+			const std::vector<Clipboard::Object>& Clipboard::Objects() const {
+				return _objects;
+			}
+			size_t Clipboard::PropertyListCount() const {
+				return _property_lists.size();
+			}
+			ObjectList::property_list_type Clipboard::GetProperties(size_t index) const {
+
+				ObjectList::property_list_type properties;
+
+				if (index >= _property_lists.size())
+					return properties;
+
+				for (auto i = _property_lists[index].begin(); i != _property_lists[index].end(); ++i)
+					properties.push_back(ObjectList::property_pair_type(_strings[i->first], _strings[i->second]));
+
+				return properties;
+
+			}
+			ObjectList::property_list_type Clipboard::GetUnpackedProperties(size_t index) const {
+
+				ObjectList::property_list_type properties = GetProperties(index);
+
+				auto prefab_iter = std::find_if(properties.begin(), properties.end(), [](const ObjectList::property_pair_type& x) {
+					return x.first == "prefab";
+				});
+
+				if (prefab_iter == properties.end())
+					return properties;
+
+				std::string name = static_cast<std::string>(prefab_iter->second);
+
+				properties.erase(prefab_iter);
+
+				auto copied_prefab_iter = std::find_if(_prefabs.begin(), _prefabs.end(), [&](const Prefab& x) {
+					return x.name == name;
+				});
+
+				if (copied_prefab_iter == _prefabs.end())
+					return properties;
+
+				// The object's own properties override the prefab's.
+
+				ObjectList::property_list_type unpacked = GetProperties(copied_prefab_iter->properties);
+
+				for (auto i = properties.begin(); i != properties.end(); ++i) {
+
+					auto property_iter = std::find_if(unpacked.begin(), unpacked.end(), [&](const ObjectList::property_pair_type& x) {
+						return x.first == i->first;
+					});
+
+					if (property_iter != unpacked.end())
+						property_iter->second = i->second;
+					else
+						unpacked.push_back(*i);
+
+				}
+
+				return unpacked;
+
+			}
+			void Clipboard::AddPrefab(const String& name, const ObjectList::property_list_type& properties) {
+
+				Prefab prefab;
+				prefab.name = static_cast<std::string>(name);
+				prefab.properties = _internProperties(properties);
+
+				_prefabs.push_back(std::move(prefab));
+
+			}
+			const std::vector<Clipboard::Prefab>& Clipboard::Prefabs() const {
+				return _prefabs;
+			}
+			void Clipboard::Encode(std::vector<uint8_t>& data) const {
+
+				data.clear();
+
+				writeVarint(data, VERSION);
+
+				// Tiles are stored as runs of the same tile. Cells that weren't copied are stored as 0, and everything else is offset by one.
+
+				writeVarint(data, static_cast<uint64_t>(_columns));
+				writeVarint(data, static_cast<uint64_t>(_rows));
+
+				for (size_t i = 0; i < _tiles.size();) {
+
+					size_t run_start = i;
+
+					while (i < _tiles.size() && _tiles[i] == _tiles[run_start])
+						++i;
+
+					writeVarint(data, i - run_start);
+					writeVarint(data, _tiles[run_start] == NO_TILE ? 0 : static_cast<uint64_t>(_tiles[run_start]) + 1);
+
+				}
+
+				writeVarint(data, _strings.size());
+
+				for (auto i = _strings.begin(); i != _strings.end(); ++i) {
+
+					writeVarint(data, i->size());
+					data.insert(data.end(), i->begin(), i->end());
+
+				}
+
+				writeVarint(data, _property_lists.size());
+
+				for (auto i = _property_lists.begin(); i != _property_lists.end(); ++i) {
+
+					writeVarint(data, i->size());
+
+					for (auto j = i->begin(); j != i->end(); ++j) {
+
+						writeVarint(data, j->first);
+						writeVarint(data, j->second);
+
+					}
+
+				}
+
+				writeVarint(data, _objects.size());
+
+				for (auto i = _objects.begin(); i != _objects.end(); ++i) {
+
+					writeFloat(data, i->position.x);
+					writeFloat(data, i->position.y);
+					writeVarint(data, i->properties);
+
+				}
+
+				writeVarint(data, _prefabs.size());
+
+				for (auto i = _prefabs.begin(); i != _prefabs.end(); ++i) {
+
+					writeVarint(data, i->name.size());
+					data.insert(data.end(), i->name.begin(), i->name.end());
+					writeVarint(data, i->properties);
+
+				}
+
+			}
+			bool Clipboard::Decode(const std::vector<uint8_t>& data) {
+
+				Clear();
+
+				ClipboardReader reader(data);
+				uint64_t version, columns, rows;
+
+				// Data copied by editors from before prefabs were included can still be pasted.
+
+				if (!reader.ReadVarint(version) || version == 0 || version > VERSION || !reader.ReadVarint(columns) || !reader.ReadVarint(rows))
+					return false;
+
+				// Runs can cover many cells each, so a few bytes could otherwise describe a block large enough to run out of memory. The size of the block is limited to what can be copied.
+
+				if (columns > MAX_CELLS || rows > MAX_CELLS || columns * rows > MAX_CELLS)
+					return false;
+
+				_tiles.reserve(static_cast<size_t>(columns * rows));
+
+				while (_tiles.size() < columns * rows) {
+
+					uint64_t count, value;
+
+					if (!reader.ReadVarint(count) || !reader.ReadVarint(value) || count == 0 || count > columns * rows - _tiles.size() || value > std::numeric_limits<tile_id_type>::max()) {
+
+						Clear();
+
+						return false;
+
+					}
+
+					_tiles.insert(_tiles.end(), static_cast<size_t>(count), value == 0 ? NO_TILE : static_cast<tile_id_type>(value - 1));
+
+				}
+
+				_columns = static_cast<int>(columns);
+				_rows = static_cast<int>(rows);
+
+				size_t string_count, property_list_count, object_count;
+				bool valid = reader.ReadCount(string_count);
+
+				for (size_t i = 0; valid && i < string_count; ++i) {
+
+					std::string value;
+
+					valid = reader.ReadString(value);
+
+					_strings.push_back(std::move(value));
+
+				}
+
+				valid = valid && reader.ReadCount(property_list_count);
+
+				for (size_t i = 0; valid && i < property_list_count; ++i) {
+
+					size_t property_count;
+					property_list_type properties;
+
+					valid = reader.ReadCount(property_count);
+
+					for (size_t j = 0; valid && j < property_count; ++j) {
+
+						uint64_t name, value;
+
+						valid = reader.ReadVarint(name) && reader.ReadVarint(value) && name < _strings.size() && value < _strings.size();
+
+						properties.push_back(std::make_pair(static_cast<uint32_t>(name), static_cast<uint32_t>(value)));
+
+					}
+
+					_property_lists.push_back(std::move(properties));
+
+				}
+
+				valid = valid && reader.ReadCount(object_count);
+
+				for (size_t i = 0; valid && i < object_count; ++i) {
+
+					uint64_t properties;
+					Object object;
+
+					valid = reader.ReadFloat(object.position.x) && reader.ReadFloat(object.position.y) && reader.ReadVarint(properties) && properties < _property_lists.size();
+
+					object.properties = static_cast<size_t>(properties);
+
+					_objects.push_back(object);
+
+				}
+
+				size_t prefab_count = 0;
+
+				if (version >= 2)
+					valid = valid && reader.ReadCount(prefab_count);
+
+				for (size_t i = 0; valid && i < prefab_count; ++i) {
+
+					uint64_t properties;
+					Prefab prefab;
+
+					valid = reader.ReadString(prefab.name) && reader.ReadVarint(properties) && properties < _property_lists.size();
+
+					prefab.properties = static_cast<size_t>(properties);
+
+					_prefabs.push_back(std::move(prefab));
+
+				}
+
+				if (!valid) {
+
+					Clear();
+
+					return false;
+
+				}
+
+				return true;
+
+			}
+			void Clipboard::Store() const {
+
+				std::vector<uint8_t> data;
+
+				Encode(data);
+
+				fallback_text = TEXT_PREFIX + encodeBase64(data);
+
+				ALLEGRO_DISPLAY* display = al_get_current_display();
+
+				if (display != nullptr)
+					al_set_clipboard_text(display, fallback_text.c_str());
+
+			}
+			bool Clipboard::Load() {
+
+				std::string text = fallback_text;
+				ALLEGRO_DISPLAY* display = al_get_current_display();
+
+				if (display != nullptr && al_clipboard_has_text(display)) {
+
+					char* system_text = al_get_clipboard_text(display);
+
+					if (system_text != nullptr) {
+
+						text = system_text;
+
+						al_free(system_text);
+
+					}
+
+				}
+
+				std::vector<uint8_t> data;
+
+				if (text.compare(0, sizeof(TEXT_PREFIX) - 1, TEXT_PREFIX) != 0 || !decodeBase64(text.c_str() + sizeof(TEXT_PREFIX) - 1, data))
+					return false;
+
+				return Decode(data);
+
+			}
+
+			uint32_t Clipboard::_intern(const std::string& value) {
+
+				auto id_iter = _string_ids.find(value);
+
+				if (id_iter != _string_ids.end())
+					return id_iter->second;
+
+				uint32_t id = static_cast<uint32_t>(_strings.size());
+
+				_strings.push_back(value);
+				_string_ids.emplace(value, id);
+
+				return id;
+
+			}
+			size_t Clipboard::_internProperties(const ObjectList::property_list_type& properties) {
+
+				property_list_type ids;
+				ids.reserve(properties.size());
+
+				for (auto i = properties.begin(); i != properties.end(); ++i)
+					ids.push_back(std::make_pair(_intern(i->first), _intern(i->second)));
+
+				return _internProperties(ids);
+
+			}
+			size_t Clipboard::_internProperties(const property_list_type& properties) {
+
+				auto id_iter = _property_list_ids.find(properties);
+
+				if (id_iter != _property_list_ids.end())
+					return id_iter->second;
+
+				size_t id = _property_lists.size();
+
+				_property_lists.push_back(properties);
+				_property_list_ids.emplace(properties, id);
+
+				return id;
+
+			}
+
+		}
+	}
+}
\ No newline at end of file
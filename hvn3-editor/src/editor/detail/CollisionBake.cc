@@ -0,0 +1,226 @@
+#include "editor/detail/CollisionBake.h"
+
+#include <cstring>
+#include <fstream>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			namespace {
+
+				const char MAGIC[4] = { 'H', 'V', 'C', 'B' };
+
+				bool testBit(const std::vector<uint64_t>& bits, size_t words_per_row, int x, int y) {
+					return ((bits[static_cast<size_t>(y) * words_per_row + static_cast<size_t>(x / 64)] >> (x % 64)) & 1) != 0;
+				}
+				void clearBit(std::vector<uint64_t>& bits, size_t words_per_row, int x, int y) {
+					bits[static_cast<size_t>(y) * words_per_row + static_cast<size_t>(x / 64)] &= ~(static_cast<uint64_t>(1) << (x % 64));
+				}
+
+			}
+
+			CollisionBake::CollisionBake(int columns, int rows, const SizeI& tile_size) :
+				_columns(columns),
+				_rows(rows),
+				_tile_size(tile_size) {
+
+				_words_per_row = static_cast<size_t>((columns + 63) / 64);
+
+			}
+			void CollisionBake::SetFlags(std::vector<uint32_t>&& flags) {
+				_flags = std::move(flags);
+			}
+			void CollisionBake::AddChunk(int layer, int chunk_x, int chunk_y, const TileLayer::Chunk& chunk) {
+
+				int first_x = chunk_x * TileLayer::CHUNK_SIZE;
+				int first_y = chunk_y * TileLayer::CHUNK_SIZE;
+
+				// The plane is looked up once per run of tiles with the same flags, rather than once per tile.
+
+				uint32_t last_flag = 0;
+				Plane* last_plane = nullptr;
+
+				for (int y = 0; y < TileLayer::CHUNK_SIZE; ++y) {
+
+					int tile_y = first_y + y;
+
+					if (tile_y < 0 || tile_y >= _rows)
+						continue;
+
+					for (int x = 0; x < TileLayer::CHUNK_SIZE; ++x) {
+
+						int tile_x = first_x + x;
+
+						if (tile_x < 0 || tile_x >= _columns)
+							continue;
+
+						TileLayer::tile_id_type id = chunk.At(x, y);
+						uint32_t flags = id < _flags.size() ? _flags[id] : 0;
+
+						while (flags != 0) {
+
+							uint32_t flag = flags & (~flags + 1);
+
+							flags &= flags - 1;
+
+							if (last_plane == nullptr || flag != last_flag) {
+
+								last_plane = &_getPlane(layer, flag);
+								last_flag = flag;
+
+							}
+
+							last_plane->bits[static_cast<size_t>(tile_y) * _words_per_row + static_cast<size_t>(tile_x / 64)] |= static_cast<uint64_t>(1) << (tile_x % 64);
+
+						}
+
+					}
+
+				}
+
+			}
+			void CollisionBake::MergeRectangles() {
+
+				for (auto i = _planes.begin(); i != _planes.end(); ++i)
+					_mergeRectangles(i->second);
+
+			}
+			size_t CollisionBake::PlaneCount() const {
+				return _planes.size();
+			}
+			size_t CollisionBake::RectangleCount() const {
+
+				size_t count = 0;
+
+				for (auto i = _planes.begin(); i != _planes.end(); ++i)
+					count += i->second.rectangles.size();
+
+				return count;
+
+			}
+			bool CollisionBake::Write(const std::string& file_path) const {
+
+				std::ofstream file(file_path, std::ios::binary | std::ios::trunc);
+
+				if (!file)
+					return false;
+
+				Header header;
+				std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+				header.version = VERSION;
+				header.columns = static_cast<uint32_t>(_columns);
+				header.rows = static_cast<uint32_t>(_rows);
+				header.tile_width = static_cast<uint32_t>(_tile_size.width);
+				header.tile_height = static_cast<uint32_t>(_tile_size.height);
+				header.words_per_row = static_cast<uint32_t>(_words_per_row);
+				header.plane_count = static_cast<uint32_t>(_planes.size());
+				header.planes_offset = sizeof(Header);
+
+				// Planes' bits are stored after the table, followed by their rectangles. Both sizes are multiples of 8 bytes, so everything stays aligned.
+
+				std::vector<PlaneEntry> entries;
+				uint64_t offset = sizeof(Header) + _planes.size() * sizeof(PlaneEntry);
+
+				for (auto i = _planes.begin(); i != _planes.end(); ++i) {
+
+					PlaneEntry entry;
+					entry.layer = static_cast<uint32_t>(i->first.first);
+					entry.flag = i->first.second;
+					entry.bits_offset = offset;
+					entry.rectangles_offset = offset + i->second.bits.size() * sizeof(uint64_t);
+					entry.rectangle_count = static_cast<uint32_t>(i->second.rectangles.size());
+					entry.reserved = 0;
+
+					offset = entry.rectangles_offset + i->second.rectangles.size() * sizeof(Rectangle);
+
+					entries.push_back(entry);
+
+				}
+
+				file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+
+				if (!entries.empty())
+					file.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(PlaneEntry)));
+
+				for (auto i = _planes.begin(); i != _planes.end(); ++i) {
+
+					file.write(reinterpret_cast<const char*>(i->second.bits.data()), static_cast<std::streamsize>(i->second.bits.size() * sizeof(uint64_t)));
+
+					if (!i->second.rectangles.empty())
+						file.write(reinterpret_cast<const char*>(i->second.rectangles.data()), static_cast<std::streamsize>(i->second.rectangles.size() * sizeof(Rectangle)));
+
+				}
+
+				return static_cast<bool>(file);
+
+			}
+
+			CollisionBake::Plane& CollisionBake::_getPlane(int layer, uint32_t flag) {
+
+				Plane& plane = _planes[std::make_pair(layer, flag)];
+
+				if (plane.bits.empty())
+					plane.bits.resize(_words_per_row * static_cast<size_t>(_rows));
+
+				return plane;
+
+			}
+			void CollisionBake::_mergeRectangles(Plane& plane) const {
+
+				// Each rectangle starts at the first remaining tile, covers the run of tiles to its right, and is extended down for as long as the rows below have the same run.
+				// Tiles are cleared from a copy of the plane as they're covered, and words without any remaining tiles are skipped.
+
+				std::vector<uint64_t> remaining = plane.bits;
+
+				plane.rectangles.clear();
+
+				for (int y = 0; y < _rows; ++y) {
+
+					size_t row = static_cast<size_t>(y) * _words_per_row;
+
+					for (size_t word = 0; word < _words_per_row; ++word) {
+
+						while (remaining[row + word] != 0) {
+
+							int x = static_cast<int>(word * 64);
+
+							while (!testBit(remaining, _words_per_row, x, y))
+								++x;
+
+							int width = 1;
+
+							while (x + width < _columns && testBit(remaining, _words_per_row, x + width, y))
+								++width;
+
+							int height = 1;
+
+							for (bool full = true; full && y + height < _rows; ) {
+
+								for (int i = x; full && i < x + width; ++i)
+									full = testBit(remaining, _words_per_row, i, y + height);
+
+								if (full)
+									++height;
+
+							}
+
+							for (int j = y; j < y + height; ++j)
+								for (int i = x; i < x + width; ++i)
+									clearBit(remaining, _words_per_row, i, j);
+
+							Rectangle rectangle = { static_cast<uint32_t>(x), static_cast<uint32_t>(y), static_cast<uint32_t>(width), static_cast<uint32_t>(height) };
+
+							plane.rectangles.push_back(rectangle);
+
+						}
+
+					}
+
+				}
+
+			}
+
+		}
+	}
+}
\ No newline at end of file
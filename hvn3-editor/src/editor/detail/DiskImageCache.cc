@@ -0,0 +1,394 @@
+#include "editor/detail/DiskImageCache.h"
+#include "editor/detail/JobSystem.h"
+#include "editor/detail/MappedFile.h"
+
+#include <allegro5/allegro.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <vector>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			namespace {
+
+				const char MAGIC[4] = { 'H', 'V', 'I', 'C' };
+
+				// Rows are aligned so that they can be copied efficiently straight out of the mapped file.
+				const uint32_t ALIGNMENT = 64;
+
+				uint32_t alignUp(uint32_t value) {
+					return (value + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+				}
+				void createDirectory(const std::string& path) {
+
+					// The cache is usually in the user's data directory, whose parents might not exist yet either.
+					al_make_directory(path.c_str());
+
+				}
+				bool writeFile(const std::string& path, const std::vector<uint8_t>& data) {
+
+					// Write to a temporary file first, so that a partially written entry is never read.
+
+					std::string temp_path = path + ".tmp";
+					bool written;
+
+					{
+						std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+
+						if (!file)
+							return false;
+
+						file.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+						file.close();
+
+						written = static_cast<bool>(file);
+					}
+
+					if (!written) {
+
+						std::remove(temp_path.c_str());
+
+						return false;
+
+					}
+
+					std::remove(path.c_str());
+
+					return std::rename(temp_path.c_str(), path.c_str()) == 0;
+
+				}
+
+			}
+
+			DiskImageCache::DiskImageCache(const std::string& directory) :
+				_directory(directory),
+				_jobs(nullptr),
+				_max_size(1024ULL * 1024 * 1024),
+				_max_age(30),
+				_index_loaded(false) {
+			}
+			void DiskImageCache::SetJobSystem(JobSystem* jobs) {
+				_jobs = jobs;
+			}
+			void DiskImageCache::SetMaxSize(uint64_t bytes) {
+				_max_size = bytes;
+			}
+			void DiskImageCache::SetMaxAge(int days) {
+				_max_age = days;
+			}
+			std::unique_ptr<Graphics::Bitmap> DiskImageCache::Load(const std::string& source_path, uint64_t content_hash) {
+
+				_loadIndex();
+
+				auto entry_iter = _entries.find(content_hash);
+
+				if (entry_iter == _entries.end())
+					return nullptr;
+
+				MappedFile file;
+
+				if (!file.Open(_getEntryPath(content_hash)))
+					return nullptr;
+
+				// Make sure that the entry is complete and was written by this version of the editor.
+
+				Header header;
+
+				if (file.Size() < sizeof(Header))
+					std::memset(&header, 0, sizeof(Header));
+				else
+					std::memcpy(&header, file.Data(), sizeof(Header));
+
+				if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+					header.version != VERSION ||
+					header.content_hash != content_hash ||
+					header.stride < header.width * 4 ||
+					static_cast<uint64_t>(header.pixels_offset) + static_cast<uint64_t>(header.stride) * header.height > file.Size()) {
+
+					file.Close();
+
+					_remove(content_hash);
+
+					return nullptr;
+
+				}
+
+				std::unique_ptr<Graphics::Bitmap> bitmap(new Graphics::Bitmap(static_cast<int>(header.width), static_cast<int>(header.height)));
+				ALLEGRO_LOCKED_REGION* region = al_lock_bitmap(bitmap->AlPtr(), ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_WRITEONLY);
+
+				if (region == nullptr)
+					return nullptr;
+
+				const uint8_t* source = file.Data() + header.pixels_offset;
+
+				for (uint32_t y = 0; y < header.height; ++y)
+					std::memcpy(static_cast<uint8_t*>(region->data) + static_cast<ptrdiff_t>(y) * region->pitch, source + static_cast<size_t>(y) * header.stride, header.width * 4);
+
+				al_unlock_bitmap(bitmap->AlPtr());
+
+				entry_iter->second.source_path = source_path;
+				entry_iter->second.last_used = std::time(nullptr);
+
+				return bitmap;
+
+			}
+			void DiskImageCache::Store(const std::string& source_path, uint64_t content_hash, const Graphics::Bitmap& bitmap) {
+
+				_loadIndex();
+
+				// If the source file was cached before it was modified, the old entry will never be used again.
+
+				for (auto i = _entries.begin(); i != _entries.end(); ++i)
+					if (i->first != content_hash && i->second.source_path == source_path) {
+						_remove(i->first);
+						break;
+					}
+
+				for (auto i = _pending_writes.begin(); i != _pending_writes.end(); ++i)
+					if (i->first != content_hash && i->second.entry.source_path == source_path)
+						i->second.removed = true;
+
+				// Entries are named after their contents, so there's nothing to write if this one has already been written or is being written.
+
+				auto entry_iter = _entries.find(content_hash);
+
+				if (entry_iter != _entries.end()) {
+
+					entry_iter->second.source_path = source_path;
+					entry_iter->second.last_used = std::time(nullptr);
+
+					return;
+
+				}
+
+				auto pending_iter = _pending_writes.find(content_hash);
+
+				if (pending_iter != _pending_writes.end()) {
+
+					pending_iter->second.entry.source_path = source_path;
+					pending_iter->second.removed = false;
+
+					return;
+
+				}
+
+				Header header;
+				std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+				header.version = VERSION;
+				header.content_hash = content_hash;
+				header.width = static_cast<uint32_t>(bitmap.Width());
+				header.height = static_cast<uint32_t>(bitmap.Height());
+				header.stride = alignUp(header.width * 4);
+				header.pixels_offset = alignUp(static_cast<uint32_t>(sizeof(Header)));
+
+				// The pixels need to be read on this thread, since that's the thread the bitmap belongs to.
+
+				ALLEGRO_LOCKED_REGION* region = al_lock_bitmap(bitmap.AlPtr(), ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_READONLY);
+
+				if (region == nullptr)
+					return;
+
+				std::shared_ptr<std::vector<uint8_t>> data = std::make_shared<std::vector<uint8_t>>(header.pixels_offset + static_cast<size_t>(header.stride) * header.height, 0);
+
+				std::memcpy(data->data(), &header, sizeof(Header));
+
+				for (uint32_t y = 0; y < header.height; ++y)
+					std::memcpy(data->data() + header.pixels_offset + static_cast<size_t>(y) * header.stride, static_cast<const uint8_t*>(region->data) + static_cast<ptrdiff_t>(y) * region->pitch, header.width * 4);
+
+				al_unlock_bitmap(bitmap.AlPtr());
+
+				createDirectory(_directory);
+
+				std::string entry_path = _getEntryPath(content_hash);
+
+				Entry entry;
+				entry.source_path = source_path;
+				entry.last_used = std::time(nullptr);
+				entry.size = data->size();
+
+				if (_jobs == nullptr) {
+
+					if (writeFile(entry_path, *data))
+						_entries[content_hash] = entry;
+
+					return;
+
+				}
+
+				// The entry is indexed by the completion once it's been written. Removing it before then is deferred until the write has finished, so the two never race.
+
+				PendingWrite& pending = _pending_writes[content_hash];
+				pending.entry = entry;
+				pending.removed = false;
+				pending.job = _jobs->Submit("Caching " + source_path, [entry_path, data](Job& job) {
+
+					if (!writeFile(entry_path, *data))
+						throw std::runtime_error("Couldn't write " + entry_path);
+
+				}, [this, content_hash](const Job& job) {
+
+					_finishWrite(content_hash, job.IsFailed());
+
+				});
+
+				// The completion has to run for the write to be finished, so the user can't cancel it.
+				pending.job->SetCancellable(false);
+
+			}
+			void DiskImageCache::Flush() {
+
+				if (!_index_loaded)
+					return;
+
+				// Entries that are still being written are indexed once they've finished.
+
+				while (_jobs != nullptr && !_pending_writes.empty()) {
+
+					uint64_t content_hash = _pending_writes.begin()->first;
+					JobPtr job = _pending_writes.begin()->second.job;
+
+					_jobs->Wait(job);
+
+					// Cancelled jobs don't call their completions.
+
+					if (job->IsCancelled())
+						_finishWrite(content_hash, true);
+
+				}
+
+				// Remove entries that haven't been used recently.
+
+				time_t now = std::time(nullptr);
+				std::vector<std::pair<time_t, uint64_t>> entries;
+				uint64_t total_size = 0;
+
+				for (auto i = _entries.begin(); i != _entries.end();) {
+
+					if (std::difftime(now, i->second.last_used) > _max_age * 24.0 * 60.0 * 60.0) {
+
+						std::remove(_getEntryPath(i->first).c_str());
+
+						i = _entries.erase(i);
+
+					}
+					else {
+
+						entries.emplace_back(i->second.last_used, i->first);
+						total_size += i->second.size;
+
+						++i;
+
+					}
+
+				}
+
+				// If the cache is still too large, remove the least recently used entries.
+
+				std::sort(entries.begin(), entries.end());
+
+				for (auto i = entries.begin(); i != entries.end() && total_size > _max_size; ++i) {
+
+					total_size -= _entries[i->second].size;
+
+					_remove(i->second);
+
+				}
+
+				_saveIndex();
+
+			}
+
+			void DiskImageCache::_loadIndex() {
+
+				if (_index_loaded)
+					return;
+
+				_index_loaded = true;
+
+				// Each line holds an entry's hash, size, last use time and source path.
+
+				std::ifstream file(_getIndexPath());
+				std::string line;
+
+				while (std::getline(file, line)) {
+
+					std::istringstream fields(line);
+					uint64_t content_hash;
+					Entry entry;
+					long long last_used;
+
+					if (!(fields >> std::hex >> content_hash >> std::dec >> entry.size >> last_used))
+						continue;
+
+					fields >> std::ws;
+					std::getline(fields, entry.source_path);
+
+					entry.last_used = static_cast<time_t>(last_used);
+
+					_entries[content_hash] = entry;
+
+				}
+
+			}
+			void DiskImageCache::_saveIndex() {
+
+				createDirectory(_directory);
+
+				std::ofstream file(_getIndexPath(), std::ios::trunc);
+
+				for (auto i = _entries.begin(); i != _entries.end(); ++i)
+					file << std::hex << i->first << std::dec << ' ' << i->second.size << ' ' << static_cast<long long>(i->second.last_used) << ' ' << i->second.source_path << '\n';
+
+			}
+			void DiskImageCache::_remove(uint64_t content_hash) {
+
+				std::remove(_getEntryPath(content_hash).c_str());
+
+				_entries.erase(content_hash);
+
+			}
+			void DiskImageCache::_finishWrite(uint64_t content_hash, bool failed) {
+
+				auto pending_iter = _pending_writes.find(content_hash);
+
+				if (pending_iter == _pending_writes.end())
+					return;
+
+				PendingWrite pending = std::move(pending_iter->second);
+
+				_pending_writes.erase(pending_iter);
+
+				if (pending.removed) {
+
+					std::remove(_getEntryPath(content_hash).c_str());
+
+					return;
+
+				}
+
+				if (!failed)
+					_entries[content_hash] = pending.entry;
+
+			}
+			std::string DiskImageCache::_getEntryPath(uint64_t content_hash) const {
+
+				char file_name[32];
+				std::snprintf(file_name, sizeof(file_name), "%016llx.bin", static_cast<unsigned long long>(content_hash));
+
+				return _directory + "/" + file_name;
+
+			}
+			std::string DiskImageCache::_getIndexPath() const {
+				return _directory + "/index.txt";
+			}
+
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,246 @@
+#include "editor/detail/BitmapCache.h"
+#include "editor/detail/FileWatcher.h"
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <vector>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			FileWatcher::FileWatcher() :
+				_poll_interval(1000),
+				_last_poll(std::chrono::steady_clock::now()) {
+
+#ifdef __linux__
+				// If inotify isn't available, fall back to checking modification times.
+				_inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+#endif
+
+			}
+			FileWatcher::~FileWatcher() {
+
+#ifdef __linux__
+				if (_inotify >= 0)
+					close(_inotify);
+#endif
+
+			}
+			void FileWatcher::SetCallback(callback_type&& callback) {
+				_callback = std::move(callback);
+			}
+			void FileWatcher::SetPollInterval(std::chrono::milliseconds interval) {
+				_poll_interval = interval;
+			}
+			void FileWatcher::Watch(const std::string& file_path) {
+
+				std::string key = BitmapCache::NormalizePath(file_path);
+
+				if (_files.count(key) > 0)
+					return;
+
+				File file;
+				file.path = file_path;
+				file.directory = _getDirectory(key);
+				file.modified = _getModificationTime(file_path);
+
+				_files.emplace(key, file);
+
+				_addDirectory(file.directory);
+
+			}
+			void FileWatcher::Unwatch(const std::string& file_path) {
+
+				auto file_iter = _files.find(BitmapCache::NormalizePath(file_path));
+
+				if (file_iter == _files.end())
+					return;
+
+				_removeDirectory(file_iter->second.directory);
+
+				_files.erase(file_iter);
+
+			}
+			void FileWatcher::Clear() {
+
+				for (auto i = _files.begin(); i != _files.end(); ++i)
+					_removeDirectory(i->second.directory);
+
+				_files.clear();
+
+			}
+			bool FileWatcher::IsWatching(const std::string& file_path) const {
+				return _files.count(BitmapCache::NormalizePath(file_path)) > 0;
+			}
+			void FileWatcher::Poll() {
+
+				if (_files.empty())
+					return;
+
+				// A file can change several times between polls (e.g. when it's written and then renamed), but it's only reported once.
+
+				std::unordered_set<std::string> changed;
+
+#ifdef __linux__
+				if (_inotify >= 0) {
+
+					alignas(struct inotify_event) char buffer[4096];
+					ssize_t length;
+
+					while ((length = read(_inotify, buffer, sizeof(buffer))) > 0) {
+
+						for (char* ptr = buffer; ptr < buffer + length;) {
+
+							const struct inotify_event* event = reinterpret_cast<const struct inotify_event*>(ptr);
+
+							ptr += sizeof(struct inotify_event) + event->len;
+
+							auto watch_iter = _watches.find(event->wd);
+
+							if (event->len == 0 || watch_iter == _watches.end())
+								continue;
+
+							for (auto i = watch_iter->second.begin(); i != watch_iter->second.end(); ++i) {
+
+								std::string key = i->empty() ? std::string(event->name) : *i + (*i == "/" ? "" : "/") + event->name;
+
+								if (_files.count(key) > 0)
+									changed.insert(key);
+
+							}
+
+						}
+
+					}
+
+				}
+				else
+#endif
+				{
+
+					std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+
+					if (now - _last_poll < _poll_interval)
+						return;
+
+					_last_poll = now;
+
+					for (auto i = _files.begin(); i != _files.end(); ++i) {
+
+						time_t modified = _getModificationTime(i->second.path);
+
+						if (modified != i->second.modified) {
+
+							i->second.modified = modified;
+
+							changed.insert(i->first);
+
+						}
+
+					}
+
+				}
+
+				if (!_callback)
+					return;
+
+				// The callback may watch or unwatch files, so collect the paths first.
+
+				std::vector<std::string> paths;
+
+				for (auto i = changed.begin(); i != changed.end(); ++i)
+					paths.push_back(_files.find(*i)->second.path);
+
+				for (auto i = paths.begin(); i != paths.end(); ++i)
+					_callback(*i);
+
+			}
+
+			void FileWatcher::_addDirectory(const std::string& directory) {
+
+#ifdef __linux__
+				if (_inotify < 0)
+					return;
+
+				auto directory_iter = _directories.find(directory);
+
+				if (directory_iter != _directories.end()) {
+
+					++directory_iter->second.second;
+
+					return;
+
+				}
+
+				// Programs often save by renaming a new file over the old one, which a watch on the file itself wouldn't survive, so watch the directory instead.
+
+				int watch = inotify_add_watch(_inotify, directory.empty() ? "." : directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+
+				if (watch < 0)
+					return;
+
+				_directories.emplace(directory, std::make_pair(watch, 1));
+				_watches[watch].push_back(directory);
+#else
+				(void)directory;
+#endif
+
+			}
+			void FileWatcher::_removeDirectory(const std::string& directory) {
+
+#ifdef __linux__
+				auto directory_iter = _directories.find(directory);
+
+				if (directory_iter == _directories.end() || --directory_iter->second.second > 0)
+					return;
+
+				auto watch_iter = _watches.find(directory_iter->second.first);
+
+				watch_iter->second.erase(std::find(watch_iter->second.begin(), watch_iter->second.end(), directory));
+
+				if (watch_iter->second.empty()) {
+
+					inotify_rm_watch(_inotify, watch_iter->first);
+
+					_watches.erase(watch_iter);
+
+				}
+
+				_directories.erase(directory_iter);
+#else
+				(void)directory;
+#endif
+
+			}
+			std::string FileWatcher::_getDirectory(const std::string& normalized_path) {
+
+				size_t index = normalized_path.find_last_of('/');
+
+				if (index == std::string::npos)
+					return "";
+
+				return index == 0 ? "/" : normalized_path.substr(0, index);
+
+			}
+			time_t FileWatcher::_getModificationTime(const std::string& file_path) {
+
+				struct stat info;
+
+				if (stat(file_path.c_str(), &info) != 0)
+					return 0;
+
+				return info.st_mtime;
+
+			}
+
+		}
+	}
+}
\ No newline at end of file
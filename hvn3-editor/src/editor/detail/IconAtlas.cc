@@ -0,0 +1,190 @@
+#include "hvn3/graphics/Graphics.h"
+
+#include "editor/detail/BitmapCache.h"
+#include "editor/detail/DiskImageCache.h"
+#include "editor/detail/IconAtlas.h"
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <algorithm>
+#include <cassert>
+#include <fstream>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			namespace {
+
+				// The minimum width of the packed bitmap. Images are placed in rows from left to right, and a new row is started when the current one is full.
+				const int MIN_WIDTH = 128;
+				// The number of bytes at the start of a PNG file that hold the image's size.
+				const size_t PNG_HEADER_SIZE = 24;
+
+				struct Image {
+					std::string name;
+					std::string path;
+					int width;
+					int height;
+					bool valid;
+				};
+
+			}
+
+			void IconAtlas::Load(const std::string& directory, const std::vector<std::string>& names, DiskImageCache* disk_cache) {
+
+				_bitmap.reset();
+				_regions.clear();
+
+				if (names.empty())
+					return;
+
+				// Read the size of each image from its header, and hash the names, sizes and modification times of the files together, which identifies the packed bitmap in the disk cache.
+				// This means that the files' contents are only read when one of them has changed.
+
+				std::vector<Image> images;
+				uint64_t content_hash = BitmapCache::FNV_OFFSET_BASIS;
+
+				for (auto i = names.begin(); i != names.end(); ++i) {
+
+					Image image = { *i, directory + "/" + *i + ".png", 1, 1, false };
+
+					std::ifstream file(image.path, std::ios::binary);
+					std::vector<char> data(PNG_HEADER_SIZE);
+
+					file.read(data.data(), static_cast<std::streamsize>(data.size()));
+					data.resize(static_cast<size_t>(std::max<std::streamsize>(file.gcount(), 0)));
+
+					image.valid = _readPngSize(data, image.width, image.height);
+
+					struct stat info;
+					int64_t file_info[2] = { -1, -1 };
+
+					if (stat(image.path.c_str(), &info) == 0) {
+
+						file_info[0] = static_cast<int64_t>(info.st_size);
+						file_info[1] = static_cast<int64_t>(info.st_mtime);
+
+					}
+
+					// Files that can't be read still get a region, so that looking them up doesn't fail.
+
+					if (!image.valid) {
+
+						image.width = 1;
+						image.height = 1;
+
+					}
+
+					content_hash = BitmapCache::HashData(i->c_str(), i->size() + 1, content_hash);
+					content_hash = BitmapCache::HashData(file_info, sizeof(file_info), content_hash);
+
+					images.push_back(image);
+
+				}
+
+				// Pack the tallest images first, which keeps the rows from wasting too much space.
+
+				std::stable_sort(images.begin(), images.end(), [](const Image& lhs, const Image& rhs) { return lhs.height > rhs.height; });
+
+				int width = MIN_WIDTH;
+
+				for (auto i = images.begin(); i != images.end(); ++i)
+					width = std::max(width, i->width + PADDING * 2);
+
+				int x = PADDING;
+				int y = PADDING;
+				int row_height = 0;
+
+				for (auto i = images.begin(); i != images.end(); ++i) {
+
+					if (x + i->width + PADDING > width) {
+
+						x = PADDING;
+						y += row_height + PADDING;
+						row_height = 0;
+
+					}
+
+					_regions.emplace(i->name, RectangleI(x, y, i->width, i->height));
+
+					x += i->width + PADDING;
+					row_height = std::max(row_height, i->height);
+
+				}
+
+				int height = y + row_height + PADDING;
+
+				// If none of the files have changed, the packed bitmap can be copied from the disk cache without reading or decoding them.
+
+				if (disk_cache != nullptr) {
+
+					_bitmap = disk_cache->Load(directory, content_hash);
+
+					if (_bitmap && (_bitmap->Width() != width || _bitmap->Height() != height))
+						_bitmap.reset();
+
+				}
+
+				if (_bitmap)
+					return;
+
+				_bitmap.reset(new Graphics::Bitmap(width, height));
+
+				{
+					Graphics::Graphics gfx(*_bitmap);
+
+					gfx.Clear(Color::Transparent);
+
+					for (auto i = images.begin(); i != images.end(); ++i)
+						if (i->valid) {
+
+							const RectangleI& region = _regions.find(i->name)->second;
+
+							gfx.DrawBitmap(static_cast<float>(region.X()), static_cast<float>(region.Y()), Graphics::Bitmap::FromFile(i->path));
+
+						}
+				}
+
+				if (disk_cache != nullptr)
+					disk_cache->Store(directory, content_hash, *_bitmap);
+
+			}
+			Graphics::Bitmap IconAtlas::Icon(const std::string& name) const {
+
+				assert(static_cast<bool>(_bitmap));
+
+				return Graphics::Bitmap::CreateSubBitmap(*_bitmap, Region(name));
+
+			}
+			const RectangleI& IconAtlas::Region(const std::string& name) const {
+				return _regions.at(name);
+			}
+			const Graphics::Bitmap* IconAtlas::Bitmap() const {
+				return _bitmap.get();
+			}
+
+			bool IconAtlas::_readPngSize(const std::vector<char>& data, int& width, int& height) {
+
+				// The first chunk of a PNG file is always IHDR, which begins with the width and height as big-endian integers.
+
+				static const unsigned char SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n' };
+
+				if (data.size() < 24 || !std::equal(SIGNATURE, SIGNATURE + 8, reinterpret_cast<const unsigned char*>(data.data())) || std::string(data.data() + 12, 4) != "IHDR")
+					return false;
+
+				auto readInt = [&data](size_t offset) {
+					return static_cast<int>((static_cast<uint32_t>(static_cast<unsigned char>(data[offset])) << 24) | (static_cast<uint32_t>(static_cast<unsigned char>(data[offset + 1])) << 16) | (static_cast<uint32_t>(static_cast<unsigned char>(data[offset + 2])) << 8) | static_cast<uint32_t>(static_cast<unsigned char>(data[offset + 3])));
+				};
+
+				width = readInt(16);
+				height = readInt(20);
+
+				return width > 0 && height > 0;
+
+			}
+
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,141 @@
+#include "editor/detail/ImageData.h"
+
+#include <allegro5/allegro.h>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			ImageData::ImageData() :
+				_width(0),
+				_height(0) {
+			}
+			bool ImageData::Load(const std::string& file_path) {
+
+				// Bitmap flags are per-thread, so this doesn't affect bitmaps created on other threads. A memory bitmap can be created without a display.
+
+				int flags = al_get_new_bitmap_flags();
+
+				al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+
+				ALLEGRO_BITMAP* bitmap = al_load_bitmap(file_path.c_str());
+
+				al_set_new_bitmap_flags(flags);
+
+				if (bitmap == nullptr)
+					return false;
+
+				ALLEGRO_LOCKED_REGION* region = al_lock_bitmap(bitmap, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_READONLY);
+
+				if (region == nullptr) {
+
+					al_destroy_bitmap(bitmap);
+
+					return false;
+
+				}
+
+				_width = al_get_bitmap_width(bitmap);
+				_height = al_get_bitmap_height(bitmap);
+				_pixels.resize(static_cast<size_t>(_width) * static_cast<size_t>(_height) * 4);
+
+				for (int y = 0; y < _height; ++y)
+					std::memcpy(_pixels.data() + static_cast<size_t>(y) * _width * 4, static_cast<const uint8_t*>(region->data) + static_cast<ptrdiff_t>(y) * region->pitch, static_cast<size_t>(_width) * 4);
+
+				al_unlock_bitmap(bitmap);
+				al_destroy_bitmap(bitmap);
+
+				return true;
+
+			}
+			bool ImageData::Save(const std::string& file_path) const {
+
+				if (_width <= 0 || _height <= 0)
+					return false;
+
+				// Like loading, this goes through a memory bitmap, so that it can be done on a worker thread.
+
+				int flags = al_get_new_bitmap_flags();
+
+				al_set_new_bitmap_flags(ALLEGRO_MEMORY_BITMAP);
+
+				ALLEGRO_BITMAP* bitmap = al_create_bitmap(_width, _height);
+
+				al_set_new_bitmap_flags(flags);
+
+				if (bitmap == nullptr)
+					return false;
+
+				ALLEGRO_LOCKED_REGION* region = al_lock_bitmap(bitmap, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_WRITEONLY);
+
+				if (region == nullptr) {
+
+					al_destroy_bitmap(bitmap);
+
+					return false;
+
+				}
+
+				for (int y = 0; y < _height; ++y)
+					std::memcpy(static_cast<uint8_t*>(region->data) + static_cast<ptrdiff_t>(y) * region->pitch, _pixels.data() + static_cast<size_t>(y) * _width * 4, static_cast<size_t>(_width) * 4);
+
+				al_unlock_bitmap(bitmap);
+
+				bool saved = al_save_bitmap(file_path.c_str(), bitmap);
+
+				al_destroy_bitmap(bitmap);
+
+				return saved;
+
+			}
+			void ImageData::Create(int width, int height) {
+
+				_width = width;
+				_height = height;
+				_pixels.assign(static_cast<size_t>(width) * static_cast<size_t>(height) * 4, 0);
+
+			}
+			void ImageData::Draw(const ImageData& image, int x, int y) {
+
+				int first_x = std::max(x, 0);
+				int last_x = std::min(x + image._width, _width);
+
+				if (first_x >= last_x)
+					return;
+
+				for (int row = std::max(y, 0); row < std::min(y + image._height, _height); ++row)
+					std::memcpy(_pixels.data() + (static_cast<size_t>(row) * _width + first_x) * 4, image._pixels.data() + (static_cast<size_t>(row - y) * image._width + (first_x - x)) * 4, static_cast<size_t>(last_x - first_x) * 4);
+
+			}
+			bool ImageData::CopyTo(Graphics::Bitmap& bitmap) const {
+
+				if (bitmap.Width() != _width || bitmap.Height() != _height)
+					return false;
+
+				ALLEGRO_LOCKED_REGION* region = al_lock_bitmap(bitmap.AlPtr(), ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_WRITEONLY);
+
+				if (region == nullptr)
+					return false;
+
+				for (int y = 0; y < _height; ++y)
+					std::memcpy(static_cast<uint8_t*>(region->data) + static_cast<ptrdiff_t>(y) * region->pitch, _pixels.data() + static_cast<size_t>(y) * _width * 4, static_cast<size_t>(_width) * 4);
+
+				al_unlock_bitmap(bitmap.AlPtr());
+
+				return true;
+
+			}
+			int ImageData::Width() const {
+				return _width;
+			}
+			int ImageData::Height() const {
+				return _height;
+			}
+
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,261 @@
+#include "editor/detail/JobSystem.h"
+
+#include <algorithm>
+#include <exception>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			Job::Job(const std::string& name) :
+				_name(name),
+				_cancelled(false),
+				_cancellable(true),
+				_progress(0.0f),
+				_finished(false),
+				_failed(false) {
+			}
+			const std::string& Job::Name() const {
+				return _name;
+			}
+			void Job::Cancel() {
+				_cancelled.store(true);
+			}
+			bool Job::IsCancelled() const {
+				return _cancelled.load();
+			}
+			void Job::SetCancellable(bool value) {
+				_cancellable = value;
+			}
+			bool Job::IsCancellable() const {
+				return _cancellable;
+			}
+			float Job::Progress() const {
+				return _progress.load(std::memory_order_relaxed);
+			}
+			void Job::SetProgress(float progress) {
+				_progress.store(std::min(1.0f, std::max(0.0f, progress)), std::memory_order_relaxed);
+			}
+			bool Job::IsFinished() const {
+				return _finished.load(std::memory_order_acquire);
+			}
+			bool Job::IsFailed() const {
+				return IsFinished() && _failed;
+			}
+			const std::string& Job::Error() const {
+				return _error;
+			}
+
+
+			JobSystem::JobSystem() {
+
+				// Leave a hardware thread for the main thread.
+				_initialize(std::max(1, static_cast<int>(std::thread::hardware_concurrency()) - 1));
+
+			}
+			JobSystem::JobSystem(int thread_count) {
+				_initialize(thread_count);
+			}
+			JobSystem::~JobSystem() {
+
+				{
+					std::lock_guard<std::mutex> lock(_wake_mutex);
+					_stopping = true;
+				}
+
+				_wake.notify_all();
+
+				for (auto i = _workers.begin(); i != _workers.end(); ++i)
+					(*i)->thread.join();
+
+				// Free the tasks whose completion callbacks were never called.
+
+				while (Task* task = _completions.Pop())
+					delete task;
+
+			}
+			JobPtr JobSystem::Submit(const std::string& name, work_type&& work, completion_type&& on_complete) {
+
+				Task* task = new Task;
+				task->job = std::make_shared<Job>(name);
+				task->work = std::move(work);
+				task->on_complete = std::move(on_complete);
+
+				_active_jobs.push_back(task->job);
+
+				// Distribute tasks evenly between workers. Workers that run out of tasks will steal from the others anyway.
+
+				Worker& worker = *_workers[_next_worker.fetch_add(1, std::memory_order_relaxed) % _workers.size()];
+
+				{
+					std::lock_guard<std::mutex> lock(worker.mutex);
+					worker.tasks.push_back(task);
+				}
+
+				{
+					std::lock_guard<std::mutex> lock(_wake_mutex);
+					_pending_count.fetch_add(1);
+				}
+
+				_wake.notify_one();
+
+				return task->job;
+
+			}
+			void JobSystem::Wait(const JobPtr& job) {
+
+				Join(job);
+
+				// The job's task has been pushed by now, but the completion queue can't pop it while another worker is in the middle of pushing one after it, so completions are processed until the job's has been.
+
+				while (true) {
+
+					ProcessCompletions();
+
+					if (std::find(_active_jobs.begin(), _active_jobs.end(), job) == _active_jobs.end())
+						break;
+
+					std::this_thread::yield();
+
+				}
+
+			}
+			void JobSystem::Join(const JobPtr& job) {
+
+				std::unique_lock<std::mutex> lock(_finished_mutex);
+
+				_finished.wait(lock, [&]() { return job->IsFinished(); });
+
+			}
+			size_t JobSystem::ProcessCompletions() {
+
+				size_t count = 0;
+
+				while (Task* task = _completions.Pop()) {
+
+					if (task->on_complete && !task->job->IsCancelled())
+						task->on_complete(*task->job);
+
+					_active_jobs.erase(std::find(_active_jobs.begin(), _active_jobs.end(), task->job));
+
+					delete task;
+
+					++count;
+
+				}
+
+				return count;
+
+			}
+			const std::vector<JobPtr>& JobSystem::ActiveJobs() const {
+				return _active_jobs;
+			}
+			int JobSystem::ThreadCount() const {
+				return static_cast<int>(_workers.size());
+			}
+
+			void JobSystem::_initialize(int thread_count) {
+
+				_next_worker = 0;
+				_pending_count = 0;
+				_stopping = false;
+
+				for (int i = 0; i < std::max(1, thread_count); ++i)
+					_workers.emplace_back(new Worker);
+
+				// Start the threads only once all workers exist, since any of them can be stolen from.
+
+				for (size_t i = 0; i < _workers.size(); ++i)
+					_workers[i]->thread = std::thread(&JobSystem::_run, this, i);
+
+			}
+			void JobSystem::_run(size_t worker_index) {
+
+				while (true) {
+
+					Task* task = _takeTask(worker_index);
+
+					if (task == nullptr) {
+
+						std::unique_lock<std::mutex> lock(_wake_mutex);
+
+						// Keep working until the queues are empty, even when stopping, so that work like saving isn't lost.
+
+						_wake.wait(lock, [this]() { return _stopping || _pending_count.load() > 0; });
+
+						if (_stopping && _pending_count.load() <= 0)
+							return;
+
+						continue;
+
+					}
+
+					// An exception escaping a worker would terminate the editor, so it's caught and stored on the job for its completion to report instead.
+
+					if (!task->job->IsCancelled()) {
+
+						try {
+							task->work(*task->job);
+						}
+						catch (const std::exception& ex) {
+							task->job->_failed = true;
+							task->job->_error = ex.what();
+						}
+						catch (...) {
+							task->job->_failed = true;
+							task->job->_error = "Unknown error";
+						}
+
+					}
+
+					// The job is marked as finished and its task is pushed together, so that once Join sees the job as finished, its completion is already in the queue.
+
+					{
+						std::lock_guard<std::mutex> lock(_finished_mutex);
+
+						task->job->_finished.store(true, std::memory_order_release);
+
+						_completions.Push(task);
+					}
+
+					_finished.notify_all();
+
+				}
+
+			}
+			JobSystem::Task* JobSystem::_takeTask(size_t worker_index) {
+
+				// Take the most recently added task from this worker's queue first, then steal the oldest task from the other queues.
+
+				for (size_t i = 0; i < _workers.size(); ++i) {
+
+					Worker& worker = *_workers[(worker_index + i) % _workers.size()];
+					std::lock_guard<std::mutex> lock(worker.mutex);
+
+					if (worker.tasks.empty())
+						continue;
+
+					Task* task = nullptr;
+
+					if (i == 0) {
+						task = worker.tasks.back();
+						worker.tasks.pop_back();
+					}
+					else {
+						task = worker.tasks.front();
+						worker.tasks.pop_front();
+					}
+
+					_pending_count.fetch_sub(1);
+
+					return task;
+
+				}
+
+				return nullptr;
+
+			}
+
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include "editor/detail/MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+#ifdef _WIN32
+
+			MappedFile::MappedFile() :
+				_data(nullptr),
+				_size(0),
+				_file(INVALID_HANDLE_VALUE),
+				_mapping(nullptr) {
+			}
+			bool MappedFile::Open(const std::string& file_path) {
+
+				Close();
+
+				_file = CreateFileA(file_path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+				if (_file == INVALID_HANDLE_VALUE)
+					return false;
+
+				LARGE_INTEGER size;
+
+				if (!GetFileSizeEx(_file, &size) || size.QuadPart <= 0) {
+					Close();
+					return false;
+				}
+
+				_mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+				if (_mapping == nullptr) {
+					Close();
+					return false;
+				}
+
+				_data = static_cast<const uint8_t*>(MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0));
+				_size = static_cast<size_t>(size.QuadPart);
+
+				if (_data == nullptr) {
+					Close();
+					return false;
+				}
+
+				return true;
+
+			}
+			void MappedFile::Close() {
+
+				if (_data != nullptr)
+					UnmapViewOfFile(_data);
+
+				if (_mapping != nullptr)
+					CloseHandle(_mapping);
+
+				if (_file != INVALID_HANDLE_VALUE)
+					CloseHandle(_file);
+
+				_data = nullptr;
+				_size = 0;
+				_mapping = nullptr;
+				_file = INVALID_HANDLE_VALUE;
+
+			}
+
+#else
+
+			MappedFile::MappedFile() :
+				_data(nullptr),
+				_size(0),
+				_file(-1) {
+			}
+			bool MappedFile::Open(const std::string& file_path) {
+
+				Close();
+
+				_file = open(file_path.c_str(), O_RDONLY);
+
+				if (_file < 0)
+					return false;
+
+				struct stat info;
+
+				if (fstat(_file, &info) != 0 || info.st_size <= 0) {
+					Close();
+					return false;
+				}
+
+				void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, _file, 0);
+
+				if (data == MAP_FAILED) {
+					Close();
+					return false;
+				}
+
+				_data = static_cast<const uint8_t*>(data);
+				_size = static_cast<size_t>(info.st_size);
+
+				return true;
+
+			}
+			void MappedFile::Close() {
+
+				if (_data != nullptr)
+					munmap(const_cast<uint8_t*>(_data), _size);
+
+				if (_file >= 0)
+					close(_file);
+
+				_data = nullptr;
+				_size = 0;
+				_file = -1;
+
+			}
+
+#endif
+
+			MappedFile::~MappedFile() {
+				Close();
+			}
+			bool MappedFile::IsOpen() const {
+				return _data != nullptr;
+			}
+			const uint8_t* MappedFile::Data() const {
+				return _data;
+			}
+			size_t MappedFile::Size() const {
+				return _size;
+			}
+
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,312 @@
+#include "editor/detail/Minimap.h"
+
+#include <allegro5/allegro.h>
+
+#include <algorithm>
+#include <climits>
+#include <cmath>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			namespace {
+
+				// Pixels containing at least this many objects are drawn entirely in the object color.
+				const int MAX_OBJECT_DENSITY = 4;
+
+				const Color OBJECT_COLOR(255, 64, 64);
+
+				uint8_t toByte(float value) {
+					return static_cast<uint8_t>(std::max(0.0f, std::min(255.0f, value + 0.5f)));
+				}
+
+			}
+
+			Minimap::Minimap() :
+				_size(0, 0),
+				_tile_size(32, 32),
+				_scale(1.0f),
+				_update_budget(4096) {
+			}
+			void Minimap::Reset(const SizeI& room_size, const SizeI& tile_size) {
+
+				_tile_size = tile_size;
+				_scale = std::max(1.0f, static_cast<float>(std::max(room_size.width, room_size.height)) / static_cast<float>(MAX_SIZE));
+				_size = SizeI(std::max(1, static_cast<int>(std::ceil(room_size.width / _scale))), std::max(1, static_cast<int>(std::ceil(room_size.height / _scale))));
+
+				size_t pixel_count = static_cast<size_t>(_size.width * _size.height);
+
+				_object_counts.assign(pixel_count, 0);
+				_dirty.assign(pixel_count, false);
+				_dirty_pixels.clear();
+				_tile_colors.clear();
+
+				_bitmap.reset(new Graphics::Bitmap(_size.width, _size.height));
+
+				InvalidateAll();
+
+			}
+			void Minimap::SetTileColorCallback(tile_color_callback_type&& callback) {
+				_tile_color = std::move(callback);
+			}
+			void Minimap::SetUpdateBudget(size_t budget) {
+				_update_budget = budget;
+			}
+			SizeI Minimap::Size() const {
+				return _size;
+			}
+			float Minimap::Scale() const {
+				return _scale;
+			}
+			const Graphics::Bitmap* Minimap::Bitmap() const {
+				return _bitmap.get();
+			}
+			void Minimap::InvalidateTile(int x, int y) {
+
+				// A tile can be larger than a pixel, in which case it covers several of them.
+
+				int first_x = static_cast<int>(std::floor(x * _tile_size.width / _scale));
+				int first_y = static_cast<int>(std::floor(y * _tile_size.height / _scale));
+				int last_x = static_cast<int>(std::floor(((x + 1) * _tile_size.width - 1) / _scale));
+				int last_y = static_cast<int>(std::floor(((y + 1) * _tile_size.height - 1) / _scale));
+
+				for (int pixel_y = std::max(0, first_y); pixel_y <= std::min(_size.height - 1, last_y); ++pixel_y)
+					for (int pixel_x = std::max(0, first_x); pixel_x <= std::min(_size.width - 1, last_x); ++pixel_x)
+						_invalidatePixel(pixel_y * _size.width + pixel_x);
+
+			}
+			void Minimap::InvalidateRegion(const RectangleI& tiles) {
+
+				int first_x = static_cast<int>(std::floor(tiles.X() * _tile_size.width / _scale));
+				int first_y = static_cast<int>(std::floor(tiles.Y() * _tile_size.height / _scale));
+				int last_x = static_cast<int>(std::floor(((tiles.X() + tiles.Width()) * _tile_size.width - 1) / _scale));
+				int last_y = static_cast<int>(std::floor(((tiles.Y() + tiles.Height()) * _tile_size.height - 1) / _scale));
+
+				for (int pixel_y = std::max(0, first_y); pixel_y <= std::min(_size.height - 1, last_y); ++pixel_y)
+					for (int pixel_x = std::max(0, first_x); pixel_x <= std::min(_size.width - 1, last_x); ++pixel_x)
+						_invalidatePixel(pixel_y * _size.width + pixel_x);
+
+			}
+			void Minimap::InvalidateAll() {
+
+				_dirty_pixels.clear();
+
+				for (int i = 0; i < _size.width * _size.height; ++i) {
+
+					_dirty[static_cast<size_t>(i)] = true;
+					_dirty_pixels.push_back(i);
+
+				}
+
+			}
+			void Minimap::InvalidateTiles(const TileLayerList& layers, TileLayer::tile_id_type first_id, TileLayer::tile_id_type last_id) {
+
+				for (auto i = _tile_colors.begin(); i != _tile_colors.end();) {
+					if (i->first >= first_id && i->first <= last_id)
+						i = _tile_colors.erase(i);
+					else
+						++i;
+				}
+
+				for (int layer = 0; layer < layers.Count(); ++layer)
+					layers.FindLayer(layer)->ForEachChunk([&](int chunk_x, int chunk_y, const TileLayer::Chunk& chunk) {
+
+						for (int y = 0; y < TileLayer::CHUNK_SIZE; ++y)
+							for (int x = 0; x < TileLayer::CHUNK_SIZE; ++x) {
+
+								TileLayer::tile_id_type id = chunk.At(x, y);
+
+								if (id >= first_id && id <= last_id)
+									InvalidateTile(chunk_x * TileLayer::CHUNK_SIZE + x, chunk_y * TileLayer::CHUNK_SIZE + y);
+
+							}
+
+					});
+
+			}
+			void Minimap::AddObject(const PointF& position) {
+
+				int index = _pixelAt(position.x, position.y);
+
+				if (index < 0)
+					return;
+
+				++_object_counts[static_cast<size_t>(index)];
+
+				_invalidatePixel(index);
+
+			}
+			void Minimap::RemoveObject(const PointF& position) {
+
+				int index = _pixelAt(position.x, position.y);
+
+				if (index < 0 || _object_counts[static_cast<size_t>(index)] == 0)
+					return;
+
+				--_object_counts[static_cast<size_t>(index)];
+
+				_invalidatePixel(index);
+
+			}
+			void Minimap::MoveObject(const PointF& from, const PointF& to) {
+
+				// Most moves stay within the same pixel, which doesn't change anything.
+
+				if (_pixelAt(from.x, from.y) == _pixelAt(to.x, to.y))
+					return;
+
+				RemoveObject(from);
+				AddObject(to);
+
+			}
+			void Minimap::Update(const TileLayerList& layers) {
+
+				if (!_bitmap || _dirty_pixels.empty())
+					return;
+
+				size_t count = std::min(_update_budget, _dirty_pixels.size());
+
+				// Lock the smallest region containing the pixels being redrawn once, and write them to it directly.
+
+				int first_x = INT_MAX;
+				int first_y = INT_MAX;
+				int last_x = INT_MIN;
+				int last_y = INT_MIN;
+
+				for (size_t i = _dirty_pixels.size() - count; i < _dirty_pixels.size(); ++i) {
+
+					first_x = std::min(first_x, _dirty_pixels[i] % _size.width);
+					first_y = std::min(first_y, _dirty_pixels[i] / _size.width);
+					last_x = std::max(last_x, _dirty_pixels[i] % _size.width);
+					last_y = std::max(last_y, _dirty_pixels[i] / _size.width);
+
+				}
+
+				ALLEGRO_LOCKED_REGION* region = al_lock_bitmap_region(_bitmap->AlPtr(), first_x, first_y, last_x - first_x + 1, last_y - first_y + 1, ALLEGRO_PIXEL_FORMAT_ABGR_8888_LE, ALLEGRO_LOCK_READWRITE);
+
+				// The pixels stay dirty, so they're redrawn by the next update.
+
+				if (region == nullptr)
+					return;
+
+				for (size_t i = 0; i < count; ++i) {
+
+					int index = _dirty_pixels.back();
+
+					_dirty_pixels.pop_back();
+					_dirty[static_cast<size_t>(index)] = false;
+
+					// Pixels are either transparent or opaque, since they're only transparent when they don't cover anything.
+
+					Color color = _computePixel(layers, index);
+					uint8_t* pixel = static_cast<uint8_t*>(region->data) + static_cast<ptrdiff_t>(index / _size.width - first_y) * region->pitch + (index % _size.width - first_x) * 4;
+
+					pixel[0] = toByte(color.R());
+					pixel[1] = toByte(color.G());
+					pixel[2] = toByte(color.B());
+					pixel[3] = color.Alpha() > 0 ? 255 : 0;
+
+				}
+
+				al_unlock_bitmap(_bitmap->AlPtr());
+
+			}
+
+			int Minimap::_pixelAt(float x, float y) const {
+
+				int pixel_x = static_cast<int>(std::floor(x / _scale));
+				int pixel_y = static_cast<int>(std::floor(y / _scale));
+
+				if (pixel_x < 0 || pixel_y < 0 || pixel_x >= _size.width || pixel_y >= _size.height)
+					return -1;
+
+				return pixel_y * _size.width + pixel_x;
+
+			}
+			void Minimap::_invalidatePixel(int index) {
+
+				if (_dirty[static_cast<size_t>(index)])
+					return;
+
+				_dirty[static_cast<size_t>(index)] = true;
+				_dirty_pixels.push_back(index);
+
+			}
+			Color Minimap::_computePixel(const TileLayerList& layers, int index) {
+
+				float pixel_x = static_cast<float>(index % _size.width) * _scale;
+				float pixel_y = static_cast<float>(index / _size.width) * _scale;
+
+				int first_x = static_cast<int>(std::floor(pixel_x / _tile_size.width));
+				int first_y = static_cast<int>(std::floor(pixel_y / _tile_size.height));
+				int last_x = std::max(first_x, static_cast<int>(std::ceil((pixel_x + _scale) / _tile_size.width)) - 1);
+				int last_y = std::max(first_y, static_cast<int>(std::ceil((pixel_y + _scale) / _tile_size.height)) - 1);
+
+				// Average the colors of every tile covered by the pixel, on every layer.
+
+				float r = 0.0f;
+				float g = 0.0f;
+				float b = 0.0f;
+				int tile_count = 0;
+
+				_row.resize(static_cast<size_t>(last_x - first_x + 1));
+
+				for (int layer = 0; layer < layers.Count(); ++layer)
+					for (int y = first_y; y <= last_y; ++y) {
+
+						layers.FindLayer(layer)->ReadRow(first_x, y, static_cast<int>(_row.size()), _row.data());
+
+						for (size_t x = 0; x < _row.size(); ++x) {
+
+							if (_row[x] == 0)
+								continue;
+
+							const Color& color = _getTileColor(_row[x]);
+
+							if (color.Alpha() <= 0)
+								continue;
+
+							r += color.R();
+							g += color.G();
+							b += color.B();
+							++tile_count;
+
+						}
+
+					}
+
+				int object_count = _object_counts[static_cast<size_t>(index)];
+
+				if (tile_count == 0 && object_count == 0)
+					return Color::Transparent;
+
+				if (tile_count > 0) {
+
+					r /= tile_count;
+					g /= tile_count;
+					b /= tile_count;
+
+				}
+
+				// Blend the tile color towards the object color depending on how many objects the pixel contains.
+
+				float density = tile_count > 0 ? std::min(1.0f, static_cast<float>(object_count) / MAX_OBJECT_DENSITY) : 1.0f;
+
+				return Color(r + (OBJECT_COLOR.R() - r) * density, g + (OBJECT_COLOR.G() - g) * density, b + (OBJECT_COLOR.B() - b) * density);
+
+			}
+			const Color& Minimap::_getTileColor(TileLayer::tile_id_type id) {
+
+				auto color_iter = _tile_colors.find(id);
+
+				if (color_iter == _tile_colors.end())
+					color_iter = _tile_colors.emplace(id, _tile_color ? _tile_color(id) : Color::White).first;
+
+				return color_iter->second;
+
+			}
+
+		}
+	}
+}
\ No newline at end of file
@@ -11,6 +11,20 @@ namespace hvn3 {
 	namespace editor {
 		namespace detail {
 
+			namespace {
+
+				const String* findProperty(const ObjectList::property_list_type& properties, const String& name) {
+
+					for (auto i = properties.begin(); i != properties.end(); ++i)
+						if (i->first == name)
+							return &i->second;
+
+					return nullptr;
+
+				}
+
+			}
+
 			ObjectList::Item::Item() {}
 			ObjectList::Item::Item(IObjectPtr&& object) {
 
@@ -57,27 +71,116 @@ namespace hvn3 {
 
 
 
+			ObjectList::ObjectList() {
+
+				_revision = 0;
+
+			}
 			const ObjectList::value_type& ObjectList::Add(IObjectPtr object) {
 
-				// Initialize the properties vector for this object.
-				_properties[object.get()] = std::vector<std::pair<String, String>>();
+				// Adding an object a second time would reset its properties while leaving the old ones in the index, so the existing item is returned instead.
+
+				if (_properties.count(object.get()) > 0) {
+
+					auto item_iter = std::find_if(_items.begin(), _items.end(), [&](const Item& x) {
+						return x.Object() == object;
+					});
+
+					assert(item_iter != _items.end());
+
+					return *item_iter;
+
+				}
+
+				// Initialize the properties for this object.
+				_properties[object.get()];
+
+				// Instances in the editor are drawn in batches by the ObjectRenderer, so the room shouldn't draw them individually.
+				object->SetFlags(object->Flags() | ObjectFlags::NoDraw);
 
 				// Move the object into the list.
 				_items.push_back(std::move(Item(std::move(object))));
 
+				++_revision;
+
+				if (_item_added)
+					_item_added(_items.back());
+
 				return _items.back();
 
 			}
 			void ObjectList::Remove(const IObjectPtr& object) {
 
 				// Remove the properties vector for this object.
-				_properties.erase(object.get());
+
+				auto properties_iter = _properties.find(object.get());
+
+				if (properties_iter != _properties.end()) {
+
+					_removeFromIndex(object.get(), properties_iter->second);
+					_properties.erase(properties_iter);
+
+					if (_item_removed)
+						_item_removed(object);
+
+				}
 
 				// Remove the object from the list.
 				_items.erase(std::remove_if(_items.begin(), _items.end(), [&](const Item& x)->bool {
 					return x.Object() == object;
 				}), _items.end());
 
+				++_revision;
+
+			}
+			void ObjectList::RemoveIf(const std::function<bool(const IObjectPtr&)>& predicate) {
+
+				_items.erase(std::remove_if(_items.begin(), _items.end(), [&](const Item& x)->bool {
+
+					if (!predicate(x.Object()))
+						return false;
+
+					auto properties_iter = _properties.find(x.Object().get());
+
+					if (properties_iter != _properties.end()) {
+
+						_removeFromIndex(x.Object().get(), properties_iter->second);
+						_properties.erase(properties_iter);
+
+					}
+
+					if (_item_removed)
+						_item_removed(x.Object());
+
+					return true;
+
+				}), _items.end());
+
+				++_revision;
+
+			}
+			void ObjectList::Clear() {
+
+				if (_item_removed)
+					for (auto i = _items.begin(); i != _items.end(); ++i)
+						_item_removed(i->Object());
+
+				_properties.clear();
+				_prefabs.clear();
+				_index.Clear();
+				_items.clear();
+
+				++_revision;
+
+			}
+			void ObjectList::SetItemAddedCallback(item_added_callback_type&& callback) {
+				_item_added = std::move(callback);
+			}
+			void ObjectList::SetItemRemovedCallback(item_removed_callback_type&& callback) {
+				_item_removed = std::move(callback);
+			}
+			void ObjectList::SetSchemaLookup(schema_lookup_type&& lookup) {
+				_schema_lookup = std::move(lookup);
 			}
 			void ObjectList::SetProperty(const IObjectPtr& object, const String& name, const String& value) {
 
@@ -92,34 +195,239 @@ namespace hvn3 {
 
 				assert(properties_iter != _properties.end());
 
-				// If the given property already exists, update its value.
+				ObjectProperties& object_properties = properties_iter->second;
+				const String* current_value = _getProperty(object_properties, name);
+
+				if (current_value != nullptr && *current_value == value)
+					return;
+
+				if (current_value != nullptr)
+					_index.Remove(const_cast<IObject*>(object), name, *current_value);
 
-				auto property_iter = std::find_if(properties_iter->second.begin(), properties_iter->second.end(), [&](const property_pair_type& x) {
+				// Instances only store the properties whose values differ from their prefab's, so setting one back to the prefab's value removes the override.
+
+				const String* prefab_value = object_properties.prefab ? findProperty(object_properties.prefab->properties, name) : nullptr;
+
+				auto override_iter = std::find_if(object_properties.overrides.begin(), object_properties.overrides.end(), [&](const property_pair_type& x) {
 					return x.first == name;
 				});
 
-				if (property_iter != properties_iter->second.end())
-					property_iter->second = value;
+				if (prefab_value != nullptr && *prefab_value == value) {
+
+					if (override_iter != object_properties.overrides.end())
+						object_properties.overrides.erase(override_iter);
+
+				}
+				else if (override_iter != object_properties.overrides.end())
+					override_iter->second = value;
+				else
+					object_properties.overrides.push_back(std::make_pair(name, value));
+
+				_index.Add(const_cast<IObject*>(object), name, value);
+
+				// Changing the object's type changes how all of its properties are parsed.
+
+				if (name == "name")
+					_updateValues(object_properties);
 				else
-					properties_iter->second.push_back(std::make_pair(name, value));
+					object_properties.values.Set(static_cast<std::string>(name), static_cast<std::string>(value));
 
 			}
-			const ObjectList::property_list_type& ObjectList::GetProperties(const IObjectPtr& object) const {
+			ObjectList::property_list_type ObjectList::GetProperties(const IObjectPtr& object) const {
 
 				return GetProperties(object.get());
 
 			}
-			const ObjectList::property_list_type& ObjectList::GetProperties(const IObject* object) const {
+			ObjectList::property_list_type ObjectList::GetProperties(const IObject* object) const {
+
+				auto properties_iter = _properties.find(const_cast<IObject*>(object));
+
+				assert(properties_iter != _properties.end());
+
+				property_list_type properties;
+
+				_forEachProperty(properties_iter->second, [&](const String& name, const String& value) {
+					properties.push_back(property_pair_type(name, value));
+				});
+
+				return properties;
+
+			}
+			const String* ObjectList::GetProperty(const IObject* object, const String& name) const {
+
+				auto properties_iter = _properties.find(const_cast<IObject*>(object));
+
+				assert(properties_iter != _properties.end());
+
+				return _getProperty(properties_iter->second, name);
+
+			}
+			const PropertyValues& ObjectList::GetValues(const IObject* object) const {
+
+				auto properties_iter = _properties.find(const_cast<IObject*>(object));
+
+				assert(properties_iter != _properties.end());
+
+				return properties_iter->second.values;
+
+			}
+			void ObjectList::SetPrefab(const String& name, const property_list_type& properties) {
+
+				std::shared_ptr<Prefab> prefab = std::make_shared<Prefab>();
+				prefab->name = name;
+				prefab->properties = properties;
+
+				_prefabs[static_cast<std::string>(name)] = std::move(prefab);
+
+			}
+			const ObjectList::property_list_type* ObjectList::GetPrefab(const String& name) const {
+
+				auto prefab_iter = _prefabs.find(static_cast<std::string>(name));
+
+				return prefab_iter == _prefabs.end() ? nullptr : &prefab_iter->second->properties;
+
+			}
+			std::vector<String> ObjectList::Prefabs() const {
+
+				std::vector<String> names;
+
+				for (auto i = _prefabs.begin(); i != _prefabs.end(); ++i)
+					names.push_back(i->second->name);
+
+				return names;
+
+			}
+			bool ObjectList::SetObjectPrefab(const IObject* object, const String& name) {
+
+				auto prefab_iter = _prefabs.find(static_cast<std::string>(name));
+				auto properties_iter = _properties.find(const_cast<IObject*>(object));
+
+				assert(properties_iter != _properties.end());
+
+				if (prefab_iter == _prefabs.end())
+					return false;
+
+				_removeFromIndex(const_cast<IObject*>(object), properties_iter->second);
+
+				properties_iter->second.overrides.clear();
+				properties_iter->second.prefab = prefab_iter->second;
+
+				for (auto i = prefab_iter->second->properties.begin(); i != prefab_iter->second->properties.end(); ++i)
+					_index.Add(const_cast<IObject*>(object), i->first, i->second);
+
+				_updateValues(properties_iter->second);
+
+				return true;
+
+			}
+			const String* ObjectList::GetObjectPrefab(const IObject* object) const {
 
 				auto properties_iter = _properties.find(const_cast<IObject*>(object));
 
 				assert(properties_iter != _properties.end());
 
-				return properties_iter->second;
+				return properties_iter->second.prefab ? &properties_iter->second.prefab->name : nullptr;
+
+			}
+			ObjectList::property_list_type ObjectList::GetPackedProperties(const IObject* object) const {
+
+				auto properties_iter = _properties.find(const_cast<IObject*>(object));
+
+				assert(properties_iter != _properties.end());
+
+				const ObjectProperties& object_properties = properties_iter->second;
+
+				if (!object_properties.prefab)
+					return object_properties.overrides;
+
+				// Overrides are found against the current definition of the prefab, since that's the one that will be used when the object is loaded again.
+
+				auto prefab_iter = _prefabs.find(static_cast<std::string>(object_properties.prefab->name));
+
+				if (prefab_iter == _prefabs.end())
+					return GetProperties(object);
+
+				property_list_type packed;
+				const String* name = _getProperty(object_properties, "name");
+
+				packed.push_back(property_pair_type("prefab", object_properties.prefab->name));
+
+				if (name != nullptr)
+					packed.push_back(property_pair_type("name", *name));
+
+				// Instances of the current definition already store only their overrides.
+
+				if (object_properties.prefab == prefab_iter->second) {
+
+					for (auto i = object_properties.overrides.begin(); i != object_properties.overrides.end(); ++i)
+						if (!(i->first == "name"))
+							packed.push_back(*i);
+
+					return packed;
+
+				}
+
+				// Otherwise, the prefab was redefined after the object became an instance of it, so its properties are compared with the new definition.
+
+				const property_list_type& prefab_properties = prefab_iter->second->properties;
+
+				_forEachProperty(object_properties, [&](const String& property_name, const String& value) {
+
+					if (property_name == "name")
+						return;
+
+					const String* prefab_value = findProperty(prefab_properties, property_name);
+
+					if (prefab_value == nullptr || !(*prefab_value == value))
+						packed.push_back(property_pair_type(property_name, value));
+
+				});
+
+				return packed;
+
+			}
+			void ObjectList::SetPackedProperties(const IObject* object, const property_list_type& properties) {
+
+				for (auto i = properties.begin(); i != properties.end(); ++i)
+					if (i->first == "prefab")
+						SetObjectPrefab(object, i->second);
+
+				for (auto i = properties.begin(); i != properties.end(); ++i)
+					if (!(i->first == "prefab"))
+						SetProperty(object, i->first, i->second);
+
+			}
+			std::vector<ObjectList::value_type> ObjectList::Query(const PropertyQuery& query) const {
+
+				std::vector<IObject*> matches = query.Execute(_index);
+				std::vector<value_type> results;
+
+				if (matches.empty())
+					return results;
+
+				results.reserve(matches.size());
+
+				// The matches are sorted by address, so they can be looked up with a binary search.
+
+				for (auto i = _items.begin(); i != _items.end(); ++i)
+					if (std::binary_search(matches.begin(), matches.end(), i->Object().get()))
+						results.push_back(*i);
+
+				return results;
+
+			}
+			const PropertyIndex& ObjectList::Index() const {
+
+				return _index;
 
 			}
 			const ObjectList::value_type& ObjectList::Pick(const PointF& at) {
 
+				return Pick(at, nullptr);
+
+			}
+			const ObjectList::value_type& ObjectList::Pick(const PointF& at, const hit_test_type& hit_test) {
+
 				// Sort the list by depth first.
 
 				std::sort(_items.begin(), _items.end(), [](const Item& lhs, const Item& rhs) {
@@ -129,13 +437,89 @@ namespace hvn3 {
 				// Return the first object whose bounding box contains the given point.
 
 				for (auto i = _items.begin(); i != _items.end(); ++i)
-					if (i->BoundingBox().ContainsPoint(at))
+					if (i->BoundingBox().ContainsPoint(at) && (!hit_test || hit_test(*i, at)))
 						return *i;
 
 				// If no such objects exist, return an empty item that the user can check for.
 				return Item::NULL_ITEM;
 
 			}
+			void ObjectList::BuildSnapIndex(const RectangleF& region, SnapIndex& index) {
+
+				index.Clear();
+
+				for (auto i = _items.begin(); i != _items.end(); ++i)
+					if (i->Object()->Position().In(region))
+						index.Add(i->Object().get(), i->BoundingBox());
+
+				index.Build();
+
+			}
+			size_t ObjectList::Count() const {
+				return _items.size();
+			}
+			size_t ObjectList::Revision() const {
+				return _revision;
+			}
+			ObjectList::iterator ObjectList::begin() {
+				return _items.begin();
+			}
+			ObjectList::iterator ObjectList::end() {
+				return _items.end();
+			}
+
+			void ObjectList::_forEachProperty(const ObjectProperties& object_properties, const std::function<void(const String&, const String&)>& func) const {
+
+				if (object_properties.prefab) {
+
+					for (auto i = object_properties.prefab->properties.begin(); i != object_properties.prefab->properties.end(); ++i) {
+
+						const String* override_value = findProperty(object_properties.overrides, i->first);
+
+						func(i->first, override_value == nullptr ? i->second : *override_value);
+
+					}
+
+				}
+
+				for (auto i = object_properties.overrides.begin(); i != object_properties.overrides.end(); ++i)
+					if (!object_properties.prefab || findProperty(object_properties.prefab->properties, i->first) == nullptr)
+						func(i->first, i->second);
+
+			}
+			const String* ObjectList::_getProperty(const ObjectProperties& object_properties, const String& name) const {
+
+				const String* value = findProperty(object_properties.overrides, name);
+
+				if (value == nullptr && object_properties.prefab)
+					value = findProperty(object_properties.prefab->properties, name);
+
+				return value;
+
+			}
+			void ObjectList::_removeFromIndex(IObject* object, const ObjectProperties& object_properties) {
+
+				_forEachProperty(object_properties, [&](const String& name, const String& value) {
+					_index.Remove(object, name, value);
+				});
+
+			}
+			void ObjectList::_updateValues(ObjectProperties& object_properties) {
+
+				std::shared_ptr<const PropertySchema> schema;
+				const String* name = _getProperty(object_properties, "name");
+
+				if (_schema_lookup && name != nullptr)
+					schema = _schema_lookup(*name);
+
+				object_properties.values.Reset(schema);
+
+				if (schema)
+					_forEachProperty(object_properties, [&](const String& property_name, const String& value) {
+						object_properties.values.Set(static_cast<std::string>(property_name), static_cast<std::string>(value));
+					});
+
+			}
 
 
 
@@ -0,0 +1,130 @@
+#include "editor/detail/ObjectPool.h"
+
+#include <algorithm>
+#include <cassert>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			ObjectPool::ObjectPool() {
+
+				_block_size = 0;
+				_free_list = nullptr;
+				_free_count = 0;
+				_capacity = 0;
+
+			}
+			ObjectPool::~ObjectPool() {
+
+				for (auto i = _chunks.begin(); i != _chunks.end(); ++i)
+					::operator delete(*i);
+
+			}
+			void* ObjectPool::Allocate(size_t size) {
+
+				std::lock_guard<std::mutex> lock(_mutex);
+
+				if (_block_size == 0) {
+
+					// Blocks are kept aligned for any type, and need to be large enough to hold the free list's links.
+
+					const size_t alignment = alignof(std::max_align_t);
+
+					_block_size = (std::max(size, sizeof(void*)) + alignment - 1) / alignment * alignment;
+
+				}
+				else if (size > _block_size)
+					return nullptr;
+
+				// Each chunk is twice as large as the last, up to a limit, so that types with few instances don't waste much memory.
+
+				if (_free_list == nullptr)
+					_allocateChunk(_capacity < MIN_CHUNK_BLOCKS ? MIN_CHUNK_BLOCKS : (_capacity > MAX_CHUNK_BLOCKS ? MAX_CHUNK_BLOCKS : _capacity));
+
+				void* block = _free_list;
+
+				_free_list = *static_cast<void**>(block);
+				--_free_count;
+
+				return block;
+
+			}
+			void ObjectPool::Free(void* block) {
+
+				if (block == nullptr)
+					return;
+
+				std::lock_guard<std::mutex> lock(_mutex);
+
+				*static_cast<void**>(block) = _free_list;
+				_free_list = block;
+				++_free_count;
+
+			}
+			bool ObjectPool::Fits(size_t size) const {
+
+				std::lock_guard<std::mutex> lock(_mutex);
+
+				return _block_size != 0 && size <= _block_size;
+
+			}
+			void ObjectPool::Reserve(size_t count) {
+
+				std::lock_guard<std::mutex> lock(_mutex);
+
+				if (_block_size == 0 || _free_count >= count)
+					return;
+
+				_allocateChunk(count - _free_count);
+
+			}
+			size_t ObjectPool::BlockSize() const {
+
+				std::lock_guard<std::mutex> lock(_mutex);
+
+				return _block_size;
+
+			}
+			size_t ObjectPool::Count() const {
+
+				std::lock_guard<std::mutex> lock(_mutex);
+
+				return _capacity - _free_count;
+
+			}
+			size_t ObjectPool::Capacity() const {
+
+				std::lock_guard<std::mutex> lock(_mutex);
+
+				return _capacity;
+
+			}
+
+			void ObjectPool::_allocateChunk(size_t blocks) {
+
+				assert(_block_size > 0);
+
+				char* chunk = static_cast<char*>(::operator new(blocks * _block_size));
+
+				_chunks.push_back(chunk);
+
+				// Link the new blocks in order, so that objects allocated one after another end up next to each other.
+
+				for (size_t i = blocks; i-- > 0;) {
+
+					void* block = chunk + i * _block_size;
+
+					*static_cast<void**>(block) = _free_list;
+					_free_list = block;
+
+				}
+
+				_free_count += blocks;
+				_capacity += blocks;
+
+			}
+
+		}
+	}
+}
\ No newline at end of file
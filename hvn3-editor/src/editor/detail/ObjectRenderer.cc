@@ -0,0 +1,318 @@
+#include "hvn3/core/DrawEventArgs.h"
+#include "hvn3/objects/IObject.h"
+
+#include "editor/detail/ObjectRenderer.h"
+
+#include <allegro5/allegro.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			ObjectRenderer::ObjectRenderer() :
+				_max_sprite_extent(0.0f),
+				_grid_invalidated(true),
+				_drawn_count(0),
+				_batch_count(0) {
+			}
+			void ObjectRenderer::Invalidate() {
+
+				_grid_invalidated = true;
+
+			}
+			void ObjectRenderer::Insert(ObjectList& objects, ObjectList::Item item) {
+
+				// Changes made while the grid is out of date are picked up when it's rebuilt.
+
+				if (_grid_invalidated)
+					return;
+
+				Sprite* sprite = _getSprite(item, _typeOf(objects, item.Object()));
+
+				if (!sprite->bitmap)
+					return;
+
+				PointF position = item.Object()->Position();
+				uint64_t key = _makeKey(_cellCoordinate(position.x), _cellCoordinate(position.y));
+
+				_grid[key].push_back(GridEntry{ item.Object().get(), sprite });
+				_cells[item.Object().get()] = key;
+
+			}
+			void ObjectRenderer::Move(const IObject* object) {
+
+				if (_grid_invalidated)
+					return;
+
+				// Instances without sprites aren't in the grid.
+
+				auto cell_iter = _cells.find(object);
+
+				if (cell_iter == _cells.end())
+					return;
+
+				PointF position = object->Position();
+				uint64_t key = _makeKey(_cellCoordinate(position.x), _cellCoordinate(position.y));
+
+				if (key == cell_iter->second)
+					return;
+
+				GridEntry entry = _removeFromCell(object, cell_iter->second);
+
+				_grid[key].push_back(entry);
+
+				cell_iter->second = key;
+
+			}
+			void ObjectRenderer::Remove(const IObject* object) {
+
+				if (_grid_invalidated)
+					return;
+
+				auto cell_iter = _cells.find(object);
+
+				if (cell_iter == _cells.end())
+					return;
+
+				_removeFromCell(object, cell_iter->second);
+
+				_cells.erase(cell_iter);
+
+			}
+			void ObjectRenderer::Clear() {
+
+				_grid.clear();
+				_cells.clear();
+				_batches.clear();
+				_sprites.clear();
+				_max_sprite_extent = 0.0f;
+				_grid_invalidated = true;
+
+			}
+			void ObjectRenderer::Draw(Graphics::Graphics& graphics, ObjectList& objects, const RectangleF& region, const PointF& offset, float scale) {
+
+				if (_grid_invalidated)
+					_rebuildGrid(objects);
+
+				// Instances are indexed by their position only, so the region needs to be expanded to include instances whose sprites extend into it.
+
+				float region_right = region.X() + region.Width();
+				float region_bottom = region.Y() + region.Height();
+
+				int first_cell_x = _cellCoordinate(region.X() - _max_sprite_extent);
+				int first_cell_y = _cellCoordinate(region.Y() - _max_sprite_extent);
+				int last_cell_x = _cellCoordinate(region_right + _max_sprite_extent);
+				int last_cell_y = _cellCoordinate(region_bottom + _max_sprite_extent);
+
+				// Collect the positions of visible instances, grouped by type.
+
+				_drawn_count = 0;
+
+				for (int cell_y = first_cell_y; cell_y <= last_cell_y; ++cell_y)
+					for (int cell_x = first_cell_x; cell_x <= last_cell_x; ++cell_x) {
+
+						auto cell_iter = _grid.find(_makeKey(cell_x, cell_y));
+
+						if (cell_iter == _grid.end())
+							continue;
+
+						for (auto i = cell_iter->second.begin(); i != cell_iter->second.end(); ++i) {
+
+							Sprite* sprite = i->sprite;
+							PointF position = i->object->Position();
+
+							float left = position.x + sprite->origin.x;
+							float top = position.y + sprite->origin.y;
+
+							if (left > region_right || top > region_bottom || left + sprite->size.width < region.X() || top + sprite->size.height < region.Y())
+								continue;
+
+							if (sprite->batch.empty())
+								_batches.push_back(sprite);
+
+							sprite->batch.push_back(PointF(left * scale + offset.x, top * scale + offset.y));
+
+							++_drawn_count;
+
+						}
+
+					}
+
+				// Draw types with greater depths first so that types with lower depths appear on top.
+
+				std::sort(_batches.begin(), _batches.end(), [](const Sprite* lhs, const Sprite* rhs) {
+					return lhs->depth > rhs->depth;
+				});
+
+				// While drawing is held, Allegro combines consecutive draws from the same bitmap into a single draw call.
+
+				al_hold_bitmap_drawing(true);
+
+				for (auto i = _batches.begin(); i != _batches.end(); ++i) {
+
+					if (scale == 1.0f)
+						for (auto j = (*i)->batch.begin(); j != (*i)->batch.end(); ++j)
+							graphics.DrawBitmap(j->x, j->y, *(*i)->bitmap);
+					else
+						for (auto j = (*i)->batch.begin(); j != (*i)->batch.end(); ++j)
+							graphics.DrawBitmap(j->x, j->y, *(*i)->bitmap, scale, scale);
+
+					(*i)->batch.clear();
+
+				}
+
+				al_hold_bitmap_drawing(false);
+
+				_batch_count = _batches.size();
+				_batches.clear();
+
+			}
+			bool ObjectRenderer::HitTest(ObjectList& objects, ObjectList::Item& item, const PointF& at) {
+
+				Sprite* sprite = _getSprite(item, _typeOf(objects, item.Object()));
+
+				if (!sprite->bitmap)
+					return false;
+
+				if (!sprite->has_mask)
+					_buildMask(*sprite);
+
+				PointF position = item.Object()->Position();
+
+				return sprite->mask.Test(static_cast<int>(std::floor(at.x - position.x - sprite->origin.x)), static_cast<int>(std::floor(at.y - position.y - sprite->origin.y)));
+
+			}
+			size_t ObjectRenderer::DrawnCount() const {
+				return _drawn_count;
+			}
+			size_t ObjectRenderer::BatchCount() const {
+				return _batch_count;
+			}
+
+			void ObjectRenderer::_rebuildGrid(ObjectList& objects) {
+
+				_grid.clear();
+				_cells.clear();
+
+				for (auto i = objects.begin(); i != objects.end(); ++i) {
+
+					Sprite* sprite = _getSprite(*i, _typeOf(objects, i->Object()));
+
+					if (!sprite->bitmap)
+						continue;
+
+					PointF position = i->Object()->Position();
+					uint64_t key = _makeKey(_cellCoordinate(position.x), _cellCoordinate(position.y));
+
+					_grid[key].push_back(GridEntry{ i->Object().get(), sprite });
+					_cells[i->Object().get()] = key;
+
+				}
+
+				_grid_invalidated = false;
+
+			}
+			ObjectRenderer::GridEntry ObjectRenderer::_removeFromCell(const IObject* object, uint64_t key) {
+
+				// Entries keep their order within the cell, so that overlapping instances of the same type are still drawn in the order they were added.
+
+				auto cell_iter = _grid.find(key);
+				std::vector<GridEntry>& cell = cell_iter->second;
+
+				auto entry_iter = std::find_if(cell.begin(), cell.end(), [=](const GridEntry& x) {
+					return x.object == object;
+				});
+
+				GridEntry entry = *entry_iter;
+
+				cell.erase(entry_iter);
+
+				if (cell.empty())
+					_grid.erase(cell_iter);
+
+				return entry;
+
+			}
+			ObjectRenderer::Sprite* ObjectRenderer::_getSprite(ObjectList::Item& item, const String& type) {
+
+				std::string key = type;
+				auto sprite_iter = _sprites.find(key);
+
+				if (sprite_iter != _sprites.end())
+					return &sprite_iter->second;
+
+				// Draw the object offscreen once. Every instance of this type will reuse the result.
+
+				Sprite sprite;
+
+				RectangleF bounding_box = item.BoundingBox();
+				PointF position = item.Object()->Position();
+
+				sprite.origin = PointF(bounding_box.X() - position.x, bounding_box.Y() - position.y);
+				sprite.size = SizeF(std::ceil(bounding_box.Width()), std::ceil(bounding_box.Height()));
+				sprite.depth = item.Object()->Depth();
+				sprite.has_mask = false;
+
+				if (sprite.size.width > 0.0f && sprite.size.height > 0.0f) {
+
+					sprite.bitmap.reset(new Graphics::Bitmap(static_cast<int>(sprite.size.width), static_cast<int>(sprite.size.height)));
+
+					Graphics::Graphics gfx(*sprite.bitmap);
+					DrawEventArgs args(gfx);
+
+					gfx.Clear(Color::Transparent);
+
+					item.Object()->SetPosition(-sprite.origin.x, -sprite.origin.y);
+					item.Object()->OnDraw(args);
+					item.Object()->SetPosition(position);
+
+					_max_sprite_extent = std::max(_max_sprite_extent, std::max(std::abs(sprite.origin.x) + sprite.size.width, std::abs(sprite.origin.y) + sprite.size.height));
+
+				}
+
+				return &_sprites.emplace(key, std::move(sprite)).first->second;
+
+			}
+			void ObjectRenderer::_buildMask(Sprite& sprite) {
+
+				// Reading pixels back is slow, but this only happens once per object type.
+
+				int width = static_cast<int>(sprite.size.width);
+				int height = static_cast<int>(sprite.size.height);
+
+				sprite.mask = AlphaMask(width, height);
+
+				for (int y = 0; y < height; ++y)
+					for (int x = 0; x < width; ++x)
+						if (sprite.bitmap->GetPixel(x, y).Alpha() > 0)
+							sprite.mask.Set(x, y, true);
+
+				sprite.has_mask = true;
+
+			}
+			String ObjectRenderer::_typeOf(const ObjectList& objects, const IObjectPtr& object) {
+
+				// Instances are grouped by the name they were created from in the object registry.
+
+				const String* name = objects.GetProperty(object.get(), "name");
+
+				return name == nullptr ? String::Empty : *name;
+
+			}
+			uint64_t ObjectRenderer::_makeKey(int cell_x, int cell_y) {
+
+				return (static_cast<uint64_t>(static_cast<uint32_t>(cell_x)) << 32) | static_cast<uint32_t>(cell_y);
+
+			}
+			int ObjectRenderer::_cellCoordinate(float value) {
+
+				return static_cast<int>(std::floor(value / GRID_CELL_SIZE));
+
+			}
+
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,314 @@
+#include "editor/detail/BitmapCache.h"
+#include "editor/detail/PageFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			namespace {
+
+				const char MAGIC[4] = { 'H', 'V', 'P', 'G' };
+
+				// Files aren't rewritten to reclaim less than this many bytes, since it wouldn't be worth the time.
+				const uint64_t MIN_REWRITE_SIZE = 4 * 1024 * 1024;
+
+			}
+
+			PageFile::PageFile() :
+				_page_size(0),
+				_unused_size(0) {
+			}
+			bool PageFile::Open(const std::string& file_path) {
+
+				Close();
+
+				std::ifstream file(file_path, std::ios::binary);
+				Header header;
+
+				if (!file.read(reinterpret_cast<char*>(&header), sizeof(Header)) ||
+					std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0 ||
+					header.version != VERSION ||
+					header.page_size == 0)
+					return false;
+
+				file.seekg(0, std::ios::end);
+
+				uint64_t file_size = static_cast<uint64_t>(file.tellg());
+
+				if (header.index_offset + static_cast<uint64_t>(header.page_count) * sizeof(IndexEntry) > file_size)
+					return false;
+
+				file.seekg(static_cast<std::streamoff>(header.index_offset));
+
+				std::vector<IndexEntry> entries(header.page_count);
+
+				if (!entries.empty() && !file.read(reinterpret_cast<char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(IndexEntry))))
+					return false;
+
+				for (auto i = entries.begin(); i != entries.end(); ++i) {
+
+					if (i->offset + i->size > file_size) {
+
+						_index.clear();
+
+						return false;
+
+					}
+
+					Location location = { i->offset, i->size };
+
+					_index[i->key] = location;
+
+				}
+
+				_path = file_path;
+				_page_size = static_cast<int>(header.page_size);
+				_unused_size = header.unused_size;
+
+				return true;
+
+			}
+			void PageFile::Close() {
+
+				_path.clear();
+				_page_size = 0;
+				_unused_size = 0;
+				_index.clear();
+
+			}
+			bool PageFile::IsOpen() const {
+				return !_path.empty();
+			}
+			const std::string& PageFile::Path() const {
+				return _path;
+			}
+			int PageFile::PageSize() const {
+				return _page_size;
+			}
+			bool PageFile::GetLocation(uint64_t key, Location& location) const {
+
+				auto index_iter = _index.find(key);
+
+				if (index_iter == _index.end())
+					return false;
+
+				location = index_iter->second;
+
+				return true;
+
+			}
+			std::vector<uint64_t> PageFile::Keys() const {
+
+				std::vector<uint64_t> keys;
+				keys.reserve(_index.size());
+
+				for (auto i = _index.begin(); i != _index.end(); ++i)
+					keys.push_back(i->first);
+
+				return keys;
+
+			}
+			bool PageFile::Write(const std::string& file_path, int page_size, const page_map_type& pages) {
+
+				if (IsOpen() && page_size == _page_size && BitmapCache::NormalizePath(file_path) == BitmapCache::NormalizePath(_path))
+					return _append(pages);
+
+				return _rewrite(file_path, page_size, pages);
+
+			}
+			bool PageFile::Read(const std::string& file_path, const Location& location, std::vector<uint8_t>& data) {
+
+				std::ifstream file(file_path, std::ios::binary);
+
+				if (!file.seekg(static_cast<std::streamoff>(location.offset)))
+					return false;
+
+				data.resize(location.size);
+
+				return location.size == 0 || static_cast<bool>(file.read(reinterpret_cast<char*>(data.data()), static_cast<std::streamsize>(location.size)));
+
+			}
+
+			bool PageFile::_append(const page_map_type& pages) {
+
+				std::fstream file(_path, std::ios::in | std::ios::out | std::ios::binary);
+
+				if (!file.seekp(0, std::ios::end))
+					return false;
+
+				uint64_t offset = static_cast<uint64_t>(file.tellp());
+				std::unordered_map<uint64_t, Location> index = _index;
+
+				// The previous index is no longer needed once the new one has been written.
+				uint64_t unused_size = _unused_size + index.size() * sizeof(IndexEntry);
+
+				for (auto i = pages.begin(); i != pages.end(); ++i) {
+
+					auto index_iter = index.find(i->first);
+
+					if (index_iter != index.end()) {
+
+						unused_size += index_iter->second.size;
+
+						index.erase(index_iter);
+
+					}
+
+					if (i->second.empty())
+						continue;
+
+					file.write(reinterpret_cast<const char*>(i->second.data()), static_cast<std::streamsize>(i->second.size()));
+
+					Location location = { offset, static_cast<uint32_t>(i->second.size()) };
+
+					index[i->first] = location;
+					offset += location.size;
+
+				}
+
+				std::vector<IndexEntry> entries;
+				uint64_t used_size = 0;
+
+				for (auto i = index.begin(); i != index.end(); ++i) {
+
+					IndexEntry entry = { i->first, i->second.offset, i->second.size, 0 };
+
+					entries.push_back(entry);
+					used_size += i->second.size;
+
+				}
+
+				if (!entries.empty())
+					file.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(IndexEntry)));
+
+				file.flush();
+
+				if (!file)
+					return false;
+
+				// Everything the new header refers to has been written, so it's safe to update it now.
+
+				Header header;
+				std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+				header.version = VERSION;
+				header.page_size = static_cast<uint32_t>(_page_size);
+				header.page_count = static_cast<uint32_t>(entries.size());
+				header.index_offset = offset;
+				header.unused_size = unused_size;
+
+				file.seekp(0);
+				file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+				file.flush();
+
+				if (!file)
+					return false;
+
+				file.close();
+
+				_index = std::move(index);
+				_unused_size = unused_size;
+
+				if (_unused_size > used_size && _unused_size > MIN_REWRITE_SIZE)
+					return _rewrite(_path, _page_size, page_map_type());
+
+				return true;
+
+			}
+			bool PageFile::_rewrite(const std::string& file_path, int page_size, const page_map_type& pages) {
+
+				// Write to a temporary file first, so that the existing file stays intact if something goes wrong.
+
+				std::string temp_path = file_path + ".tmp";
+				std::unordered_map<uint64_t, Location> index;
+
+				{
+					std::ofstream file(temp_path, std::ios::binary | std::ios::trunc);
+
+					if (!file)
+						return false;
+
+					Header header;
+					std::memset(&header, 0, sizeof(Header));
+
+					file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+
+					uint64_t offset = sizeof(Header);
+					std::vector<uint8_t> data;
+
+					auto writePage = [&](uint64_t key, const std::vector<uint8_t>& page) {
+
+						file.write(reinterpret_cast<const char*>(page.data()), static_cast<std::streamsize>(page.size()));
+
+						Location location = { offset, static_cast<uint32_t>(page.size()) };
+
+						index[key] = location;
+						offset += location.size;
+
+					};
+
+					// Copy the pages that aren't being replaced from the open file.
+
+					for (auto i = _index.begin(); i != _index.end(); ++i) {
+
+						if (pages.count(i->first) > 0)
+							continue;
+
+						if (!Read(_path, i->second, data))
+							return false;
+
+						writePage(i->first, data);
+
+					}
+
+					for (auto i = pages.begin(); i != pages.end(); ++i)
+						if (!i->second.empty())
+							writePage(i->first, i->second);
+
+					std::vector<IndexEntry> entries;
+
+					for (auto i = index.begin(); i != index.end(); ++i) {
+
+						IndexEntry entry = { i->first, i->second.offset, i->second.size, 0 };
+
+						entries.push_back(entry);
+
+					}
+
+					if (!entries.empty())
+						file.write(reinterpret_cast<const char*>(entries.data()), static_cast<std::streamsize>(entries.size() * sizeof(IndexEntry)));
+
+					std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+					header.version = VERSION;
+					header.page_size = static_cast<uint32_t>(page_size);
+					header.page_count = static_cast<uint32_t>(entries.size());
+					header.index_offset = offset;
+					header.unused_size = 0;
+
+					file.seekp(0);
+					file.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+
+					if (!file)
+						return false;
+				}
+
+				std::remove(file_path.c_str());
+
+				if (std::rename(temp_path.c_str(), file_path.c_str()) != 0)
+					return false;
+
+				_path = file_path;
+				_page_size = page_size;
+				_unused_size = 0;
+				_index = std::move(index);
+
+				return true;
+
+			}
+
+		}
+	}
+}
\ No newline at end of file
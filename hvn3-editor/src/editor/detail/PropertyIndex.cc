@@ -0,0 +1,254 @@
+#include "editor/detail/PropertyIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <iterator>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			void PropertyIndex::Add(IObject* object, const std::string& key, const std::string& value) {
+
+				KeyIndex& index = _keys[key];
+
+				if (!index.values[value].insert(object).second)
+					return;
+
+				double number;
+
+				if (ParseNumber(value, number))
+					index.numbers[number].insert(object);
+
+				++index.count;
+
+			}
+			void PropertyIndex::Remove(IObject* object, const std::string& key, const std::string& value) {
+
+				auto key_iter = _keys.find(key);
+
+				if (key_iter == _keys.end())
+					return;
+
+				KeyIndex& index = key_iter->second;
+				auto value_iter = index.values.find(value);
+
+				if (value_iter == index.values.end() || value_iter->second.erase(object) == 0)
+					return;
+
+				// Empty buckets are removed, so that scans over the values of a key only visit values that are in use.
+
+				if (value_iter->second.empty())
+					index.values.erase(value_iter);
+
+				double number;
+
+				if (ParseNumber(value, number)) {
+
+					auto number_iter = index.numbers.find(number);
+
+					if (number_iter != index.numbers.end()) {
+
+						number_iter->second.erase(object);
+
+						if (number_iter->second.empty())
+							index.numbers.erase(number_iter);
+
+					}
+
+				}
+
+				if (--index.count == 0)
+					_keys.erase(key_iter);
+
+			}
+			void PropertyIndex::Clear() {
+
+				_keys.clear();
+
+			}
+			void PropertyIndex::Find(const std::string& key, Comparison comparison, const std::string& value, std::vector<IObject*>& results) const {
+
+				auto key_iter = _keys.find(key);
+
+				if (key_iter == _keys.end())
+					return;
+
+				const KeyIndex& index = key_iter->second;
+				size_t first = results.size();
+				double number;
+				bool is_number = ParseNumber(value, number);
+
+				switch (comparison) {
+
+				case Comparison::Equal:
+					_findEqual(index, value, results);
+					break;
+
+				case Comparison::NotEqual: {
+
+					std::vector<IObject*> all;
+					std::vector<IObject*> equal;
+
+					_findAll(index, all);
+					_findEqual(index, value, equal);
+
+					std::sort(all.begin(), all.end());
+					std::sort(equal.begin(), equal.end());
+					std::set_difference(all.begin(), all.end(), equal.begin(), equal.end(), std::back_inserter(results));
+
+					break;
+
+				}
+
+				case Comparison::Less:
+					if (is_number)
+						_append(index.numbers.begin(), index.numbers.lower_bound(number), results);
+					else
+						_append(index.values.begin(), index.values.lower_bound(value), results);
+					break;
+
+				case Comparison::LessOrEqual:
+					if (is_number)
+						_append(index.numbers.begin(), index.numbers.upper_bound(number), results);
+					else
+						_append(index.values.begin(), index.values.upper_bound(value), results);
+					break;
+
+				case Comparison::Greater:
+					if (is_number)
+						_append(index.numbers.upper_bound(number), index.numbers.end(), results);
+					else
+						_append(index.values.upper_bound(value), index.values.end(), results);
+					break;
+
+				case Comparison::GreaterOrEqual:
+					if (is_number)
+						_append(index.numbers.lower_bound(number), index.numbers.end(), results);
+					else
+						_append(index.values.lower_bound(value), index.values.end(), results);
+					break;
+
+				}
+
+				// Each object has a single value per key, so the buckets never overlap and sorting is enough to make the results usable as a set.
+				std::sort(results.begin() + first, results.end());
+
+			}
+			size_t PropertyIndex::Count(const std::string& key) const {
+
+				auto key_iter = _keys.find(key);
+
+				return key_iter == _keys.end() ? 0 : key_iter->second.count;
+
+			}
+			bool PropertyIndex::ParseNumber(const std::string& value, double& number) {
+
+				if (value.empty())
+					return false;
+
+				const char* begin = value.c_str();
+				char* end = nullptr;
+
+				number = std::strtod(begin, &end);
+
+				// Values like "nan" can't be ordered, so they're treated as strings.
+				return end != begin && *end == '\0' && std::isfinite(number);
+
+			}
+			bool PropertyIndex::Match(const char* pattern, const char* value) {
+
+				// When a character doesn't match, retry from the last '*', letting it match one more character.
+
+				const char* star = nullptr;
+				const char* resume = nullptr;
+
+				while (*value != '\0') {
+
+					if (*pattern == '*') {
+
+						star = pattern++;
+						resume = value;
+
+					}
+					else if (*pattern == *value) {
+
+						++pattern;
+						++value;
+
+					}
+					else if (star != nullptr) {
+
+						pattern = star + 1;
+						value = ++resume;
+
+					}
+					else
+						return false;
+
+				}
+
+				while (*pattern == '*')
+					++pattern;
+
+				return *pattern == '\0';
+
+			}
+
+			void PropertyIndex::_findEqual(const KeyIndex& index, const std::string& value, std::vector<IObject*>& results) const {
+
+				size_t wildcard = value.find('*');
+
+				if (wildcard == std::string::npos) {
+
+					double number;
+
+					if (ParseNumber(value, number)) {
+
+						auto number_iter = index.numbers.find(number);
+
+						if (number_iter != index.numbers.end())
+							results.insert(results.end(), number_iter->second.begin(), number_iter->second.end());
+
+					}
+					else {
+
+						auto value_iter = index.values.find(value);
+
+						if (value_iter != index.values.end())
+							results.insert(results.end(), value_iter->second.begin(), value_iter->second.end());
+
+					}
+
+					return;
+
+				}
+
+				// Only values beginning with the part of the pattern before the first wildcard can match, and they're next to each other in the map.
+
+				std::string prefix = value.substr(0, wildcard);
+
+				for (auto i = index.values.lower_bound(prefix); i != index.values.end() && i->first.compare(0, prefix.size(), prefix) == 0; ++i)
+					if (Match(value.c_str() + wildcard, i->first.c_str() + prefix.size()))
+						results.insert(results.end(), i->second.begin(), i->second.end());
+
+			}
+			void PropertyIndex::_findAll(const KeyIndex& index, std::vector<IObject*>& results) const {
+
+				results.reserve(results.size() + index.count);
+
+				_append(index.values.begin(), index.values.end(), results);
+
+			}
+			template <typename IteratorType>
+			void PropertyIndex::_append(IteratorType begin, IteratorType end, std::vector<IObject*>& results) {
+
+				for (auto i = begin; i != end; ++i)
+					results.insert(results.end(), i->second.begin(), i->second.end());
+
+			}
+
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,272 @@
+#include "editor/detail/PropertyQuery.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			PropertyQuery::PropertyQuery() {}
+			bool PropertyQuery::Parse(const std::string& query) {
+
+				_groups.clear();
+				_error_message.clear();
+
+				std::vector<Token> tokens;
+
+				if (!_tokenize(query, tokens))
+					return false;
+
+				if (tokens.empty()) {
+
+					_error_message = "The query is empty.";
+
+					return false;
+
+				}
+
+				std::vector<std::vector<Condition>> groups(1);
+
+				for (size_t i = 0; i < tokens.size();) {
+
+					if (tokens[i].type != Token::Type::Value) {
+
+						_error_message = "Expected a property or value before '" + tokens[i].text + "'.";
+
+						return false;
+
+					}
+
+					Condition condition;
+
+					if (i + 1 < tokens.size() && tokens[i + 1].type == Token::Type::Operator) {
+
+						if (!_parseOperator(tokens[i + 1].text, condition.comparison)) {
+
+							_error_message = "Unknown operator '" + tokens[i + 1].text + "'.";
+
+							return false;
+
+						}
+
+						if (i + 2 >= tokens.size() || tokens[i + 2].type != Token::Type::Value) {
+
+							_error_message = "Expected a value after '" + tokens[i + 1].text + "'.";
+
+							return false;
+
+						}
+
+						condition.key = tokens[i].text;
+						condition.value = tokens[i + 2].text;
+
+						i += 3;
+
+					}
+					else {
+
+						// A value on its own refers to the object's type.
+
+						condition.key = "name";
+						condition.comparison = PropertyIndex::Comparison::Equal;
+						condition.value = tokens[i].text;
+
+						i += 1;
+
+					}
+
+					groups.back().push_back(condition);
+
+					if (i >= tokens.size())
+						break;
+
+					if (tokens[i].type == Token::Type::Or)
+						groups.emplace_back();
+					else if (tokens[i].type != Token::Type::And) {
+
+						_error_message = "Expected 'and' or 'or' before '" + tokens[i].text + "'.";
+
+						return false;
+
+					}
+
+					if (++i >= tokens.size()) {
+
+						_error_message = "Expected a condition after '" + tokens[i - 1].text + "'.";
+
+						return false;
+
+					}
+
+				}
+
+				_groups = std::move(groups);
+
+				return true;
+
+			}
+			const std::string& PropertyQuery::ErrorMessage() const {
+
+				return _error_message;
+
+			}
+			bool PropertyQuery::Empty() const {
+
+				return _groups.empty();
+
+			}
+			std::vector<IObject*> PropertyQuery::Execute(const PropertyIndex& index) const {
+
+				std::vector<IObject*> results;
+				std::vector<IObject*> group_results;
+				std::vector<IObject*> condition_results;
+				std::vector<IObject*> merged;
+
+				for (auto group = _groups.begin(); group != _groups.end(); ++group) {
+
+					// Each condition is looked up in the index separately, and the (sorted) results are intersected. Once nothing is left, the remaining conditions can be skipped.
+
+					group_results.clear();
+
+					for (auto condition = group->begin(); condition != group->end(); ++condition) {
+
+						condition_results.clear();
+
+						index.Find(condition->key, condition->comparison, condition->value, condition_results);
+
+						if (condition == group->begin())
+							group_results.swap(condition_results);
+						else {
+
+							merged.clear();
+
+							std::set_intersection(group_results.begin(), group_results.end(), condition_results.begin(), condition_results.end(), std::back_inserter(merged));
+
+							group_results.swap(merged);
+
+						}
+
+						if (group_results.empty())
+							break;
+
+					}
+
+					if (results.empty())
+						results.swap(group_results);
+					else {
+
+						merged.clear();
+
+						std::set_union(results.begin(), results.end(), group_results.begin(), group_results.end(), std::back_inserter(merged));
+
+						results.swap(merged);
+
+					}
+
+				}
+
+				return results;
+
+			}
+
+			bool PropertyQuery::_tokenize(const std::string& query, std::vector<Token>& tokens) {
+
+				auto is_operator = [](char c) {
+					return c == '=' || c == '!' || c == '<' || c == '>';
+				};
+
+				for (size_t i = 0; i < query.size();) {
+
+					char c = query[i];
+
+					if (std::isspace(static_cast<unsigned char>(c))) {
+
+						++i;
+
+						continue;
+
+					}
+
+					Token token;
+					size_t start = i;
+
+					if (c == '"') {
+
+						size_t end = query.find('"', i + 1);
+
+						if (end == std::string::npos) {
+
+							_error_message = "Missing closing quote.";
+
+							return false;
+
+						}
+
+						token.type = Token::Type::Value;
+						token.text = query.substr(i + 1, end - i - 1);
+
+						i = end + 1;
+
+					}
+					else if (is_operator(c)) {
+
+						while (i < query.size() && is_operator(query[i]))
+							++i;
+
+						token.type = Token::Type::Operator;
+						token.text = query.substr(start, i - start);
+
+					}
+					else {
+
+						while (i < query.size() && !std::isspace(static_cast<unsigned char>(query[i])) && !is_operator(query[i]) && query[i] != '"')
+							++i;
+
+						token.type = Token::Type::Value;
+						token.text = query.substr(start, i - start);
+
+						// Keywords are only recognized when they aren't quoted, so that "and" and "or" can still be searched for.
+
+						std::string lower = token.text;
+						std::transform(lower.begin(), lower.end(), lower.begin(), [](char x) { return static_cast<char>(std::tolower(static_cast<unsigned char>(x))); });
+
+						if (lower == "and")
+							token.type = Token::Type::And;
+						else if (lower == "or")
+							token.type = Token::Type::Or;
+
+					}
+
+					tokens.push_back(std::move(token));
+
+				}
+
+				return true;
+
+			}
+			bool PropertyQuery::_parseOperator(const std::string& text, PropertyIndex::Comparison& comparison) {
+
+				if (text == "=" || text == "==")
+					comparison = PropertyIndex::Comparison::Equal;
+				else if (text == "!=")
+					comparison = PropertyIndex::Comparison::NotEqual;
+				else if (text == "<")
+					comparison = PropertyIndex::Comparison::Less;
+				else if (text == "<=")
+					comparison = PropertyIndex::Comparison::LessOrEqual;
+				else if (text == ">")
+					comparison = PropertyIndex::Comparison::Greater;
+				else if (text == ">=")
+					comparison = PropertyIndex::Comparison::GreaterOrEqual;
+				else
+					return false;
+
+				return true;
+
+			}
+
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,794 @@
+#include "editor/detail/RoomStreamer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			namespace {
+
+				// The number of pages kept in memory by default. With a single layer of 16-bit tiles, this works out to around 8 MiB of tiles.
+				const size_t DEFAULT_CAPACITY = 256;
+
+				void writeValue(std::vector<uint8_t>& data, const void* value, size_t size) {
+
+					const uint8_t* bytes = static_cast<const uint8_t*>(value);
+
+					data.insert(data.end(), bytes, bytes + size);
+
+				}
+				template<typename T>
+				void writeValue(std::vector<uint8_t>& data, T value) {
+					writeValue(data, &value, sizeof(T));
+				}
+				void writeString(std::vector<uint8_t>& data, const std::string& value) {
+
+					writeValue(data, static_cast<uint32_t>(value.size()));
+					writeValue(data, value.data(), value.size());
+
+				}
+
+				// Reads values written by the functions above, failing instead of reading past the end of the data.
+				class PageReader {
+
+				public:
+					PageReader(const std::vector<uint8_t>& data) :
+						_data(data),
+						_position(0) {
+					}
+					template<typename T>
+					bool Read(T& value) {
+
+						if (_data.size() - _position < sizeof(T))
+							return false;
+
+						std::memcpy(&value, _data.data() + _position, sizeof(T));
+
+						_position += sizeof(T);
+
+						return true;
+
+					}
+					bool ReadString(std::string& value) {
+
+						uint32_t size;
+
+						if (!Read(size) || _data.size() - _position < size)
+							return false;
+
+						value.assign(reinterpret_cast<const char*>(_data.data()) + _position, size);
+
+						_position += size;
+
+						return true;
+
+					}
+
+				private:
+					const std::vector<uint8_t>& _data;
+					size_t _position;
+
+				};
+
+			}
+
+			RoomStreamer::RoomStreamer(JobSystem& jobs, TileLayerList& layers, ObjectList& objects) :
+				_jobs(jobs),
+				_layers(layers),
+				_objects(objects),
+				_open(false),
+				_capacity(DEFAULT_CAPACITY) {
+			}
+			bool RoomStreamer::Open(const std::string& file_path, const SizeI& tile_size) {
+
+				Close();
+
+				if (!_file.Open(file_path))
+					return false;
+
+				if (_file.PageSize() != PAGE_SIZE) {
+
+					_file.Close();
+
+					return false;
+
+				}
+
+				_open = true;
+				_tile_size = tile_size;
+
+				return true;
+
+			}
+			void RoomStreamer::Attach(const SizeI& tile_size) {
+
+				Close();
+
+				_open = true;
+				_tile_size = tile_size;
+
+				std::unordered_set<uint64_t> keys;
+
+				for (int i = 0; i < _layers.Count(); ++i) {
+
+					_layers.FindLayer(i)->ForEachChunk([&](int chunk_x, int chunk_y, const TileLayer::Chunk&) {
+						keys.insert(_makeKey(_floorDivide(chunk_x, PAGE_CHUNKS), _floorDivide(chunk_y, PAGE_CHUNKS)));
+					});
+
+				}
+
+				for (auto i = _objects.begin(); i != _objects.end(); ++i)
+					keys.insert(_pageAt(i->Object()->Position()));
+
+				for (auto i = keys.begin(); i != keys.end(); ++i) {
+
+					Page& page = _pages[*i];
+
+					page.state = PageState::Resident;
+					page.modified = true;
+					page.lru_iter = _lru.insert(_lru.end(), *i);
+
+					_loaded_pages.insert(*i);
+
+				}
+
+			}
+			void RoomStreamer::Close() {
+
+				// Cancelled jobs never complete, so nothing is applied to the room after this.
+
+				for (auto i = _pages.begin(); i != _pages.end(); ++i)
+					if (i->second.job)
+						i->second.job->Cancel();
+
+				_pages.clear();
+				_lru.clear();
+				_modified.clear();
+				_loaded_pages.clear();
+				_unreadable_pages.clear();
+				_file.Close();
+				_open = false;
+
+			}
+			bool RoomStreamer::IsOpen() const {
+				return _open;
+			}
+			const std::string& RoomStreamer::FilePath() const {
+				return _file.Path();
+			}
+			void RoomStreamer::SetCapacity(size_t pages) {
+				_capacity = std::max<size_t>(pages, 1);
+			}
+			void RoomStreamer::SetObjectLoadedCallback(object_loaded_callback_type&& callback) {
+				_object_loaded = std::move(callback);
+			}
+			void RoomStreamer::SetPageLoadedCallback(page_loaded_callback_type&& callback) {
+				_page_loaded = std::move(callback);
+			}
+			void RoomStreamer::SetPageEvictedCallback(page_evicted_callback_type&& callback) {
+				_page_evicted = std::move(callback);
+			}
+			void RoomStreamer::Update(const RectangleF& region) {
+
+				if (!_open || _tile_size.width <= 0 || _tile_size.height <= 0)
+					return;
+
+				float page_width = static_cast<float>(_tile_size.width * PAGE_SIZE);
+				float page_height = static_cast<float>(_tile_size.height * PAGE_SIZE);
+
+				// Include a page of margin on each side, so that pages are already loaded by the time they scroll into view.
+
+				int first_x = static_cast<int>(std::floor(region.X() / page_width)) - 1;
+				int first_y = static_cast<int>(std::floor(region.Y() / page_height)) - 1;
+				int last_x = static_cast<int>(std::floor((region.X() + region.Width()) / page_width)) + 1;
+				int last_y = static_cast<int>(std::floor((region.Y() + region.Height()) / page_height)) + 1;
+				float center_x = (region.X() + region.Width() / 2.0f) / page_width;
+				float center_y = (region.Y() + region.Height() / 2.0f) / page_height;
+
+				// When zoomed far out, the region can cover more pages than fit in memory. Only the ones nearest to the center are wanted in that case.
+
+				int max_span = static_cast<int>(std::sqrt(static_cast<double>(_capacity))) + 2;
+
+				if (last_x - first_x + 1 > max_span) {
+
+					first_x = static_cast<int>(std::floor(center_x)) - max_span / 2;
+					last_x = first_x + max_span - 1;
+
+				}
+
+				if (last_y - first_y + 1 > max_span) {
+
+					first_y = static_cast<int>(std::floor(center_y)) - max_span / 2;
+					last_y = first_y + max_span - 1;
+
+				}
+
+				std::vector<std::pair<float, uint64_t>> wanted;
+
+				for (int y = first_y; y <= last_y; ++y)
+					for (int x = first_x; x <= last_x; ++x) {
+
+						float dx = static_cast<float>(x) + 0.5f - center_x;
+						float dy = static_cast<float>(y) + 0.5f - center_y;
+
+						wanted.push_back(std::make_pair(dx * dx + dy * dy, _makeKey(x, y)));
+
+					}
+
+				std::sort(wanted.begin(), wanted.end(), [](const std::pair<float, uint64_t>& lhs, const std::pair<float, uint64_t>& rhs) {
+					return lhs.first < rhs.first;
+				});
+
+				if (wanted.size() > _capacity)
+					wanted.resize(_capacity);
+
+				// Visit the wanted pages from farthest to nearest, so that the nearest pages end up at the front of the LRU list and are loaded first.
+
+				std::unordered_set<uint64_t> wanted_keys;
+
+				for (auto i = wanted.rbegin(); i != wanted.rend(); ++i) {
+
+					uint64_t key = i->second;
+
+					wanted_keys.insert(key);
+
+					if (_unreadable_pages.count(key) > 0)
+						continue;
+
+					auto page_iter = _pages.find(key);
+
+					if (page_iter == _pages.end())
+						_load(key);
+					else if (page_iter->second.state != PageState::Evicting)
+						_lru.splice(_lru.begin(), _lru, page_iter->second.lru_iter);
+
+					// Pages that are still being encoded are loaded on a later update, once they've been written to memory.
+
+				}
+
+				// Unload the least recently used pages that aren't wanted until there's room.
+
+				while (_lru.size() > _capacity) {
+
+					uint64_t key = _lru.back();
+
+					if (wanted_keys.count(key) > 0)
+						break;
+
+					_evict(key);
+
+				}
+
+			}
+			bool RoomStreamer::IsResident(int tile_x, int tile_y) const {
+
+				if (!_open)
+					return true;
+
+				auto page_iter = _pages.find(_makeKey(_floorDivide(tile_x, PAGE_SIZE), _floorDivide(tile_y, PAGE_SIZE)));
+
+				return page_iter != _pages.end() && page_iter->second.state == PageState::Resident;
+
+			}
+			bool RoomStreamer::IsResident(const PointF& position) const {
+
+				if (!_open)
+					return true;
+
+				auto page_iter = _pages.find(_pageAt(position));
+
+				return page_iter != _pages.end() && page_iter->second.state == PageState::Resident;
+
+			}
+			void RoomStreamer::MarkModified(int tile_x, int tile_y) {
+
+				auto page_iter = _pages.find(_makeKey(_floorDivide(tile_x, PAGE_SIZE), _floorDivide(tile_y, PAGE_SIZE)));
+
+				if (page_iter != _pages.end() && page_iter->second.state == PageState::Resident)
+					page_iter->second.modified = true;
+
+			}
+			void RoomStreamer::MarkModified(const PointF& position) {
+
+				auto page_iter = _pages.find(_pageAt(position));
+
+				if (page_iter != _pages.end() && page_iter->second.state == PageState::Resident)
+					page_iter->second.modified = true;
+
+			}
+			bool RoomStreamer::ForEachUnloaded(const chunk_callback_type& chunk_func, const object_callback_type& object_func) {
+
+				if (!_open)
+					return true;
+
+				// Pages being unloaded need to finish encoding before they can be read.
+
+				_wait();
+
+				std::unordered_set<uint64_t> keys;
+
+				for (auto i = _modified.begin(); i != _modified.end(); ++i)
+					keys.insert(i->first);
+
+				if (_file.IsOpen()) {
+
+					std::vector<uint64_t> file_keys = _file.Keys();
+
+					keys.insert(file_keys.begin(), file_keys.end());
+
+				}
+
+				bool success = true;
+
+				for (auto i = keys.begin(); i != keys.end(); ++i) {
+
+					auto page_iter = _pages.find(*i);
+
+					if (page_iter != _pages.end() && page_iter->second.state == PageState::Resident)
+						continue;
+
+					// Pages that were modified since the last save are read from memory, and other pages from the file.
+
+					PageContents contents;
+					PageFile::Location location;
+					std::vector<uint8_t> data;
+					auto modified_iter = _modified.find(*i);
+					bool decoded;
+
+					if (modified_iter != _modified.end())
+						decoded = _decode(*modified_iter->second, contents);
+					else
+						decoded = _file.GetLocation(*i, location) && PageFile::Read(_file.Path(), location, data) && _decode(data, contents);
+
+					if (!decoded) {
+
+						success = false;
+
+						continue;
+
+					}
+
+					if (chunk_func)
+						for (auto j = contents.chunks.begin(); j != contents.chunks.end(); ++j)
+							chunk_func(j->layer, j->x, j->y, *j->chunk);
+
+					if (object_func)
+						for (auto j = contents.objects.begin(); j != contents.objects.end(); ++j)
+							object_func(*j);
+
+				}
+
+				return success;
+
+			}
+			bool RoomStreamer::Save(const std::string& file_path) {
+
+				if (!_open)
+					return false;
+
+				// Pages being unloaded need to finish encoding before they can be written.
+
+				_wait();
+
+				PageFile::page_map_type pages;
+
+				for (auto i = _modified.begin(); i != _modified.end(); ++i)
+					pages[i->first] = *i->second;
+
+				for (auto i = _pages.begin(); i != _pages.end(); ++i)
+					if (i->second.state == PageState::Resident && i->second.modified)
+						_encode(_collectPage(i->first, false), pages[i->first]);
+
+				if (!_file.Write(file_path, PAGE_SIZE, pages))
+					return false;
+
+				_modified.clear();
+
+				for (auto i = _pages.begin(); i != _pages.end(); ++i)
+					i->second.modified = false;
+
+				return true;
+
+			}
+			size_t RoomStreamer::ResidentCount() const {
+
+				size_t count = 0;
+
+				for (auto i = _pages.begin(); i != _pages.end(); ++i)
+					if (i->second.state == PageState::Resident)
+						++count;
+
+				return count;
+
+			}
+			size_t RoomStreamer::LoadingCount() const {
+
+				size_t count = 0;
+
+				for (auto i = _pages.begin(); i != _pages.end(); ++i)
+					if (i->second.state == PageState::Loading)
+						++count;
+
+				return count;
+
+			}
+			bool RoomStreamer::IsLargeRoom(int columns, int rows) {
+
+				int64_t pages_x = (static_cast<int64_t>(columns) + PAGE_SIZE - 1) / PAGE_SIZE;
+				int64_t pages_y = (static_cast<int64_t>(rows) + PAGE_SIZE - 1) / PAGE_SIZE;
+
+				return pages_x * pages_y >= MIN_STREAMED_PAGES;
+
+			}
+
+			void RoomStreamer::_load(uint64_t key) {
+
+				Page& page = _pages[key];
+
+				page.state = PageState::Loading;
+				page.modified = false;
+				page.lru_iter = _lru.insert(_lru.begin(), key);
+
+				// Pages that were modified since the last save are loaded from memory, and other pages from the file.
+
+				std::shared_ptr<std::vector<uint8_t>> modified_data;
+				PageFile::Location location;
+				auto modified_iter = _modified.find(key);
+
+				if (modified_iter != _modified.end())
+					modified_data = modified_iter->second;
+				else if (!_file.IsOpen() || !_file.GetLocation(key, location)) {
+
+					// The page has never been written, so it's empty.
+
+					PageContents contents;
+
+					page.state = PageState::Resident;
+
+					_applyPage(key, contents);
+
+					return;
+
+				}
+
+				std::string file_path = _file.Path();
+				std::shared_ptr<PageContents> contents = std::make_shared<PageContents>();
+				std::shared_ptr<bool> success = std::make_shared<bool>(false);
+
+				page.job = _jobs.Submit("Loading page", [=](Job&) {
+
+					std::vector<uint8_t> data;
+
+					if (modified_data)
+						*success = _decode(*modified_data, *contents);
+					else
+						*success = PageFile::Read(file_path, location, data) && _decode(data, *contents);
+
+				}, [=](const Job&) {
+
+					// Work that failed leaves success unset, so the page is treated as unreadable.
+
+					auto page_iter = _pages.find(key);
+
+					if (page_iter == _pages.end())
+						return;
+
+					if (!*success) {
+
+						// Leave pages that couldn't be read alone, rather than editing an empty page that would replace them when saved.
+
+						_lru.erase(page_iter->second.lru_iter);
+						_pages.erase(page_iter);
+						_unreadable_pages.insert(key);
+
+						return;
+
+					}
+
+					page_iter->second.state = PageState::Resident;
+					page_iter->second.job.reset();
+
+					if (modified_data) {
+
+						page_iter->second.modified = true;
+
+						_modified.erase(key);
+
+					}
+
+					_applyPage(key, *contents);
+
+				});
+
+				// Pages are only cancelled by the streamer itself, which knows to forget them.
+				page.job->SetCancellable(false);
+
+			}
+			void RoomStreamer::_evict(uint64_t key) {
+
+				auto page_iter = _pages.find(key);
+				Page& page = page_iter->second;
+
+				_lru.erase(page.lru_iter);
+
+				if (page.state == PageState::Loading) {
+
+					// The completion of a cancelled job is never called, so the page is never applied.
+
+					page.job->Cancel();
+
+					_pages.erase(page_iter);
+
+					return;
+
+				}
+
+				std::shared_ptr<PageContents> contents = std::make_shared<PageContents>(_collectPage(key, true));
+
+				if (_page_evicted)
+					_page_evicted(_pageBounds(key));
+
+				if (!page.modified) {
+
+					_pages.erase(page_iter);
+
+					return;
+
+				}
+
+				// Encode the modified page on a worker thread, and keep it until it's saved or loaded again.
+
+				std::shared_ptr<std::vector<uint8_t>> data = std::make_shared<std::vector<uint8_t>>();
+
+				page.state = PageState::Evicting;
+				page.job = _jobs.Submit("Unloading page", [=](Job&) {
+
+					_encode(*contents, *data);
+
+				}, [=](const Job& job) {
+
+					auto page_iter = _pages.find(key);
+
+					if (job.IsFailed() && page_iter != _pages.end()) {
+
+						// The page's contents are still held by the job, so put them back rather than losing them. It stays modified, and is evicted again later.
+
+						page_iter->second.state = PageState::Resident;
+						page_iter->second.job.reset();
+						page_iter->second.lru_iter = _lru.insert(_lru.end(), key);
+
+						_applyPage(key, *contents);
+
+						return;
+
+					}
+
+					_modified[key] = data;
+					_pages.erase(key);
+
+				});
+
+				// The page's contents only exist in the job until it completes.
+				page.job->SetCancellable(false);
+
+			}
+			void RoomStreamer::_applyPage(uint64_t key, PageContents& contents) {
+
+				bool first_load = _loaded_pages.insert(key).second;
+
+				for (auto i = contents.chunks.begin(); i != contents.chunks.end(); ++i)
+					_layers.GetOrCreateLayer(i->layer).SetChunk(i->x, i->y, std::move(i->chunk));
+
+				if (_object_loaded)
+					for (auto i = contents.objects.begin(); i != contents.objects.end(); ++i)
+						_object_loaded(*i, first_load);
+
+				if (_page_loaded)
+					_page_loaded(_pageTiles(key), first_load);
+
+			}
+			RoomStreamer::PageContents RoomStreamer::_collectPage(uint64_t key, bool remove) {
+
+				PageContents contents;
+				int first_chunk_x = _pageX(key) * PAGE_CHUNKS;
+				int first_chunk_y = _pageY(key) * PAGE_CHUNKS;
+
+				for (int layer = 0; layer < _layers.Count(); ++layer)
+					for (int y = first_chunk_y; y < first_chunk_y + PAGE_CHUNKS; ++y)
+						for (int x = first_chunk_x; x < first_chunk_x + PAGE_CHUNKS; ++x) {
+
+							std::unique_ptr<TileLayer::Chunk> chunk;
+
+							if (remove)
+								chunk = _layers.FindLayer(layer)->TakeChunk(x, y);
+							else if (const TileLayer::Chunk* existing = _layers.FindLayer(layer)->GetChunk(x, y))
+								chunk.reset(new TileLayer::Chunk(*existing));
+
+							if (!chunk)
+								continue;
+
+							PageChunk page_chunk;
+							page_chunk.layer = layer;
+							page_chunk.x = x;
+							page_chunk.y = y;
+							page_chunk.chunk = std::move(chunk);
+
+							contents.chunks.push_back(std::move(page_chunk));
+
+						}
+
+				auto inPage = [&](const IObjectPtr& object) {
+					return _pageAt(object->Position()) == key;
+				};
+
+				for (auto i = _objects.begin(); i != _objects.end(); ++i)
+					if (inPage(i->Object())) {
+
+						PageObject object;
+						object.position = i->Object()->Position();
+						object.properties = _objects.GetPackedProperties(i->Object().get());
+
+						contents.objects.push_back(std::move(object));
+
+					}
+
+				if (remove)
+					_objects.RemoveIf(inPage);
+
+				return contents;
+
+			}
+			void RoomStreamer::_wait() {
+
+				// Completions can remove pages, so hold on to the jobs while waiting on them.
+
+				std::vector<JobPtr> jobs;
+
+				for (auto i = _pages.begin(); i != _pages.end(); ++i)
+					if (i->second.job)
+						jobs.push_back(i->second.job);
+
+				for (auto i = jobs.begin(); i != jobs.end(); ++i)
+					if (!(*i)->IsCancelled())
+						_jobs.Wait(*i);
+
+			}
+			RectangleI RoomStreamer::_pageTiles(uint64_t key) const {
+				return RectangleI(_pageX(key) * PAGE_SIZE, _pageY(key) * PAGE_SIZE, PAGE_SIZE, PAGE_SIZE);
+			}
+			RectangleF RoomStreamer::_pageBounds(uint64_t key) const {
+
+				float width = static_cast<float>(_tile_size.width * PAGE_SIZE);
+				float height = static_cast<float>(_tile_size.height * PAGE_SIZE);
+
+				return RectangleF(static_cast<float>(_pageX(key)) * width, static_cast<float>(_pageY(key)) * height, width, height);
+
+			}
+			uint64_t RoomStreamer::_pageAt(const PointF& position) const {
+
+				int tile_x = static_cast<int>(std::floor(position.x / static_cast<float>(std::max(_tile_size.width, 1))));
+				int tile_y = static_cast<int>(std::floor(position.y / static_cast<float>(std::max(_tile_size.height, 1))));
+
+				return _makeKey(_floorDivide(tile_x, PAGE_SIZE), _floorDivide(tile_y, PAGE_SIZE));
+
+			}
+			void RoomStreamer::_encode(const PageContents& contents, std::vector<uint8_t>& data) {
+
+				data.clear();
+
+				// Empty pages are left without any data, which removes them from the file.
+
+				if (contents.chunks.empty() && contents.objects.empty())
+					return;
+
+				writeValue(data, static_cast<uint32_t>(contents.chunks.size()));
+
+				for (auto i = contents.chunks.begin(); i != contents.chunks.end(); ++i) {
+
+					writeValue(data, static_cast<int32_t>(i->layer));
+					writeValue(data, static_cast<int32_t>(i->x));
+					writeValue(data, static_cast<int32_t>(i->y));
+					writeString(data, TileLayer::EncodeChunk(*i->chunk));
+
+				}
+
+				writeValue(data, static_cast<uint32_t>(contents.objects.size()));
+
+				for (auto i = contents.objects.begin(); i != contents.objects.end(); ++i) {
+
+					writeValue(data, i->position.x);
+					writeValue(data, i->position.y);
+					writeValue(data, static_cast<uint32_t>(i->properties.size()));
+
+					for (auto j = i->properties.begin(); j != i->properties.end(); ++j) {
+
+						writeString(data, j->first);
+						writeString(data, j->second);
+
+					}
+
+				}
+
+			}
+			bool RoomStreamer::_decode(const std::vector<uint8_t>& data, PageContents& contents) {
+
+				if (data.empty())
+					return true;
+
+				PageReader reader(data);
+				uint32_t chunk_count;
+
+				if (!reader.Read(chunk_count))
+					return false;
+
+				for (uint32_t i = 0; i < chunk_count; ++i) {
+
+					int32_t layer, x, y;
+					std::string encoded;
+
+					if (!reader.Read(layer) || !reader.Read(x) || !reader.Read(y) || !reader.ReadString(encoded) || layer < 0)
+						return false;
+
+					PageChunk page_chunk;
+					page_chunk.layer = layer;
+					page_chunk.x = x;
+					page_chunk.y = y;
+					page_chunk.chunk.reset(new TileLayer::Chunk);
+
+					if (!TileLayer::DecodeChunk(encoded, *page_chunk.chunk))
+						return false;
+
+					contents.chunks.push_back(std::move(page_chunk));
+
+				}
+
+				uint32_t object_count;
+
+				if (!reader.Read(object_count))
+					return false;
+
+				for (uint32_t i = 0; i < object_count; ++i) {
+
+					PageObject object;
+					uint32_t property_count;
+
+					if (!reader.Read(object.position.x) || !reader.Read(object.position.y) || !reader.Read(property_count))
+						return false;
+
+					for (uint32_t j = 0; j < property_count; ++j) {
+
+						std::string name, value;
+
+						if (!reader.ReadString(name) || !reader.ReadString(value))
+							return false;
+
+						object.properties.push_back(ObjectList::property_pair_type(name, value));
+
+					}
+
+					contents.objects.push_back(std::move(object));
+
+				}
+
+				return true;
+
+			}
+			uint64_t RoomStreamer::_makeKey(int page_x, int page_y) {
+				return (static_cast<uint64_t>(static_cast<uint32_t>(page_x)) << 32) | static_cast<uint32_t>(page_y);
+			}
+			int RoomStreamer::_pageX(uint64_t key) {
+				return static_cast<int>(static_cast<int32_t>(key >> 32));
+			}
+			int RoomStreamer::_pageY(uint64_t key) {
+				return static_cast<int>(static_cast<int32_t>(key & 0xFFFFFFFF));
+			}
+			int RoomStreamer::_floorDivide(int value, int divisor) {
+				return value >= 0 ? value / divisor : (value - divisor + 1) / divisor;
+			}
+
+		}
+	}
+}
\ No newline at end of file
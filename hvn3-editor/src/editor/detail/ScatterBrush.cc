@@ -0,0 +1,260 @@
+#include "editor/detail/ScatterBrush.h"
+
+#include <cmath>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			ScatterBrush::ScatterBrush() :
+				_random(std::random_device()()) {
+
+				_radius = 64.0f;
+				_spacing = 0.0f;
+				_cell_size = 1.0f;
+				_density = 1.0f;
+				_in_stroke = false;
+
+				SetSpacing(32.0f);
+
+			}
+			void ScatterBrush::SetRadius(float radius) {
+
+				_radius = radius > 1.0f ? radius : 1.0f;
+
+			}
+			void ScatterBrush::SetSpacing(float spacing) {
+
+				spacing = spacing > 1.0f ? spacing : 1.0f;
+
+				if (spacing == _spacing)
+					return;
+
+				_spacing = spacing;
+
+				// A cell whose diagonal is the spacing can't hold two positions that are far enough apart.
+				_cell_size = _spacing / std::sqrt(2.0f);
+
+				Clear();
+
+			}
+			void ScatterBrush::SetDensity(float density) {
+
+				_density = density < 0.0f ? 0.0f : (density > 1.0f ? 1.0f : density);
+
+			}
+			float ScatterBrush::Radius() const {
+				return _radius;
+			}
+			float ScatterBrush::Spacing() const {
+				return _spacing;
+			}
+			float ScatterBrush::Density() const {
+				return _density;
+			}
+			void ScatterBrush::BeginStroke(const PointF& position, const accept_callback_type& accept, std::vector<PointF>& results) {
+
+				_in_stroke = true;
+				_last_stamp = position;
+
+				_stamp(position, accept, results);
+
+			}
+			void ScatterBrush::ContinueStroke(const PointF& position, const accept_callback_type& accept, std::vector<PointF>& results) {
+
+				if (!_in_stroke)
+					return;
+
+				// Stamp every half radius along the way, so that fast strokes don't leave gaps.
+
+				float step = _radius / 2.0f;
+				float dx = position.x - _last_stamp.x;
+				float dy = position.y - _last_stamp.y;
+				float distance = std::sqrt(dx * dx + dy * dy);
+
+				if (distance < step)
+					return;
+
+				int stamps = static_cast<int>(distance / step);
+
+				for (int i = 1; i <= stamps; ++i)
+					_stamp(PointF(_last_stamp.x + dx * step * i / distance, _last_stamp.y + dy * step * i / distance), accept, results);
+
+				_last_stamp = PointF(_last_stamp.x + dx * step * stamps / distance, _last_stamp.y + dy * step * stamps / distance);
+
+			}
+			void ScatterBrush::EndStroke() {
+
+				_in_stroke = false;
+
+			}
+			bool ScatterBrush::InStroke() const {
+				return _in_stroke;
+			}
+			void ScatterBrush::Clear() {
+
+				_grid.clear();
+				_active.clear();
+
+			}
+
+			void ScatterBrush::_stamp(const PointF& center, const accept_callback_type& accept, std::vector<PointF>& results) {
+
+				const float two_pi = 6.28318530718f;
+
+				std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+				float radius_squared = _radius * _radius;
+
+				auto in_brush = [&](const PointF& position) {
+
+					float dx = position.x - center.x;
+					float dy = position.y - center.y;
+
+					return dx * dx + dy * dy <= radius_squared;
+
+				};
+
+				// New positions are grown outwards from existing ones near the brush, so that they fit in with what's already been painted.
+
+				_active.clear();
+
+				int first_x = _cellIndex(center.x - _radius - _spacing);
+				int last_x = _cellIndex(center.x + _radius + _spacing);
+				int first_y = _cellIndex(center.y - _radius - _spacing);
+				int last_y = _cellIndex(center.y + _radius + _spacing);
+
+				if (!_grid.empty()) {
+
+					for (int y = first_y; y <= last_y; ++y)
+						for (int x = first_x; x <= last_x; ++x) {
+
+							auto cell_iter = _grid.find(_cellKey(x, y));
+
+							if (cell_iter != _grid.end() && !cell_iter->second.closed)
+								_active.push_back(cell_iter->first);
+
+						}
+
+				}
+
+				// If nothing has been painted here yet, start from a random position inside of the brush.
+
+				if (_active.empty()) {
+
+					for (int i = 0; i < MAX_ATTEMPTS; ++i) {
+
+						float angle = two_pi * unit(_random);
+						float distance = _radius * std::sqrt(unit(_random));
+						PointF position(center.x + std::cos(angle) * distance, center.y + std::sin(angle) * distance);
+
+						if (_isFarEnough(position) && accept(position)) {
+
+							_active.push_back(_insert(position, results));
+
+							break;
+
+						}
+
+					}
+
+				}
+
+				// Generate candidates between one and two times the spacing away from a random active position, until none of them fit.
+
+				while (!_active.empty()) {
+
+					size_t index = static_cast<size_t>(unit(_random) * _active.size());
+
+					if (index >= _active.size())
+						index = _active.size() - 1;
+
+					PointF origin = _grid[_active[index]].position;
+					bool found = false;
+
+					for (int i = 0; i < MAX_ATTEMPTS; ++i) {
+
+						float angle = two_pi * unit(_random);
+						float distance = _spacing * (1.0f + unit(_random));
+						PointF position(origin.x + std::cos(angle) * distance, origin.y + std::sin(angle) * distance);
+
+						if (!in_brush(position) || !_isFarEnough(position) || !accept(position))
+							continue;
+
+						_active.push_back(_insert(position, results));
+
+						found = true;
+
+						break;
+
+					}
+
+					if (!found) {
+
+						// Candidates that fell outside of the brush might fit later, so the position is only closed if all of them were inside of it.
+
+						if (std::sqrt(radius_squared) - std::sqrt((origin.x - center.x) * (origin.x - center.x) + (origin.y - center.y) * (origin.y - center.y)) >= _spacing * 2.0f)
+							_grid[_active[index]].closed = true;
+
+						_active[index] = _active.back();
+						_active.pop_back();
+
+					}
+
+				}
+
+			}
+			uint64_t ScatterBrush::_insert(const PointF& position, std::vector<PointF>& results) {
+
+				uint64_t key = _cellKey(_cellIndex(position.x), _cellIndex(position.y));
+
+				Cell& cell = _grid[key];
+				cell.position = position;
+				cell.closed = false;
+
+				if (_density >= 1.0f || std::uniform_real_distribution<float>(0.0f, 1.0f)(_random) < _density)
+					results.push_back(position);
+
+				return key;
+
+			}
+			bool ScatterBrush::_isFarEnough(const PointF& position) const {
+
+				int cell_x = _cellIndex(position.x);
+				int cell_y = _cellIndex(position.y);
+				float spacing_squared = _spacing * _spacing;
+
+				// Positions within the spacing can be up to two cells away.
+
+				for (int y = cell_y - 2; y <= cell_y + 2; ++y)
+					for (int x = cell_x - 2; x <= cell_x + 2; ++x) {
+
+						auto cell_iter = _grid.find(_cellKey(x, y));
+
+						if (cell_iter == _grid.end())
+							continue;
+
+						float dx = cell_iter->second.position.x - position.x;
+						float dy = cell_iter->second.position.y - position.y;
+
+						if (dx * dx + dy * dy < spacing_squared)
+							return false;
+
+					}
+
+				return true;
+
+			}
+			uint64_t ScatterBrush::_cellKey(int x, int y) const {
+
+				return (static_cast<uint64_t>(static_cast<uint32_t>(x)) << 32) | static_cast<uint32_t>(y);
+
+			}
+			int ScatterBrush::_cellIndex(float value) const {
+
+				return static_cast<int>(std::floor(value / _cell_size));
+
+			}
+
+		}
+	}
+}
\ No newline at end of file
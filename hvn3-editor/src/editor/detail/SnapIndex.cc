@@ -0,0 +1,94 @@
+#include "editor/detail/SnapIndex.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			SnapIndex::SnapIndex() {}
+			void SnapIndex::Add(const IObject* object, const RectangleF& bounds) {
+
+				float left = bounds.X();
+				float top = bounds.Y();
+				float right = bounds.X() + bounds.Width();
+				float bottom = bounds.Y() + bounds.Height();
+
+				_x_edges.push_back({ left, top, bottom, object });
+				_x_edges.push_back({ (left + right) / 2.0f, top, bottom, object });
+				_x_edges.push_back({ right, top, bottom, object });
+
+				_y_edges.push_back({ top, left, right, object });
+				_y_edges.push_back({ (top + bottom) / 2.0f, left, right, object });
+				_y_edges.push_back({ bottom, left, right, object });
+
+			}
+			void SnapIndex::Build() {
+
+				auto less = [](const Edge& lhs, const Edge& rhs) {
+					return lhs.value < rhs.value;
+				};
+
+				std::sort(_x_edges.begin(), _x_edges.end(), less);
+				std::sort(_y_edges.begin(), _y_edges.end(), less);
+
+			}
+			void SnapIndex::Clear() {
+
+				_x_edges.clear();
+				_y_edges.clear();
+
+			}
+			bool SnapIndex::Empty() const {
+				return _x_edges.empty();
+			}
+			bool SnapIndex::FindX(const float* values, size_t count, float tolerance, const IObject* ignore, float& delta, Edge& edge) const {
+
+				return _find(_x_edges, values, count, tolerance, ignore, delta, edge);
+
+			}
+			bool SnapIndex::FindY(const float* values, size_t count, float tolerance, const IObject* ignore, float& delta, Edge& edge) const {
+
+				return _find(_y_edges, values, count, tolerance, ignore, delta, edge);
+
+			}
+
+			bool SnapIndex::_find(const std::vector<Edge>& edges, const float* values, size_t count, float tolerance, const IObject* ignore, float& delta, Edge& edge) {
+
+				bool found = false;
+
+				for (size_t i = 0; i < count; ++i) {
+
+					// Only the edges within the tolerance of the value need to be looked at, and they're next to each other.
+
+					auto first = std::lower_bound(edges.begin(), edges.end(), values[i] - tolerance, [](const Edge& lhs, float rhs) {
+						return lhs.value < rhs;
+					});
+
+					for (auto j = first; j != edges.end() && j->value <= values[i] + tolerance; ++j) {
+
+						if (j->object == ignore)
+							continue;
+
+						float distance = j->value - values[i];
+
+						if (!found || std::abs(distance) < std::abs(delta)) {
+
+							delta = distance;
+							edge = *j;
+							found = true;
+
+						}
+
+					}
+
+				}
+
+				return found;
+
+			}
+
+		}
+	}
+}
\ No newline at end of file
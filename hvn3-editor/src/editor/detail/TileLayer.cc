@@ -0,0 +1,767 @@
+#include "editor/detail/TileLayer.h"
+
+#include <algorithm>
+#include <bitset>
+#include <cassert>
+#include <cerrno>
+#include <cstdlib>
+#include <limits>
+#include <sstream>
+
+// SSE2 is always available on x64, and can be enabled for x86.
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define HVN3_EDITOR_SSE2
+#include <emmintrin.h>
+#endif
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			namespace {
+
+				// These scan chunk storage directly, comparing 8 (16-bit) or 4 (32-bit) tiles at a time where SSE2 is available.
+				// Ranges are tested as (id - first_id) <= (last_id - first_id) using unsigned arithmetic, which needs a single comparison per tile.
+
+				int countBits(int mask) {
+					return static_cast<int>(std::bitset<16>(static_cast<unsigned long>(mask)).count());
+				}
+				int replaceTiles(uint16_t* tiles, int count, uint16_t first_id, uint16_t span, uint16_t replacement) {
+
+					int changed = 0;
+					int i = 0;
+
+#ifdef HVN3_EDITOR_SSE2
+					__m128i first_v = _mm_set1_epi16(static_cast<short>(first_id));
+					__m128i span_v = _mm_set1_epi16(static_cast<short>(span));
+					__m128i replacement_v = _mm_set1_epi16(static_cast<short>(replacement));
+					__m128i zero_v = _mm_setzero_si128();
+
+					for (; i + 8 <= count; i += 8) {
+
+						__m128i tiles_v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tiles + i));
+						__m128i in_range = _mm_cmpeq_epi16(_mm_subs_epu16(_mm_sub_epi16(tiles_v, first_v), span_v), zero_v);
+						int mask = _mm_movemask_epi8(_mm_andnot_si128(_mm_cmpeq_epi16(tiles_v, replacement_v), in_range));
+
+						if (mask == 0)
+							continue;
+
+						// Each 16-bit lane sets two bits of the mask.
+						changed += countBits(mask) / 2;
+
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(tiles + i), _mm_or_si128(_mm_and_si128(in_range, replacement_v), _mm_andnot_si128(in_range, tiles_v)));
+
+					}
+#endif
+
+					for (; i < count; ++i)
+						if (static_cast<uint16_t>(tiles[i] - first_id) <= span && tiles[i] != replacement) {
+
+							tiles[i] = replacement;
+							++changed;
+
+						}
+
+					return changed;
+
+				}
+				int replaceTiles(uint32_t* tiles, int count, uint32_t first_id, uint32_t span, uint32_t replacement) {
+
+					int changed = 0;
+					int i = 0;
+
+#ifdef HVN3_EDITOR_SSE2
+					// SSE2 only has signed comparisons, so flip the sign bits to compare unsigned values.
+					__m128i bias_v = _mm_set1_epi32(static_cast<int>(0x80000000u));
+					__m128i first_v = _mm_set1_epi32(static_cast<int>(first_id));
+					__m128i span_v = _mm_xor_si128(_mm_set1_epi32(static_cast<int>(span)), bias_v);
+					__m128i replacement_v = _mm_set1_epi32(static_cast<int>(replacement));
+
+					for (; i + 4 <= count; i += 4) {
+
+						__m128i tiles_v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tiles + i));
+						__m128i out_of_range = _mm_cmpgt_epi32(_mm_xor_si128(_mm_sub_epi32(tiles_v, first_v), bias_v), span_v);
+						__m128i unchanged = _mm_or_si128(out_of_range, _mm_cmpeq_epi32(tiles_v, replacement_v));
+						int mask = ~_mm_movemask_epi8(unchanged) & 0xFFFF;
+
+						if (mask == 0)
+							continue;
+
+						// Each 32-bit lane sets four bits of the mask.
+						changed += countBits(mask) / 4;
+
+						_mm_storeu_si128(reinterpret_cast<__m128i*>(tiles + i), _mm_or_si128(_mm_andnot_si128(out_of_range, replacement_v), _mm_and_si128(out_of_range, tiles_v)));
+
+					}
+#endif
+
+					for (; i < count; ++i)
+						if (tiles[i] - first_id <= span && tiles[i] != replacement) {
+
+							tiles[i] = replacement;
+							++changed;
+
+						}
+
+					return changed;
+
+				}
+				int findTiles(const uint16_t* tiles, int count, uint16_t first_id, uint16_t span, std::vector<int>* indices) {
+
+					int found = 0;
+					int i = 0;
+
+#ifdef HVN3_EDITOR_SSE2
+					__m128i first_v = _mm_set1_epi16(static_cast<short>(first_id));
+					__m128i span_v = _mm_set1_epi16(static_cast<short>(span));
+					__m128i zero_v = _mm_setzero_si128();
+
+					for (; i + 8 <= count; i += 8) {
+
+						__m128i tiles_v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tiles + i));
+						int mask = _mm_movemask_epi8(_mm_cmpeq_epi16(_mm_subs_epu16(_mm_sub_epi16(tiles_v, first_v), span_v), zero_v));
+
+						if (mask == 0)
+							continue;
+
+						found += countBits(mask) / 2;
+
+						if (indices != nullptr)
+							for (int lane = 0; lane < 8; ++lane)
+								if (mask & (1 << (lane * 2)))
+									indices->push_back(i + lane);
+
+					}
+#endif
+
+					for (; i < count; ++i)
+						if (static_cast<uint16_t>(tiles[i] - first_id) <= span) {
+
+							if (indices != nullptr)
+								indices->push_back(i);
+
+							++found;
+
+						}
+
+					return found;
+
+				}
+				int findTiles(const uint32_t* tiles, int count, uint32_t first_id, uint32_t span, std::vector<int>* indices) {
+
+					int found = 0;
+					int i = 0;
+
+#ifdef HVN3_EDITOR_SSE2
+					__m128i bias_v = _mm_set1_epi32(static_cast<int>(0x80000000u));
+					__m128i first_v = _mm_set1_epi32(static_cast<int>(first_id));
+					__m128i span_v = _mm_xor_si128(_mm_set1_epi32(static_cast<int>(span)), bias_v);
+
+					for (; i + 4 <= count; i += 4) {
+
+						__m128i tiles_v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tiles + i));
+						int mask = ~_mm_movemask_epi8(_mm_cmpgt_epi32(_mm_xor_si128(_mm_sub_epi32(tiles_v, first_v), bias_v), span_v)) & 0xFFFF;
+
+						if (mask == 0)
+							continue;
+
+						found += countBits(mask) / 4;
+
+						if (indices != nullptr)
+							for (int lane = 0; lane < 4; ++lane)
+								if (mask & (1 << (lane * 4)))
+									indices->push_back(i + lane);
+
+					}
+#endif
+
+					for (; i < count; ++i)
+						if (tiles[i] - first_id <= span) {
+
+							if (indices != nullptr)
+								indices->push_back(i);
+
+							++found;
+
+						}
+
+					return found;
+
+				}
+				uint16_t maxTile(const uint16_t* tiles, int count) {
+
+					uint16_t max_id = 0;
+					int i = 0;
+
+#ifdef HVN3_EDITOR_SSE2
+					// SSE2 only has a signed 16-bit maximum, so flip the sign bits to compare unsigned values.
+					__m128i bias_v = _mm_set1_epi16(static_cast<short>(0x8000));
+					__m128i max_v = bias_v;
+
+					for (; i + 8 <= count; i += 8)
+						max_v = _mm_max_epi16(max_v, _mm_xor_si128(_mm_loadu_si128(reinterpret_cast<const __m128i*>(tiles + i)), bias_v));
+
+					max_v = _mm_xor_si128(max_v, bias_v);
+
+					uint16_t lanes[8];
+					_mm_storeu_si128(reinterpret_cast<__m128i*>(lanes), max_v);
+
+					max_id = *std::max_element(lanes, lanes + 8);
+#endif
+
+					for (; i < count; ++i)
+						max_id = std::max(max_id, tiles[i]);
+
+					return max_id;
+
+				}
+				uint32_t maxTile(const uint32_t* tiles, int count) {
+					return *std::max_element(tiles, tiles + count);
+				}
+				template<typename T>
+				void countTiles(const T* tiles, int count, int empty_count, std::vector<uint32_t>& counts) {
+
+					// Size the counts up front, so that the loop below doesn't need to check each tile.
+
+					size_t max_id = static_cast<size_t>(maxTile(tiles, count));
+
+					if (counts.size() <= max_id)
+						counts.resize(max_id + 1, 0);
+
+					for (int i = 0; i < count; ++i)
+						++counts[tiles[i]];
+
+					// Empty tiles were counted along with the others, which is faster than skipping them.
+					counts[0] -= static_cast<uint32_t>(empty_count);
+
+				}
+
+			}
+
+			TileLayer::Chunk::Chunk() :
+				_narrow(CHUNK_AREA, 0),
+				_count(0) {
+			}
+			TileLayer::tile_id_type TileLayer::Chunk::At(int x, int y) const {
+
+				size_t index = static_cast<size_t>(y * CHUNK_SIZE + x);
+
+				return IsNarrow() ? _narrow[index] : _wide[index];
+
+			}
+			bool TileLayer::Chunk::SetTile(int x, int y, tile_id_type id) {
+
+				size_t index = static_cast<size_t>(y * CHUNK_SIZE + x);
+				tile_id_type old_id = At(x, y);
+
+				if (old_id == id)
+					return false;
+
+				if (IsNarrow() && id > std::numeric_limits<uint16_t>::max())
+					_widen();
+
+				if (IsNarrow())
+					_narrow[index] = static_cast<uint16_t>(id);
+				else
+					_wide[index] = id;
+
+				if (old_id == 0)
+					++_count;
+				else if (id == 0)
+					--_count;
+
+				return true;
+
+			}
+			int TileLayer::Chunk::Count() const {
+				return _count;
+			}
+			int TileLayer::Chunk::Replace(tile_id_type first_id, tile_id_type last_id, tile_id_type replacement) {
+
+				if (first_id > last_id)
+					return 0;
+
+				int changed;
+
+				if (IsNarrow()) {
+
+					const tile_id_type narrow_max = std::numeric_limits<uint16_t>::max();
+
+					// Tiles outside of the 16-bit range can't be stored in a narrow chunk, so they can't match.
+
+					if (first_id > narrow_max)
+						return 0;
+
+					uint16_t first = static_cast<uint16_t>(first_id);
+					uint16_t span = static_cast<uint16_t>(std::min(last_id, narrow_max) - first_id);
+
+					if (replacement > narrow_max) {
+
+						// Only widen the chunk if something is actually going to be replaced.
+
+						if (findTiles(_narrow.data(), CHUNK_AREA, first, span, nullptr) == 0)
+							return 0;
+
+						_widen();
+
+						changed = replaceTiles(_wide.data(), CHUNK_AREA, first_id, last_id - first_id, replacement);
+
+					}
+					else
+						changed = replaceTiles(_narrow.data(), CHUNK_AREA, first, span, static_cast<uint16_t>(replacement));
+
+				}
+				else
+					changed = replaceTiles(_wide.data(), CHUNK_AREA, first_id, last_id - first_id, replacement);
+
+				// The number of non-empty tiles only changes if empty tiles were replaced, or tiles were replaced with empty tiles.
+
+				if (changed > 0 && (first_id == 0 || replacement == 0))
+					_count = CHUNK_AREA - FindTiles(0, 0, nullptr);
+
+				return changed;
+
+			}
+			void TileLayer::Chunk::CountTiles(std::vector<uint32_t>& counts) const {
+
+				if (IsNarrow())
+					countTiles(_narrow.data(), CHUNK_AREA, CHUNK_AREA - _count, counts);
+				else
+					countTiles(_wide.data(), CHUNK_AREA, CHUNK_AREA - _count, counts);
+
+			}
+			int TileLayer::Chunk::FindTiles(tile_id_type first_id, tile_id_type last_id, std::vector<int>* indices) const {
+
+				if (first_id > last_id)
+					return 0;
+
+				if (!IsNarrow())
+					return findTiles(_wide.data(), CHUNK_AREA, first_id, last_id - first_id, indices);
+
+				const tile_id_type narrow_max = std::numeric_limits<uint16_t>::max();
+
+				if (first_id > narrow_max)
+					return 0;
+
+				return findTiles(_narrow.data(), CHUNK_AREA, static_cast<uint16_t>(first_id), static_cast<uint16_t>(std::min(last_id, narrow_max) - first_id), indices);
+
+			}
+			bool TileLayer::Chunk::IsNarrow() const {
+				return _wide.empty();
+			}
+			size_t TileLayer::Chunk::MemoryUsage() const {
+
+				return sizeof(Chunk) + _narrow.capacity() * sizeof(uint16_t) + _wide.capacity() * sizeof(uint32_t);
+
+			}
+			void TileLayer::Chunk::_widen() {
+
+				_wide.assign(_narrow.begin(), _narrow.end());
+
+				// Release the narrow buffer entirely (clear alone would not free its memory).
+				std::vector<uint16_t>().swap(_narrow);
+
+			}
+
+
+
+			TileLayer::TileLayer() :
+				_chunk_memory_usage(0) {
+			}
+			TileLayer::tile_id_type TileLayer::At(int x, int y) const {
+
+				const Chunk* chunk = GetChunk(_chunkCoordinate(x), _chunkCoordinate(y));
+
+				if (chunk == nullptr)
+					return 0;
+
+				return chunk->At(_localCoordinate(x), _localCoordinate(y));
+
+			}
+			bool TileLayer::SetTile(int x, int y, tile_id_type id) {
+
+				uint64_t key = _makeKey(_chunkCoordinate(x), _chunkCoordinate(y));
+				auto chunk_iter = _chunks.find(key);
+
+				if (chunk_iter == _chunks.end()) {
+
+					// Writing an empty tile to an empty chunk doesn't require allocating anything.
+
+					if (id == 0)
+						return false;
+
+					chunk_iter = _chunks.emplace(key, std::unique_ptr<Chunk>(new Chunk)).first;
+
+					_chunk_memory_usage += chunk_iter->second->MemoryUsage();
+
+				}
+
+				// Keep a running total of chunk memory so that it can be queried without visiting every chunk.
+
+				size_t chunk_memory_usage = chunk_iter->second->MemoryUsage();
+				bool changed = chunk_iter->second->SetTile(_localCoordinate(x), _localCoordinate(y), id);
+
+				_chunk_memory_usage += chunk_iter->second->MemoryUsage() - chunk_memory_usage;
+
+				// Free chunks as soon as they become empty so that empty regions cost nothing.
+
+				if (chunk_iter->second->Count() <= 0) {
+
+					_chunk_memory_usage -= chunk_iter->second->MemoryUsage();
+
+					_chunks.erase(chunk_iter);
+
+				}
+
+				return changed;
+
+			}
+			void TileLayer::ReadRow(int x, int y, int count, tile_id_type* out) const {
+
+				int chunk_y = _chunkCoordinate(y);
+				int local_y = _localCoordinate(y);
+
+				while (count > 0) {
+
+					int local_x = _localCoordinate(x);
+					int run_length = std::min(count, CHUNK_SIZE - local_x);
+					const Chunk* chunk = GetChunk(_chunkCoordinate(x), chunk_y);
+
+					if (chunk == nullptr)
+						std::fill(out, out + run_length, 0);
+					else
+						for (int i = 0; i < run_length; ++i)
+							out[i] = chunk->At(local_x + i, local_y);
+
+					x += run_length;
+					out += run_length;
+					count -= run_length;
+
+				}
+
+			}
+			size_t TileLayer::ReplaceTiles(tile_id_type first_id, tile_id_type last_id, tile_id_type replacement, std::vector<std::pair<int, int>>* changed_chunks) {
+
+				size_t changed = 0;
+
+				for (auto i = _chunks.begin(); i != _chunks.end();) {
+
+					size_t chunk_memory_usage = i->second->MemoryUsage();
+					int chunk_changed = i->second->Replace(first_id, last_id, replacement);
+
+					if (chunk_changed <= 0) {
+
+						++i;
+
+						continue;
+
+					}
+
+					changed += static_cast<size_t>(chunk_changed);
+					_chunk_memory_usage += i->second->MemoryUsage() - chunk_memory_usage;
+
+					if (changed_chunks != nullptr)
+						changed_chunks->push_back(std::make_pair(static_cast<int>(static_cast<int32_t>(i->first >> 32)), static_cast<int>(static_cast<int32_t>(i->first & 0xFFFFFFFF))));
+
+					if (i->second->Count() <= 0) {
+
+						_chunk_memory_usage -= i->second->MemoryUsage();
+
+						i = _chunks.erase(i);
+
+					}
+					else
+						++i;
+
+				}
+
+				return changed;
+
+			}
+			void TileLayer::CountTiles(std::vector<uint32_t>& counts) const {
+
+				for (auto i = _chunks.begin(); i != _chunks.end(); ++i)
+					i->second->CountTiles(counts);
+
+			}
+			size_t TileLayer::FindTiles(tile_id_type first_id, tile_id_type last_id, std::vector<std::pair<int, int>>& positions) const {
+
+				std::vector<int> indices;
+				size_t found = 0;
+
+				for (auto i = _chunks.begin(); i != _chunks.end(); ++i) {
+
+					int chunk_x = static_cast<int>(static_cast<int32_t>(i->first >> 32));
+					int chunk_y = static_cast<int>(static_cast<int32_t>(i->first & 0xFFFFFFFF));
+
+					indices.clear();
+
+					i->second->FindTiles(first_id, last_id, &indices);
+
+					for (auto j = indices.begin(); j != indices.end(); ++j)
+						positions.push_back(std::make_pair(chunk_x * CHUNK_SIZE + *j % CHUNK_SIZE, chunk_y * CHUNK_SIZE + *j / CHUNK_SIZE));
+
+					found += indices.size();
+
+				}
+
+				return found;
+
+			}
+			void TileLayer::Clear() {
+
+				_chunks.clear();
+				_chunk_memory_usage = 0;
+
+			}
+			size_t TileLayer::ChunkCount() const {
+				return _chunks.size();
+			}
+			size_t TileLayer::MemoryUsage() const {
+
+				return sizeof(TileLayer) + _chunks.bucket_count() * sizeof(void*) + _chunks.size() * sizeof(chunk_map_type::value_type) + _chunk_memory_usage;
+
+			}
+			const TileLayer::Chunk* TileLayer::GetChunk(int chunk_x, int chunk_y) const {
+
+				auto chunk_iter = _chunks.find(_makeKey(chunk_x, chunk_y));
+
+				if (chunk_iter == _chunks.end())
+					return nullptr;
+
+				return chunk_iter->second.get();
+
+			}
+			void TileLayer::SetChunk(int chunk_x, int chunk_y, std::unique_ptr<Chunk> chunk) {
+
+				TakeChunk(chunk_x, chunk_y);
+
+				if (!chunk || chunk->Count() <= 0)
+					return;
+
+				_chunk_memory_usage += chunk->MemoryUsage();
+
+				_chunks.emplace(_makeKey(chunk_x, chunk_y), std::move(chunk));
+
+			}
+			std::unique_ptr<TileLayer::Chunk> TileLayer::TakeChunk(int chunk_x, int chunk_y) {
+
+				auto chunk_iter = _chunks.find(_makeKey(chunk_x, chunk_y));
+
+				if (chunk_iter == _chunks.end())
+					return nullptr;
+
+				std::unique_ptr<Chunk> chunk = std::move(chunk_iter->second);
+
+				_chunk_memory_usage -= chunk->MemoryUsage();
+
+				_chunks.erase(chunk_iter);
+
+				return chunk;
+
+			}
+			std::string TileLayer::EncodeChunk(const Chunk& chunk) {
+
+				std::stringstream stream;
+
+				int run_length = 0;
+				tile_id_type run_id = 0;
+
+				for (int index = 0; index <= CHUNK_AREA; ++index) {
+
+					tile_id_type id = index < CHUNK_AREA ? chunk.At(index % CHUNK_SIZE, index / CHUNK_SIZE) : 0;
+
+					if (index < CHUNK_AREA && run_length > 0 && id == run_id) {
+						++run_length;
+						continue;
+					}
+
+					if (run_length > 0) {
+
+						if (stream.tellp() > 0)
+							stream << ',';
+
+						if (run_length > 1)
+							stream << run_length << '*';
+
+						stream << run_id;
+
+					}
+
+					run_id = id;
+					run_length = 1;
+
+				}
+
+				return stream.str();
+
+			}
+			bool TileLayer::DecodeChunk(int chunk_x, int chunk_y, const std::string& data) {
+
+				Chunk chunk;
+
+				if (!DecodeChunk(data, chunk))
+					return false;
+
+				for (int index = 0; index < CHUNK_AREA; ++index) {
+
+					tile_id_type id = chunk.At(index % CHUNK_SIZE, index / CHUNK_SIZE);
+
+					if (id != 0)
+						SetTile(chunk_x * CHUNK_SIZE + index % CHUNK_SIZE, chunk_y * CHUNK_SIZE + index / CHUNK_SIZE, id);
+
+				}
+
+				return true;
+
+			}
+			bool TileLayer::DecodeChunk(const std::string& data, Chunk& chunk) {
+
+				// Chunks can come from files that were edited by hand or damaged, so the numbers are parsed without anything that can throw.
+
+				auto parseNumber = [](const char*& position, unsigned long max, unsigned long& value) {
+
+					// strtoul would also accept whitespace and signs, so the number has to start with a digit.
+
+					if (*position < '0' || *position > '9')
+						return false;
+
+					char* end;
+
+					errno = 0;
+					value = std::strtoul(position, &end, 10);
+
+					if (errno == ERANGE || value > max)
+						return false;
+
+					position = end;
+
+					return true;
+
+				};
+
+				const char* position = data.c_str();
+				const char* end = position + data.size();
+				int index = 0;
+
+				while (position < end && index < CHUNK_AREA) {
+
+					unsigned long run_length = 1;
+					unsigned long id;
+
+					if (!parseNumber(position, std::numeric_limits<tile_id_type>::max(), id))
+						return false;
+
+					if (*position == '*') {
+
+						++position;
+						run_length = id;
+
+						if (!parseNumber(position, std::numeric_limits<tile_id_type>::max(), id))
+							return false;
+
+					}
+
+					if (*position == ',')
+						++position;
+					else if (position != end)
+						return false;
+
+					for (unsigned long i = 0; i < run_length && index < CHUNK_AREA; ++i, ++index)
+						if (id != 0)
+							chunk.SetTile(index % CHUNK_SIZE, index / CHUNK_SIZE, static_cast<tile_id_type>(id));
+
+				}
+
+				return true;
+
+			}
+			uint64_t TileLayer::_makeKey(int chunk_x, int chunk_y) {
+
+				return (static_cast<uint64_t>(static_cast<uint32_t>(chunk_x)) << 32) | static_cast<uint32_t>(chunk_y);
+
+			}
+			int TileLayer::_chunkCoordinate(int value) {
+
+				// Round towards negative infinity so that negative coordinates map to their own chunks.
+
+				return value >= 0 ? value / CHUNK_SIZE : (value - CHUNK_SIZE + 1) / CHUNK_SIZE;
+
+			}
+			int TileLayer::_localCoordinate(int value) {
+
+				int local = value % CHUNK_SIZE;
+
+				return local < 0 ? local + CHUNK_SIZE : local;
+
+			}
+
+
+
+			TileLayerList::TileLayerList() {
+
+				// There is always at least one layer.
+				_layers.emplace_back();
+
+			}
+			TileLayer& TileLayerList::GetOrCreateLayer(int index) {
+
+				assert(index >= 0 && index < MAX_LAYERS);
+
+				while (static_cast<size_t>(index) >= _layers.size())
+					_layers.emplace_back();
+
+				return _layers[static_cast<size_t>(index)];
+
+			}
+			TileLayer* TileLayerList::FindLayer(int index) {
+
+				if (index < 0 || static_cast<size_t>(index) >= _layers.size())
+					return nullptr;
+
+				return &_layers[static_cast<size_t>(index)];
+
+			}
+			const TileLayer* TileLayerList::FindLayer(int index) const {
+
+				if (index < 0 || static_cast<size_t>(index) >= _layers.size())
+					return nullptr;
+
+				return &_layers[static_cast<size_t>(index)];
+
+			}
+			int TileLayerList::Count() const {
+				return static_cast<int>(_layers.size());
+			}
+			TileLayer::tile_id_type TileLayerList::At(int x, int y, int layer) const {
+
+				const TileLayer* ptr = FindLayer(layer);
+
+				return ptr == nullptr ? 0 : ptr->At(x, y);
+
+			}
+			bool TileLayerList::SetTile(int x, int y, TileLayer::tile_id_type id, int layer) {
+
+				return GetOrCreateLayer(layer).SetTile(x, y, id);
+
+			}
+			void TileLayerList::Clear() {
+
+				_layers.clear();
+				_layers.emplace_back();
+
+			}
+			size_t TileLayerList::MemoryUsage() const {
+
+				size_t bytes = 0;
+
+				for (auto i = _layers.begin(); i != _layers.end(); ++i)
+					bytes += i->MemoryUsage();
+
+				return bytes;
+
+			}
+
+		}
+	}
+}
\ No newline at end of file
@@ -0,0 +1,337 @@
+#include "hvn3/graphics/Graphics.h"
+
+#include "editor/detail/TileOverview.h"
+
+#include <allegro5/allegro.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace hvn3 {
+	namespace editor {
+		namespace detail {
+
+			TileOverview::TileOverview() :
+				_tile_size(32, 32),
+				_capacity(512),
+				_build_budget(8) {
+			}
+			void TileOverview::SetTileSize(const SizeI& tile_size) {
+
+				_tile_size = tile_size;
+
+				// Cached images are only valid for the tile size they were built with.
+				Clear();
+
+			}
+			void TileOverview::SetDrawTileCallback(draw_tile_callback_type&& callback) {
+				_draw_tile = std::move(callback);
+			}
+			void TileOverview::SetCapacity(size_t capacity) {
+
+				_capacity = capacity;
+
+				_evict();
+
+			}
+			void TileOverview::SetBuildBudget(int budget) {
+				_build_budget = budget;
+			}
+			void TileOverview::Clear() {
+
+				_images.clear();
+				_lru.clear();
+
+			}
+			void TileOverview::UpdateTile(const TileLayerList& layers, int x, int y, int layer) {
+
+				TileLayer::tile_id_type id = layers.At(x, y, layer);
+
+				for (int level = 1; level <= MAX_LEVEL; ++level) {
+
+					SizeI tile_count = _imageTileCount(level);
+					int image_x = _floorDivide(x, tile_count.width);
+					int image_y = _floorDivide(y, tile_count.height);
+
+					auto image_iter = _images.find(_makeKey(layer, level, image_x, image_y));
+
+					if (image_iter == _images.end() || image_iter->second.invalidated)
+						continue;
+
+					float scale = 1.0f / static_cast<float>(1 << level);
+					float tile_width = _tile_size.width * scale;
+					float tile_height = _tile_size.height * scale;
+
+					// If tiles don't cover a whole number of pixels at this level, redrawing one would affect its neighbors, so rebuild the image instead.
+
+					if (tile_width < 1.0f || tile_height < 1.0f || std::floor(tile_width) != tile_width || std::floor(tile_height) != tile_height) {
+
+						image_iter->second.invalidated = true;
+
+						continue;
+
+					}
+
+					// Clear the area covered by the tile and redraw it.
+
+					float tile_x = (x - image_x * tile_count.width) * tile_width;
+					float tile_y = (y - image_y * tile_count.height) * tile_height;
+
+					Graphics::Graphics gfx(*image_iter->second.bitmap);
+
+					gfx.SetClip(RectangleF(tile_x, tile_y, tile_width, tile_height));
+					gfx.Clear(Color::Transparent);
+
+					if (id != 0 && _draw_tile)
+						_draw_tile(gfx, id, tile_x, tile_y, scale);
+
+					gfx.ResetClip();
+
+				}
+
+			}
+			void TileOverview::InvalidateTiles(const TileLayerList& layers, TileLayer::tile_id_type first_id, TileLayer::tile_id_type last_id) {
+
+				// Find the chunks containing any of the tiles, and invalidate the images covering them at every level.
+
+				for (int layer = 0; layer < layers.Count(); ++layer)
+					layers.FindLayer(layer)->ForEachChunk([&](int chunk_x, int chunk_y, const TileLayer::Chunk& chunk) {
+
+						bool contains_tiles = false;
+
+						for (int y = 0; y < TileLayer::CHUNK_SIZE && !contains_tiles; ++y)
+							for (int x = 0; x < TileLayer::CHUNK_SIZE && !contains_tiles; ++x) {
+
+								TileLayer::tile_id_type id = chunk.At(x, y);
+
+								contains_tiles = id >= first_id && id <= last_id;
+
+							}
+
+						if (!contains_tiles)
+							return;
+
+						for (int level = 1; level <= MAX_LEVEL; ++level) {
+
+							SizeI tile_count = _imageTileCount(level);
+
+							for (int image_y = _floorDivide(chunk_y * TileLayer::CHUNK_SIZE, tile_count.height); image_y <= _floorDivide((chunk_y + 1) * TileLayer::CHUNK_SIZE - 1, tile_count.height); ++image_y)
+								for (int image_x = _floorDivide(chunk_x * TileLayer::CHUNK_SIZE, tile_count.width); image_x <= _floorDivide((chunk_x + 1) * TileLayer::CHUNK_SIZE - 1, tile_count.width); ++image_x) {
+
+									auto image_iter = _images.find(_makeKey(layer, level, image_x, image_y));
+
+									if (image_iter != _images.end())
+										image_iter->second.invalidated = true;
+
+								}
+
+						}
+
+					});
+
+			}
+			void TileOverview::InvalidateRegion(const TileLayerList& layers, const RectangleI& tiles) {
+
+				for (int level = 1; level <= MAX_LEVEL; ++level) {
+
+					SizeI tile_count = _imageTileCount(level);
+
+					for (int image_y = _floorDivide(tiles.Y(), tile_count.height); image_y <= _floorDivide(tiles.Y() + tiles.Height() - 1, tile_count.height); ++image_y)
+						for (int image_x = _floorDivide(tiles.X(), tile_count.width); image_x <= _floorDivide(tiles.X() + tiles.Width() - 1, tile_count.width); ++image_x)
+							for (int layer = 0; layer < layers.Count(); ++layer) {
+
+								auto image_iter = _images.find(_makeKey(layer, level, image_x, image_y));
+
+								if (image_iter != _images.end())
+									image_iter->second.invalidated = true;
+
+							}
+
+				}
+
+			}
+			void TileOverview::Draw(Graphics::Graphics& graphics, const TileLayerList& layers, int level, const RectangleF& region, const PointF& offset) {
+
+				assert(level >= 1 && level <= MAX_LEVEL);
+
+				if (_tile_size.width <= 0 || _tile_size.height <= 0)
+					return;
+
+				float scale = 1.0f / static_cast<float>(1 << level);
+				SizeI tile_count = _imageTileCount(level);
+				float image_width = static_cast<float>(tile_count.width * _tile_size.width);
+				float image_height = static_cast<float>(tile_count.height * _tile_size.height);
+
+				int first_x = static_cast<int>(std::floor(region.X() / image_width));
+				int first_y = static_cast<int>(std::floor(region.Y() / image_height));
+				int last_x = static_cast<int>(std::floor((region.X() + region.Width()) / image_width));
+				int last_y = static_cast<int>(std::floor((region.Y() + region.Height()) / image_height));
+
+				int build_budget = _build_budget;
+
+				for (int layer = 0; layer < layers.Count(); ++layer)
+					for (int image_y = first_y; image_y <= last_y; ++image_y)
+						for (int image_x = first_x; image_x <= last_x; ++image_x) {
+
+							Image* image = _getImage(layers, layer, level, image_x, image_y, build_budget);
+
+							if (image != nullptr)
+								graphics.DrawBitmap(offset.x + image_x * image_width * scale, offset.y + image_y * image_height * scale, *image->bitmap);
+
+						}
+
+				_evict();
+
+			}
+			size_t TileOverview::Count() const {
+				return _images.size();
+			}
+
+			TileOverview::Image* TileOverview::_getImage(const TileLayerList& layers, int layer, int level, int image_x, int image_y, int& build_budget) {
+
+				uint64_t key = _makeKey(layer, level, image_x, image_y);
+				auto image_iter = _images.find(key);
+
+				if (image_iter != _images.end()) {
+
+					// Move the image to the front of the LRU list.
+					_lru.splice(_lru.begin(), _lru, image_iter->second.lru_iter);
+
+					if (image_iter->second.invalidated && build_budget > 0) {
+
+						_buildImage(image_iter->second, *layers.FindLayer(layer), level, image_x, image_y);
+
+						--build_budget;
+
+					}
+
+					return &image_iter->second;
+
+				}
+
+				// Empty regions don't get an image at all. Checking for chunks is cheap compared to drawing.
+
+				SizeI tile_count = _imageTileCount(level);
+				const TileLayer* tile_layer = layers.FindLayer(layer);
+				bool has_tiles = false;
+
+				int first_chunk_x = _floorDivide(image_x * tile_count.width, TileLayer::CHUNK_SIZE);
+				int first_chunk_y = _floorDivide(image_y * tile_count.height, TileLayer::CHUNK_SIZE);
+				int last_chunk_x = _floorDivide((image_x + 1) * tile_count.width - 1, TileLayer::CHUNK_SIZE);
+				int last_chunk_y = _floorDivide((image_y + 1) * tile_count.height - 1, TileLayer::CHUNK_SIZE);
+
+				for (int chunk_y = first_chunk_y; chunk_y <= last_chunk_y && !has_tiles; ++chunk_y)
+					for (int chunk_x = first_chunk_x; chunk_x <= last_chunk_x && !has_tiles; ++chunk_x)
+						has_tiles = tile_layer->GetChunk(chunk_x, chunk_y) != nullptr;
+
+				if (!has_tiles || build_budget <= 0)
+					return nullptr;
+
+				Image& image = _images[key];
+
+				_lru.push_front(key);
+				image.lru_iter = _lru.begin();
+
+				_buildImage(image, *tile_layer, level, image_x, image_y);
+
+				--build_budget;
+
+				return &image;
+
+			}
+			void TileOverview::_buildImage(Image& image, const TileLayer& layer, int level, int image_x, int image_y) {
+
+				if (!image.bitmap)
+					image.bitmap.reset(new Graphics::Bitmap(IMAGE_SIZE, IMAGE_SIZE));
+
+				float scale = 1.0f / static_cast<float>(1 << level);
+				SizeI tile_count = _imageTileCount(level);
+				int first_x = image_x * tile_count.width;
+				int first_y = image_y * tile_count.height;
+
+				Graphics::Graphics gfx(*image.bitmap);
+
+				gfx.Clear(Color::Transparent);
+
+				// Tiles from the same tileset share a texture, so holding drawing lets Allegro draw them in a single batch.
+
+				al_hold_bitmap_drawing(true);
+
+				_drawTiles(gfx, layer, scale, first_x, first_y, first_x + tile_count.width - 1, first_y + tile_count.height - 1, PointF(-first_x * _tile_size.width * scale, -first_y * _tile_size.height * scale));
+
+				al_hold_bitmap_drawing(false);
+
+				image.invalidated = false;
+
+			}
+			void TileOverview::_drawTiles(Graphics::Graphics& graphics, const TileLayer& layer, float scale, int first_x, int first_y, int last_x, int last_y, const PointF& offset) {
+
+				if (!_draw_tile)
+					return;
+
+				float tile_width = _tile_size.width * scale;
+				float tile_height = _tile_size.height * scale;
+
+				// Visit only the chunks that exist, since most of a large room is usually empty.
+
+				for (int chunk_y = _floorDivide(first_y, TileLayer::CHUNK_SIZE); chunk_y <= _floorDivide(last_y, TileLayer::CHUNK_SIZE); ++chunk_y)
+					for (int chunk_x = _floorDivide(first_x, TileLayer::CHUNK_SIZE); chunk_x <= _floorDivide(last_x, TileLayer::CHUNK_SIZE); ++chunk_x) {
+
+						const TileLayer::Chunk* chunk = layer.GetChunk(chunk_x, chunk_y);
+
+						if (chunk == nullptr)
+							continue;
+
+						int chunk_first_x = std::max(first_x, chunk_x * TileLayer::CHUNK_SIZE);
+						int chunk_first_y = std::max(first_y, chunk_y * TileLayer::CHUNK_SIZE);
+						int chunk_last_x = std::min(last_x, (chunk_x + 1) * TileLayer::CHUNK_SIZE - 1);
+						int chunk_last_y = std::min(last_y, (chunk_y + 1) * TileLayer::CHUNK_SIZE - 1);
+
+						for (int y = chunk_first_y; y <= chunk_last_y; ++y)
+							for (int x = chunk_first_x; x <= chunk_last_x; ++x) {
+
+								TileLayer::tile_id_type id = chunk->At(x - chunk_x * TileLayer::CHUNK_SIZE, y - chunk_y * TileLayer::CHUNK_SIZE);
+
+								if (id != 0)
+									_draw_tile(graphics, id, offset.x + x * tile_width, offset.y + y * tile_height, scale);
+
+							}
+
+					}
+
+			}
+			void TileOverview::_evict() {
+
+				while (_images.size() > _capacity) {
+
+					_images.erase(_lru.back());
+					_lru.pop_back();
+
+				}
+
+			}
+			SizeI TileOverview::_imageTileCount(int level) const {
+
+				int pixels = IMAGE_SIZE << level;
+
+				return SizeI(std::max(1, pixels / std::max(1, _tile_size.width)), std::max(1, pixels / std::max(1, _tile_size.height)));
+
+			}
+			uint64_t TileOverview::_makeKey(int layer, int level, int image_x, int image_y) {
+
+				return (static_cast<uint64_t>(layer & 0xFF) << 56) |
+					(static_cast<uint64_t>(level & 0xFF) << 48) |
+					(static_cast<uint64_t>(static_cast<uint32_t>(image_x) & 0xFFFFFF) << 24) |
+					(static_cast<uint64_t>(static_cast<uint32_t>(image_y) & 0xFFFFFF));
+
+			}
+			int TileOverview::_floorDivide(int value, int divisor) {
+
+				return value >= 0 ? value / divisor : (value - divisor + 1) / divisor;
+
+			}
+
+		}
+	}
+}
\ No newline at end of file
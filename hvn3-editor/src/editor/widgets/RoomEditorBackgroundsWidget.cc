@@ -32,12 +32,11 @@ namespace hvn3 {
 				if (dialog.ShowDialog()) {
 
 					std::string id = dialog.FileName();
-					Background bg(Graphics::Bitmap::FromFile(id));
+					Background bg(_editor->_bitmap_cache.Load(id));
 
 					_editor->Room()->Backgrounds().Add(bg);
 
-					_backgrounds.push_back(bg);
-					_backgrounds_list->AddItem(id);
+					AddBackground(id, bg);
 
 					_backgrounds_list->SetSelectedIndex(_backgrounds_list->Count() - 1);
 
@@ -156,6 +155,9 @@ namespace hvn3 {
 
 		}
 
+		const std::vector<Background>& RoomEditorBackgroundsWidget::Backgrounds() const {
+			return _backgrounds;
+		}
 		String RoomEditorBackgroundsWidget::GetIdByBackground(const Background& background) const {
 
 			int index = 0;
@@ -183,6 +185,9 @@ namespace hvn3 {
 			_backgrounds.push_back(background);
 			_backgrounds_list->AddItem(id);
 
+			// Reload the image when it's modified on disk.
+			_editor->_file_watcher.Watch(id);
+
 		}
 		void RoomEditorBackgroundsWidget::OnRendererChanged(Gui::WidgetRendererChangedEventArgs& e) {
 
@@ -0,0 +1,286 @@
+#include "hvn3/gui2/ListBox.h"
+#include "hvn3/gui2/MenuStrip.h"
+#include "hvn3/gui2/TextBox.h"
+
+#include "editor/widgets/RoomEditorListWidget.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+
+namespace hvn3 {
+	namespace editor {
+
+		const size_t RoomEditorListWidget::NO_ITEM = static_cast<size_t>(-1);
+
+		RoomEditorListWidget::RoomEditorListWidget() :
+			Window("") {
+
+			SetBorderStyle(Gui::Window::BorderStyle::None);
+
+			_count = 0;
+			_first_row = 0;
+			_visible_rows = 0;
+			_selected_item = NO_ITEM;
+			_block_selection_update = false;
+
+			// The arrows scroll the list by a page at a time.
+
+			Gui::MenuStrip* menu_strip = new Gui::MenuStrip;
+			Gui::MenuStripItem* item;
+
+			item = menu_strip->AddItem("");
+			item->AddId(".arrow_u");
+			item->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) {
+				Scroll(-static_cast<int>(std::max<size_t>(_visible_rows, 1)));
+			});
+
+			item = menu_strip->AddItem("");
+			item->AddId(".arrow_d");
+			item->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) {
+				Scroll(static_cast<int>(std::max<size_t>(_visible_rows, 1)));
+			});
+
+			_filter_textbox = new Gui::TextBox(200);
+			_filter_textbox->SetDockStyle(Gui::DockStyle::Top);
+			_filter_textbox->SetEventHandler<Gui::WidgetEventType::OnTextChanged>([this](Gui::WidgetTextChangedEventArgs& e) {
+				_applyFilter(static_cast<std::string>(_filter_textbox->Text()), true);
+			});
+
+			_rows = new Gui::ListBox;
+			_rows->SetDockStyle(Gui::DockStyle::Fill);
+			_rows->SetEventHandler<Gui::WidgetEventType::OnSelectedItemChanged>([this](Gui::WidgetSelectedItemChangedEventArgs& e) {
+
+				if (_block_selection_update || e.Index() < 0)
+					return;
+
+				size_t index = _first_row + static_cast<size_t>(e.Index());
+
+				if (index >= _filtered.size())
+					return;
+
+				_selected_item = _filtered[index];
+
+				if (_selected_item_changed)
+					_selected_item_changed(_selected_item);
+
+			});
+
+			GetChildren().Add(menu_strip);
+			GetChildren().Add(_filter_textbox);
+			GetChildren().Add(_rows);
+
+		}
+		void RoomEditorListWidget::SetItems(size_t count, item_text_callback_type&& callback) {
+
+			_count = count;
+			_item_text = std::move(callback);
+			_selected_item = NO_ITEM;
+
+			_applyFilter(_filter, false);
+
+		}
+		void RoomEditorListWidget::Insert(size_t index, size_t count) {
+
+			if (count == 0)
+				return;
+
+			// The filtered items are kept in order, so the ones after the new items are the ones that need to be moved down.
+
+			auto insert_iter = std::lower_bound(_filtered.begin(), _filtered.end(), index);
+
+			for (auto i = insert_iter; i != _filtered.end(); ++i)
+				*i += count;
+
+			std::vector<size_t> inserted;
+
+			for (size_t i = index; i < index + count; ++i)
+				if (_filter.empty() || _matchesFilter(i, _filter))
+					inserted.push_back(i);
+
+			_filtered.insert(insert_iter, inserted.begin(), inserted.end());
+
+			if (_selected_item != NO_ITEM && _selected_item >= index)
+				_selected_item += count;
+
+			_count += count;
+
+			_updateRows();
+
+		}
+		void RoomEditorListWidget::Remove(const std::vector<size_t>& items) {
+
+			if (items.empty())
+				return;
+
+			// Both lists are sorted, so each remaining item can be moved up by the number of removed items before it in a single pass.
+
+			auto output_iter = _filtered.begin();
+			auto removed_iter = items.begin();
+
+			for (auto i = _filtered.begin(); i != _filtered.end(); ++i) {
+
+				while (removed_iter != items.end() && *removed_iter < *i)
+					++removed_iter;
+
+				if (removed_iter != items.end() && *removed_iter == *i)
+					continue;
+
+				*output_iter++ = *i - static_cast<size_t>(removed_iter - items.begin());
+
+			}
+
+			_filtered.erase(output_iter, _filtered.end());
+
+			if (_selected_item != NO_ITEM) {
+
+				auto selected_iter = std::lower_bound(items.begin(), items.end(), _selected_item);
+
+				if (selected_iter != items.end() && *selected_iter == _selected_item)
+					_selected_item = NO_ITEM;
+				else
+					_selected_item -= static_cast<size_t>(selected_iter - items.begin());
+
+			}
+
+			_count -= std::min(items.size(), _count);
+
+			_updateRows();
+
+		}
+		void RoomEditorListWidget::SetSelectedItemChangedCallback(selected_item_changed_callback_type&& callback) {
+			_selected_item_changed = std::move(callback);
+		}
+		size_t RoomEditorListWidget::SelectedItem() const {
+			return _selected_item;
+		}
+		size_t RoomEditorListWidget::Count() const {
+			return _count;
+		}
+		size_t RoomEditorListWidget::FilteredCount() const {
+			return _filtered.size();
+		}
+		void RoomEditorListWidget::Scroll(int rows) {
+
+			long long first_row = static_cast<long long>(_first_row) + rows;
+
+			// _updateRows keeps the last page full, so only the top needs to be clamped here.
+			_first_row = static_cast<size_t>(std::max(0LL, first_row));
+
+			_updateRows();
+
+		}
+		void RoomEditorListWidget::OnUpdate(Gui::WidgetUpdateEventArgs& e) {
+
+			Window::OnUpdate(e);
+
+			// Add rows until they fill the list. Rows are never removed when the list gets smaller, since the ones that aren't needed are hidden.
+
+			if (_rows->Count() == 0)
+				_rows->AddItem("");
+
+			float row_height = _rows->ItemAt(0)->Height();
+			size_t visible_rows = row_height > 0.0f ? static_cast<size_t>(std::ceil(_rows->Height() / row_height)) : 1;
+
+			if (visible_rows == _visible_rows)
+				return;
+
+			while (static_cast<size_t>(_rows->Count()) < visible_rows)
+				_rows->AddItem("");
+
+			_visible_rows = visible_rows;
+
+			_updateRows();
+
+		}
+
+		void RoomEditorListWidget::_applyFilter(const std::string& filter, bool incremental) {
+
+			std::string lower = filter;
+			std::transform(lower.begin(), lower.end(), lower.begin(), [](char x) { return static_cast<char>(std::tolower(static_cast<unsigned char>(x))); });
+
+			if (incremental && lower.compare(0, _filter.size(), _filter) == 0) {
+
+				// Items that didn't match the current filter can't match a longer one.
+
+				_filtered.erase(std::remove_if(_filtered.begin(), _filtered.end(), [&](size_t x) {
+					return !_matchesFilter(x, lower);
+				}), _filtered.end());
+
+			}
+			else {
+
+				_filtered.clear();
+				_filtered.reserve(_count);
+
+				for (size_t i = 0; i < _count; ++i)
+					if (lower.empty() || _matchesFilter(i, lower))
+						_filtered.push_back(i);
+
+			}
+
+			if (lower != _filter) {
+
+				_filter = lower;
+				_first_row = 0;
+
+			}
+
+			_updateRows();
+
+		}
+		void RoomEditorListWidget::_updateRows() {
+
+			size_t last_first_row = _filtered.size() > _visible_rows ? _filtered.size() - _visible_rows : 0;
+
+			_first_row = std::min(_first_row, last_first_row);
+
+			int selected_row = -1;
+
+			_block_selection_update = true;
+
+			for (int i = 0; i < _rows->Count(); ++i) {
+
+				size_t index = _first_row + static_cast<size_t>(i);
+				auto row = _rows->ItemAt(i);
+
+				if (static_cast<size_t>(i) < _visible_rows && index < _filtered.size()) {
+
+					row->SetText(_item_text(_filtered[index]));
+					row->SetVisible(true);
+
+					if (_filtered[index] == _selected_item)
+						selected_row = i;
+
+				}
+				else {
+
+					row->SetText("");
+					row->SetVisible(false);
+
+				}
+
+			}
+
+			_rows->SetSelectedIndex(selected_row);
+
+			_block_selection_update = false;
+
+		}
+		bool RoomEditorListWidget::_matchesFilter(size_t item, const std::string& filter) const {
+
+			std::string text = static_cast<std::string>(_item_text(item));
+
+			if (text.size() < filter.size())
+				return false;
+
+			for (size_t i = 0; i < filter.size(); ++i)
+				if (std::tolower(static_cast<unsigned char>(text[i])) != static_cast<unsigned char>(filter[i]))
+					return false;
+
+			return true;
+
+		}
+
+	}
+}
\ No newline at end of file
@@ -0,0 +1,111 @@
+#include "hvn3/backgrounds/BackgroundManager.h"
+#include "hvn3/gui2/RoomView.h"
+#include "hvn3/rooms/Room.h"
+
+#include "editor/widgets/RoomEditorMinimapWidget.h"
+#include "editor/RoomEditor.h"
+
+#include <algorithm>
+
+namespace hvn3 {
+	namespace editor {
+
+		RoomEditorMinimapWidget::RoomEditorMinimapWidget(RoomEditor* editor) {
+
+			SetDockStyle(Gui::DockStyle::Bottom);
+			SetHeight(200.0f);
+
+			_editor = editor;
+
+		}
+		detail::Minimap& RoomEditorMinimapWidget::Minimap() {
+			return _minimap;
+		}
+		void RoomEditorMinimapWidget::OnDraw(Gui::WidgetDrawEventArgs& e) {
+
+			WidgetBase::OnDraw(e);
+
+			if (!_editor->_room || _minimap.Bitmap() == nullptr)
+				return;
+
+			float scale = _roomScale();
+			PointF offset = _roomOffset();
+			SizeF room_size = static_cast<SizeF>(_editor->_room->Size());
+
+			e.Graphics().SetClip(RectangleF(FixedPosition().x, FixedPosition().y, Width(), Height()));
+
+			// Backgrounds are drawn as-is rather than being stored in the minimap, since each one only takes a single draw.
+
+			e.Graphics().DrawFilledRectangle(RectangleF(offset.x, offset.y, room_size.width * scale, room_size.height * scale), _editor->_room->BackgroundColor());
+
+			_editor->_room->Backgrounds().ForEach([&](Background& i) {
+
+				if (i.Visible() && !i.IsForeground())
+					e.Graphics().DrawBitmap(offset.x + i.Offset().x * scale, offset.y + i.Offset().y * scale, i.Bitmap(), scale, scale);
+
+				HVN3_CONTINUE;
+
+			});
+
+			float minimap_scale = scale * _minimap.Scale();
+
+			e.Graphics().DrawBitmap(offset.x, offset.y, *_minimap.Bitmap(), minimap_scale, minimap_scale);
+
+			// Outline the region visible in the room view.
+
+			RectangleF bounds = _editor->_room_view->Bounds();
+			PointF view_top_left = _editor->_displayPositionToWorldPosition(bounds.Position(), false);
+			PointF view_bottom_right = _editor->_displayPositionToWorldPosition(PointF(bounds.X() + bounds.Width(), bounds.Y() + bounds.Height()), false);
+
+			e.Graphics().DrawRectangle(RectangleF(offset.x + view_top_left.x * scale, offset.y + view_top_left.y * scale, (view_bottom_right.x - view_top_left.x) * scale, (view_bottom_right.y - view_top_left.y) * scale), Color::White, 1.0f);
+
+			e.Graphics().ResetClip();
+
+		}
+		void RoomEditorMinimapWidget::OnUpdate(Gui::WidgetUpdateEventArgs& e) {
+
+			WidgetBase::OnUpdate(e);
+
+			if (_editor->_room)
+				_minimap.Update(_editor->_tile_layers);
+
+		}
+		void RoomEditorMinimapWidget::OnMouseDown(Gui::WidgetMouseDownEventArgs& e) {
+
+			WidgetBase::OnMouseDown(e);
+
+			if (!_editor->_room || e.Button() != MouseButton::Left)
+				return;
+
+			// Center the room view on the clicked position. Holding the button down drags the view along with the mouse.
+
+			float scale = _roomScale();
+			PointF offset = _roomOffset();
+
+			_editor->_setViewCenter(PointF((e.Position().x - offset.x) / scale, (e.Position().y - offset.y) / scale));
+
+		}
+
+		float RoomEditorMinimapWidget::_roomScale() const {
+
+			SizeF room_size = static_cast<SizeF>(_editor->_room->Size());
+
+			if (room_size.width <= 0.0f || room_size.height <= 0.0f)
+				return 1.0f;
+
+			return std::min(Width() / room_size.width, Height() / room_size.height);
+
+		}
+		PointF RoomEditorMinimapWidget::_roomOffset() const {
+
+			// The room is centered inside of the widget.
+
+			float scale = _roomScale();
+			SizeF room_size = static_cast<SizeF>(_editor->_room->Size());
+
+			return PointF(FixedPosition().x + (Width() - room_size.width * scale) / 2.0f, FixedPosition().y + (Height() - room_size.height * scale) / 2.0f);
+
+		}
+
+	}
+}
\ No newline at end of file
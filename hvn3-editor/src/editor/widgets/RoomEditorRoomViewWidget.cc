@@ -0,0 +1,23 @@
+#include "hvn3/core/DrawEventArgs.h"
+
+#include "editor/widgets/RoomEditorRoomViewWidget.h"
+#include "editor/RoomEditor.h"
+
+namespace hvn3 {
+	namespace editor {
+
+		RoomEditorRoomViewWidget::RoomEditorRoomViewWidget(RoomEditor* editor) {
+			_editor = editor;
+		}
+		void RoomEditorRoomViewWidget::OnDraw(Gui::WidgetDrawEventArgs& e) {
+
+			RoomView::OnDraw(e);
+
+			DrawEventArgs args(e.Graphics());
+
+			_editor->_drawRoomView(args);
+
+		}
+
+	}
+}
\ No newline at end of file
@@ -7,8 +7,10 @@ namespace hvn3 {
 			_pop_animation(0.0f, 0.0f, 0) {
 
 			_label = new Gui::Label("");
+			_progress_label = new Gui::Label("");
 
 			AddItem(_label);
+			AddItem(_progress_label);
 
 		}
 		void RoomEditorStatusStripWidget::PopText(const String& text) {
@@ -31,6 +33,14 @@ namespace hvn3 {
 
 			_label->SetText(text);
 
+		}
+		void RoomEditorStatusStripWidget::SetProgressText(const String& text) {
+
+			// This is called every frame, so avoid updating the label unless the text has actually changed.
+
+			if (_progress_label->Text() != text)
+				_progress_label->SetText(text);
+
 		}
 		void RoomEditorStatusStripWidget::OnUpdate(Gui::WidgetUpdateEventArgs& e) {
 
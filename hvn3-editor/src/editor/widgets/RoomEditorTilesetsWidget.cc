@@ -1,13 +1,21 @@
 #include "hvn3/gui2/Button.h"
+#include "hvn3/gui2/ListBox.h"
 #include "hvn3/gui2/MenuStrip.h"
 #include "hvn3/gui2/TextBox.h"
 #include "hvn3/gui2/TilesetView.h"
 #include "hvn3/gui2/WidgetLayoutBuilder.h"
+#include "hvn3/io/Path.h"
 #include "hvn3/native/FileDialog.h"
+#include "hvn3/xml/XmlDocument.h"
 
 #include "editor/RoomEditor.h"
+#include "editor/widgets/RoomEditorMinimapWidget.h"
+#include "editor/widgets/RoomEditorStatusStripWidget.h"
 #include "editor/widgets/RoomEditorTilesetsWidget.h"
 
+#include <algorithm>
+#include <cstdint>
+
 namespace hvn3 {
 	namespace editor {
 
@@ -15,16 +23,36 @@ namespace hvn3 {
 			Window("") {
 
 			_editor = editor;
+			_current_layer = 0;
+			_auto_tiling_enabled = false;
 
 			tilesets_context_menu = new Gui::ContextMenu;
 			layers_context_menu = new Gui::ContextMenu;
+			autotile_context_menu = new Gui::ContextMenu;
+			find_context_menu = new Gui::ContextMenu;
 			Gui::MenuStrip* menu_strip = new Gui::MenuStrip;
 			tileset_view = nullptr;
 
 			tilesets_context_menu->AddItem("Add Tileset...")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) { _openTileset(); });
-			layers_context_menu->AddItem("Layer 0")->SetChecked(true);
+			layers_context_menu->AddItem("Add Layer")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) { _addLayer(); });
 			layers_context_menu->AddSeparator();
-			layers_context_menu->AddItem("Add Layer...");
+
+			auto autotile_cm_enabled_item = autotile_context_menu->AddItem("Auto-tiling", true);
+
+			autotile_cm_enabled_item->SetEventHandler<Gui::WidgetEventType::OnMousePressed>([=](Gui::WidgetMousePressedEventArgs& e) {
+				_auto_tiling_enabled = !_auto_tiling_enabled;
+				autotile_cm_enabled_item->SetChecked(_auto_tiling_enabled);
+			});
+
+			autotile_context_menu->AddSeparator();
+			autotile_context_menu->AddItem("Add Terrain From Selection (47 Tiles)")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) { _addTerrainFromSelection(detail::AutoTiler::Layout::Blob47); });
+			autotile_context_menu->AddItem("Add Terrain From Selection (16 Tiles)")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) { _addTerrainFromSelection(detail::AutoTiler::Layout::Edge16); });
+			autotile_context_menu->AddItem("Apply To Current Layer")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) { _applyAutoTilingToLayer(); });
+
+			find_context_menu->AddItem("Select Matching Tiles")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) { _selectMatchingTiles(); });
+			find_context_menu->AddItem("Replace Tiles...")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) { _showReplaceTilesDialog(); });
+			find_context_menu->AddSeparator();
+			find_context_menu->AddItem("Tile Usage...")->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) { _showTileUsageDialog(); });
 
 			Gui::MenuStripItem* item;
 
@@ -35,6 +63,12 @@ namespace hvn3 {
 			item = menu_strip->AddItem("");
 			item->SetContextMenu(layers_context_menu);
 			item->AddId(".layers_btn");
+			item->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([this](Gui::WidgetMouseClickEventArgs& e) {
+
+				// The memory usage of each layer is only refreshed when the menu is opened, rather than after every edit.
+				UpdateLayers();
+
+			});
 
 			item = menu_strip->AddItem("");
 			item->AddId(".flags_btn");
@@ -54,8 +88,16 @@ namespace hvn3 {
 
 			});
 
+			item = menu_strip->AddItem("Auto");
+			item->SetContextMenu(autotile_context_menu);
+
+			item = menu_strip->AddItem("Find");
+			item->SetContextMenu(find_context_menu);
+
 			GetChildren().Add(menu_strip);
 
+			UpdateLayers();
+
 		}
 		Gui::TilesetView* RoomEditorTilesetsWidget::TilesetView() {
 			return tileset_view;
@@ -96,8 +138,14 @@ namespace hvn3 {
 				tilesets_context_menu->AddSeparator();
 
 			_tilesets.push_back(tileset);
+			_auto_tilers.emplace_back();
 			tilesets_context_menu->AddItem(id);
 
+			_loadTilesetMetadata(id, tileset, _auto_tilers.back());
+
+			// Reload the image when it's modified on disk.
+			_editor->_file_watcher.Watch(id);
+
 			Gui::ContextMenuItem* item = tilesets_context_menu->AddItem(id);
 
 			item->SetEventHandler<Gui::WidgetEventType::OnCheckedStateChanged>([this](Gui::WidgetCheckedStateChangedEventArgs& e) {
@@ -115,6 +163,70 @@ namespace hvn3 {
 
 			}
 
+		}
+		detail::AutoTiler* RoomEditorTilesetsWidget::GetAutoTilerByTileset(const Tileset& tileset) {
+
+			for (size_t i = 0; i < _tilesets.size(); ++i)
+				if (_tilesets[i].Bitmap() == tileset.Bitmap())
+					return &_auto_tilers[i];
+
+			return nullptr;
+
+		}
+		bool RoomEditorTilesetsWidget::AutoTilingEnabled() const {
+			return _auto_tiling_enabled;
+		}
+		int RoomEditorTilesetsWidget::CurrentLayer() const {
+			return _current_layer;
+		}
+		void RoomEditorTilesetsWidget::SetCurrentLayer(int layer) {
+
+			_current_layer = layer;
+
+			UpdateLayers();
+
+		}
+		void RoomEditorTilesetsWidget::UpdateLayers() {
+
+			// Remove the items of layers that no longer exist (after a room is created or opened), and add an item for each layer that doesn't have one yet.
+
+			while (_layer_items.size() > static_cast<size_t>(_editor->_tile_layers.Count())) {
+
+				layers_context_menu->GetChildren().Remove(_layer_items.back());
+
+				_layer_items.pop_back();
+
+			}
+
+			if (_current_layer >= _editor->_tile_layers.Count())
+				_current_layer = 0;
+
+			while (_layer_items.size() < static_cast<size_t>(_editor->_tile_layers.Count())) {
+
+				int layer = static_cast<int>(_layer_items.size());
+
+				Gui::ContextMenuItem* item = layers_context_menu->AddItem("", true);
+
+				item->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([=](Gui::WidgetMouseClickEventArgs& e) {
+					SetCurrentLayer(layer);
+				});
+
+				_layer_items.push_back(item);
+
+			}
+
+			// Show how much memory each layer is using so that it's easy to spot unusually dense layers.
+
+			for (size_t i = 0; i < _layer_items.size(); ++i) {
+
+				const detail::TileLayer* layer = _editor->_tile_layers.FindLayer(static_cast<int>(i));
+				size_t kilobytes = layer == nullptr ? 0 : (layer->MemoryUsage() + 1023) / 1024;
+
+				_layer_items[i]->SetText(StringUtils::Format("Layer {0} ({1} KB)", i, kilobytes));
+				_layer_items[i]->SetChecked(static_cast<int>(i) == _current_layer);
+
+			}
+
 		}
 
 		void RoomEditorTilesetsWidget::_openTileset() {
@@ -148,7 +260,7 @@ namespace hvn3 {
 
 				if (textbox_tileset_dir->Text().Length() > 0) {
 
-					AddTileset(Tileset(Graphics::Bitmap::FromFile(textbox_tileset_dir->Text()), SizeI(StringUtils::Parse<int>(textbox_tile_width->Text()),
+					AddTileset(Tileset(_editor->_bitmap_cache.Load(textbox_tileset_dir->Text()), SizeI(StringUtils::Parse<int>(textbox_tile_width->Text()),
 						StringUtils::Parse<int>(textbox_tile_height->Text()))), textbox_tileset_dir->Text());
 
 					_editor->_room->Tiles().AddTileset(_tilesets.back());
@@ -182,6 +294,245 @@ namespace hvn3 {
 			builder.AnchorToInnerEdge(button_ok, Gui::Anchor::Bottom | Gui::Anchor::Right);
 
 		}
+		void RoomEditorTilesetsWidget::_addLayer() {
+
+			if (_editor->_tile_layers.Count() >= detail::TileLayerList::MAX_LAYERS) {
+
+				_editor->_status_strip->SetText(StringUtils::Format("Rooms can't have more than {0} layers", static_cast<int>(detail::TileLayerList::MAX_LAYERS)));
+
+				return;
+
+			}
+
+			// Accessing a layer by index creates it.
+			_editor->_tile_layers.GetOrCreateLayer(_editor->_tile_layers.Count());
+
+			SetCurrentLayer(_editor->_tile_layers.Count() - 1);
+
+		}
+
+		void RoomEditorTilesetsWidget::_addTerrainFromSelection(detail::AutoTiler::Layout layout) {
+
+			if (tileset_view == nullptr)
+				return;
+
+			detail::AutoTiler* auto_tiler = GetAutoTilerByTileset(tileset_view->Tileset());
+
+			if (auto_tiler == nullptr)
+				return;
+
+			// The terrain's tiles are expected to be laid out consecutively, starting with the top-left tile of the selection.
+
+			RectangleI selection = tileset_view->SelectedRegion();
+			detail::AutoTiler::tile_id_type first_tile = static_cast<detail::AutoTiler::tile_id_type>((selection.Y() * tileset_view->Tileset().Columns()) + selection.X() + 1);
+
+			if (first_tile - 1 + static_cast<size_t>(detail::AutoTiler::TileCount(layout)) > tileset_view->Tileset().Count()) {
+
+				_editor->_status_strip->SetText(StringUtils::Format("The terrain needs {0} tiles, but the tileset ends before then", detail::AutoTiler::TileCount(layout)));
+
+				return;
+
+			}
+
+			if (auto_tiler->AddTerrain(first_tile, layout) < 0) {
+
+				_editor->_status_strip->SetText(StringUtils::Format("Tilesets can't have more than {0} terrains", detail::AutoTiler::MAX_TERRAINS));
+
+				return;
+
+			}
+
+			_editor->_status_strip->PopText(StringUtils::Format("Added auto-tiling terrain starting at tile {0}", first_tile));
+
+		}
+		void RoomEditorTilesetsWidget::_applyAutoTilingToLayer() {
+
+			if (tileset_view == nullptr || !_editor->_room)
+				return;
+
+			detail::AutoTiler* auto_tiler = GetAutoTilerByTileset(tileset_view->Tileset());
+
+			if (auto_tiler == nullptr)
+				return;
+
+			int layer = _current_layer;
+			TileManager& tiles = _editor->_room->Tiles();
+			size_t changed = 0;
+
+			auto_tiler->Apply(_editor->_tile_layers.GetOrCreateLayer(layer), tiles.Columns(), tiles.Rows(), [&](int x, int y, detail::AutoTiler::tile_id_type id) {
+
+				if (_editor->_room_streamer.IsOpen())
+					_editor->_room_streamer.MarkModified(x, y);
+
+				++changed;
+
+			});
+
+			if (changed > 0) {
+
+				// Updating the overview one tile at a time would be slower than rebuilding it.
+				_editor->_tile_overview.Clear();
+				_editor->_minimap_view->Minimap().InvalidateAll();
+
+				_editor->_markUnsavedChanges();
+
+			}
+
+		}
+		detail::TileLayer::tile_id_type RoomEditorTilesetsWidget::_selectedTile() const {
+
+			if (tileset_view == nullptr)
+				return 0;
+
+			RectangleI selection = tileset_view->SelectedRegion();
+
+			return static_cast<detail::TileLayer::tile_id_type>((selection.Y() * tileset_view->Tileset().Columns()) + selection.X() + 1);
+
+		}
+		void RoomEditorTilesetsWidget::_selectMatchingTiles() {
+
+			detail::TileLayer::tile_id_type id = _selectedTile();
+
+			if (id == 0 || !_editor->_room)
+				return;
+
+			_editor->_selectTiles(id, _current_layer);
+
+		}
+		void RoomEditorTilesetsWidget::_showReplaceTilesDialog() {
+
+			if (!_editor->_room)
+				return;
+
+			Gui::Window* dialog = new Gui::Window(250, 200, "Replace Tiles");
+
+			Gui::Label* label_first = new Gui::Label("Find (first)");
+			Gui::TextBox* textbox_first = new Gui::TextBox(100, Gui::InputType::Numeric);
+			Gui::Label* label_last = new Gui::Label("Find (last)");
+			Gui::TextBox* textbox_last = new Gui::TextBox(100, Gui::InputType::Numeric);
+			Gui::Label* label_replacement = new Gui::Label("Replace with");
+			Gui::TextBox* textbox_replacement = new Gui::TextBox(100, Gui::InputType::Numeric);
+			Gui::Button* button_ok = new Gui::Button("Replace");
+
+			// Start with the selected tile, which is the most likely one to be replaced.
+
+			detail::TileLayer::tile_id_type selected_tile = _selectedTile();
+
+			textbox_first->SetText(StringUtils::ToString(selected_tile));
+			textbox_last->SetText(StringUtils::ToString(selected_tile));
+			textbox_replacement->SetText("0");
+			button_ok->SetWidth(100);
+
+			button_ok->SetEventHandler<Gui::WidgetEventType::OnMouseClick>([=](Gui::WidgetMouseClickEventArgs& e) {
+
+				detail::TileLayer::tile_id_type first_id = static_cast<detail::TileLayer::tile_id_type>(std::max(0, StringUtils::Parse<int>(textbox_first->Text())));
+				detail::TileLayer::tile_id_type last_id = static_cast<detail::TileLayer::tile_id_type>(std::max(0, StringUtils::Parse<int>(textbox_last->Text())));
+				detail::TileLayer::tile_id_type replacement = static_cast<detail::TileLayer::tile_id_type>(std::max(0, StringUtils::Parse<int>(textbox_replacement->Text())));
+
+				_editor->_replaceTiles(first_id, std::max(first_id, last_id), replacement);
+
+				dialog->Close();
+
+			});
+
+			dialog->GetChildren().Add(label_first);
+			dialog->GetChildren().Add(textbox_first);
+			dialog->GetChildren().Add(label_last);
+			dialog->GetChildren().Add(textbox_last);
+			dialog->GetChildren().Add(label_replacement);
+			dialog->GetChildren().Add(textbox_replacement);
+			dialog->GetChildren().Add(button_ok);
+
+			_editor->_widgets.ShowDialog(std::unique_ptr<Gui::IWidget>(dialog));
+
+			Gui::WidgetLayoutBuilder builder;
+
+			builder.PlaceAt(label_first, PointF(0.0f, 0.0f));
+			builder.PlaceBottom(textbox_first);
+			builder.PlaceRight(textbox_last);
+			builder.PlaceTop(label_last);
+			builder.PlaceBottomOf(label_replacement, textbox_first);
+			builder.PlaceBottom(textbox_replacement);
+			builder.AnchorToInnerEdge(button_ok, Gui::Anchor::Bottom | Gui::Anchor::Right);
+
+		}
+		void RoomEditorTilesetsWidget::_showTileUsageDialog() {
+
+			if (!_editor->_room)
+				return;
+
+			// Count every tile on every layer, then list the tiles of all tilesets in the order their indices are assigned.
+
+			std::vector<uint32_t> counts;
+
+			for (int i = 0; i < _editor->_tile_layers.Count(); ++i)
+				_editor->_tile_layers.FindLayer(i)->CountTiles(counts);
+
+			size_t tile_count = 0;
+
+			for (auto i = _tilesets.begin(); i != _tilesets.end(); ++i)
+				tile_count += i->Count();
+
+			Gui::Window* dialog = new Gui::Window(250, 400, "Tile Usage");
+			Gui::ListBox* list = new Gui::ListBox;
+			size_t unused_count = 0;
+
+			for (size_t id = 1; id <= tile_count; ++id) {
+
+				uint32_t count = id < counts.size() ? counts[id] : 0;
+
+				if (count == 0)
+					++unused_count;
+
+				list->AddItem(StringUtils::Format("Tile {0}: {1}", id, count));
+
+			}
+
+			Gui::Label* label_summary = new Gui::Label(StringUtils::Format("{0} of {1} tiles unused", unused_count, tile_count));
+
+			list->SetDockStyle(Gui::DockStyle::Fill);
+			label_summary->SetDockStyle(Gui::DockStyle::Top);
+
+			dialog->GetChildren().Add(label_summary);
+			dialog->GetChildren().Add(list);
+
+			_editor->_widgets.ShowDialog(std::unique_ptr<Gui::IWidget>(dialog));
+
+		}
+		void RoomEditorTilesetsWidget::_loadTilesetMetadata(const String& id, const Tileset& tileset, detail::AutoTiler& auto_tiler) {
+
+			// Auto-tiling terrains are stored alongside the tileset's flags in its metadata file.
+
+			std::string metadata_path = IO::Path::SetExtension(id, ".xml");
+
+			if (!IO::File::Exists(metadata_path))
+				return;
+
+			Xml::XmlDocument metadata = Xml::XmlDocument::Open(metadata_path);
+			const Xml::XmlElement* terrains_node = metadata.Root().GetChild("terrains");
+
+			if (terrains_node == nullptr)
+				return;
+
+			size_t invalid_count = 0;
+
+			for (auto i = terrains_node->ChildrenBegin(); i != terrains_node->ChildrenEnd(); ++i) {
+
+				detail::AutoTiler::Layout layout = (*i)->GetAttribute("layout") == "edge16" ? detail::AutoTiler::Layout::Edge16 : detail::AutoTiler::Layout::Blob47;
+
+				// Terrains whose tiles don't fit in the tileset are skipped, rather than sizing the auto-tiler's tables to whatever the file says.
+
+				long long first_tile = StringUtils::Parse<long long>((*i)->GetAttribute("first"));
+
+				if (first_tile < 1 || static_cast<unsigned long long>(first_tile) - 1 + static_cast<unsigned long long>(detail::AutoTiler::TileCount(layout)) > tileset.Count() || auto_tiler.AddTerrain(static_cast<detail::AutoTiler::tile_id_type>(first_tile), layout) < 0)
+					++invalid_count;
+
+			}
+
+			if (invalid_count > 0)
+				_editor->_status_strip->SetText(StringUtils::Format("Skipped {0} invalid auto-tiling terrains in {1}", invalid_count, id));
+
+		}
 
 	}
 }
\ No newline at end of file